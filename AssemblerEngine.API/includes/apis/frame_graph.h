@@ -0,0 +1,135 @@
+/*****************************************************************//**
+ * @file   frame_graph.h
+ * @ingroup group_api
+ * @brief  Frame graph API, orders render passes by the resources they read and write
+ *********************************************************************/
+
+ /**
+ *@addtogroup group_api
+ * @{
+ */
+
+#pragma once
+
+#include "core/types.h"
+
+/** @brief opaque graph object */
+struct ae_frame_graph;
+
+/**
+ * @brief a version of a resource, 0 is none. every write returns a new handle, reads of the old
+ * handle see the contents from before the write
+ */
+typedef uint32_t ae_frame_graph_handle;
+
+/** @brief a pass of the current frame, 0 is none */
+typedef uint32_t ae_frame_graph_pass;
+
+/** @brief called while the graph executes, the framebuffer of the pass is bound and cleared */
+typedef void (*ae_frame_graph_execute_fn)(struct ae_frame_graph* graph, void* user_data);
+
+enum ae_frame_graph_format
+{
+	AE_FRAME_GRAPH_FORMAT_RGBA8,
+	AE_FRAME_GRAPH_FORMAT_RGBA16F,
+	/** @brief written as the depth attachment of a pass */
+	AE_FRAME_GRAPH_FORMAT_DEPTH24_STENCIL8
+};
+
+/** @brief how a pass reads a resource, decides the barrier after a storage write */
+enum ae_frame_graph_access
+{
+	/** @brief a texture read through a sampler, e.g. the texture of ae_textured_draw_params */
+	AE_FRAME_GRAPH_ACCESS_SAMPLED,
+	/** @brief image load or shader storage buffer read */
+	AE_FRAME_GRAPH_ACCESS_STORAGE,
+	AE_FRAME_GRAPH_ACCESS_VERTEX,
+	AE_FRAME_GRAPH_ACCESS_INDEX,
+	AE_FRAME_GRAPH_ACCESS_INDIRECT,
+	AE_FRAME_GRAPH_ACCESS_UNIFORM
+};
+
+struct ae_frame_graph_texture_desc
+{
+	/** @brief 0 takes the size of the viewport when the graph executes */
+	uint32_t					width;
+	uint32_t					height;
+	enum ae_frame_graph_format	format;
+};
+
+struct ae_frame_graph_attachment
+{
+	/** @brief the attachment is cleared when the pass starts instead of keeping what the earlier version holds */
+	bool	clear;
+	/** @brief clear color, depth attachments are cleared to the first component and stencil to 0 */
+	vec4	clear_value;
+};
+
+/** @brief counters of the last execute */
+struct ae_frame_graph_stats
+{
+	uint32_t	pass_count;
+	/** @brief passes left out because nothing used what they wrote */
+	uint32_t	culled_count;
+	/** @brief transient textures used by the passes that ran */
+	uint32_t	texture_count;
+	/** @brief gl textures behind them, textures with lifetimes that do not overlap share one */
+	uint32_t	allocated_count;
+	uint32_t	barrier_count;
+	uint32_t	clear_count;
+};
+
+/**
+ * @brief passes are declared every frame with the resources they use and run in an order that respects
+ * every dependency, independent of the order they were added in. passes whose results are never read are
+ * culled, a pass always runs when it writes an imported resource or is marked with set_side_effect.
+ * transient textures live in a pool and are shared by resources that are not alive at the same time.
+ * call render_frame_start once per frame before execute, render_scene_start would clear the backbuffer the
+ * passes draw to. passes set their own camera with render_set_camera and end their batches before they return.
+ * clears ignore the scissor test and write masks, they are turned off and reset before the clears of a pass
+ * and the gl state a pass changes is not kept for the next one. render thread only
+ */
+struct ae_frame_graph_api
+{
+	struct ae_frame_graph*	(*create)(void);
+	void					(*destroy)(struct ae_frame_graph* graph);
+
+	/** @brief drops the passes and resources of the last frame, pooled textures are kept */
+	void					(*reset)(struct ae_frame_graph* graph);
+
+	/** @brief a texture that only lives for this frame, the contents are undefined until a pass writes it */
+	ae_frame_graph_handle	(*create_texture)(struct ae_frame_graph* graph, const char* name, const struct ae_frame_graph_texture_desc* desc);
+
+	/** @brief a texture created elsewhere, writing it keeps the pass alive */
+	ae_frame_graph_handle	(*import_texture)(struct ae_frame_graph* graph, const char* name, const uint32_t texture, const struct ae_frame_graph_texture_desc* desc);
+	ae_frame_graph_handle	(*import_buffer)(struct ae_frame_graph* graph, const char* name, const uint32_t buffer);
+
+	/** @brief the framebuffer of the backend, a pass that writes it can not write other attachments */
+	ae_frame_graph_handle	(*get_backbuffer)(struct ae_frame_graph* graph);
+
+	ae_frame_graph_pass		(*add_pass)(struct ae_frame_graph* graph, const char* name, ae_frame_graph_execute_fn execute, void* user_data);
+
+	/** @brief the pass runs after the pass that wrote this version */
+	void					(*read)(struct ae_frame_graph* graph, const ae_frame_graph_pass pass, const ae_frame_graph_handle resource, const enum ae_frame_graph_access access);
+
+	/**
+	 * @brief renders into a texture, color attachments are numbered in the order they are written
+	 * @param [in] attachment NULL keeps the contents of the earlier version
+	 * @return the new version, 0 if the resource is not a texture or this version was already written
+	 */
+	ae_frame_graph_handle	(*write_attachment)(struct ae_frame_graph* graph, const ae_frame_graph_pass pass, const ae_frame_graph_handle resource, const struct ae_frame_graph_attachment* attachment);
+
+	/** @brief image store or shader storage buffer write, later reads get a memory barrier */
+	ae_frame_graph_handle	(*write_storage)(struct ae_frame_graph* graph, const ae_frame_graph_pass pass, const ae_frame_graph_handle resource);
+
+	void					(*set_side_effect)(struct ae_frame_graph* graph, const ae_frame_graph_pass pass);
+
+	/** @return false if a declaration failed, the passes have a cycle or a pass mixes the backbuffer with other attachments */
+	bool					(*execute)(struct ae_frame_graph* graph);
+
+	/** @brief the gl texture or buffer of a resource, textures of a transient resource are only assigned during execute */
+	uint32_t				(*get_name)(const struct ae_frame_graph* graph, const ae_frame_graph_handle resource);
+	void					(*get_stats)(const struct ae_frame_graph* graph, struct ae_frame_graph_stats* stats);
+};
+
+/**@}*/
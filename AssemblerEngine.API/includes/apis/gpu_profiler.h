@@ -0,0 +1,75 @@
+/*****************************************************************//**
+ * @file   gpu_profiler.h
+ * @ingroup group_api
+ * @brief  GPU time of the frame, its batches and named scopes
+ *********************************************************************/
+
+ /**
+ *@addtogroup group_api
+ * @{
+ */
+
+#pragma once
+
+#include "core/types.h"
+
+/** @brief characters kept of a scope name, including the terminator */
+#define AE_GPU_SCOPE_NAME_LENGTH 32
+
+/** @brief gpu time spent between begin_scope and end_scope */
+struct ae_gpu_scope
+{
+	/** @brief name given to begin_scope, the renderer adds "batch <vao>" scopes with a "draw" scope in them */
+	char name[AE_GPU_SCOPE_NAME_LENGTH];
+	/** @brief scopes it is nested in */
+	uint32_t depth;
+	/** @brief times the scope was begun, a scope begun right after a sibling with the same name is merged into it */
+	uint32_t count;
+	/** @brief nanoseconds from the start of the frame to the start of the scope */
+	uint64_t start;
+	/** @brief nanoseconds */
+	uint64_t duration;
+};
+
+/** @brief the scopes of one frame, in the order they were begun */
+struct ae_gpu_frame
+{
+	/** @brief counts the frames since the profiler was enabled */
+	uint64_t frame_index;
+	/** @brief nanoseconds between the two render_scene_start calls around the frame */
+	uint64_t gpu_time;
+	/** @brief scopes that did not fit in the frame and were not measured */
+	uint32_t dropped_count;
+	uint32_t scope_count;
+	const struct ae_gpu_scope* scopes;
+};
+
+/**
+ * @brief timer queries around frames, render batches and user scopes.
+ * a frame ends at render_scene_start, its results are read two frames later and only if the gpu is done,
+ * so the profiler never waits on the gpu. scopes nest and must be begun and ended on the render thread
+ */
+struct ae_gpu_profiler_api
+{
+	/** @brief off by default, the queries are created the first time it is enabled */
+	void	(*set_enabled)(const bool enabled);
+
+	/**
+	 * @brief starts a scope inside the current one, the name is copied.
+	 * a scope with the name of the one that ended just before it in the same parent (e.g. one per draw) extends that one
+	 * to the new end instead of using up another
+	 */
+	void	(*begin_scope)(const char* name);
+
+	/** @brief ends the innermost scope, scopes still open at the end of a frame are ended there */
+	void	(*end_scope)(void);
+
+	/**
+	 * @brief the newest frame that has been read back
+	 * @param [out] frame The frame, its scopes stay valid until the next render_scene_start
+	 * @return false if no frame was read back yet
+	 */
+	bool	(*get_frame)(struct ae_gpu_frame* frame);
+};
+
+/**@}*/
@@ -16,13 +16,99 @@
 
 #include <core/types.h>
 
+/** @brief numeric levels for the preprocessor, match enum ae_log_levels */
+#define AE_LOG_LEVEL_TRACE		0
+#define AE_LOG_LEVEL_DEBUG		1
+#define AE_LOG_LEVEL_INFO		2
+#define AE_LOG_LEVEL_WARN		3
+#define AE_LOG_LEVEL_ERROR		4
+#define AE_LOG_LEVEL_CRITICAL	5
+#define AE_LOG_LEVEL_OFF		6
+
+/** @brief log sites below this level are compiled out, define before including to strip trace and debug logging */
+#ifndef AE_LOG_MIN_LEVEL
+#define AE_LOG_MIN_LEVEL AE_LOG_LEVEL_TRACE
+#endif // !AE_LOG_MIN_LEVEL
+
+/** @brief set on a log site once the logging plugin knows about it */
+#define AE_LOG_SITE_REGISTERED	(1u << 0)
+/** @brief set on a log site that was disabled at runtime through set_site_enabled */
+#define AE_LOG_SITE_DISABLED	(1u << 1)
+/** @brief set on a log site that has to pass admit_site, see set_site_rate_limit */
+#define AE_LOG_SITE_LIMITED		(1u << 2)
+
 struct ae_logger;
+struct ae_log_site_limit;
 
 enum ae_log_levels
 {
 	LEVEL_TRACE, LEVEL_DEBUG, LEVEL_INFO, LEVEL_WARN, LEVEL_ERROR, LEVEL_CRITICAL
 };
 
+/** @brief what an async logger does when its queue is full */
+enum ae_log_backpressure
+{
+	/** @brief the logging thread waits until the writer thread made room */
+	AE_LOG_BACKPRESSURE_BLOCK,
+	/** @brief the message is silently discarded */
+	AE_LOG_BACKPRESSURE_DROP,
+	/** @brief the message is discarded and counted, the writer reports the count to the sinks */
+	AE_LOG_BACKPRESSURE_COUNT_AND_DROP
+};
+
+/** @brief type tag of an argument captured by a binary log call */
+enum ae_log_argument_type
+{
+	AE_LOG_ARGUMENT_I64,
+	AE_LOG_ARGUMENT_U64,
+	AE_LOG_ARGUMENT_F64,
+	AE_LOG_ARGUMENT_POINTER,
+	AE_LOG_ARGUMENT_STRING
+};
+
+/** @brief raw argument of a binary log call, formatting happens offline by the decoder */
+struct ae_log_argument
+{
+	enum ae_log_argument_type type;
+
+	union
+	{
+		int64_t		i64;
+		uint64_t	u64;
+		double		f64;
+		const void*	pointer;
+		const char*	string;
+	};
+};
+
+/** @brief static data of a log call site, registered with the logging plugin on first use */
+struct ae_log_site
+{
+	const char*			fmt;
+	const char*			file;
+	int32_t				line;
+	enum ae_log_levels	level;
+	/** @brief id used to refer to the site in binary logs */
+	volatile uint32_t	id;
+	/** @brief AE_LOG_SITE_* flags, read by the log macros before any call */
+	volatile uint32_t	flags;
+	/** @brief rate limit state, owned by the logging plugin */
+	struct ae_log_site_limit* limit;
+	struct ae_log_site*	next;
+};
+
+/** @brief throughput of a memory mapped file sink */
+struct ae_log_file_sink_stats
+{
+	uint64_t	bytes_written;
+	/** @brief measured over the last second by the sink's background thread */
+	uint64_t	bytes_per_second;
+	/** @brief messages lost because no segment could be opened */
+	uint64_t	dropped_count;
+	uint32_t	segment_count;
+	uint32_t	compressed_segment_count;
+};
+
 typedef void (*ae_logger_lock_fn)(void* data);
 typedef void (*ae_logger_unlock_fn)(void* data);
 
@@ -30,50 +116,239 @@ struct ae_logging_api
 {
 	struct ae_logger*	(*get_main_logger)();
 	struct ae_logger*	(*get_or_create_main_logger)(const enum ae_log_levels level);
+
+	/**
+	 * @brief makes logger the one the log macros write to, e.g. one made by create_async.
+	 * call it before other threads log, the previous logger is not destroyed and may still be in use until they stop
+	 * @param [in] logger The new main logger, NULL turns the log macros off
+	 * @return the previous main logger, owned by the caller again
+	 */
+	struct ae_logger*	(*set_main_logger)(struct ae_logger* logger);
+
 	struct ae_logger*	(*create)(const enum ae_log_levels level);
 	struct ae_logger*	(*create_threaded)(const enum ae_log_levels level, ae_logger_lock_fn lock_fn, ae_logger_unlock_fn unlock_fn);
+	struct ae_logger*	(*create_async)(const enum ae_log_levels level, const uint32_t capacity, const enum ae_log_backpressure backpressure);
+	void				(*destroy)(struct ae_logger* logger);
+	void				(*flush)(struct ae_logger* logger);
+	uint64_t			(*get_dropped_count)(struct ae_logger* logger);
+	struct ae_logger*	(*create_binary)(const enum ae_log_levels level, const char* path, const uint64_t max_size);
+	void				(*log_binary)(struct ae_logger* logger, struct ae_log_site* site, const struct ae_log_argument* arguments, const uint32_t argument_count);
 	void				(*enable_threading)(struct ae_logger* logger, ae_logger_lock_fn lock_fn, ae_logger_unlock_fn unlock_fn);
 	bool				(*add_console_sink)(struct ae_logger* logger, void* data, const enum ae_log_levels level);
 	bool				(*add_file_sink)(struct ae_logger* logger, FILE* file, const enum ae_log_levels level);
+
+	/**
+	 * @brief adds a sink appending to memory mapped segments named path.0000, path.0001, ...
+	 * messages are copied into the mapping without a system call, full or expired segments are
+	 * closed and compressed to path.NNNN.lz by a background thread. segments of earlier runs are kept,
+	 * the numbering continues after the highest one found
+	 * @param [in] segment_size The size of a segment in bytes
+	 * @param [in] rotate_seconds The maximum age of a segment, 0 only rotates by size
+	 * @return index of the sink for get_mapped_file_sink_stats, -1 on failure
+	 */
+	int32_t				(*add_mapped_file_sink)(struct ae_logger* logger, const char* path, const enum ae_log_levels level, const uint64_t segment_size, const uint32_t rotate_seconds);
+	bool				(*get_mapped_file_sink_stats)(struct ae_logger* logger, const int32_t index, struct ae_log_file_sink_stats* stats);
 	bool				(*set_level)(struct ae_logger* logger, const enum ae_log_levels level);
 	void				(*log)(struct ae_logger* logger, const enum ae_log_levels level, const char* file, int32_t line, const char* fmt, ...);
 	void				(*log_main)(const enum ae_log_levels level, const char* file, int32_t line, const char* fmt, ...);
+
+	/** @brief level of the main logger, read inline by the log macros. AE_LOG_LEVEL_OFF while there is no main logger */
+	const volatile int32_t* main_level;
+
+	/**
+	 * @brief registers a log site on first use and applies the enable rules to it
+	 * @return true if the site is enabled
+	 */
+	bool				(*register_site)(struct ae_log_site* site);
+
+	/**
+	 * @brief enables or disables log sites at runtime, also applies to sites registered later on
+	 * @param [in] file The end of the source file path to match, e.g. "imgui.c"
+	 * @param [in] line The line to match, 0 matches every line of the file
+	 * @param [in] enabled Whether the matching sites should log
+	 * @return the amount of registered sites that matched
+	 */
+	uint32_t			(*set_site_enabled)(const char* file, const int32_t line, const bool enabled);
+
+	/**
+	 * @brief limits log sites to a token bucket and/or to every n-th message, applies to sites registered later on as well.
+	 * suppressed messages are counted and reported on the main logger as "message repeated N times"
+	 * by the next admitted message of the site, every few seconds while sites are suppressed and when the main logger is flushed or destroyed
+	 * @param [in] file The end of the source file path to match, e.g. "imgui.c"
+	 * @param [in] line The line to match, 0 matches every line of the file
+	 * @param [in] messages_per_second The refill rate of the bucket, 0 disables the rate limit
+	 * @param [in] burst The amount of messages let through at once
+	 * @param [in] sample_every Only every n-th message is considered, 0 or 1 considers every message
+	 * @return the amount of registered sites that matched
+	 */
+	uint32_t			(*set_site_rate_limit)(const char* file, const int32_t line, const float messages_per_second, const uint32_t burst, const uint32_t sample_every);
+
+	/**
+	 * @brief called by the log macros for AE_LOG_SITE_LIMITED sites, before the arguments are evaluated
+	 * @return true if the message should be logged
+	 */
+	bool				(*admit_site)(struct ae_log_site* site);
+
+	/**
+	 * @brief forgets the registered sites of the library that contains module_address, e.g. a function of the plugin.
+	 * sites live in the static data of the code that logs, a plugin using the log macros calls this from plugin_unload.
+	 * the sites register again on first use once the plugin is loaded again
+	 */
+	void				(*unregister_sites)(const void* module_address);
 };
 
+#define AE_LOG_FMT(fmt, ...) fmt
+
+/// <summary>
+/// log site on the main logger, the level, site flags and rate limit are checked before anything is evaluated
+/// </summary>
+#define AE_LOG_MAIN(level, ...)																							\
+	do {																												\
+		static struct ae_log_site ae_log_site_ = { AE_LOG_FMT(__VA_ARGS__, ~), __FILE__, __LINE__, level, 0, 0, NULL, NULL };	\
+		if ((int32_t)(level) >= *ae_logging_api->main_level && !(ae_log_site_.flags & AE_LOG_SITE_DISABLED))			\
+		{																												\
+			if (!(ae_log_site_.flags & AE_LOG_SITE_REGISTERED) && !ae_logging_api->register_site(&ae_log_site_))		\
+				break;																									\
+			if ((ae_log_site_.flags & AE_LOG_SITE_LIMITED) && !ae_logging_api->admit_site(&ae_log_site_))				\
+				break;																									\
+			ae_logging_api->log_main(level, __FILE__, __LINE__, __VA_ARGS__);											\
+		}																												\
+	} while (0)
+
+/// <summary>
+/// log site below AE_LOG_MIN_LEVEL, never runs but keeps the arguments type checked and referenced
+/// </summary>
+#define AE_LOG_STRIPPED(level, ...)																						\
+	do {																												\
+		if (0)																											\
+			ae_logging_api->log_main(level, __FILE__, __LINE__, __VA_ARGS__);											\
+	} while (0)
+
 /// <summary>
 /// utility log macro calls log_log with predefined level, file and line
 /// </summary>
 /// <param name="...">: variadic parameter to pass log string and values to pass to log string</param>
-#define ae_log_trace(...) ae_logging_api->log_main(LEVEL_TRACE, __FILE__, __LINE__, __VA_ARGS__)
+#if AE_LOG_MIN_LEVEL <= AE_LOG_LEVEL_TRACE
+#define ae_log_trace(...) AE_LOG_MAIN(LEVEL_TRACE, __VA_ARGS__)
+#else
+#define ae_log_trace(...) AE_LOG_STRIPPED(LEVEL_TRACE, __VA_ARGS__)
+#endif
 
 /// <summary>
 /// utility log macro calls log_log with predefined level, file and line
 /// </summary>
 /// <param name="...">: variadic parameter to pass log string and values to pass to log string</param>
-#define ae_log_debug(...) ae_logging_api->log_main(LEVEL_DEBUG, __FILE__, __LINE__, __VA_ARGS__)
+#if AE_LOG_MIN_LEVEL <= AE_LOG_LEVEL_DEBUG
+#define ae_log_debug(...) AE_LOG_MAIN(LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define ae_log_debug(...) AE_LOG_STRIPPED(LEVEL_DEBUG, __VA_ARGS__)
+#endif
 
 /// <summary>
 /// utility log macro calls log_log with predefined level, file and line
 /// </summary>
 /// <param name="...">: variadic parameter to pass log string and values to pass to log string</param>
-#define ae_log_info(...)  ae_logging_api->log_main(LEVEL_INFO,  __FILE__, __LINE__, __VA_ARGS__)
+#if AE_LOG_MIN_LEVEL <= AE_LOG_LEVEL_INFO
+#define ae_log_info(...)  AE_LOG_MAIN(LEVEL_INFO, __VA_ARGS__)
+#else
+#define ae_log_info(...)  AE_LOG_STRIPPED(LEVEL_INFO, __VA_ARGS__)
+#endif
 
 /// <summary>
 /// utility log macro calls log_log with predefined level, file and line
 /// </summary>
 /// <param name="...">: variadic parameter to pass log string and values to pass to log string</param>
-#define ae_log_warn(...)  ae_logging_api->log_main(LEVEL_WARN,  __FILE__, __LINE__, __VA_ARGS__)
+#if AE_LOG_MIN_LEVEL <= AE_LOG_LEVEL_WARN
+#define ae_log_warn(...)  AE_LOG_MAIN(LEVEL_WARN, __VA_ARGS__)
+#else
+#define ae_log_warn(...)  AE_LOG_STRIPPED(LEVEL_WARN, __VA_ARGS__)
+#endif
 
 /// <summary>
 /// utility log macro calls log_log with predefined level, file and line
 /// </summary>
 /// <param name="...">: variadic parameter to pass log string and values to pass to log string</param>
-#define ae_log_error(...) ae_logging_api->log_main(LEVEL_ERROR, __FILE__, __LINE__, __VA_ARGS__)
+#if AE_LOG_MIN_LEVEL <= AE_LOG_LEVEL_ERROR
+#define ae_log_error(...) AE_LOG_MAIN(LEVEL_ERROR, __VA_ARGS__)
+#else
+#define ae_log_error(...) AE_LOG_STRIPPED(LEVEL_ERROR, __VA_ARGS__)
+#endif
 
 /// <summary>
 /// utility log macro calls log_log with predefined level, file and line
 /// </summary>
 /// <param name="...">: variadic parameter to pass log string and values to pass to log string</param>
-#define ae_log_critical(...) ae_logging_api->log_main(LEVEL_CRITICAL, __FILE__, __LINE__, __VA_ARGS__)
+#if AE_LOG_MIN_LEVEL <= AE_LOG_LEVEL_CRITICAL
+#define ae_log_critical(...) AE_LOG_MAIN(LEVEL_CRITICAL, __VA_ARGS__)
+#else
+#define ae_log_critical(...) AE_LOG_STRIPPED(LEVEL_CRITICAL, __VA_ARGS__)
+#endif
+
+static inline struct ae_log_argument ae_log_argument_i64(const int64_t value) { struct ae_log_argument argument = { .type = AE_LOG_ARGUMENT_I64, .i64 = value }; return argument; }
+static inline struct ae_log_argument ae_log_argument_u64(const uint64_t value) { struct ae_log_argument argument = { .type = AE_LOG_ARGUMENT_U64, .u64 = value }; return argument; }
+static inline struct ae_log_argument ae_log_argument_f64(const double value) { struct ae_log_argument argument = { .type = AE_LOG_ARGUMENT_F64, .f64 = value }; return argument; }
+static inline struct ae_log_argument ae_log_argument_pointer(const void* value) { struct ae_log_argument argument = { .type = AE_LOG_ARGUMENT_POINTER, .pointer = value }; return argument; }
+static inline struct ae_log_argument ae_log_argument_string(const char* value) { struct ae_log_argument argument = { .type = AE_LOG_ARGUMENT_STRING, .string = value }; return argument; }
+
+/// <summary>
+/// captures a log argument together with its type at compile time
+/// </summary>
+/// <param name="x">: the argument to capture</param>
+#define AE_LOG_ARGUMENT(x) _Generic((x),			\
+	_Bool:				ae_log_argument_u64,		\
+	char:				ae_log_argument_i64,		\
+	signed char:		ae_log_argument_i64,		\
+	unsigned char:		ae_log_argument_u64,		\
+	short:				ae_log_argument_i64,		\
+	unsigned short:		ae_log_argument_u64,		\
+	int:				ae_log_argument_i64,		\
+	unsigned int:		ae_log_argument_u64,		\
+	long:				ae_log_argument_i64,		\
+	unsigned long:		ae_log_argument_u64,		\
+	long long:			ae_log_argument_i64,		\
+	unsigned long long:	ae_log_argument_u64,		\
+	float:				ae_log_argument_f64,		\
+	double:				ae_log_argument_f64,		\
+	char*:				ae_log_argument_string,		\
+	const char*:		ae_log_argument_string,		\
+	default:			ae_log_argument_pointer)(x)
+
+#define AE_LOG_ARGUMENT_COUNT(...) AE_LOG_ARGUMENT_COUNT_(__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0, ~)
+#define AE_LOG_ARGUMENT_COUNT_(fmt, _1, _2, _3, _4, _5, _6, _7, _8, N, ...) N
+
+#define AE_LOG_CONCAT(a, b) AE_LOG_CONCAT_(a, b)
+#define AE_LOG_CONCAT_(a, b) a##b
+
+#define AE_LOG_CAPTURE_0(fmt)
+#define AE_LOG_CAPTURE_1(fmt, a) AE_LOG_ARGUMENT(a)
+#define AE_LOG_CAPTURE_2(fmt, a, ...) AE_LOG_ARGUMENT(a), AE_LOG_CAPTURE_1(fmt, __VA_ARGS__)
+#define AE_LOG_CAPTURE_3(fmt, a, ...) AE_LOG_ARGUMENT(a), AE_LOG_CAPTURE_2(fmt, __VA_ARGS__)
+#define AE_LOG_CAPTURE_4(fmt, a, ...) AE_LOG_ARGUMENT(a), AE_LOG_CAPTURE_3(fmt, __VA_ARGS__)
+#define AE_LOG_CAPTURE_5(fmt, a, ...) AE_LOG_ARGUMENT(a), AE_LOG_CAPTURE_4(fmt, __VA_ARGS__)
+#define AE_LOG_CAPTURE_6(fmt, a, ...) AE_LOG_ARGUMENT(a), AE_LOG_CAPTURE_5(fmt, __VA_ARGS__)
+#define AE_LOG_CAPTURE_7(fmt, a, ...) AE_LOG_ARGUMENT(a), AE_LOG_CAPTURE_6(fmt, __VA_ARGS__)
+#define AE_LOG_CAPTURE_8(fmt, a, ...) AE_LOG_ARGUMENT(a), AE_LOG_CAPTURE_7(fmt, __VA_ARGS__)
+
+/// <summary>
+/// binary log macro, records the call site once and only the raw arguments per call (at most 8).
+/// a constant level below AE_LOG_MIN_LEVEL is removed by the compiler
+/// </summary>
+/// <param name="logger">: logger created with create_binary</param>
+/// <param name="level">: log level of the message</param>
+/// <param name="...">: format string literal followed by the values to pass to the format string</param>
+#define ae_log_binary(logger, level, ...)																				\
+	do {																												\
+		static struct ae_log_site ae_log_site_ = { AE_LOG_FMT(__VA_ARGS__, ~), __FILE__, __LINE__, level, 0, 0, NULL, NULL };	\
+		if ((int32_t)(level) >= AE_LOG_MIN_LEVEL && !(ae_log_site_.flags & AE_LOG_SITE_DISABLED))						\
+		{																												\
+			if (!(ae_log_site_.flags & AE_LOG_SITE_REGISTERED) && !ae_logging_api->register_site(&ae_log_site_))		\
+				break;																									\
+			if ((ae_log_site_.flags & AE_LOG_SITE_LIMITED) && !ae_logging_api->admit_site(&ae_log_site_))				\
+				break;																									\
+			const struct ae_log_argument ae_log_arguments_[] = {														\
+				{ 0 }, AE_LOG_CONCAT(AE_LOG_CAPTURE_, AE_LOG_ARGUMENT_COUNT(__VA_ARGS__))(__VA_ARGS__) };				\
+			ae_logging_api->log_binary(logger, &ae_log_site_, ae_log_arguments_ + 1, AE_LOG_ARGUMENT_COUNT(__VA_ARGS__));\
+		}																												\
+	} while (0)
 
 /**@}*/
@@ -14,6 +14,8 @@
 
 #pragma once
 
+#include <core/types.h>
+
 struct ae_opengl_backend;
 struct ae_camera;
 struct ae_window;
@@ -27,6 +29,15 @@ struct ae_opengl_backend_api
 	void						(*destroy)(struct ae_opengl_backend* backend);
 	void						(*set_window)(struct ae_opengl_backend* backend, struct ae_window* window);
 	void						(*set_debug_callback)(ae_renderer_opengl_debug_callback_fn callback);
+
+	/** @brief size of the frame read_pixels returns, the window size or the headless framebuffer size on linux */
+	void						(*get_framebuffer_size)(struct ae_opengl_backend* backend, uint32_t* width, uint32_t* height);
+
+	/**
+	 * @brief copies the last rendered frame as tightly packed rgba8, bottom row first like glReadPixels
+	 * @return false if size is smaller than width * height * 4
+	 */
+	bool						(*read_pixels)(struct ae_opengl_backend* backend, uint8_t* pixels, const size_t size);
 };
 
 /**@}*/
@@ -0,0 +1,54 @@
+/*****************************************************************//**
+ * @file   render_recorder.h
+ * @ingroup group_api
+ * @brief  Recording of the render api calls made to the null renderer
+ *********************************************************************/
+
+ /**
+ *@addtogroup group_api
+ * @{
+ */
+
+#pragma once
+
+#include "core/types.h"
+
+/** @brief counters of the current recording */
+struct ae_render_recorder_stats
+{
+	/** @brief commands in the recording */
+	uint64_t command_count;
+	/** @brief bytes of the recording without the file header */
+	uint64_t byte_count;
+	/** @brief quads drawn */
+	uint64_t quad_count;
+	/** @brief batch flushes, the draw calls the opengl backend would make without indirect drawing */
+	uint64_t flush_count;
+	/** @brief vertex and instance bytes the flushes would draw */
+	uint64_t vertex_byte_count;
+	/** @brief commands lost because the recording could not grow */
+	uint64_t dropped_count;
+};
+
+/**
+ * @brief the null renderer registers ae_renderer_api, ae_shader_api, ae_texture_api and ae_opengl_backend_api without a gpu.
+ * every call is recorded into memory with the vertices the opengl backend would draw, textures have no texels.
+ * ae_render_replay dumps and replays saved recordings
+ */
+struct ae_render_recorder_api
+{
+	/** @brief drops the recorded commands, the shaders and batches that are alive are recorded again so the recording stays replayable */
+	void			(*reset)(void);
+
+	/** @brief records the vertex bytes of every flush, on by default. vertices are written either way */
+	void			(*set_record_vertices)(const bool enabled);
+
+	/** @brief the recorded commands without the file header, valid until the next render call */
+	const uint8_t*	(*get_data)(size_t* size);
+
+	/** @brief writes the recording with its file header, false if the file could not be written */
+	bool			(*save)(const char* path);
+	void			(*get_stats)(struct ae_render_recorder_stats* stats);
+};
+
+/**@}*/
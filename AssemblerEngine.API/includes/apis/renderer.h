@@ -17,6 +17,8 @@
 #include "core/types.h"
 
 struct ae_render_batch;
+struct ae_render_queue;
+struct ae_static_batch;
 struct ae_camera;
 struct ae_shader;
 
@@ -38,15 +40,262 @@ struct ae_textured_draw_params
 	uint32_t texture;
 };
 
+/** @brief draw parameters of many quads as separate arrays, every array holds one element per quad */
+struct ae_draw_params_soa
+{
+	const float* x;
+	const float* y;
+	const float* z;
+	const float* width;
+	const float* height;
+	const vec4* color;
+};
+
+enum ae_vertex_color_format
+{
+	/** @brief four floats, 16 bytes */
+	AE_VERTEX_COLOR_FLOAT4,
+	/** @brief normalized bytes, 4 bytes */
+	AE_VERTEX_COLOR_RGBA8
+};
+
+enum ae_vertex_texture_coordinate_format
+{
+	/** @brief two floats, 8 bytes */
+	AE_VERTEX_TEXTURE_COORDINATE_FLOAT2,
+	/** @brief two half floats, 4 bytes */
+	AE_VERTEX_TEXTURE_COORDINATE_HALF2,
+	/** @brief two normalized shorts, 4 bytes, coordinates are clamped to [0, 1] */
+	AE_VERTEX_TEXTURE_COORDINATE_UNORM16
+};
+
+enum ae_vertex_texture_unit_format
+{
+	AE_VERTEX_TEXTURE_UNIT_FLOAT,
+	AE_VERTEX_TEXTURE_UNIT_UINT8
+};
+
+/**
+ * @brief vertex layout of a render batch, the shader inputs stay the same for every format.
+ * the default (float color, coordinates and unit) takes 40 bytes per vertex,
+ * rgba8 + half2/unorm16 + uint8 takes 24
+ */
+struct ae_vertex_format
+{
+	enum ae_vertex_color_format					color;
+	enum ae_vertex_texture_coordinate_format	texture_coordinate;
+	enum ae_vertex_texture_unit_format			texture_unit;
+};
+
+/**
+ * @brief how a batch hands its textures to the shader, the texture unit attribute is the index in every mode.
+ * index 0 is a white texture used by untextured draws
+ */
+enum ae_texture_binding
+{
+	/**
+	 * @brief textures are bound to units read through `uniform sampler2D u_textures[]`,
+	 * the batch flushes once every unit is in use
+	 */
+	AE_TEXTURE_BINDING_UNITS,
+	/**
+	 * @brief GL_ARB_bindless_texture handles in a shader storage buffer at binding 1,
+	 * `layout(std430, binding = 1) readonly buffer Textures { sampler2D u_textures[]; };`
+	 */
+	AE_TEXTURE_BINDING_BINDLESS,
+	/**
+	 * @brief textures are copied into the layers of `layout(binding = 0) uniform sampler2DArray u_textureArray;`
+	 * and the index is the layer
+	 */
+	AE_TEXTURE_BINDING_ARRAY
+};
+
+struct ae_texture_binding_desc
+{
+	enum ae_texture_binding binding;
+	/**
+	 * @brief layer size of AE_TEXTURE_BINDING_ARRAY, quads with textures that are not rgba8 are not drawn.
+	 * smaller textures use the top left part of their layer, bigger ones are cropped.
+	 * layers are copied again after a texture changed through ae_texture_api or the atlas,
+	 * textures written with gl directly have to set the binding again
+	 */
+	uint32_t layer_width;
+	uint32_t layer_height;
+	/** @brief at least 2, layer 0 holds the white texture of untextured quads */
+	uint32_t layer_count;
+};
+
+/** @brief what a batch tests its quads against before writing them, the planes come from the camera of render_scene_start or render_set_camera */
+enum ae_cull_mode
+{
+	AE_CULL_NONE,
+	/** @brief the left, right, bottom and top planes, quads at any depth are kept */
+	AE_CULL_RECT,
+	/** @brief the side planes and the near and far planes */
+	AE_CULL_FRUSTUM
+};
+
+/** @brief counters of a render batch since it was created */
+struct ae_render_batch_stats
+{
+	/** @brief times the batch ran full or was ended with quads in it */
+	uint64_t flush_count;
+	/** @brief gl draw calls, one per flush or one per multi draw of the recorded flushes in indirect mode */
+	uint64_t draw_call_count;
+	/** @brief times the cpu had to wait for the gpu to finish reading a vertex buffer region */
+	uint64_t stall_count;
+	/** @brief total time spent waiting in nanoseconds */
+	uint64_t stall_time;
+};
+
+/** @brief counters of the last render_queue_flush */
+struct ae_render_queue_stats
+{
+	/** @brief commands drawn */
+	uint32_t command_count;
+	/** @brief draw calls the batches needed for them */
+	uint32_t draw_call_count;
+	/** @brief commands dropped because the queue could not grow */
+	uint32_t dropped_count;
+	/** @brief time spent sorting in nanoseconds */
+	uint64_t sort_time;
+};
+
+/** @brief gl state changes of the last frame, a frame ends at render_scene_start */
+struct ae_render_state_stats
+{
+	/** @brief gl calls that changed the bound program, blend, depth test, vertex array or textures */
+	uint64_t issued_count;
+	/** @brief calls left out because the state was already set */
+	uint64_t skipped_count;
+};
+
+/** @brief quads of batches with culling enabled in the last frame, a frame ends at render_scene_start */
+struct ae_render_cull_stats
+{
+	/** @brief quads that were written to a batch */
+	uint64_t submitted_count;
+	/** @brief quads left out because they were outside the view */
+	uint64_t culled_count;
+};
+
 struct ae_renderer_api
 {
-	struct ae_render_batch* (*render_batch_create)(struct ae_shader* const shader, const uint32_t max_quad_count);
+	/**
+	 * @brief creates a batch of at most max_quad_count quads per draw call, indices are 32 bit above 16384 quads
+	 * @param [in] format The vertex layout, NULL for full precision floats
+	 */
+	struct ae_render_batch* (*render_batch_create)(struct ae_shader* const shader, const uint32_t max_quad_count, const struct ae_vertex_format* format);
+
+	/**
+	 * @brief creates a batch that uploads one 32 byte instance per quad instead of four vertices
+	 * the shader gets per instance attributes: 0 vec2 position, 1 vec2 size, 2 vec4 texture rect (left, top, right, bottom),
+	 * 3 vec4 color, 4 uint texture unit, 5 float depth and expands them with gl_VertexID (0..3, triangle strip).
+	 * texture coordinates are clamped to [0, 1] and depth to [-1, 1]
+	 */
+	struct ae_render_batch* (*render_batch_create_instanced)(struct ae_shader* const shader, const uint32_t max_quad_count);
 	void					(*render_batch_destroy)(struct ae_render_batch* batch);
+
+	/** @brief AE_TEXTURE_BINDING_BINDLESS when the driver supports it, AE_TEXTURE_BINDING_ARRAY otherwise */
+	enum ae_texture_binding (*render_get_preferred_texture_binding)(void);
+
+	/**
+	 * @brief changes how the batch binds textures, new batches use AE_TEXTURE_BINDING_UNITS.
+	 * the batch is flushed and the shader has to read its textures the new way.
+	 * with bindless handles or layers a texture keeps its index until every index is in use,
+	 * any number of textures fit in one draw call until then
+	 * @return false if the binding is not supported, the batch then keeps using texture units
+	 */
+	bool					(*render_batch_set_texture_binding)(struct ae_render_batch* batch, const struct ae_texture_binding_desc* desc);
+	/** @brief ends the frame and starts the next one with camera, the bound framebuffer is cleared */
 	void					(*render_scene_start)(const struct ae_camera* camera);
+
+	/** @brief render_scene_start without the clear, for frames whose passes clear their own attachments like a frame graph */
+	void					(*render_frame_start)(const struct ae_camera* camera);
+
+	/** @brief changes the camera without ending the frame or clearing, e.g. for the passes of a frame graph */
+	void					(*render_set_camera)(const struct ae_camera* camera);
 	void					(*render_batch_start)(const struct ae_render_batch* batch);
 	void					(*render_batch_end)(struct ae_render_batch* batch);
 	void					(*render_batch_draw)(struct ae_render_batch* batch, struct ae_draw_params* const params);
 	void					(*render_batch_draw_textured)(struct ae_render_batch* batch, struct ae_textured_draw_params* const params);
+
+	/**
+	 * @brief draws count untextured quads, same result as calling render_batch_draw for each of them.
+	 * the capacity of the batch is checked once per chunk instead of once per quad
+	 */
+	void					(*render_batch_draw_many)(struct ae_render_batch* batch, const struct ae_draw_params* params, const uint32_t count);
+
+	/** @brief render_batch_draw_many with the parameters stored as arrays */
+	void					(*render_batch_draw_many_soa)(struct ae_render_batch* batch, const struct ae_draw_params_soa* params, const uint32_t count);
+	/**
+	 * @brief records every flush as a command and draws them with one glMultiDrawElementsIndirect (or
+	 * glMultiDrawArraysIndirect) call when the batch ends or runs out of vertex buffer regions.
+	 * the vertex buffer of an indirect batch holds AE_RENDER_BATCH_INDIRECT_REGION_COUNT regions of max_quad_count quads.
+	 * with texture units the call also ends when the units run out, use bindless handles or a texture array
+	 * to get one draw call per batch and frame
+	 */
+	void					(*render_batch_set_indirect)(struct ae_render_batch* batch, const bool enabled);
+
+	/**
+	 * @brief tests every quad drawn to the batch against the view of the camera, quads completely outside are dropped.
+	 * a quad covers position to position + size at the depth of its position, sizes must not be negative.
+	 * quads whose params name a camera with another view projection than the current one are never dropped.
+	 * new batches use AE_CULL_NONE
+	 */
+	void					(*render_batch_set_culling)(struct ae_render_batch* batch, const enum ae_cull_mode mode);
+	void					(*render_get_state_stats)(struct ae_render_state_stats* stats);
+	void					(*render_get_cull_stats)(struct ae_render_cull_stats* stats);
+	void					(*render_batch_get_stats)(const struct ae_render_batch* batch, struct ae_render_batch_stats* stats);
+
+	/**
+	 * @brief creates a queue that records draws of a frame and submits them sorted to their batches.
+	 * commands are ordered by layer, batch, blend, texture and depth (lowest first).
+	 * recording makes no gl calls and touches no shared state, a queue per worker thread can be filled
+	 * in parallel and merged into the queue that is flushed on the gl thread
+	 */
+	struct ae_render_queue* (*render_queue_create)(const uint32_t initial_capacity);
+	void					(*render_queue_destroy)(struct ae_render_queue* queue);
+
+	/**
+	 * @brief records an untextured quad drawn with batch
+	 * @param [in] layer Most significant part of the order
+	 * @param [in] blend Groups commands of one layer and batch, only the lowest 4 bits are used
+	 */
+	void					(*render_queue_submit)(struct ae_render_queue* queue, struct ae_render_batch* batch, const uint8_t layer, const uint8_t blend, const struct ae_draw_params* params);
+	void					(*render_queue_submit_textured)(struct ae_render_queue* queue, struct ae_render_batch* batch, const uint8_t layer, const uint8_t blend, const struct ae_textured_draw_params* params);
+
+	/**
+	 * @brief moves the commands of source to the end of queue and empties source.
+	 * neither queue may be used by another thread during the merge, equal keys keep the order of the merges
+	 */
+	void					(*render_queue_merge)(struct ae_render_queue* queue, struct ae_render_queue* source);
+
+	/** @brief drops every recorded command */
+	void					(*render_queue_reset)(struct ae_render_queue* queue);
+
+	/** @brief sorts and draws every recorded command and empties the queue, starts and ends the batches it uses */
+	void					(*render_queue_flush)(struct ae_render_queue* queue);
+	void					(*render_queue_get_stats)(const struct ae_render_queue* queue, struct ae_render_queue_stats* stats);
+
+	/**
+	 * @brief writes the quads once into gpu storage that is drawn every frame without being written again.
+	 * textures are bound to units like a new render batch, quads are split into one draw call per set of units
+	 * @param [in] format The vertex layout, NULL for full precision floats
+	 * @param [in] updatable Allows render_static_batch_update, the storage is immutable otherwise
+	 */
+	struct ae_static_batch* (*render_static_batch_create)(struct ae_shader* const shader, const struct ae_textured_draw_params* params, const uint32_t count, const struct ae_vertex_format* format, const bool updatable);
+	void					(*render_static_batch_destroy)(struct ae_static_batch* batch);
+
+	/**
+	 * @brief replaces the quads [first, first + count), only the changed range is uploaded
+	 * @return false if the batch is not updatable, the range is out of bounds or a new texture
+	 * does not fit in the units of the draw call its quad belongs to
+	 */
+	bool					(*render_static_batch_update)(struct ae_static_batch* batch, const uint32_t first, const struct ae_textured_draw_params* params, const uint32_t count);
+
+	/** @brief draws every quad of the batch right away, call it between batches and not between render_batch_start and render_batch_end */
+	void					(*render_static_batch_draw)(struct ae_static_batch* batch);
 };
 
 /**@}*/
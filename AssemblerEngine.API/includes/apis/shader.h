@@ -25,13 +25,53 @@ struct ae_shader
 	int32_t id;
 };
 
+/** @brief program creation counters since startup */
+struct ae_shader_cache_stats
+{
+	/** @brief programs loaded from a cached binary */
+	uint32_t hit_count;
+	/** @brief programs compiled from source */
+	uint32_t miss_count;
+	/** @brief cached binaries the driver refused, their programs were compiled again and the binary replaced */
+	uint32_t rejected_count;
+	/** @brief nanoseconds spent creating programs from cached binaries, the warm startup cost */
+	uint64_t load_time;
+	/** @brief nanoseconds spent compiling and linking, the cold startup cost */
+	uint64_t compile_time;
+};
+
+/** @brief called by poll_async once a program of create_async is done, shader is NULL and error has the log if it failed */
+typedef void (*ae_shader_ready_callback)(struct ae_shader* shader, const char* error, void* user_data);
+
 struct ae_shader_api
 {
-	struct ae_shader*	(*create)(char* debug_output, int32_t debug_output_size, char** stage_sources, int32_t* stage_sizes, int32_t* stage_types, int32_t stage_count);
+	struct ae_shader*	(*create)(char* debug_output, int32_t debug_output_size, const char** stage_sources, const int32_t* stage_sizes, const int32_t* stage_types, int32_t stage_count);
 	struct ae_shader*	(*create_basic)(char* debug_output, int32_t debug_output_size, const char* vertex_shader, const char* fragment_shader);
 	void				(*set_view_projection)(mat4 view_projection);
 	void				(*set_blending)(struct ae_shader* shader, bool enable, uint32_t source, uint32_t destination);
 	void				(*set_depth_test)(struct ae_shader* shader, bool enable);
+
+	/**
+	 * @brief directory linked programs are cached in, keyed by their sources and the driver.
+	 * defaults to "shader_cache" next to the executable, a relative path starts at the working directory. NULL turns the cache off
+	 * @return false if the path is too long, the previous directory stays in use
+	 */
+	bool				(*set_cache_directory)(const char* directory);
+	void				(*get_cache_stats)(struct ae_shader_cache_stats* stats);
+
+	/**
+	 * @brief starts creating a program without waiting for the compiler, the sources are copied.
+	 * with GL_KHR_parallel_shader_compile the driver compiles all submitted programs on its own threads,
+	 * without it poll_async compiles one program per call
+	 * @return false if the program was not submitted, the callback is not called then
+	 */
+	bool				(*create_async)(const char** stage_sources, const int32_t* stage_sizes, const int32_t* stage_types, int32_t stage_count, ae_shader_ready_callback callback, void* user_data);
+
+	/**
+	 * @brief calls the callbacks of the programs that are done, never waits on the driver when it compiles in parallel
+	 * @return programs still compiling
+	 */
+	uint32_t			(*poll_async)(void);
 };
 
 /**@}*/
@@ -0,0 +1,121 @@
+/*****************************************************************//**
+ * @file   texture.h
+ * @ingroup group_api
+ * @brief  Texture API, textures are filled from staging memory without blocking the frame
+ *********************************************************************/
+
+ /**
+ *@addtogroup group_api
+ * @{
+ */
+
+#pragma once
+
+#include "core/types.h"
+
+/** @brief pixel formats of a texture, the pixels of an upload are tightly packed rows of this format */
+enum ae_texture_format
+{
+	/** @brief 4 bytes per pixel */
+	AE_TEXTURE_FORMAT_RGBA8,
+	/** @brief 1 byte per pixel, read as red by the shader */
+	AE_TEXTURE_FORMAT_R8
+};
+
+struct ae_texture_desc
+{
+	uint32_t				width;
+	uint32_t				height;
+	enum ae_texture_format	format;
+	/** @brief levels of storage, 0 makes the full chain down to 1x1 */
+	uint32_t				mip_count;
+	/** @brief the smaller levels are generated from level 0 after every upload to it */
+	bool					generate_mips;
+};
+
+/** @brief fields are set by create and must not change */
+struct ae_texture
+{
+	/** @brief gl name of the texture, the texture of ae_textured_draw_params */
+	uint32_t				id;
+	uint32_t				width;
+	uint32_t				height;
+	uint32_t				mip_count;
+	enum ae_texture_format	format;
+	bool					generate_mips;
+};
+
+/** @brief result of begin_upload */
+enum ae_texture_upload_result
+{
+	/** @brief the staging memory of the upload is handed out, end_upload has to follow */
+	AE_TEXTURE_UPLOAD_OK,
+	/** @brief no texture, the level does not exist or the region is empty or outside of the level */
+	AE_TEXTURE_UPLOAD_INVALID,
+	/** @brief the staging memory or the upload slots are used up, try again after the next frame */
+	AE_TEXTURE_UPLOAD_FULL,
+	/** @brief the region is bigger than the whole staging memory (staging_size of the stats) and never fits, upload it in parts */
+	AE_TEXTURE_UPLOAD_TOO_LARGE
+};
+
+/** @brief a part of the staging memory handed out by begin_upload */
+struct ae_texture_upload
+{
+	/** @brief where the pixels of the region are written, rows are tightly packed */
+	uint8_t*	pixels;
+	/** @brief bytes of the region */
+	size_t		size;
+	/** @brief identifies the upload for end_upload */
+	uint32_t	slot;
+};
+
+/** @brief upload counters, the frame values are of the last frame */
+struct ae_texture_stats
+{
+	/** @brief bytes copied into textures in the last frame */
+	uint64_t	uploaded_bytes;
+	/** @brief uploads copied into textures in the last frame */
+	uint32_t	committed_count;
+	/** @brief uploads begun but not yet copied */
+	uint32_t	pending_count;
+	/** @brief staging bytes in use, including uploads the gpu has not read yet */
+	uint64_t	staging_used;
+	/** @brief bytes of the whole staging memory, the largest region a single upload can hold */
+	uint64_t	staging_size;
+	/** @brief begin_upload calls that failed because the staging memory or upload slots were used up, since startup */
+	uint64_t	full_count;
+};
+
+/**
+ * @brief textures with a persistent mapped staging ring. begin_upload reserves staging memory, any thread
+ * writes the pixels and calls end_upload, the render thread copies finished uploads at render_scene_start
+ * until the byte budget of the frame is used. staging memory is reused once the gpu has read it
+ */
+struct ae_texture_api
+{
+	/** @brief allocates the storage, the contents are undefined until the first upload is done. render thread only */
+	struct ae_texture*	(*create)(const struct ae_texture_desc* desc);
+
+	/** @brief uploads that did not finish are dropped. render thread only */
+	void				(*destroy)(struct ae_texture* texture);
+
+	/**
+	 * @brief reserves staging memory for a region of a level, safe to call from any thread.
+	 * a region takes width * height * pixel size bytes, at most staging_size of the stats (32 MiB in the opengl backend
+	 * unless AE_TEXTURE_STAGING_SIZE is changed), bigger regions are refused with AE_TEXTURE_UPLOAD_TOO_LARGE
+	 * @return AE_TEXTURE_UPLOAD_OK if upload was filled in
+	 */
+	enum ae_texture_upload_result (*begin_upload)(struct ae_texture* texture, const uint32_t level, const uint32_t x, const uint32_t y, const uint32_t width, const uint32_t height, struct ae_texture_upload* upload);
+
+	/** @brief the pixels are written, the upload is copied during one of the next frames. safe to call from any thread */
+	void				(*end_upload)(const struct ae_texture_upload* upload);
+
+	/** @brief true once every upload begun for the texture was copied into it */
+	bool				(*is_ready)(const struct ae_texture* texture);
+
+	/** @brief bytes copied per frame, at least one upload is copied every frame however big it is */
+	void				(*set_upload_budget)(const uint64_t bytes_per_frame);
+	void				(*get_stats)(struct ae_texture_stats* stats);
+};
+
+/**@}*/
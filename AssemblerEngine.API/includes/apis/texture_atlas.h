@@ -0,0 +1,86 @@
+/*****************************************************************//**
+ * @file   texture_atlas.h
+ * @ingroup group_api
+ * @brief  Texture atlas API, packs small images into a few shared textures
+ *********************************************************************/
+
+ /**
+ *@addtogroup group_api
+ * @{
+ */
+
+#pragma once
+
+#include "core/types.h"
+#include "apis/texture.h"
+
+/** @brief opaque atlas object */
+struct ae_texture_atlas;
+
+struct ae_texture_atlas_desc
+{
+	/** @brief size of every page texture */
+	uint32_t				page_width;
+	uint32_t				page_height;
+	enum ae_texture_format	format;
+	/** @brief insert fails once every page is full, 0 means no limit */
+	uint32_t				max_page_count;
+	/** @brief empty pixels kept around every image so filtering does not pick up its neighbours */
+	uint32_t				padding;
+};
+
+/** @brief where an image was placed */
+struct ae_texture_atlas_entry
+{
+	/** @brief identifies the image for remove, never 0 */
+	uint32_t	id;
+	/** @brief gl name of the page, the texture of ae_textured_draw_params */
+	uint32_t	texture;
+	uint32_t	page;
+	/** @brief pixel rect of the image in the page, without padding */
+	uint32_t	x;
+	uint32_t	y;
+	uint32_t	width;
+	uint32_t	height;
+	/** @brief the texture coordinates of ae_textured_draw_params, same corner order as a full texture */
+	vec2		texture_coordinates[4];
+};
+
+struct ae_texture_atlas_stats
+{
+	uint32_t	page_count;
+	uint32_t	entry_count;
+	/** @brief pixels taken by images and their padding */
+	uint64_t	used_area;
+	/** @brief pixels of all pages */
+	uint64_t	page_area;
+};
+
+/**
+ * @brief shelf packed atlas pages on top of ae_texture_api, images can be inserted and removed at any time.
+ * the pixels of an insert are streamed like any other upload, the entry can be drawn once the page is ready.
+ * render thread only
+ */
+struct ae_texture_atlas_api
+{
+	/** @brief pages are created when the ones there are full */
+	struct ae_texture_atlas*	(*create)(const struct ae_texture_atlas_desc* desc);
+	void						(*destroy)(struct ae_texture_atlas* atlas);
+
+	/**
+	 * @brief places an image and uploads its pixels
+	 * @param [in] pixels Tightly packed rows in the format of the atlas, NULL only reserves the space.
+	 * the pixels can then be uploaded to the page with ae_texture_api at the x and y of the entry
+	 * @return false if the image does not fit in a page, the page limit was reached or the staging memory is full
+	 */
+	bool						(*insert)(struct ae_texture_atlas* atlas, const uint32_t width, const uint32_t height, const uint8_t* pixels, struct ae_texture_atlas_entry* entry);
+
+	/** @brief frees the space of the image, uploads to it that were not copied yet are dropped. the page keeps its pixels until the space is used again */
+	void						(*remove)(struct ae_texture_atlas* atlas, const uint32_t id);
+
+	/** @brief the texture of a page, to upload pixels of entries inserted without them */
+	struct ae_texture*			(*get_page)(struct ae_texture_atlas* atlas, const uint32_t page);
+	void						(*get_stats)(const struct ae_texture_atlas* atlas, struct ae_texture_atlas_stats* stats);
+};
+
+/**@}*/
@@ -0,0 +1,153 @@
+/*****************************************************************//**
+ * @file   atomic.h
+ * @ingroup group_api
+ * @brief  Minimal set of atomic operations shared by the plugins
+ *
+ * @author RickNijhuis
+ * @date   May 2022
+ *********************************************************************/
+
+ /**
+ *@addtogroup group_api
+ * @{
+ */
+
+#pragma once
+
+#include "core/core.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+
+AE_INLINE uint32_t ae_atomic_load_u32(volatile uint32_t* ptr)
+{
+	return (uint32_t)_InterlockedCompareExchange((volatile long*)ptr, 0, 0);
+}
+
+AE_INLINE void ae_atomic_store_u32(volatile uint32_t* ptr, const uint32_t value)
+{
+	_InterlockedExchange((volatile long*)ptr, (long)value);
+}
+
+AE_INLINE uint32_t ae_atomic_exchange_u32(volatile uint32_t* ptr, const uint32_t value)
+{
+	return (uint32_t)_InterlockedExchange((volatile long*)ptr, (long)value);
+}
+
+AE_INLINE uint32_t ae_atomic_add_u32(volatile uint32_t* ptr, const uint32_t value)
+{
+	return (uint32_t)_InterlockedExchangeAdd((volatile long*)ptr, (long)value);
+}
+
+AE_INLINE bool ae_atomic_cas_u32(volatile uint32_t* ptr, const uint32_t expected, const uint32_t desired)
+{
+	return (uint32_t)_InterlockedCompareExchange((volatile long*)ptr, (long)desired, (long)expected) == expected;
+}
+
+AE_INLINE uint64_t ae_atomic_load_u64(volatile uint64_t* ptr)
+{
+	return (uint64_t)_InterlockedCompareExchange64((volatile long long*)ptr, 0, 0);
+}
+
+AE_INLINE uint64_t ae_atomic_exchange_u64(volatile uint64_t* ptr, const uint64_t value)
+{
+	uint64_t old;
+
+	do
+	{
+		old = ae_atomic_load_u64(ptr);
+	} while ((uint64_t)_InterlockedCompareExchange64((volatile long long*)ptr, (long long)value, (long long)old) != old);
+
+	return old;
+}
+
+AE_INLINE uint64_t ae_atomic_add_u64(volatile uint64_t* ptr, const uint64_t value)
+{
+	uint64_t old;
+
+	do
+	{
+		old = ae_atomic_load_u64(ptr);
+	} while ((uint64_t)_InterlockedCompareExchange64((volatile long long*)ptr, (long long)(old + value), (long long)old) != old);
+
+	return old;
+}
+
+AE_INLINE bool ae_atomic_cas_u64(volatile uint64_t* ptr, const uint64_t expected, const uint64_t desired)
+{
+	return (uint64_t)_InterlockedCompareExchange64((volatile long long*)ptr, (long long)desired, (long long)expected) == expected;
+}
+
+AE_INLINE void* ae_atomic_load_ptr(void* volatile* ptr)
+{
+	return _InterlockedCompareExchangePointer(ptr, NULL, NULL);
+}
+
+AE_INLINE void ae_atomic_store_ptr(void* volatile* ptr, void* value)
+{
+	_InterlockedExchangePointer(ptr, value);
+}
+
+#elif defined(__GNUC__)
+
+AE_INLINE uint32_t ae_atomic_load_u32(volatile uint32_t* ptr)
+{
+	return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+AE_INLINE void ae_atomic_store_u32(volatile uint32_t* ptr, const uint32_t value)
+{
+	__atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+}
+
+AE_INLINE uint32_t ae_atomic_exchange_u32(volatile uint32_t* ptr, const uint32_t value)
+{
+	return __atomic_exchange_n(ptr, value, __ATOMIC_ACQ_REL);
+}
+
+AE_INLINE uint32_t ae_atomic_add_u32(volatile uint32_t* ptr, const uint32_t value)
+{
+	return __atomic_fetch_add(ptr, value, __ATOMIC_ACQ_REL);
+}
+
+AE_INLINE bool ae_atomic_cas_u32(volatile uint32_t* ptr, uint32_t expected, const uint32_t desired)
+{
+	return __atomic_compare_exchange_n(ptr, &expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+AE_INLINE uint64_t ae_atomic_load_u64(volatile uint64_t* ptr)
+{
+	return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+AE_INLINE uint64_t ae_atomic_exchange_u64(volatile uint64_t* ptr, const uint64_t value)
+{
+	return __atomic_exchange_n(ptr, value, __ATOMIC_ACQ_REL);
+}
+
+AE_INLINE uint64_t ae_atomic_add_u64(volatile uint64_t* ptr, const uint64_t value)
+{
+	return __atomic_fetch_add(ptr, value, __ATOMIC_ACQ_REL);
+}
+
+AE_INLINE bool ae_atomic_cas_u64(volatile uint64_t* ptr, uint64_t expected, const uint64_t desired)
+{
+	return __atomic_compare_exchange_n(ptr, &expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+AE_INLINE void* ae_atomic_load_ptr(void* volatile* ptr)
+{
+	return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+AE_INLINE void ae_atomic_store_ptr(void* volatile* ptr, void* value)
+{
+	__atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+}
+
+#endif
+
+/**@}*/
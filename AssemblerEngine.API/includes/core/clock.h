@@ -0,0 +1,49 @@
+/*****************************************************************//**
+ * @file   clock.h
+ * @ingroup group_api
+ * @brief  Monotonic clock for measuring durations
+ *
+ * @author RickNijhuis
+ * @date   May 2022
+ *********************************************************************/
+
+ /**
+ *@addtogroup group_api
+ * @{
+ */
+
+#pragma once
+
+#include "core/core.h"
+#include "core/os.h"
+
+#include <stdint.h>
+
+#ifndef _WIN32
+#include <time.h>
+#endif // !_WIN32
+
+/** @brief monotonic time in nanoseconds, only meaningful as a difference between two calls */
+AE_INLINE uint64_t ae_clock_now()
+{
+#ifdef _WIN32
+	LARGE_INTEGER counter;
+	LARGE_INTEGER frequency;
+
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+
+	uint64_t ticks = (uint64_t)counter.QuadPart;
+	uint64_t ticks_per_second = (uint64_t)frequency.QuadPart;
+
+	// split to keep the multiplication from overflowing
+	return ticks / ticks_per_second * 1000000000ull + ticks % ticks_per_second * 1000000000ull / ticks_per_second;
+#else
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+#endif // _WIN32
+}
+
+/**@}*/
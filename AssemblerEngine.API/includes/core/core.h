@@ -21,7 +21,7 @@
 #elif defined(__GNUC__)
 //  GCC
 #define AE_DLL_EXPORT __attribute__((visibility("default")))
-define AE_INLINE static inline __attribute((always_inline))
+#define AE_INLINE static inline __attribute((always_inline))
 #else
 //  do nothing and hope for the best?
 #define AE_DLL_EXPORT
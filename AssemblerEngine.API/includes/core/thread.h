@@ -0,0 +1,136 @@
+/*****************************************************************//**
+ * @file   thread.h
+ * @ingroup group_api
+ * @brief  Thin wrapper around the native threads of the platform
+ *********************************************************************/
+
+ /**
+ *@addtogroup group_api
+ * @{
+ */
+
+#pragma once
+
+#include "core/core.h"
+#include "core/os.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#endif // !_WIN32
+
+#if defined(_MSC_VER)
+#define AE_THREAD_LOCAL __declspec(thread)
+#else
+#define AE_THREAD_LOCAL __thread
+#endif
+
+typedef void (*ae_thread_fn)(void* data);
+
+struct ae_thread
+{
+#ifdef _WIN32
+	HANDLE		handle;
+#else
+	pthread_t	handle;
+#endif // _WIN32
+};
+
+struct ae_thread_start
+{
+	ae_thread_fn	function;
+	void*			data;
+};
+
+#ifdef _WIN32
+static inline DWORD WINAPI ae_thread_entry(LPVOID param)
+#else
+static inline void* ae_thread_entry(void* param)
+#endif // _WIN32
+{
+	struct ae_thread_start start = *(struct ae_thread_start*)param;
+	free(param);
+
+	start.function(start.data);
+
+#ifdef _WIN32
+	return 0;
+#else
+	return NULL;
+#endif // _WIN32
+}
+
+/**
+ * @brief starts a new native thread running function(data)
+ * @param [out] thread The thread handle to initialize
+ * @param [in] function The function to run on the new thread
+ * @param [in] data The user data passed to function
+ * @return true if the thread was started
+ */
+AE_INLINE bool ae_thread_create(struct ae_thread* thread, ae_thread_fn function, void* data)
+{
+	struct ae_thread_start* start = malloc(sizeof(*start));
+
+	if (!start)
+		return false;
+
+	start->function = function;
+	start->data = data;
+
+#ifdef _WIN32
+	thread->handle = CreateThread(NULL, 0, ae_thread_entry, start, 0, NULL);
+
+	if (!thread->handle)
+	{
+		free(start);
+		return false;
+	}
+#else
+	if (pthread_create(&thread->handle, NULL, ae_thread_entry, start) != 0)
+	{
+		free(start);
+		return false;
+	}
+#endif // _WIN32
+
+	return true;
+}
+
+/** @brief blocks until the thread has returned and releases its handle */
+AE_INLINE void ae_thread_join(struct ae_thread* thread)
+{
+#ifdef _WIN32
+	WaitForSingleObject(thread->handle, INFINITE);
+	CloseHandle(thread->handle);
+#else
+	pthread_join(thread->handle, NULL);
+#endif // _WIN32
+}
+
+/** @brief gives the remainder of the time slice to another thread */
+AE_INLINE void ae_thread_yield()
+{
+#ifdef _WIN32
+	SwitchToThread();
+#else
+	sched_yield();
+#endif // _WIN32
+}
+
+/** @brief suspends the calling thread for at least the given amount of milliseconds */
+AE_INLINE void ae_thread_sleep(const uint32_t milliseconds)
+{
+#ifdef _WIN32
+	Sleep(milliseconds);
+#else
+	struct timespec duration = { .tv_sec = milliseconds / 1000, .tv_nsec = (milliseconds % 1000) * 1000000L };
+	nanosleep(&duration, NULL);
+#endif // _WIN32
+}
+
+/**@}*/
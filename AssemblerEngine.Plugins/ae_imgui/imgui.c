@@ -75,7 +75,7 @@ static void ae_imgui_init(struct ae_window* window)
 	vector_viewport_push_back(&context.viewport_stack, main_viewport);
 
 	char output[256];
-	struct ae_shader* shader = shader_api->create_basic(output, 256, default_vertex, default_fragment);
+	struct ae_shader* shader = shader_api->create_basic(output, 256, instanced_vertex, default_fragment);
 
 	if (!shader)
 	{
@@ -83,7 +83,7 @@ static void ae_imgui_init(struct ae_window* window)
 		return;
 	}
 
-	render_batch = render_api->render_batch_create(shader, 4096);
+	render_batch = render_api->render_batch_create_instanced(shader, 4096);
 	camera = camera_api->create_orthographic((vec3)
 	{
 		0, 0, 0
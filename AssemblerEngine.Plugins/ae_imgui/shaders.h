@@ -12,7 +12,7 @@ mat4 viewProjection;\n\
 \n\
 out vec4 v_color;\n\
 out vec2 v_textureCoordinate;\n\
-out float v_textureUnit;\n\
+flat out float v_textureUnit;\n\
 \n\
 void main()\n\
 {\
@@ -23,6 +23,35 @@ void main()\n\
 	gl_Position = viewProjection * vec4(a_position, 1.0);\n\
 };";
 
+const char* instanced_vertex = "\
+#version 430\n\
+layout(location = 0) in vec2 a_position;\n\
+layout(location = 1) in vec2 a_size;\n\
+layout(location = 2) in vec4 a_textureRect;\n\
+layout(location = 3) in vec4 a_color;\n\
+layout(location = 4) in uint a_textureUnit;\n\
+layout(location = 5) in float a_depth;\n\
+\n\
+layout (std140, binding = 0) uniform ViewProjection \n\
+{\n\
+mat4 viewProjection;\n\
+};\n\
+\n\
+out vec4 v_color;\n\
+out vec2 v_textureCoordinate;\n\
+flat out float v_textureUnit;\n\
+\n\
+void main()\n\
+{\
+	vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);\n\
+\n\
+	v_color = a_color;\n\
+	v_textureCoordinate = vec2(mix(a_textureRect.x, a_textureRect.z, corner.x), mix(a_textureRect.y, a_textureRect.w, 1.0 - corner.y));\n\
+	v_textureUnit = float(a_textureUnit);\n\
+\n\
+	gl_Position = viewProjection * vec4(a_position + corner * a_size, a_depth, 1.0);\n\
+};";
+
 const char* default_fragment = "\
 #version 430\n\
 \n\
@@ -32,7 +61,7 @@ uniform sampler2D u_textures[32];\n\
 \n\
 in vec4 v_color;\n\
 in vec2 v_textureCoordinate;\n\
-in float v_textureUnit;\n\
+flat in float v_textureUnit;\n\
 \n\
 void main()\n\
 {\n\
@@ -42,4 +71,42 @@ void main()\n\
 	// o_color = sampled * v_color;\n\
 \n\
 	o_color = texture(u_textures[index], v_textureCoordinate) * v_color;\n\
-};";
\ No newline at end of file
+};";
+
+// default_fragment for batches using AE_TEXTURE_BINDING_BINDLESS
+const char* bindless_fragment = "\
+#version 430\n\
+#extension GL_ARB_bindless_texture : require\n\
+\n\
+layout(location = 0) out vec4 o_color;\n\
+\n\
+layout(std430, binding = 1) readonly buffer Textures\n\
+{\n\
+	sampler2D u_textures[];\n\
+};\n\
+\n\
+in vec4 v_color;\n\
+in vec2 v_textureCoordinate;\n\
+flat in float v_textureUnit;\n\
+\n\
+void main()\n\
+{\n\
+	o_color = texture(u_textures[int(v_textureUnit)], v_textureCoordinate) * v_color;\n\
+};";
+
+// default_fragment for batches using AE_TEXTURE_BINDING_ARRAY
+const char* array_fragment = "\
+#version 430\n\
+\n\
+layout(location = 0) out vec4 o_color;\n\
+\n\
+layout(binding = 0) uniform sampler2DArray u_textureArray;\n\
+\n\
+in vec4 v_color;\n\
+in vec2 v_textureCoordinate;\n\
+flat in float v_textureUnit;\n\
+\n\
+void main()\n\
+{\n\
+	o_color = texture(u_textureArray, vec3(v_textureCoordinate, v_textureUnit)) * v_color;\n\
+};";
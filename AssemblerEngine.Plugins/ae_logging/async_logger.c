@@ -0,0 +1,484 @@
+#ifndef _WIN32
+// sigaction
+#define _GNU_SOURCE
+#endif // !_WIN32
+
+#include "logger.h"
+#include "log_clock.h"
+
+#include <core/atomic.h>
+#include <core/thread.h>
+
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <io.h>
+#define AE_LOG_WRITE(descriptor, data, size) _write(descriptor, data, (unsigned int)(size))
+#else
+#include <unistd.h>
+#define AE_LOG_WRITE(descriptor, data, size) write(descriptor, data, size)
+#endif // _WIN32
+
+// record size is 256 bytes with the default message length
+#ifndef AE_LOG_MESSAGE_MAX_LENGTH
+#define AE_LOG_MESSAGE_MAX_LENGTH 224
+#endif // !AE_LOG_MESSAGE_MAX_LENGTH
+
+#ifndef AE_LOG_WRITER_BATCH_SIZE
+#define AE_LOG_WRITER_BATCH_SIZE 256
+#endif // !AE_LOG_WRITER_BATCH_SIZE
+
+#ifndef AE_MAX_ASYNC_LOGGERS
+#define AE_MAX_ASYNC_LOGGERS 8
+#endif // !AE_MAX_ASYNC_LOGGERS
+
+// amount of tries before the crash handler drains the queue without owning it
+#define AE_LOG_CRASH_FLUSH_ATTEMPTS 4096
+
+// a line written by the crash handler, longer file paths and messages are cut
+#define AE_LOG_CRASH_LINE_LENGTH (AE_LOG_MESSAGE_MAX_LENGTH + 256)
+
+struct ae_async_log_record
+{
+	volatile uint32_t sequence;
+	enum ae_log_levels level;
+	int32_t line;
+	const char* file;
+	uint64_t ticks;
+	char message[AE_LOG_MESSAGE_MAX_LENGTH];
+};
+
+// bounded multi producer single consumer queue, every record carries a sequence number
+// telling producers and the consumer whose turn it is to touch the record.
+struct ae_async_log_queue
+{
+	struct ae_async_log_record* records;
+	struct ae_thread writer;
+	volatile uint64_t dropped_count;
+	uint64_t reported_dropped_count;
+	volatile uint32_t write_index;
+	volatile uint32_t read_index;
+	volatile uint32_t draining;
+	volatile uint32_t running;
+	uint32_t mask;
+	enum ae_log_backpressure backpressure;
+};
+
+static const struct ae_logger* async_loggers[AE_MAX_ASYNC_LOGGERS] = { 0 };
+static uint32_t async_logger_count = 0;
+static bool crash_handler_installed = false;
+
+static const int crash_signals[] = { SIGSEGV, SIGABRT, SIGFPE, SIGILL };
+
+// the handlers of the host, called after the queues were written
+#ifdef _WIN32
+typedef void (*ae_signal_handler)(int);
+static ae_signal_handler previous_handlers[sizeof(crash_signals) / sizeof(crash_signals[0])];
+#else
+static struct sigaction previous_actions[sizeof(crash_signals) / sizeof(crash_signals[0])];
+#endif // _WIN32
+
+static bool ae_async_logger_try_lock(struct ae_async_log_queue* queue)
+{
+	return ae_atomic_cas_u32(&queue->draining, 0, 1);
+}
+
+static void ae_async_logger_unlock(struct ae_async_log_queue* queue)
+{
+	ae_atomic_store_u32(&queue->draining, 0);
+}
+
+static void ae_async_logger_report_dropped(const struct ae_logger* logger)
+{
+	struct ae_async_log_queue* queue = logger->queue;
+	uint64_t dropped = ae_atomic_load_u64(&queue->dropped_count);
+
+	if (dropped == queue->reported_dropped_count)
+		return;
+
+	char message[64];
+	snprintf(message, sizeof(message), "dropped %llu log messages", (unsigned long long)(dropped - queue->reported_dropped_count));
+	queue->reported_dropped_count = dropped;
+
+	struct ae_logger_event event = {
+	.message = message,
+	.file = __FILE__,
+	.line = __LINE__,
+	.level = LEVEL_WARN,
+	.ticks = ae_log_clock_ticks()
+	};
+
+	ae_logger_write_to_sinks(logger, &event);
+}
+
+// must only be called by the owner of the draining flag
+static uint32_t ae_async_logger_drain(const struct ae_logger* logger)
+{
+	struct ae_async_log_queue* queue = logger->queue;
+	struct ae_logger_event event = { 0 };
+	uint32_t position = queue->read_index;
+	uint32_t count = 0;
+
+	while (count < AE_LOG_WRITER_BATCH_SIZE)
+	{
+		struct ae_async_log_record* record = &queue->records[position & queue->mask];
+
+		if ((int32_t)(ae_atomic_load_u32(&record->sequence) - (position + 1)) < 0)
+			break;
+
+		event.message = record->message;
+		event.file = record->file;
+		event.line = record->line;
+		event.level = record->level;
+		event.ticks = record->ticks;
+
+		ae_logger_write_to_sinks(logger, &event);
+
+		ae_atomic_store_u32(&record->sequence, position + queue->mask + 1);
+		position++;
+		count++;
+	}
+
+	ae_atomic_store_u32(&queue->read_index, position);
+	ae_async_logger_report_dropped(logger);
+
+	if (count)
+		ae_logger_flush_sinks(logger);
+
+	return count;
+}
+
+static void ae_async_logger_writer(void* data)
+{
+	const struct ae_logger* logger = data;
+	struct ae_async_log_queue* queue = logger->queue;
+
+	while (ae_atomic_load_u32(&queue->running))
+	{
+		uint32_t count = 0;
+
+		if (ae_async_logger_try_lock(queue))
+		{
+			count = ae_async_logger_drain(logger);
+			ae_async_logger_unlock(queue);
+		}
+
+		if (count == 0)
+			ae_thread_sleep(1);
+	}
+}
+
+//
+// crash handler, only async signal safe calls from here on: no stdio, no allocations and no locks
+//
+
+static size_t ae_async_logger_append(char* line, size_t length, const char* string)
+{
+	while (*string && length < AE_LOG_CRASH_LINE_LENGTH - 1)
+		line[length++] = *string++;
+
+	return length;
+}
+
+static size_t ae_async_logger_append_number(char* line, size_t length, uint32_t number)
+{
+	char digits[10];
+	uint32_t count = 0;
+
+	do
+	{
+		digits[count++] = (char)('0' + number % 10);
+		number /= 10;
+	} while (number);
+
+	while (count && length < AE_LOG_CRASH_LINE_LENGTH - 1)
+		line[length++] = digits[--count];
+
+	return length;
+}
+
+// the record is formatted on the stack and written to the descriptors of the console and file sinks.
+// mapped file sinks are left out, the crashing thread may hold their lock
+static void ae_async_logger_write_on_crash(const struct ae_logger* logger, const struct ae_async_log_record* record)
+{
+	static const char* level_strings[] = {
+		"TRACE ", "DEBUG ", "INFO  ", "WARN  ", "ERROR ", "FATAL "
+	};
+
+	char line[AE_LOG_CRASH_LINE_LENGTH];
+	size_t length = ae_async_logger_append(line, 0, (uint32_t)record->level < 6 ? level_strings[record->level] : "?     ");
+
+	length = ae_async_logger_append(line, length, record->file);
+	length = ae_async_logger_append(line, length, ":");
+	length = ae_async_logger_append_number(line, length, (uint32_t)record->line);
+	length = ae_async_logger_append(line, length, ": ");
+	length = ae_async_logger_append(line, length, record->message);
+	line[length++] = '\n';
+
+	for (int i = 0; i < logger->console_sink_count; i++)
+	{
+		if (record->level >= logger->console_sinks[i].level && AE_LOG_WRITE(logger->console_sinks[i].descriptor, line, length) < 0)
+			break;
+	}
+
+	for (int j = 0; j < logger->file_sink_count; j++)
+	{
+		if (record->level >= logger->file_sinks[j].level && AE_LOG_WRITE(logger->file_sinks[j].descriptor, line, length) < 0)
+			break;
+	}
+}
+
+static void ae_async_logger_flush_on_crash(const struct ae_logger* logger)
+{
+	struct ae_async_log_queue* queue = logger->queue;
+	bool locked = false;
+
+	for (uint32_t i = 0; i < AE_LOG_CRASH_FLUSH_ATTEMPTS && !locked; i++)
+	{
+		locked = ae_async_logger_try_lock(queue);
+
+		if (!locked)
+			ae_thread_yield();
+	}
+
+	// the crashing thread might be the owner, write whatever was published
+	uint32_t position = ae_atomic_load_u32(&queue->read_index);
+
+	for (;;)
+	{
+		struct ae_async_log_record* record = &queue->records[position & queue->mask];
+
+		if ((int32_t)(ae_atomic_load_u32(&record->sequence) - (position + 1)) < 0)
+			break;
+
+		ae_async_logger_write_on_crash(logger, record);
+
+		ae_atomic_store_u32(&record->sequence, position + queue->mask + 1);
+		position++;
+	}
+
+	ae_atomic_store_u32(&queue->read_index, position);
+
+	if (locked)
+		ae_async_logger_unlock(queue);
+}
+
+static uint32_t ae_async_logger_get_signal_index(const int signal_number)
+{
+	uint32_t index = 0;
+
+	while (index < sizeof(crash_signals) / sizeof(crash_signals[0]) - 1 && crash_signals[index] != signal_number)
+		index++;
+
+	return index;
+}
+
+// the previous handler is put back before it is called, a fault it returns from raises the signal again
+#ifdef _WIN32
+static void ae_async_logger_on_crash(int signal_number)
+{
+	for (uint32_t i = 0; i < async_logger_count; i++)
+		ae_async_logger_flush_on_crash(async_loggers[i]);
+
+	ae_signal_handler previous = previous_handlers[ae_async_logger_get_signal_index(signal_number)];
+	signal(signal_number, previous);
+
+	if (previous != SIG_DFL && previous != SIG_IGN && previous != SIG_ERR)
+		previous(signal_number);
+	else
+		raise(signal_number);
+}
+#else
+static void ae_async_logger_on_crash(int signal_number, siginfo_t* info, void* context)
+{
+	for (uint32_t i = 0; i < async_logger_count; i++)
+		ae_async_logger_flush_on_crash(async_loggers[i]);
+
+	const struct sigaction* previous = &previous_actions[ae_async_logger_get_signal_index(signal_number)];
+	sigaction(signal_number, previous, NULL);
+
+	if (previous->sa_flags & SA_SIGINFO)
+		previous->sa_sigaction(signal_number, info, context);
+	else if (previous->sa_handler != SIG_DFL && previous->sa_handler != SIG_IGN)
+		previous->sa_handler(signal_number);
+	else
+		raise(signal_number);
+}
+#endif // _WIN32
+
+static void ae_async_logger_install_crash_handler()
+{
+	if (crash_handler_installed)
+		return;
+
+	for (uint32_t i = 0; i < sizeof(crash_signals) / sizeof(crash_signals[0]); i++)
+	{
+#ifdef _WIN32
+		previous_handlers[i] = signal(crash_signals[i], ae_async_logger_on_crash);
+#else
+		struct sigaction action = { 0 };
+		action.sa_sigaction = ae_async_logger_on_crash;
+		action.sa_flags = SA_SIGINFO;
+		sigemptyset(&action.sa_mask);
+
+		sigaction(crash_signals[i], &action, &previous_actions[i]);
+#endif // _WIN32
+	}
+
+	crash_handler_installed = true;
+}
+
+bool ae_async_logger_init(struct ae_logger* logger, const uint32_t capacity, const enum ae_log_backpressure backpressure)
+{
+	// the record count is the next power of two, it would not fit above this
+	if (async_logger_count == AE_MAX_ASYNC_LOGGERS || capacity > (1u << 31))
+		return false;
+
+	struct ae_async_log_queue* queue = malloc(sizeof(*queue));
+
+	if (!queue)
+		return false;
+
+	uint32_t record_count = 2;
+
+	while (record_count < capacity)
+		record_count <<= 1;
+
+	queue->records = malloc(sizeof(*queue->records) * record_count);
+
+	if (!queue->records)
+	{
+		free(queue);
+		return false;
+	}
+
+	for (uint32_t i = 0; i < record_count; i++)
+		queue->records[i].sequence = i;
+
+	queue->mask = record_count - 1;
+	queue->backpressure = backpressure;
+	queue->dropped_count = 0;
+	queue->reported_dropped_count = 0;
+	queue->write_index = 0;
+	queue->read_index = 0;
+	queue->draining = 0;
+	queue->running = 1;
+
+	logger->queue = queue;
+
+	if (!ae_thread_create(&queue->writer, ae_async_logger_writer, logger))
+	{
+		free(queue->records);
+		free(queue);
+		logger->queue = NULL;
+		return false;
+	}
+
+	async_loggers[async_logger_count++] = logger;
+	ae_async_logger_install_crash_handler();
+
+	return true;
+}
+
+void ae_async_logger_terminate(struct ae_logger* logger)
+{
+	struct ae_async_log_queue* queue = logger->queue;
+
+	ae_atomic_store_u32(&queue->running, 0);
+	ae_thread_join(&queue->writer);
+
+	ae_async_logger_flush(logger);
+
+	for (uint32_t i = 0; i < async_logger_count; i++)
+	{
+		if (async_loggers[i] == logger)
+		{
+			async_loggers[i] = async_loggers[--async_logger_count];
+			break;
+		}
+	}
+
+	free(queue->records);
+	free(queue);
+	logger->queue = NULL;
+}
+
+void ae_async_logger_flush(const struct ae_logger* logger)
+{
+	struct ae_async_log_queue* queue = logger->queue;
+	uint32_t target = ae_atomic_load_u32(&queue->write_index);
+
+	// records claimed before the flush started are waited for until they are published
+	while ((int32_t)(ae_atomic_load_u32(&queue->read_index) - target) < 0)
+	{
+		uint32_t count = 0;
+
+		if (ae_async_logger_try_lock(queue))
+		{
+			count = ae_async_logger_drain(logger);
+			ae_async_logger_unlock(queue);
+		}
+
+		if (count == 0)
+			ae_thread_yield();
+	}
+}
+
+uint64_t ae_async_logger_get_dropped_count(const struct ae_logger* logger)
+{
+	return ae_atomic_load_u64(&logger->queue->dropped_count);
+}
+
+void ae_on_log_async(const struct ae_logger* const logger, struct ae_logger_event* event)
+{
+	if (event->level < logger->level)
+		return;
+
+	struct ae_async_log_queue* queue = logger->queue;
+	struct ae_async_log_record* record = NULL;
+	uint32_t position = ae_atomic_load_u32(&queue->write_index);
+
+	for (;;)
+	{
+		record = &queue->records[position & queue->mask];
+		int32_t difference = (int32_t)(ae_atomic_load_u32(&record->sequence) - position);
+
+		if (difference == 0)
+		{
+			if (ae_atomic_cas_u32(&queue->write_index, position, position + 1))
+				break;
+		}
+		else if (difference < 0)
+		{
+			// queue is full
+			if (queue->backpressure == AE_LOG_BACKPRESSURE_COUNT_AND_DROP)
+				ae_atomic_add_u64(&queue->dropped_count, 1);
+
+			if (queue->backpressure != AE_LOG_BACKPRESSURE_BLOCK)
+				return;
+
+			ae_thread_yield();
+		}
+
+		position = ae_atomic_load_u32(&queue->write_index);
+	}
+
+	record->level = event->level;
+	record->line = event->line;
+	record->file = event->file;
+	record->ticks = event->ticks;
+
+	va_list arguments;
+	va_copy(arguments, event->arguments);
+	vsnprintf(record->message, sizeof(record->message), event->fmt, arguments);
+	va_end(arguments);
+
+	ae_atomic_store_u32(&record->sequence, position + 1);
+
+	// make sure a fatal message reaches the sinks before the application goes down
+	if (event->level == LEVEL_CRITICAL)
+		ae_async_logger_flush(logger);
+}
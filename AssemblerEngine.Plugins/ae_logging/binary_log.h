@@ -0,0 +1,50 @@
+#pragma once
+
+// file format shared between the binary logger and the ae_log_decoder tool
+//
+// [file header][record][record]...
+// every record starts with a record header and is padded to 8 bytes, a record
+// with size 0 marks the end of the written part of the file.
+//
+// site record:		u32 line, u16 file length, file, u16 format length, format
+// message record:	per argument u8 type followed by 8 value bytes, or a u16 length and the characters for strings
+// text record:		u32 line, u16 file length, file, u16 message length, message
+
+#include <stdint.h>
+
+#define AE_BINARY_LOG_MAGIC "AEBINLOG"
+#define AE_BINARY_LOG_VERSION 1
+#define AE_BINARY_LOG_ALIGNMENT 8
+#define AE_BINARY_LOG_MAX_ARGUMENTS 8
+
+// site ids of records are below this, the decoder rejects larger ones
+#ifndef AE_BINARY_LOG_MAX_SITES
+#define AE_BINARY_LOG_MAX_SITES 65536
+#endif // !AE_BINARY_LOG_MAX_SITES
+
+enum ae_binary_log_record_type
+{
+	AE_BINARY_LOG_RECORD_SITE = 1,
+	AE_BINARY_LOG_RECORD_MESSAGE = 2,
+	AE_BINARY_LOG_RECORD_TEXT = 3
+};
+
+struct ae_binary_log_file_header
+{
+	char		magic[8];
+	uint32_t	version;
+	uint32_t	header_size;
+	uint64_t	ticks_per_second;
+	uint64_t	start_ticks;
+	uint64_t	start_time;			// unix time in nanoseconds taken at start_ticks
+};
+
+struct ae_binary_log_record_header
+{
+	uint32_t	size;				// written last, including header and padding
+	uint16_t	type;
+	uint16_t	argument_count;
+	uint32_t	site;
+	uint32_t	level;
+	uint64_t	timestamp;			// ticks
+};
@@ -0,0 +1,290 @@
+#include "logger.h"
+#include "binary_log.h"
+#include "log_clock.h"
+#include "mapped_file.h"
+
+#include <core/atomic.h>
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef AE_BINARY_LOG_MAX_STRING_LENGTH
+#define AE_BINARY_LOG_MAX_STRING_LENGTH 1024
+#endif // !AE_BINARY_LOG_MAX_STRING_LENGTH
+
+struct ae_binary_log
+{
+	struct ae_mapped_file file;
+	volatile uint64_t write_offset;
+	volatile uint64_t dropped_count;
+	// one bit per site id, set once the site record was written to this log
+	volatile uint32_t defined_sites[AE_BINARY_LOG_MAX_SITES / 32];
+};
+
+// site ids are shared by all binary logs, the call site only stores one id
+static volatile uint32_t next_site_id = 0;
+
+static uint32_t ae_binary_log_align(const uint32_t size)
+{
+	return (size + AE_BINARY_LOG_ALIGNMENT - 1) & ~(uint32_t)(AE_BINARY_LOG_ALIGNMENT - 1);
+}
+
+static uint16_t ae_binary_log_string_length(const char* string)
+{
+	if (!string)
+		return 0;
+
+	size_t length = strlen(string);
+	return (uint16_t)(length > AE_BINARY_LOG_MAX_STRING_LENGTH ? AE_BINARY_LOG_MAX_STRING_LENGTH : length);
+}
+
+static uint8_t* ae_binary_log_write_string(uint8_t* out, const char* string, const uint16_t length)
+{
+	memcpy(out, &length, sizeof(length));
+	out += sizeof(length);
+
+	if (length)
+		memcpy(out, string, length);
+
+	return out + length;
+}
+
+static uint8_t* ae_binary_log_reserve(struct ae_binary_log* binary, const uint32_t size)
+{
+	uint64_t offset = ae_atomic_add_u64(&binary->write_offset, size);
+
+	if (offset + size > binary->file.size)
+	{
+		ae_atomic_add_u64(&binary->dropped_count, 1);
+		return NULL;
+	}
+
+	return binary->file.data + offset;
+}
+
+// the size is published last so the decoder never sees a partially written record
+static void ae_binary_log_commit(uint8_t* record, const struct ae_binary_log_record_header* header)
+{
+	memcpy(record + sizeof(header->size), (const uint8_t*)header + sizeof(header->size), sizeof(*header) - sizeof(header->size));
+	ae_atomic_store_u32((volatile uint32_t*)record, header->size);
+}
+
+static bool ae_binary_log_is_defined(struct ae_binary_log* binary, const uint32_t id)
+{
+	return (ae_atomic_load_u32(&binary->defined_sites[id / 32]) & (1u << (id % 32))) != 0;
+}
+
+static void ae_binary_log_set_defined(struct ae_binary_log* binary, const uint32_t id)
+{
+	volatile uint32_t* word = &binary->defined_sites[id / 32];
+	uint32_t bits;
+
+	do
+	{
+		bits = ae_atomic_load_u32(word);
+	} while (!ae_atomic_cas_u32(word, bits, bits | (1u << (id % 32))));
+}
+
+static uint32_t ae_binary_log_get_site_id(struct ae_log_site* site)
+{
+	uint32_t id = ae_atomic_load_u32(&site->id);
+
+	if (id)
+		return id;
+
+	// two threads may race here, the loser's id is simply never used
+	ae_atomic_cas_u32(&site->id, 0, ae_atomic_add_u32(&next_site_id, 1) + 1);
+
+	return ae_atomic_load_u32(&site->id);
+}
+
+static bool ae_binary_log_define_site(struct ae_binary_log* binary, const struct ae_log_site* site, const uint32_t id, const uint64_t timestamp)
+{
+	uint16_t file_length = ae_binary_log_string_length(site->file);
+	uint16_t fmt_length = ae_binary_log_string_length(site->fmt);
+
+	struct ae_binary_log_record_header header = {
+	.size = ae_binary_log_align(sizeof(header) + sizeof(uint32_t) + 2 * sizeof(uint16_t) + file_length + fmt_length),
+	.type = AE_BINARY_LOG_RECORD_SITE,
+	.site = id,
+	.level = site->level,
+	.timestamp = timestamp
+	};
+
+	uint8_t* record = ae_binary_log_reserve(binary, header.size);
+
+	if (!record)
+		return false;
+
+	uint8_t* out = record + sizeof(header);
+	memcpy(out, &site->line, sizeof(site->line));
+	out += sizeof(site->line);
+	out = ae_binary_log_write_string(out, site->file, file_length);
+	ae_binary_log_write_string(out, site->fmt, fmt_length);
+
+	ae_binary_log_commit(record, &header);
+	ae_binary_log_set_defined(binary, id);
+
+	return true;
+}
+
+bool ae_binary_logger_init(struct ae_logger* logger, const char* path, const uint64_t max_size)
+{
+	// the file header is copied into the mapping right away
+	if (max_size < ae_binary_log_align(sizeof(struct ae_binary_log_file_header)))
+		return false;
+
+	struct ae_binary_log* binary = calloc(1, sizeof(*binary));
+
+	if (!binary)
+		return false;
+
+	if (!ae_mapped_file_open(&binary->file, path, max_size))
+	{
+		free(binary);
+		return false;
+	}
+
+	struct ae_binary_log_file_header file_header = {
+	.version = AE_BINARY_LOG_VERSION,
+	.header_size = sizeof(file_header),
+	.ticks_per_second = ae_log_clock_ticks_per_second(),
+	.start_ticks = ae_log_clock_ticks(),
+	.start_time = ae_log_clock_unix_time()
+	};
+
+	memcpy(file_header.magic, AE_BINARY_LOG_MAGIC, sizeof(file_header.magic));
+	memcpy(binary->file.data, &file_header, sizeof(file_header));
+	binary->write_offset = ae_binary_log_align(sizeof(file_header));
+
+	logger->binary = binary;
+
+	return true;
+}
+
+void ae_binary_logger_terminate(struct ae_logger* logger)
+{
+	struct ae_binary_log* binary = logger->binary;
+
+	ae_binary_logger_flush(logger);
+	ae_mapped_file_close(&binary->file, ae_atomic_load_u64(&binary->write_offset));
+
+	free(binary);
+	logger->binary = NULL;
+}
+
+void ae_binary_logger_flush(const struct ae_logger* logger)
+{
+	ae_mapped_file_flush(&logger->binary->file);
+}
+
+uint64_t ae_binary_logger_get_dropped_count(const struct ae_logger* logger)
+{
+	return ae_atomic_load_u64(&logger->binary->dropped_count);
+}
+
+void ae_binary_logger_log(struct ae_logger* logger, struct ae_log_site* site, const struct ae_log_argument* arguments, const uint32_t argument_count)
+{
+	if (!logger->binary || site->level < logger->level)
+		return;
+
+	struct ae_binary_log* binary = logger->binary;
+	uint64_t timestamp = ae_log_clock_ticks();
+	uint32_t id = ae_binary_log_get_site_id(site);
+
+	if (id >= AE_BINARY_LOG_MAX_SITES)
+		return;
+
+	if (!ae_binary_log_is_defined(binary, id) && !ae_binary_log_define_site(binary, site, id, timestamp))
+		return;
+
+	uint32_t count = argument_count > AE_BINARY_LOG_MAX_ARGUMENTS ? AE_BINARY_LOG_MAX_ARGUMENTS : argument_count;
+	uint32_t size = sizeof(struct ae_binary_log_record_header);
+	uint16_t string_lengths[AE_BINARY_LOG_MAX_ARGUMENTS] = { 0 };
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		if (arguments[i].type == AE_LOG_ARGUMENT_STRING)
+		{
+			string_lengths[i] = ae_binary_log_string_length(arguments[i].string);
+			size += 1 + sizeof(uint16_t) + string_lengths[i];
+		}
+		else
+		{
+			size += 1 + sizeof(uint64_t);
+		}
+	}
+
+	struct ae_binary_log_record_header header = {
+	.size = ae_binary_log_align(size),
+	.type = AE_BINARY_LOG_RECORD_MESSAGE,
+	.argument_count = (uint16_t)count,
+	.site = id,
+	.level = site->level,
+	.timestamp = timestamp
+	};
+
+	uint8_t* record = ae_binary_log_reserve(binary, header.size);
+
+	if (!record)
+		return;
+
+	uint8_t* out = record + sizeof(header);
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		*out++ = (uint8_t)arguments[i].type;
+
+		if (arguments[i].type == AE_LOG_ARGUMENT_STRING)
+		{
+			out = ae_binary_log_write_string(out, arguments[i].string, string_lengths[i]);
+		}
+		else
+		{
+			memcpy(out, &arguments[i].u64, sizeof(uint64_t));
+			out += sizeof(uint64_t);
+		}
+	}
+
+	ae_binary_log_commit(record, &header);
+}
+
+// slow path for the printf style log calls, the message is formatted on the calling thread
+void ae_on_log_binary(const struct ae_logger* const logger, struct ae_logger_event* event)
+{
+	if (event->level < logger->level)
+		return;
+
+	struct ae_binary_log* binary = logger->binary;
+	char message[AE_BINARY_LOG_MAX_STRING_LENGTH + 1];
+
+	va_list arguments;
+	va_copy(arguments, event->arguments);
+	vsnprintf(message, sizeof(message), event->fmt, arguments);
+	va_end(arguments);
+
+	uint16_t file_length = ae_binary_log_string_length(event->file);
+	uint16_t message_length = ae_binary_log_string_length(message);
+
+	struct ae_binary_log_record_header header = {
+	.size = ae_binary_log_align(sizeof(header) + sizeof(uint32_t) + 2 * sizeof(uint16_t) + file_length + message_length),
+	.type = AE_BINARY_LOG_RECORD_TEXT,
+	.level = event->level,
+	.timestamp = ae_log_clock_ticks()
+	};
+
+	uint8_t* record = ae_binary_log_reserve(binary, header.size);
+
+	if (!record)
+		return;
+
+	uint8_t* out = record + sizeof(header);
+	memcpy(out, &event->line, sizeof(event->line));
+	out += sizeof(event->line);
+	out = ae_binary_log_write_string(out, event->file, file_length);
+	ae_binary_log_write_string(out, message, message_length);
+
+	ae_binary_log_commit(record, &header);
+}
@@ -0,0 +1,136 @@
+#include "log_clock.h"
+
+#include <core/atomic.h>
+#include <core/os.h>
+#include <core/thread.h>
+
+#include <string.h>
+#include <time.h>
+
+struct ae_log_clock_cache
+{
+	uint64_t	base_ticks;
+	uint64_t	base_time;
+	int64_t		second;
+	char		date_time[32];
+};
+
+enum ae_log_clock_state
+{
+	AE_LOG_CLOCK_UNCALIBRATED,
+	AE_LOG_CLOCK_CALIBRATING,
+	AE_LOG_CLOCK_CALIBRATED
+};
+
+// the first thread to log calibrates, the others wait until the rate is published
+static volatile uint32_t clock_state = AE_LOG_CLOCK_UNCALIBRATED;
+static uint64_t ticks_per_second = 0;
+static double nanoseconds_per_tick = 0.0;
+
+static AE_THREAD_LOCAL struct ae_log_clock_cache clock_cache = { 0 };
+
+static uint64_t ae_log_clock_reference_ticks(uint64_t* frequency)
+{
+#ifdef _WIN32
+	LARGE_INTEGER counter, counter_frequency;
+	QueryPerformanceFrequency(&counter_frequency);
+	QueryPerformanceCounter(&counter);
+	*frequency = (uint64_t)counter_frequency.QuadPart;
+	return (uint64_t)counter.QuadPart;
+#else
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	*frequency = 1000000000ull;
+	return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+#endif // _WIN32
+}
+
+void ae_log_clock_init()
+{
+	if (ae_atomic_load_u32(&clock_state) == AE_LOG_CLOCK_CALIBRATED)
+		return;
+
+	if (!ae_atomic_cas_u32(&clock_state, AE_LOG_CLOCK_UNCALIBRATED, AE_LOG_CLOCK_CALIBRATING))
+	{
+		while (ae_atomic_load_u32(&clock_state) != AE_LOG_CLOCK_CALIBRATED)
+			ae_thread_yield();
+
+		return;
+	}
+
+	uint64_t frequency;
+
+#ifdef AE_LOG_CLOCK_USE_TSC
+	uint64_t reference_start = ae_log_clock_reference_ticks(&frequency);
+	uint64_t start = ae_log_clock_ticks();
+
+	ae_thread_sleep(10);
+
+	uint64_t end = ae_log_clock_ticks();
+	uint64_t reference_end = ae_log_clock_reference_ticks(&frequency);
+
+	ticks_per_second = (uint64_t)((double)(end - start) * (double)frequency / (double)(reference_end - reference_start));
+#else
+	ae_log_clock_reference_ticks(&frequency);
+	ticks_per_second = frequency;
+#endif // AE_LOG_CLOCK_USE_TSC
+
+	nanoseconds_per_tick = 1e9 / (double)ticks_per_second;
+
+	ae_atomic_store_u32(&clock_state, AE_LOG_CLOCK_CALIBRATED);
+}
+
+uint64_t ae_log_clock_ticks_per_second()
+{
+	return ticks_per_second;
+}
+
+uint64_t ae_log_clock_unix_time()
+{
+#ifdef _WIN32
+	FILETIME time;
+	GetSystemTimePreciseAsFileTime(&time);
+	uint64_t intervals = ((uint64_t)time.dwHighDateTime << 32) | time.dwLowDateTime;
+	return (intervals - 116444736000000000ull) * 100;
+#else
+	struct timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
+	return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+#endif // _WIN32
+}
+
+const char* ae_log_clock_date_time(const uint64_t ticks, uint32_t* nanoseconds)
+{
+	struct ae_log_clock_cache* cache = &clock_cache;
+
+	// the calendar base follows the wall clock once per second, older ticks keep using the current base
+	if (cache->base_time == 0 || (int64_t)(ticks - cache->base_ticks) > (int64_t)ticks_per_second)
+	{
+		cache->base_ticks = ae_log_clock_ticks();
+		cache->base_time = ae_log_clock_unix_time();
+	}
+
+	int64_t elapsed = (int64_t)((double)(int64_t)(ticks - cache->base_ticks) * nanoseconds_per_tick);
+	uint64_t time = cache->base_time + (uint64_t)elapsed;
+	int64_t second = (int64_t)(time / 1000000000ull);
+
+	*nanoseconds = (uint32_t)(time % 1000000000ull);
+
+	if (second != cache->second || cache->date_time[0] == '\0')
+	{
+		struct tm local;
+		time_t seconds = (time_t)second;
+
+		// fix warning(C4996) on WIN32
+#ifdef WIN32
+		localtime_s(&local, &seconds);
+#else
+		localtime_r(&seconds, &local);
+#endif // WIN32
+
+		cache->date_time[strftime(cache->date_time, sizeof(cache->date_time), "%Y-%m-%d %H:%M:%S", &local)] = '\0';
+		cache->second = second;
+	}
+
+	return cache->date_time;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdint.h>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define AE_LOG_CLOCK_USE_TSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define AE_LOG_CLOCK_USE_TSC
+#elif defined(_WIN32)
+#include <core/os.h>
+#else
+#include <time.h>
+#endif
+
+// calibrates the tick rate once, safe to call from any thread and more than once
+void ae_log_clock_init();
+uint64_t ae_log_clock_ticks_per_second();
+
+// calendar time in nanoseconds since the unix epoch, precise but slow compared to the ticks
+uint64_t ae_log_clock_unix_time();
+
+// returns "YYYY-mm-dd HH:MM:SS" for the given ticks, the string is cached per thread and only
+// rebuilt when the second changes. nanoseconds receives the fraction of the second.
+const char* ae_log_clock_date_time(const uint64_t ticks, uint32_t* nanoseconds);
+
+// cheap monotonic clock read once per log record
+static inline uint64_t ae_log_clock_ticks()
+{
+#if defined(AE_LOG_CLOCK_USE_TSC)
+	return __rdtsc();
+#elif defined(_WIN32)
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return (uint64_t)counter.QuadPart;
+#else
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+#endif
+}
@@ -0,0 +1,302 @@
+#include "log_compression.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define AE_LOG_COMPRESSION_HASH_BITS 12
+#define AE_LOG_COMPRESSION_MIN_MATCH 4
+// the last match has to start this far from the end, the tail is always literals
+#define AE_LOG_COMPRESSION_MATCH_LIMIT 12
+#define AE_LOG_COMPRESSION_LAST_LITERALS 5
+
+static uint32_t ae_log_compression_read32(const uint8_t* in)
+{
+	uint32_t value;
+	memcpy(&value, in, sizeof(value));
+	return value;
+}
+
+static uint32_t ae_log_compression_hash(const uint32_t sequence)
+{
+	return (sequence * 2654435761u) >> (32 - AE_LOG_COMPRESSION_HASH_BITS);
+}
+
+static uint8_t* ae_log_compression_write_length(uint8_t* out, uint32_t length)
+{
+	while (length >= 255)
+	{
+		*out++ = 255;
+		length -= 255;
+	}
+
+	*out++ = (uint8_t)length;
+
+	return out;
+}
+
+static uint8_t* ae_log_compression_write_sequence(uint8_t* out, const uint8_t* literals, const uint32_t literal_length, const uint32_t offset, const uint32_t match_length)
+{
+	uint8_t* token = out++;
+	*token = (uint8_t)((literal_length < 15 ? literal_length : 15) << 4);
+
+	if (literal_length >= 15)
+		out = ae_log_compression_write_length(out, literal_length - 15);
+
+	memcpy(out, literals, literal_length);
+	out += literal_length;
+
+	// the last sequence only has literals
+	if (match_length == 0)
+		return out;
+
+	uint32_t length = match_length - AE_LOG_COMPRESSION_MIN_MATCH;
+	*token |= (uint8_t)(length < 15 ? length : 15);
+
+	*out++ = (uint8_t)offset;
+	*out++ = (uint8_t)(offset >> 8);
+
+	if (length >= 15)
+		out = ae_log_compression_write_length(out, length - 15);
+
+	return out;
+}
+
+uint32_t ae_log_compress_bound(const uint32_t size)
+{
+	return size + size / 255 + 16;
+}
+
+uint32_t ae_log_compress_block(const uint8_t* in, const uint32_t size, uint8_t* out)
+{
+	uint32_t table[1 << AE_LOG_COMPRESSION_HASH_BITS] = { 0 };
+	const uint8_t* ip = in;
+	const uint8_t* anchor = in;
+	const uint8_t* end = in + size;
+	uint8_t* op = out;
+
+	if (size > AE_LOG_COMPRESSION_MATCH_LIMIT)
+	{
+		const uint8_t* match_limit = end - AE_LOG_COMPRESSION_MATCH_LIMIT;
+		const uint8_t* extend_limit = end - AE_LOG_COMPRESSION_LAST_LITERALS;
+
+		while (ip < match_limit)
+		{
+			uint32_t sequence = ae_log_compression_read32(ip);
+			uint32_t hash = ae_log_compression_hash(sequence);
+			const uint8_t* reference = in + table[hash];
+			table[hash] = (uint32_t)(ip - in);
+
+			if (reference >= ip || ip - reference > 65535 || ae_log_compression_read32(reference) != sequence)
+			{
+				ip++;
+				continue;
+			}
+
+			const uint8_t* match_end = ip + AE_LOG_COMPRESSION_MIN_MATCH;
+			reference += AE_LOG_COMPRESSION_MIN_MATCH;
+
+			while (match_end < extend_limit && *match_end == *reference)
+			{
+				match_end++;
+				reference++;
+			}
+
+			op = ae_log_compression_write_sequence(op, anchor, (uint32_t)(ip - anchor), (uint32_t)(match_end - reference), (uint32_t)(match_end - ip));
+
+			ip = match_end;
+			anchor = ip;
+		}
+	}
+
+	op = ae_log_compression_write_sequence(op, anchor, (uint32_t)(end - anchor), 0, 0);
+
+	return (uint32_t)(op - out);
+}
+
+static bool ae_log_compression_read_length(const uint8_t** in, const uint8_t* end, uint32_t* length)
+{
+	uint8_t byte;
+
+	do
+	{
+		if (*in == end)
+			return false;
+
+		byte = *(*in)++;
+		*length += byte;
+	} while (byte == 255);
+
+	return true;
+}
+
+uint32_t ae_log_decompress_block(const uint8_t* in, const uint32_t size, uint8_t* out, const uint32_t capacity)
+{
+	const uint8_t* ip = in;
+	const uint8_t* end = in + size;
+	uint8_t* op = out;
+	uint8_t* op_end = out + capacity;
+
+	while (ip < end)
+	{
+		uint8_t token = *ip++;
+		uint32_t literal_length = token >> 4;
+
+		if (literal_length == 15 && !ae_log_compression_read_length(&ip, end, &literal_length))
+			return 0;
+
+		if (literal_length > (uint32_t)(end - ip) || literal_length > (uint32_t)(op_end - op))
+			return 0;
+
+		memcpy(op, ip, literal_length);
+		ip += literal_length;
+		op += literal_length;
+
+		if (ip == end)
+			break;
+
+		if (end - ip < 2)
+			return 0;
+
+		uint32_t offset = ip[0] | ((uint32_t)ip[1] << 8);
+		ip += 2;
+
+		if (offset == 0 || offset > (uint32_t)(op - out))
+			return 0;
+
+		uint32_t match_length = token & 15;
+
+		if (match_length == 15 && !ae_log_compression_read_length(&ip, end, &match_length))
+			return 0;
+
+		match_length += AE_LOG_COMPRESSION_MIN_MATCH;
+
+		if (match_length > (uint32_t)(op_end - op))
+			return 0;
+
+		// matches may overlap their own output
+		const uint8_t* match = op - offset;
+
+		for (uint32_t i = 0; i < match_length; i++)
+			op[i] = match[i];
+
+		op += match_length;
+	}
+
+	return (uint32_t)(op - out);
+}
+
+bool ae_log_compress_file(const char* source, const char* destination)
+{
+	FILE* in = fopen(source, "rb");
+
+	if (!in)
+		return false;
+
+	FILE* out = fopen(destination, "wb");
+
+	if (!out)
+	{
+		fclose(in);
+		return false;
+	}
+
+	uint8_t* block = malloc(AE_LOG_COMPRESSION_BLOCK_SIZE);
+	uint8_t* compressed = malloc(ae_log_compress_bound(AE_LOG_COMPRESSION_BLOCK_SIZE));
+	bool success = block && compressed;
+
+	struct ae_log_compressed_file_header header = { .size = 0 };
+	memcpy(header.magic, AE_LOG_COMPRESSED_MAGIC, sizeof(header.magic));
+
+	// the size is patched in once the whole file was read
+	success = success && fwrite(&header, sizeof(header), 1, out) == 1;
+
+	while (success)
+	{
+		size_t size = fread(block, 1, AE_LOG_COMPRESSION_BLOCK_SIZE, in);
+
+		if (size == 0)
+			break;
+
+		struct ae_log_compressed_block_header block_header = {
+		.compressed_size = ae_log_compress_block(block, (uint32_t)size, compressed),
+		.size = (uint32_t)size
+		};
+
+		const uint8_t* data = compressed;
+
+		if (block_header.compressed_size >= block_header.size)
+		{
+			block_header.compressed_size = block_header.size;
+			data = block;
+		}
+
+		success = fwrite(&block_header, sizeof(block_header), 1, out) == 1 && fwrite(data, 1, block_header.compressed_size, out) == block_header.compressed_size;
+		header.size += size;
+	}
+
+	success = success && !ferror(in) && fseek(out, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, out) == 1;
+
+	free(compressed);
+	free(block);
+	fclose(in);
+
+	if (fclose(out) != 0)
+		success = false;
+
+	if (!success)
+		remove(destination);
+
+	return success;
+}
+
+bool ae_log_is_compressed(const uint8_t* data, const size_t size)
+{
+	return size >= sizeof(struct ae_log_compressed_file_header) && memcmp(data, AE_LOG_COMPRESSED_MAGIC, 8) == 0;
+}
+
+uint8_t* ae_log_decompress(const uint8_t* data, const size_t size, size_t* decompressed_size)
+{
+	struct ae_log_compressed_file_header header;
+
+	if (!ae_log_is_compressed(data, size))
+		return NULL;
+
+	memcpy(&header, data, sizeof(header));
+
+	uint8_t* out = malloc(header.size ? (size_t)header.size : 1);
+
+	if (!out)
+		return NULL;
+
+	size_t offset = sizeof(header);
+	size_t written = 0;
+
+	while (offset + sizeof(struct ae_log_compressed_block_header) <= size)
+	{
+		struct ae_log_compressed_block_header block;
+		memcpy(&block, data + offset, sizeof(block));
+		offset += sizeof(block);
+
+		if (block.compressed_size > size - offset || block.size > header.size - written)
+			break;
+
+		if (block.compressed_size == block.size)
+			memcpy(out + written, data + offset, block.size);
+		else if (ae_log_decompress_block(data + offset, block.compressed_size, out + written, block.size) != block.size)
+			break;
+
+		offset += block.compressed_size;
+		written += block.size;
+	}
+
+	if (written != header.size)
+	{
+		free(out);
+		return NULL;
+	}
+
+	*decompressed_size = written;
+
+	return out;
+}
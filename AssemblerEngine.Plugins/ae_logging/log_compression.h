@@ -0,0 +1,46 @@
+#pragma once
+
+// compressed log file format shared between the mapped file sink and the ae_log_decoder tool
+//
+// [file header][block][block]...
+// every block starts with a block header, the data uses the lz4 block encoding and is
+// stored as is when it did not get smaller (compressed_size == size).
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define AE_LOG_COMPRESSED_MAGIC "AELOGLZ1"
+#define AE_LOG_COMPRESSED_EXTENSION ".lz"
+
+// the match offsets are 16 bit, blocks never need a bigger window
+#define AE_LOG_COMPRESSION_BLOCK_SIZE 65536
+
+struct ae_log_compressed_file_header
+{
+	char		magic[8];
+	uint64_t	size;				// size of the original file
+};
+
+struct ae_log_compressed_block_header
+{
+	uint32_t	compressed_size;
+	uint32_t	size;
+};
+
+// worst case output size of ae_log_compress_block
+uint32_t ae_log_compress_bound(const uint32_t size);
+
+// returns the compressed size, out must hold ae_log_compress_bound(size) bytes
+uint32_t ae_log_compress_block(const uint8_t* in, const uint32_t size, uint8_t* out);
+
+// returns the decompressed size or 0 if the block is corrupt
+uint32_t ae_log_decompress_block(const uint8_t* in, const uint32_t size, uint8_t* out, const uint32_t capacity);
+
+// writes source compressed to destination, the source is left alone
+bool ae_log_compress_file(const char* source, const char* destination);
+
+bool ae_log_is_compressed(const uint8_t* data, const size_t size);
+
+// returns the original file contents allocated with malloc, NULL if the data is corrupt
+uint8_t* ae_log_decompress(const uint8_t* data, const size_t size, size_t* decompressed_size);
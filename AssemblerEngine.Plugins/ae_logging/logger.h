@@ -0,0 +1,80 @@
+#pragma once
+
+#include <apis/logging.h>
+#include <core/types.h>
+
+#include <stdarg.h>
+
+#ifndef AE_MAX_LOG_SINKS
+#define AE_MAX_LOG_SINKS 8
+#endif // !AE_MAX_LOG_SINKS
+
+struct ae_logger;
+struct ae_async_log_queue;
+struct ae_binary_log;
+struct ae_mapped_sink;
+
+struct ae_sink
+{
+	void* data;
+	enum ae_log_levels level;
+	// file descriptor of console and file sinks, the crash handler can not use stdio
+	int descriptor;
+};
+
+struct ae_logger_event
+{
+	va_list arguments;
+	const char* fmt;
+	const char* message;
+	const char* file;
+	void* data;
+	uint64_t ticks;
+	enum ae_log_levels level;
+	int32_t line;
+};
+
+typedef void (*ae_logger_log_fn)(const struct ae_logger* const logger, struct ae_logger_event* event);
+
+struct ae_logger
+{
+	struct ae_sink console_sinks[AE_MAX_LOG_SINKS];
+	struct ae_sink file_sinks[AE_MAX_LOG_SINKS];
+	struct ae_sink mapped_sinks[AE_MAX_LOG_SINKS];
+	ae_logger_log_fn log_function;
+	ae_logger_lock_fn lock_function;
+	ae_logger_unlock_fn unlock_function;
+	struct ae_async_log_queue* queue;
+	struct ae_binary_log* binary;
+
+	uint16_t console_sink_count;
+	uint16_t file_sink_count;
+	uint16_t mapped_sink_count;
+	enum ae_log_levels level;
+};
+
+// sinks
+void ae_logger_write_to_sinks(const struct ae_logger* const logger, struct ae_logger_event* event);
+void ae_logger_flush_sinks(const struct ae_logger* const logger);
+
+// async
+bool ae_async_logger_init(struct ae_logger* logger, const uint32_t capacity, const enum ae_log_backpressure backpressure);
+void ae_async_logger_terminate(struct ae_logger* logger);
+void ae_async_logger_flush(const struct ae_logger* logger);
+uint64_t ae_async_logger_get_dropped_count(const struct ae_logger* logger);
+void ae_on_log_async(const struct ae_logger* const logger, struct ae_logger_event* event);
+
+// binary
+bool ae_binary_logger_init(struct ae_logger* logger, const char* path, const uint64_t max_size);
+void ae_binary_logger_terminate(struct ae_logger* logger);
+void ae_binary_logger_flush(const struct ae_logger* logger);
+uint64_t ae_binary_logger_get_dropped_count(const struct ae_logger* logger);
+void ae_binary_logger_log(struct ae_logger* logger, struct ae_log_site* site, const struct ae_log_argument* arguments, const uint32_t argument_count);
+void ae_on_log_binary(const struct ae_logger* const logger, struct ae_logger_event* event);
+
+// mapped file sink
+struct ae_mapped_sink* ae_mapped_sink_create(const char* path, const uint64_t segment_size, const uint32_t rotate_seconds);
+void ae_mapped_sink_destroy(struct ae_mapped_sink* sink);
+void ae_mapped_sink_write(struct ae_mapped_sink* sink, const char* data, const uint32_t length);
+void ae_mapped_sink_flush(struct ae_mapped_sink* sink);
+void ae_mapped_sink_get_stats(struct ae_mapped_sink* sink, struct ae_log_file_sink_stats* stats);
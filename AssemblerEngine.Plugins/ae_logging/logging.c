@@ -1,33 +1,51 @@
+#ifndef _WIN32
+// dladdr
+#define _GNU_SOURCE
+#endif // !_WIN32
+
+#include "logger.h"
+#include "log_clock.h"
+
 #include <apis/logging.h>
 #include <apis/api_registry.h>
+#include <core/atomic.h>
 #include <core/core.h>
+#include <core/thread.h>
 
 #include <stdarg.h>
-#include <time.h>
+#include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
-#ifndef AE_MAX_LOG_SINKS
-#define AE_MAX_LOG_SINKS 8
-#endif // !AE_MAX_LOG_SINKS
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <dlfcn.h>
+#endif // _WIN32
 
-struct ae_sink
-{
-	void* data;
-	enum ae_log_levels level;
-};
+// longer lines written to a mapped file sink are truncated
+#ifndef AE_LOG_MAPPED_LINE_LENGTH
+#define AE_LOG_MAPPED_LINE_LENGTH 1024
+#endif // !AE_LOG_MAPPED_LINE_LENGTH
 
-struct ae_logger_event
-{
-	va_list arguments;
-	const char* fmt;
-	const char* file;
-	void* data;
-	struct tm time;
-	int32_t level;
-	int32_t line;
-};
+// messages at or above this level are flushed to the console and file sinks right away, the rest
+// when the logger is flushed or destroyed
+#ifndef AE_LOG_FLUSH_LEVEL
+#define AE_LOG_FLUSH_LEVEL AE_LOG_LEVEL_ERROR
+#endif // !AE_LOG_FLUSH_LEVEL
+
+#ifndef AE_MAX_LOG_SITE_RULES
+#define AE_MAX_LOG_SITE_RULES 32
+#endif // !AE_MAX_LOG_SITE_RULES
+
+#ifndef AE_LOG_SITE_RULE_FILE_LENGTH
+#define AE_LOG_SITE_RULE_FILE_LENGTH 64
+#endif // !AE_LOG_SITE_RULE_FILE_LENGTH
 
-typedef void (*ae_logger_log_fn)(const struct ae_logger* const logger, struct ae_logger_event* event);
+// suppressed messages of sites that stay quiet are reported at least this often
+#ifndef AE_LOG_SUPPRESSED_REPORT_SECONDS
+#define AE_LOG_SUPPRESSED_REPORT_SECONDS 5
+#endif // !AE_LOG_SUPPRESSED_REPORT_SECONDS
 
 static const char* level_strings[] = {
   "TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL"
@@ -39,31 +57,85 @@ static const char* level_colors[] = {
 };
 #endif
 
-struct ae_logger
+enum ae_log_site_rule_type
 {
-	struct ae_sink console_sinks[AE_MAX_LOG_SINKS];
-	struct ae_sink file_sinks[AE_MAX_LOG_SINKS];
-	struct tm time;
-	ae_logger_log_fn log_function;
-	ae_logger_lock_fn lock_function;
-	ae_logger_unlock_fn unlock_function;
+	AE_LOG_SITE_RULE_ENABLE,
+	AE_LOG_SITE_RULE_LIMIT
+};
+
+// a rule enables, disables or limits every site with a matching file suffix and line
+struct ae_log_site_rule
+{
+	char file[AE_LOG_SITE_RULE_FILE_LENGTH];
+	uint64_t interval;
+	uint64_t tolerance;
+	uint32_t sample_every;
+	int32_t line;
+	enum ae_log_site_rule_type type;
+	bool enabled;
+};
 
-	uint16_t console_sink_count;
-	uint16_t file_sink_count;
-	enum ae_log_levels level;
+// the limits are changed under the site lock while other threads log, every field is read and written atomically
+struct ae_log_site_limit
+{
+	// ticks at which the bucket is full again, messages are let through while it is less than tolerance ahead
+	volatile uint64_t arrival;
+	volatile uint64_t interval;
+	volatile uint64_t tolerance;
+	volatile uint32_t counter;
+	volatile uint32_t suppressed;
+	volatile uint32_t sample_every;
+	// the limits of forgotten sites, admit_site may still be reading them
+	struct ae_log_site_limit* next_retired;
 };
 
 static struct ae_logger* main_logger = NULL;
 
+// checked inline by the log macros, nothing below this level reaches a function call
+static volatile int32_t main_level = AE_LOG_LEVEL_OFF;
+
+static struct ae_log_site* sites = NULL;
+static struct ae_log_site_rule site_rules[AE_MAX_LOG_SITE_RULES];
+static uint32_t site_rule_count = 0;
+static volatile uint32_t site_lock = 0;
+// only freed when the plugin is unloaded, no thread can be logging through it by then
+static struct ae_log_site_limit* retired_limits = NULL;
+// ticks at which the suppressed messages are reported next
+static volatile uint64_t next_suppressed_report = 0;
+
+static void ae_logger_report_suppressed();
+
+static void ae_on_log_message(struct ae_logger_event* event)
+{
+	if (event->message)
+	{
+		fputs(event->message, event->data);
+	}
+	else
+	{
+		// the arguments are consumed once per sink
+		va_list arguments;
+		va_copy(arguments, event->arguments);
+		vfprintf(event->data, event->fmt, arguments);
+		va_end(arguments);
+	}
+
+	fputc('\n', event->data);
+}
+
 static void ae_on_log_to_console(struct ae_logger_event* event)
 {
-	char buf[16] = { 0 };
-	buf[strftime(buf, sizeof(buf), "%H:%M:%S", &event->time)] = '\0';
+	uint32_t nanoseconds;
+	const char* date_time = ae_log_clock_date_time(event->ticks, &nanoseconds);
+
+	// the console only shows the time of day
+	date_time += 11;
 #ifdef LOGGER_USE_COLOR
 	fprintf(
 		event->data,
-		"%s %s%-5s\x1b[0m \x1b[90m%s:%d:\x1b[0m ",
-		buf,
+		"%s.%06u %s%-5s\x1b[0m \x1b[90m%s:%d:\x1b[0m ",
+		date_time,
+		nanoseconds / 1000,
 		level_colors[event->level],
 		level_strings[event->level],
 		event->file,
@@ -72,63 +144,135 @@ static void ae_on_log_to_console(struct ae_logger_event* event)
 #else
 	fprintf(
 		event->data,
-		"%s %-5s %s:%d: ",
-		buf,
+		"%s.%06u %-5s %s:%d: ",
+		date_time,
+		nanoseconds / 1000,
 		level_strings[event->level],
 		event->file,
 		event->line
 	);
 #endif
-	vfprintf(event->data, event->fmt, event->arguments);
-	fprintf(event->data, "\n");
-	fflush(event->data);
+	ae_on_log_message(event);
 }
 
 static void ae_on_log_to_file(struct ae_logger_event* event)
 {
-	char buf[64] = { 0 };
-	buf[strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &event->time)] = '\0';
+	uint32_t nanoseconds;
+	const char* date_time = ae_log_clock_date_time(event->ticks, &nanoseconds);
+
 	fprintf(
 		event->data,
-		"%s %-5s %s:%d: ",
-		buf,
+		"%s.%09u %-5s %s:%d: ",
+		date_time,
+		nanoseconds,
 		level_strings[event->level],
 		event->file,
 		event->line
 	);
-	vfprintf(event->data, event->fmt, event->arguments);
-	fprintf(event->data, "\n");
-	fflush(event->data);
+	ae_on_log_message(event);
 }
 
-static void ae_on_log(const struct ae_logger* const logger, struct ae_logger_event* event)
+// the line is formatted on the stack and copied into the mapping in one go
+static void ae_on_log_to_mapped_file(struct ae_logger_event* event)
 {
-	if (event->level >= logger->level)
+	char line[AE_LOG_MAPPED_LINE_LENGTH];
+	uint32_t nanoseconds;
+	const char* date_time = ae_log_clock_date_time(event->ticks, &nanoseconds);
+	const size_t capacity = sizeof(line) - 1;
+
+	int prefix = snprintf(
+		line,
+		capacity,
+		"%s.%09u %-5s %s:%d: ",
+		date_time,
+		nanoseconds,
+		level_strings[event->level],
+		event->file,
+		event->line
+	);
+
+	if (prefix < 0)
+		return;
+
+	size_t length = (size_t)prefix < capacity ? (size_t)prefix : capacity - 1;
+	int message;
+
+	if (event->message)
 	{
-		for (int i = 0; i < logger->console_sink_count; i++)
-		{
-			const struct ae_sink* sink = &logger->console_sinks[i];
+		message = snprintf(line + length, capacity - length, "%s", event->message);
+	}
+	else
+	{
+		va_list arguments;
+		va_copy(arguments, event->arguments);
+		message = vsnprintf(line + length, capacity - length, event->fmt, arguments);
+		va_end(arguments);
+	}
 
-			if (event->level >= sink->level)
-			{
-				event->data = sink->data;
-				ae_on_log_to_console(event);
-			}
+	if (message > 0)
+		length += (size_t)message < capacity - length ? (size_t)message : capacity - length - 1;
+
+	line[length++] = '\n';
+
+	ae_mapped_sink_write(event->data, line, (uint32_t)length);
+}
+
+void ae_logger_write_to_sinks(const struct ae_logger* const logger, struct ae_logger_event* event)
+{
+	for (int i = 0; i < logger->console_sink_count; i++)
+	{
+		const struct ae_sink* sink = &logger->console_sinks[i];
+
+		if (event->level >= sink->level)
+		{
+			event->data = sink->data;
+			ae_on_log_to_console(event);
 		}
+	}
 
-		for (int j = 0; j < logger->file_sink_count; j++)
+	for (int j = 0; j < logger->file_sink_count; j++)
+	{
+		const struct ae_sink* sink = &logger->file_sinks[j];
+
+		if (event->level >= sink->level)
 		{
-			const struct ae_sink* sink = &logger->file_sinks[j];
+			event->data = sink->data;
+			ae_on_log_to_file(event);
+		}
+	}
 
-			if (event->level >= sink->level)
-			{
-				event->data = sink->data;
-				ae_on_log_to_file(event);
-			}
+	for (int k = 0; k < logger->mapped_sink_count; k++)
+	{
+		const struct ae_sink* sink = &logger->mapped_sinks[k];
+
+		if (event->level >= sink->level)
+		{
+			event->data = sink->data;
+			ae_on_log_to_mapped_file(event);
 		}
 	}
 }
 
+void ae_logger_flush_sinks(const struct ae_logger* const logger)
+{
+	for (int i = 0; i < logger->console_sink_count; i++)
+		fflush(logger->console_sinks[i].data);
+
+	for (int j = 0; j < logger->file_sink_count; j++)
+		fflush(logger->file_sinks[j].data);
+}
+
+static void ae_on_log(const struct ae_logger* const logger, struct ae_logger_event* event)
+{
+	if (event->level >= logger->level)
+	{
+		ae_logger_write_to_sinks(logger, event);
+
+		if ((int32_t)event->level >= AE_LOG_FLUSH_LEVEL)
+			ae_logger_flush_sinks(logger);
+	}
+}
+
 static void ae_on_log_thread_safe(const struct ae_logger* const logger, struct ae_logger_event* event)
 {
 	if (event->level >= logger->level)
@@ -143,6 +287,9 @@ static void ae_on_log_thread_safe(const struct ae_logger* const logger, struct a
 			{
 				event->data = sink->data;
 				ae_on_log_to_console(event);
+
+				if ((int32_t)event->level >= AE_LOG_FLUSH_LEVEL)
+					fflush(event->data);
 			}
 
 			logger->unlock_function(logger->console_sinks[i].data);
@@ -158,10 +305,25 @@ static void ae_on_log_thread_safe(const struct ae_logger* const logger, struct a
 			{
 				event->data = sink->data;
 				ae_on_log_to_file(event);
+
+				if ((int32_t)event->level >= AE_LOG_FLUSH_LEVEL)
+					fflush(event->data);
 			}
 
 			logger->unlock_function(logger->file_sinks[j].data);
 		}
+
+		// mapped file sinks do their own locking
+		for (int k = 0; k < logger->mapped_sink_count; k++)
+		{
+			const struct ae_sink* sink = &logger->mapped_sinks[k];
+
+			if (event->level >= sink->level)
+			{
+				event->data = sink->data;
+				ae_on_log_to_mapped_file(event);
+			}
+		}
 	}
 }
 
@@ -172,12 +334,17 @@ struct ae_logger* ae_logger_create(enum ae_log_levels level)
 	if (!logger)
 		return NULL;
 
+	ae_log_clock_init();
+
 	logger->level = level;
 	logger->log_function = ae_on_log;
 	logger->lock_function = NULL;
 	logger->unlock_function = NULL;
+	logger->queue = NULL;
+	logger->binary = NULL;
 	logger->console_sink_count = 0;
 	logger->file_sink_count = 0;
+	logger->mapped_sink_count = 0;
 
 	return logger;
 }
@@ -189,16 +356,120 @@ struct ae_logger* ae_logger_create_threaded(enum ae_log_levels level, ae_logger_
 	if (!logger)
 		return NULL;
 
+	ae_log_clock_init();
+
 	logger->level = level;
 	logger->log_function = ae_on_log_thread_safe;
 	logger->lock_function = lock_fn;
 	logger->unlock_function = unlock_fn;
+	logger->queue = NULL;
+	logger->binary = NULL;
 	logger->console_sink_count = 0;
 	logger->file_sink_count = 0;
+	logger->mapped_sink_count = 0;
+
+	return logger;
+}
+
+struct ae_logger* ae_logger_create_async(enum ae_log_levels level, uint32_t capacity, enum ae_log_backpressure backpressure)
+{
+	struct ae_logger* logger = ae_logger_create(level);
+
+	if (!logger)
+		return NULL;
+
+	if (!ae_async_logger_init(logger, capacity, backpressure))
+	{
+		free(logger);
+		return NULL;
+	}
+
+	logger->log_function = ae_on_log_async;
 
 	return logger;
 }
 
+struct ae_logger* ae_logger_create_binary(enum ae_log_levels level, const char* path, uint64_t max_size)
+{
+	struct ae_logger* logger = ae_logger_create(level);
+
+	if (!logger)
+		return NULL;
+
+	if (!ae_binary_logger_init(logger, path, max_size))
+	{
+		free(logger);
+		return NULL;
+	}
+
+	logger->log_function = ae_on_log_binary;
+
+	return logger;
+}
+
+static void ae_logger_destroy(struct ae_logger* logger)
+{
+	if (!logger)
+		return;
+
+	if (logger == main_logger)
+		ae_logger_report_suppressed();
+
+	if (logger->queue)
+		ae_async_logger_terminate(logger);
+	else if (logger->binary)
+		ae_binary_logger_terminate(logger);
+	else
+		ae_logger_flush_sinks(logger);
+
+	for (int i = 0; i < logger->mapped_sink_count; i++)
+		ae_mapped_sink_destroy(logger->mapped_sinks[i].data);
+
+	if (logger == main_logger)
+	{
+		main_logger = NULL;
+		ae_atomic_store_u32((volatile uint32_t*)&main_level, AE_LOG_LEVEL_OFF);
+	}
+
+	free(logger);
+}
+
+static void ae_logger_flush(struct ae_logger* logger)
+{
+	if (logger == main_logger)
+		ae_logger_report_suppressed();
+
+	if (logger->queue)
+		ae_async_logger_flush(logger);
+	else if (logger->binary)
+		ae_binary_logger_flush(logger);
+	else
+		ae_logger_flush_sinks(logger);
+
+	// only an explicit flush writes the mapped pages back, the sinks are never synced per message
+	for (int i = 0; i < logger->mapped_sink_count; i++)
+		ae_mapped_sink_flush(logger->mapped_sinks[i].data);
+}
+
+static uint64_t ae_logger_get_dropped_count(struct ae_logger* logger)
+{
+	if (logger->queue)
+		return ae_async_logger_get_dropped_count(logger);
+
+	if (logger->binary)
+		return ae_binary_logger_get_dropped_count(logger);
+
+	return 0;
+}
+
+static int ae_log_get_descriptor(FILE* file)
+{
+#ifdef _WIN32
+	return _fileno(file);
+#else
+	return fileno(file);
+#endif // _WIN32
+}
 
 static bool ae_logger_add_file_sink(struct ae_logger* logger, FILE* file, enum ae_log_levels level)
 {
@@ -210,6 +481,7 @@ static bool ae_logger_add_file_sink(struct ae_logger* logger, FILE* file, enum a
 
 	logger->file_sinks[logger->file_sink_count].level = level;
 	logger->file_sinks[logger->file_sink_count].data = file;
+	logger->file_sinks[logger->file_sink_count].descriptor = ae_log_get_descriptor(file);
 	logger->file_sink_count++;
 
 	return true;
@@ -225,11 +497,38 @@ static bool ae_logger_add_console_sink(struct ae_logger* logger, void* data, enu
 
 	logger->console_sinks[logger->console_sink_count].level = level;
 	logger->console_sinks[logger->console_sink_count].data = data;
+	logger->console_sinks[logger->console_sink_count].descriptor = ae_log_get_descriptor(data);
 	logger->console_sink_count++;
 
 	return true;
 }
 
+static int32_t ae_logger_add_mapped_file_sink(struct ae_logger* logger, const char* path, enum ae_log_levels level, uint64_t segment_size, uint32_t rotate_seconds)
+{
+	if (logger->mapped_sink_count == AE_MAX_LOG_SINKS)
+		return -1;
+
+	struct ae_mapped_sink* sink = ae_mapped_sink_create(path, segment_size, rotate_seconds);
+
+	if (!sink)
+		return -1;
+
+	logger->mapped_sinks[logger->mapped_sink_count].level = level;
+	logger->mapped_sinks[logger->mapped_sink_count].data = sink;
+
+	return logger->mapped_sink_count++;
+}
+
+static bool ae_logger_get_mapped_file_sink_stats(struct ae_logger* logger, int32_t index, struct ae_log_file_sink_stats* stats)
+{
+	if (index < 0 || index >= logger->mapped_sink_count)
+		return false;
+
+	ae_mapped_sink_get_stats(logger->mapped_sinks[index].data, stats);
+
+	return true;
+}
+
 static struct ae_logger* ae_logger_get_main_logger()
 {
 	return main_logger;
@@ -242,49 +541,392 @@ static struct ae_logger* ae_logger_get_or_create_main_logger(enum ae_log_levels
 
 	main_logger = ae_logger_create(level);
 
+	if (!main_logger)
+		return NULL;
+
 	ae_logger_add_console_sink(main_logger, stderr, level);
+	ae_atomic_store_u32((volatile uint32_t*)&main_level, (uint32_t)level);
 
 	return main_logger;
 }
 
-static void ae_logger_log(struct ae_logger* logger, enum ae_log_levels level, const char* file, int32_t line, const char* fmt, ...)
+// the log macros go through the main logger, an async logger moves their formatting and writing off the calling thread
+static struct ae_logger* ae_logger_set_main_logger(struct ae_logger* logger)
+{
+	// counts suppressed so far belong to the logger that suppressed them
+	ae_logger_report_suppressed();
+
+	struct ae_logger* previous = main_logger;
+	main_logger = logger;
+	ae_atomic_store_u32((volatile uint32_t*)&main_level, logger ? (uint32_t)logger->level : (uint32_t)AE_LOG_LEVEL_OFF);
+
+	return previous;
+}
+
+static bool ae_logger_set_level(struct ae_logger* logger, enum ae_log_levels level)
+{
+	if (!logger)
+		return false;
+
+	logger->level = level;
+
+	if (logger == main_logger)
+		ae_atomic_store_u32((volatile uint32_t*)&main_level, (uint32_t)level);
+
+	return true;
+}
+
+static void ae_logger_logv(struct ae_logger* logger, enum ae_log_levels level, const char* file, int32_t line, const char* fmt, va_list arguments)
 {
 	struct ae_logger_event event = {
 	.fmt = fmt,
 	.file = file,
 	.line = line,
 	.level = level,
+	.ticks = ae_log_clock_ticks()
 	};
 
-	// fix warning(C4996) on WIN32
-#ifdef WIN32
-	time_t t = time(NULL);
-	localtime_s(&event.time, &t);
-#else
-	time_t t = time(NULL);
-	event.time = *localtime(&t);
-#endif // WIN32
-
-	va_start(event.arguments, fmt);
+	va_copy(event.arguments, arguments);
 	logger->log_function(logger, &event);
 	va_end(event.arguments);
 }
 
+static void ae_logger_log(struct ae_logger* logger, enum ae_log_levels level, const char* file, int32_t line, const char* fmt, ...)
+{
+	va_list arguments;
+	va_start(arguments, fmt);
+	ae_logger_logv(logger, level, file, line, fmt, arguments);
+	va_end(arguments);
+}
+
 static void ae_logger_log_main(enum ae_log_levels level, const char* file, int32_t line, const char* fmt, ...)
 {
-	ae_logger_log(main_logger, level, file, line, fmt);
+	if (!main_logger)
+		return;
+
+	va_list arguments;
+	va_start(arguments, fmt);
+	ae_logger_logv(main_logger, level, file, line, fmt, arguments);
+	va_end(arguments);
+}
+
+static void ae_logger_lock_sites()
+{
+	while (!ae_atomic_cas_u32(&site_lock, 0, 1))
+		ae_thread_yield();
+}
+
+static void ae_logger_unlock_sites()
+{
+	ae_atomic_store_u32(&site_lock, 0);
+}
+
+static bool ae_log_site_rule_matches(const struct ae_log_site_rule* rule, const struct ae_log_site* site)
+{
+	if (rule->line != 0 && rule->line != site->line)
+		return false;
+
+	size_t file_length = strlen(site->file);
+	size_t rule_length = strlen(rule->file);
+
+	return rule_length <= file_length && strcmp(site->file + file_length - rule_length, rule->file) == 0;
+}
+
+// base address of the library or executable holding address, NULL if it is not part of one
+static const void* ae_log_get_module(const void* address)
+{
+#ifdef _WIN32
+	HMODULE module = NULL;
+
+	if (!GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT, (LPCSTR)address, &module))
+		return NULL;
+
+	return module;
+#else
+	Dl_info info;
+
+	if (!dladdr(address, &info))
+		return NULL;
+
+	return info.dli_fbase;
+#endif // _WIN32
+}
+
+// the site goes back to unregistered, must be called with the site lock held
+static void ae_log_site_forget(struct ae_log_site* site)
+{
+	struct ae_log_site_limit* limit = ae_atomic_load_ptr((void* volatile*)&site->limit);
+
+	if (limit)
+	{
+		ae_atomic_store_ptr((void* volatile*)&site->limit, NULL);
+		limit->next_retired = retired_limits;
+		retired_limits = limit;
+	}
+
+	site->next = NULL;
+	ae_atomic_store_u32(&site->flags, 0);
+}
+
+// later rules win, must be called with the site lock held
+static void ae_log_site_apply_rules(struct ae_log_site* site)
+{
+	uint32_t flags = AE_LOG_SITE_REGISTERED;
+	const struct ae_log_site_rule* limit = NULL;
+
+	for (uint32_t i = 0; i < site_rule_count; i++)
+	{
+		if (!ae_log_site_rule_matches(&site_rules[i], site))
+			continue;
+
+		if (site_rules[i].type == AE_LOG_SITE_RULE_LIMIT)
+			limit = &site_rules[i];
+		else
+			flags = site_rules[i].enabled ? AE_LOG_SITE_REGISTERED : AE_LOG_SITE_REGISTERED | AE_LOG_SITE_DISABLED;
+	}
+
+	if (limit && (limit->interval || limit->sample_every > 1))
+	{
+		// the state outlives the rule, suppressed messages are still reported after the limit is lifted
+		struct ae_log_site_limit* state = ae_atomic_load_ptr((void* volatile*)&site->limit);
+		bool created = !state;
+
+		if (created)
+			state = calloc(1, sizeof(*state));
+
+		if (state)
+		{
+			ae_atomic_exchange_u64(&state->interval, limit->interval);
+			ae_atomic_exchange_u64(&state->tolerance, limit->tolerance);
+			ae_atomic_store_u32(&state->sample_every, limit->sample_every);
+			flags |= AE_LOG_SITE_LIMITED;
+
+			// published once it is filled in
+			if (created)
+				ae_atomic_store_ptr((void* volatile*)&site->limit, state);
+		}
+	}
+
+	ae_atomic_store_u32(&site->flags, flags);
+}
+
+static bool ae_logger_register_site(struct ae_log_site* site)
+{
+	ae_logger_lock_sites();
+
+	// another thread may have registered the site while we were waiting
+	if (!(ae_atomic_load_u32(&site->flags) & AE_LOG_SITE_REGISTERED))
+	{
+		site->next = sites;
+		sites = site;
+		ae_log_site_apply_rules(site);
+	}
+
+	bool enabled = !(site->flags & AE_LOG_SITE_DISABLED);
+
+	ae_logger_unlock_sites();
+
+	return enabled;
+}
+
+// sites are static data of the module they log from, they must leave the list before the module is unloaded
+static void ae_logger_unregister_sites(const void* module_address)
+{
+	const void* module = ae_log_get_module(module_address);
+
+	if (!module)
+		return;
+
+	ae_logger_lock_sites();
+
+	struct ae_log_site** link = &sites;
+
+	while (*link)
+	{
+		struct ae_log_site* site = *link;
+
+		if (ae_log_get_module(site) == module)
+		{
+			*link = site->next;
+			ae_log_site_forget(site);
+		}
+		else
+		{
+			link = &site->next;
+		}
+	}
+
+	ae_logger_unlock_sites();
+}
+
+static uint32_t ae_logger_add_site_rule(const struct ae_log_site_rule* rule)
+{
+	ae_logger_lock_sites();
+
+	// a rule of the same type for the same sites replaces the old one, the oldest rule makes room when full
+	uint32_t index = 0;
+
+	while (index < site_rule_count && (site_rules[index].type != rule->type || site_rules[index].line != rule->line || strcmp(site_rules[index].file, rule->file) != 0))
+		index++;
+
+	if (index == AE_MAX_LOG_SITE_RULES)
+		index = 0;
+
+	if (index < site_rule_count)
+	{
+		memmove(&site_rules[index], &site_rules[index + 1], sizeof(*site_rules) * (site_rule_count - index - 1));
+		site_rule_count--;
+	}
+
+	site_rules[site_rule_count++] = *rule;
+
+	uint32_t count = 0;
+
+	for (struct ae_log_site* site = sites; site; site = site->next)
+	{
+		if (ae_log_site_rule_matches(rule, site))
+		{
+			ae_log_site_apply_rules(site);
+			count++;
+		}
+	}
+
+	ae_logger_unlock_sites();
+
+	return count;
+}
+
+static uint32_t ae_logger_set_site_enabled(const char* file, int32_t line, bool enabled)
+{
+	if (!file)
+		return 0;
+
+	struct ae_log_site_rule rule = { .type = AE_LOG_SITE_RULE_ENABLE, .line = line, .enabled = enabled };
+	strncpy(rule.file, file, sizeof(rule.file) - 1);
+
+	return ae_logger_add_site_rule(&rule);
+}
+
+static uint32_t ae_logger_set_site_rate_limit(const char* file, int32_t line, float messages_per_second, uint32_t burst, uint32_t sample_every)
+{
+	if (!file)
+		return 0;
+
+	struct ae_log_site_rule rule = { .type = AE_LOG_SITE_RULE_LIMIT, .line = line, .sample_every = sample_every };
+	strncpy(rule.file, file, sizeof(rule.file) - 1);
+
+	// also times the reports of suppressed messages
+	ae_log_clock_init();
+
+	if (messages_per_second > 0.0f)
+	{
+		rule.interval = (uint64_t)((double)ae_log_clock_ticks_per_second() / messages_per_second);
+		rule.interval = rule.interval ? rule.interval : 1;
+		rule.tolerance = rule.interval * (burst ? burst - 1 : 0);
+	}
+
+	return ae_logger_add_site_rule(&rule);
+}
+
+// the token bucket is kept as the time the bucket is full again (gcra), one compare and
+// swap per message and no lock on the logging threads
+static bool ae_logger_admit_site(struct ae_log_site* site)
+{
+	struct ae_log_site_limit* limit = ae_atomic_load_ptr((void* volatile*)&site->limit);
+
+	if (!limit)
+		return true;
+
+	const uint32_t sample_every = ae_atomic_load_u32(&limit->sample_every);
+	const uint64_t interval = ae_atomic_load_u64(&limit->interval);
+	const uint64_t tolerance = ae_atomic_load_u64(&limit->tolerance);
+	const uint64_t now = ae_log_clock_ticks();
+
+	bool admitted = sample_every <= 1 || ae_atomic_add_u32(&limit->counter, 1) % sample_every == 0;
+
+	if (admitted && interval)
+	{
+		uint64_t arrival;
+
+		do
+		{
+			arrival = ae_atomic_load_u64(&limit->arrival);
+
+			if (arrival > now + tolerance)
+			{
+				admitted = false;
+				break;
+			}
+		} while (!ae_atomic_cas_u64(&limit->arrival, arrival, (arrival > now ? arrival : now) + interval));
+	}
+
+	if (!admitted)
+	{
+		ae_atomic_add_u32(&limit->suppressed, 1);
+
+		// a site that is never admitted again would hold on to its count until the logger is flushed,
+		// the first suppressed message only starts the period
+		uint64_t report = ae_atomic_load_u64(&next_suppressed_report);
+
+		if (now >= report && ae_atomic_cas_u64(&next_suppressed_report, report, now + ae_log_clock_ticks_per_second() * AE_LOG_SUPPRESSED_REPORT_SECONDS) && report)
+			ae_logger_report_suppressed();
+
+		return false;
+	}
+
+	uint32_t suppressed = ae_atomic_exchange_u32(&limit->suppressed, 0);
+
+	if (suppressed && main_logger)
+		ae_logger_log(main_logger, site->level, site->file, site->line, "message repeated %u times", suppressed);
+
+	return true;
+}
+
+static void ae_logger_report_suppressed()
+{
+	if (!main_logger)
+		return;
+
+	ae_logger_lock_sites();
+
+	for (struct ae_log_site* site = sites; site; site = site->next)
+	{
+		struct ae_log_site_limit* limit = ae_atomic_load_ptr((void* volatile*)&site->limit);
+		uint32_t suppressed = limit ? ae_atomic_exchange_u32(&limit->suppressed, 0) : 0;
+
+		if (suppressed)
+			ae_logger_log(main_logger, site->level, site->file, site->line, "message repeated %u times", suppressed);
+	}
+
+	ae_logger_unlock_sites();
 }
 
 static struct ae_logging_api logging_api =
 {
 	.get_main_logger = ae_logger_get_main_logger,
 	.get_or_create_main_logger = ae_logger_get_or_create_main_logger,
+	.set_main_logger = ae_logger_set_main_logger,
 	.create = ae_logger_create,
 	.create_threaded = ae_logger_create_threaded,
+	.create_async = ae_logger_create_async,
+	.destroy = ae_logger_destroy,
+	.flush = ae_logger_flush,
+	.get_dropped_count = ae_logger_get_dropped_count,
+	.create_binary = ae_logger_create_binary,
+	.log_binary = ae_binary_logger_log,
 	.add_console_sink = ae_logger_add_console_sink,
 	.add_file_sink = ae_logger_add_file_sink,
+	.add_mapped_file_sink = ae_logger_add_mapped_file_sink,
+	.get_mapped_file_sink_stats = ae_logger_get_mapped_file_sink_stats,
+	.set_level = ae_logger_set_level,
 	.log = ae_logger_log,
-	.log_main = ae_logger_log_main
+	.log_main = ae_logger_log_main,
+	.main_level = &main_level,
+	.register_site = ae_logger_register_site,
+	.set_site_enabled = ae_logger_set_site_enabled,
+	.set_site_rate_limit = ae_logger_set_site_rate_limit,
+	.admit_site = ae_logger_admit_site,
+	.unregister_sites = ae_logger_unregister_sites
 };
 
 AE_DLL_EXPORT void plugin_load(struct ae_api_registry_api* registry, bool reload)
@@ -297,4 +939,26 @@ AE_DLL_EXPORT void plugin_load(struct ae_api_registry_api* registry, bool reload
 AE_DLL_EXPORT void plugin_unload(struct ae_api_registry_api* registry)
 {
 	AE_UNREFERENCED_PARAMETER(registry);
+
+	if (main_logger)
+		ae_logger_flush(main_logger);
+
+	// the list dies with this library, the sites register again with the one loaded next
+	ae_logger_lock_sites();
+
+	while (sites)
+	{
+		struct ae_log_site* site = sites;
+		sites = site->next;
+		ae_log_site_forget(site);
+	}
+
+	while (retired_limits)
+	{
+		struct ae_log_site_limit* limit = retired_limits;
+		retired_limits = limit->next_retired;
+		free(limit);
+	}
+
+	ae_logger_unlock_sites();
 }
@@ -0,0 +1,105 @@
+#include "mapped_file.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif // !_WIN32
+
+// fault the pages in up front so the first write to a page does not stall the logging thread
+#ifdef MAP_POPULATE
+#define AE_MAP_POPULATE MAP_POPULATE
+#else
+#define AE_MAP_POPULATE 0
+#endif // MAP_POPULATE
+
+bool ae_mapped_file_open(struct ae_mapped_file* file, const char* path, const uint64_t size)
+{
+	file->size = size;
+	file->data = NULL;
+
+#ifdef _WIN32
+	file->file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (file->file == INVALID_HANDLE_VALUE)
+		return false;
+
+	file->mapping = CreateFileMappingA(file->file, NULL, PAGE_READWRITE, (DWORD)(size >> 32), (DWORD)size, NULL);
+
+	if (!file->mapping)
+	{
+		CloseHandle(file->file);
+		return false;
+	}
+
+	file->data = MapViewOfFile(file->mapping, FILE_MAP_WRITE, 0, 0, (SIZE_T)size);
+
+	if (!file->data)
+	{
+		CloseHandle(file->mapping);
+		CloseHandle(file->file);
+		return false;
+	}
+#else
+	file->file = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+	if (file->file == -1)
+		return false;
+
+	if (ftruncate(file->file, (off_t)size) != 0)
+	{
+		close(file->file);
+		return false;
+	}
+
+	void* data = mmap(NULL, (size_t)size, PROT_READ | PROT_WRITE, MAP_SHARED | AE_MAP_POPULATE, file->file, 0);
+
+	if (data == MAP_FAILED)
+	{
+		close(file->file);
+		return false;
+	}
+
+	file->data = data;
+#endif // _WIN32
+
+	return true;
+}
+
+void ae_mapped_file_flush(struct ae_mapped_file* file)
+{
+#ifdef _WIN32
+	FlushViewOfFile(file->data, 0);
+#else
+	msync(file->data, (size_t)file->size, MS_ASYNC);
+#endif // _WIN32
+}
+
+bool ae_mapped_file_close(struct ae_mapped_file* file, const uint64_t used_size)
+{
+	bool truncated = false;
+	uint64_t size = used_size < file->size ? used_size : file->size;
+
+#ifdef _WIN32
+	LARGE_INTEGER end = { .QuadPart = (LONGLONG)size };
+
+	UnmapViewOfFile(file->data);
+	CloseHandle(file->mapping);
+
+	// shrink the file to the part that was written
+	if (SetFilePointerEx(file->file, end, NULL, FILE_BEGIN))
+		truncated = SetEndOfFile(file->file);
+	CloseHandle(file->file);
+#else
+	munmap(file->data, (size_t)file->size);
+
+	// shrink the file to the part that was written
+	truncated = ftruncate(file->file, (off_t)size) == 0;
+
+	close(file->file);
+#endif // _WIN32
+
+	file->data = NULL;
+
+	return truncated;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <core/os.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct ae_mapped_file
+{
+#ifdef _WIN32
+	HANDLE		file;
+	HANDLE		mapping;
+#else
+	int			file;
+#endif // _WIN32
+	uint8_t*	data;
+	uint64_t	size;
+};
+
+bool ae_mapped_file_open(struct ae_mapped_file* file, const char* path, const uint64_t size);
+void ae_mapped_file_flush(struct ae_mapped_file* file);
+bool ae_mapped_file_close(struct ae_mapped_file* file, const uint64_t used_size);
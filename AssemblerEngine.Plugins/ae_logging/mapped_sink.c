@@ -0,0 +1,391 @@
+#include "logger.h"
+#include "log_clock.h"
+#include "log_compression.h"
+#include "mapped_file.h"
+
+#include <core/atomic.h>
+#include <core/thread.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <dirent.h>
+#endif // !_WIN32
+
+#ifndef AE_LOG_MAPPED_SINK_MIN_SEGMENT_SIZE
+#define AE_LOG_MAPPED_SINK_MIN_SEGMENT_SIZE (64 * 1024)
+#endif // !AE_LOG_MAPPED_SINK_MIN_SEGMENT_SIZE
+
+// segments waiting for the background thread to be closed and compressed
+#ifndef AE_LOG_MAPPED_SINK_MAX_RETIRED
+#define AE_LOG_MAPPED_SINK_MAX_RETIRED 4
+#endif // !AE_LOG_MAPPED_SINK_MAX_RETIRED
+
+#define AE_LOG_MAPPED_SINK_PATH_LENGTH 260
+
+struct ae_log_segment
+{
+	struct ae_mapped_file file;
+	uint64_t used;
+	uint64_t opened_ticks;
+	uint32_t index;
+};
+
+// the writers append under a short spin lock, every file system call (opening the next
+// segment, truncating and compressing old ones) happens on the background thread.
+// the mapped pages belong to the os, a crashing process does not lose what was written.
+struct ae_mapped_sink
+{
+	char path[AE_LOG_MAPPED_SINK_PATH_LENGTH];
+	struct ae_log_segment current;
+	struct ae_log_segment next;
+	struct ae_log_segment retired[AE_LOG_MAPPED_SINK_MAX_RETIRED];
+	struct ae_thread worker;
+
+	uint64_t segment_size;
+	uint64_t rotate_ticks;
+
+	volatile uint64_t bytes_written;
+	volatile uint64_t bytes_per_second;
+	volatile uint64_t dropped_count;
+	volatile uint32_t compressed_count;
+	uint32_t segment_count;
+	uint32_t retired_count;
+	uint32_t next_index;
+
+	volatile uint32_t lock;
+	volatile uint32_t running;
+	bool next_ready;
+	bool failed;
+};
+
+static void ae_mapped_sink_lock(struct ae_mapped_sink* sink)
+{
+	while (!ae_atomic_cas_u32(&sink->lock, 0, 1))
+		ae_thread_yield();
+}
+
+static void ae_mapped_sink_unlock(struct ae_mapped_sink* sink)
+{
+	ae_atomic_store_u32(&sink->lock, 0);
+}
+
+static void ae_mapped_sink_segment_path(const struct ae_mapped_sink* sink, const uint32_t index, char* path, const size_t size)
+{
+	snprintf(path, size, "%s.%04u", sink->path, index);
+}
+
+// remembers the index after the one of a segment of the sink, compressed or not
+static void ae_mapped_sink_parse_index(const char* file, const char* name, const size_t name_length, uint32_t* next_index)
+{
+	if (strncmp(file, name, name_length) != 0 || file[name_length] != '.' || file[name_length + 1] < '0' || file[name_length + 1] > '9')
+		return;
+
+	char* end;
+	unsigned long index = strtoul(file + name_length + 1, &end, 10);
+
+	if ((*end == '\0' || strcmp(end, AE_LOG_COMPRESSED_EXTENSION) == 0) && index < UINT32_MAX && index + 1 > *next_index)
+		*next_index = (uint32_t)index + 1;
+}
+
+// the segments of earlier runs are kept, numbering continues after the highest one
+static uint32_t ae_mapped_sink_find_first_index(const char* path)
+{
+	const char* name = path;
+
+	for (const char* c = path; *c; c++)
+	{
+		if (*c == '/' || *c == '\\')
+			name = c + 1;
+	}
+
+	const size_t name_length = strlen(name);
+	uint32_t next_index = 0;
+
+#ifdef _WIN32
+	char pattern[AE_LOG_MAPPED_SINK_PATH_LENGTH + 8];
+	snprintf(pattern, sizeof(pattern), "%s.*", path);
+
+	WIN32_FIND_DATAA data;
+	HANDLE find = FindFirstFileA(pattern, &data);
+
+	if (find == INVALID_HANDLE_VALUE)
+		return 0;
+
+	do
+	{
+		ae_mapped_sink_parse_index(data.cFileName, name, name_length, &next_index);
+	} while (FindNextFileA(find, &data));
+
+	FindClose(find);
+#else
+	char directory[AE_LOG_MAPPED_SINK_PATH_LENGTH];
+
+	if (name == path)
+	{
+		strcpy(directory, ".");
+	}
+	else
+	{
+		memcpy(directory, path, (size_t)(name - path));
+		directory[name - path] = '\0';
+	}
+
+	DIR* dir = opendir(directory);
+
+	if (!dir)
+		return 0;
+
+	for (struct dirent* entry = readdir(dir); entry; entry = readdir(dir))
+		ae_mapped_sink_parse_index(entry->d_name, name, name_length, &next_index);
+
+	closedir(dir);
+#endif // _WIN32
+
+	return next_index;
+}
+
+static bool ae_mapped_sink_open_segment(struct ae_mapped_sink* sink, struct ae_log_segment* segment, const uint32_t index)
+{
+	char path[AE_LOG_MAPPED_SINK_PATH_LENGTH + 16];
+	ae_mapped_sink_segment_path(sink, index, path, sizeof(path));
+
+	if (!ae_mapped_file_open(&segment->file, path, sink->segment_size))
+		return false;
+
+	segment->used = 0;
+	segment->opened_ticks = ae_log_clock_ticks();
+	segment->index = index;
+
+	return true;
+}
+
+static void ae_mapped_sink_close_segment(struct ae_mapped_sink* sink, struct ae_log_segment* segment, const bool compress)
+{
+	char path[AE_LOG_MAPPED_SINK_PATH_LENGTH + 16];
+	char compressed_path[AE_LOG_MAPPED_SINK_PATH_LENGTH + 32];
+	ae_mapped_sink_segment_path(sink, segment->index, path, sizeof(path));
+
+	bool truncated = ae_mapped_file_close(&segment->file, segment->used);
+
+	// an unused segment is only left over by the prepared one at shutdown
+	if (segment->used == 0)
+	{
+		remove(path);
+		return;
+	}
+
+	if (!compress || !truncated)
+		return;
+
+	snprintf(compressed_path, sizeof(compressed_path), "%s" AE_LOG_COMPRESSED_EXTENSION, path);
+
+	if (ae_log_compress_file(path, compressed_path))
+	{
+		remove(path);
+		ae_atomic_add_u32(&sink->compressed_count, 1);
+	}
+}
+
+// must be called with the lock held, returns false if there is no prepared segment yet
+static bool ae_mapped_sink_rotate(struct ae_mapped_sink* sink)
+{
+	if (!sink->next_ready || sink->retired_count == AE_LOG_MAPPED_SINK_MAX_RETIRED)
+		return false;
+
+	sink->retired[sink->retired_count++] = sink->current;
+	sink->current = sink->next;
+	sink->current.opened_ticks = ae_log_clock_ticks();
+	sink->next_ready = false;
+	sink->segment_count++;
+
+	return true;
+}
+
+static void ae_mapped_sink_prepare_next(struct ae_mapped_sink* sink)
+{
+	ae_mapped_sink_lock(sink);
+	bool ready = sink->next_ready;
+	uint32_t index = sink->next_index;
+	ae_mapped_sink_unlock(sink);
+
+	if (ready)
+		return;
+
+	struct ae_log_segment segment;
+	bool opened = ae_mapped_sink_open_segment(sink, &segment, index);
+
+	ae_mapped_sink_lock(sink);
+
+	if (opened)
+	{
+		sink->next = segment;
+		sink->next_ready = true;
+		sink->next_index++;
+	}
+
+	// writers waiting for this segment give up instead of spinning forever
+	sink->failed = !opened;
+
+	ae_mapped_sink_unlock(sink);
+}
+
+static void ae_mapped_sink_close_retired(struct ae_mapped_sink* sink, const bool compress)
+{
+	for (;;)
+	{
+		ae_mapped_sink_lock(sink);
+
+		if (sink->retired_count == 0)
+		{
+			ae_mapped_sink_unlock(sink);
+			return;
+		}
+
+		struct ae_log_segment segment = sink->retired[0];
+		memmove(&sink->retired[0], &sink->retired[1], sizeof(*sink->retired) * --sink->retired_count);
+
+		ae_mapped_sink_unlock(sink);
+
+		ae_mapped_sink_close_segment(sink, &segment, compress);
+	}
+}
+
+static void ae_mapped_sink_worker(void* data)
+{
+	struct ae_mapped_sink* sink = data;
+	uint64_t ticks_per_second = ae_log_clock_ticks_per_second();
+	uint64_t report_ticks = ae_log_clock_ticks();
+	uint64_t report_bytes = 0;
+
+	while (ae_atomic_load_u32(&sink->running))
+	{
+		ae_mapped_sink_prepare_next(sink);
+		ae_mapped_sink_close_retired(sink, true);
+
+		uint64_t now = ae_log_clock_ticks();
+
+		if (sink->rotate_ticks)
+		{
+			ae_mapped_sink_lock(sink);
+
+			if (sink->current.used && now - sink->current.opened_ticks >= sink->rotate_ticks)
+				ae_mapped_sink_rotate(sink);
+
+			ae_mapped_sink_unlock(sink);
+		}
+
+		if (now - report_ticks >= ticks_per_second)
+		{
+			uint64_t bytes = ae_atomic_load_u64(&sink->bytes_written);
+			uint64_t rate = (uint64_t)((double)(bytes - report_bytes) * (double)ticks_per_second / (double)(now - report_ticks));
+
+			ae_atomic_exchange_u64(&sink->bytes_per_second, rate);
+			report_bytes = bytes;
+			report_ticks = now;
+		}
+
+		ae_thread_sleep(1);
+	}
+}
+
+struct ae_mapped_sink* ae_mapped_sink_create(const char* path, const uint64_t segment_size, const uint32_t rotate_seconds)
+{
+	if (!path || strlen(path) >= AE_LOG_MAPPED_SINK_PATH_LENGTH)
+		return NULL;
+
+	struct ae_mapped_sink* sink = calloc(1, sizeof(*sink));
+
+	if (!sink)
+		return NULL;
+
+	ae_log_clock_init();
+
+	strcpy(sink->path, path);
+	sink->segment_size = segment_size < AE_LOG_MAPPED_SINK_MIN_SEGMENT_SIZE ? AE_LOG_MAPPED_SINK_MIN_SEGMENT_SIZE : segment_size;
+	sink->rotate_ticks = (uint64_t)rotate_seconds * ae_log_clock_ticks_per_second();
+	sink->segment_count = 1;
+	sink->running = 1;
+
+	uint32_t first_index = ae_mapped_sink_find_first_index(path);
+	sink->next_index = first_index + 1;
+
+	if (!ae_mapped_sink_open_segment(sink, &sink->current, first_index))
+	{
+		free(sink);
+		return NULL;
+	}
+
+	if (!ae_thread_create(&sink->worker, ae_mapped_sink_worker, sink))
+	{
+		ae_mapped_sink_close_segment(sink, &sink->current, false);
+		free(sink);
+		return NULL;
+	}
+
+	return sink;
+}
+
+void ae_mapped_sink_destroy(struct ae_mapped_sink* sink)
+{
+	ae_atomic_store_u32(&sink->running, 0);
+	ae_thread_join(&sink->worker);
+
+	ae_mapped_sink_close_retired(sink, true);
+	ae_mapped_sink_close_segment(sink, &sink->current, false);
+
+	if (sink->next_ready)
+		ae_mapped_sink_close_segment(sink, &sink->next, false);
+
+	free(sink);
+}
+
+void ae_mapped_sink_write(struct ae_mapped_sink* sink, const char* data, const uint32_t length)
+{
+	ae_mapped_sink_lock(sink);
+
+	while (sink->current.used + length > sink->current.file.size)
+	{
+		if (ae_mapped_sink_rotate(sink))
+			continue;
+
+		// lines never exceed the minimum segment size, the background thread is just behind
+		if (sink->failed || length > sink->segment_size)
+		{
+			ae_mapped_sink_unlock(sink);
+			ae_atomic_add_u64(&sink->dropped_count, 1);
+			return;
+		}
+
+		ae_mapped_sink_unlock(sink);
+		ae_thread_yield();
+		ae_mapped_sink_lock(sink);
+	}
+
+	memcpy(sink->current.file.data + sink->current.used, data, length);
+	sink->current.used += length;
+	ae_atomic_add_u64(&sink->bytes_written, length);
+
+	ae_mapped_sink_unlock(sink);
+}
+
+void ae_mapped_sink_flush(struct ae_mapped_sink* sink)
+{
+	ae_mapped_sink_lock(sink);
+	ae_mapped_file_flush(&sink->current.file);
+	ae_mapped_sink_unlock(sink);
+}
+
+void ae_mapped_sink_get_stats(struct ae_mapped_sink* sink, struct ae_log_file_sink_stats* stats)
+{
+	ae_mapped_sink_lock(sink);
+	stats->segment_count = sink->segment_count;
+	ae_mapped_sink_unlock(sink);
+
+	stats->bytes_written = ae_atomic_load_u64(&sink->bytes_written);
+	stats->bytes_per_second = ae_atomic_load_u64(&sink->bytes_per_second);
+	stats->dropped_count = ae_atomic_load_u64(&sink->dropped_count);
+	stats->compressed_segment_count = ae_atomic_load_u32(&sink->compressed_count);
+}
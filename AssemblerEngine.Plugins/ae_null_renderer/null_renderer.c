@@ -0,0 +1,1345 @@
+#include "render_recording.h"
+#include "render_batch.h"
+#include "render_queue.h"
+
+#include <apis/api_registry.h>
+#include <apis/camera.h>
+#include <apis/opengl_backend.h>
+#include <apis/render_recorder.h>
+#include <apis/renderer.h>
+#include <apis/shader.h>
+#include <apis/texture.h>
+#include <apis/window.h>
+#include <core/core.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// renders nothing, every call is recorded instead. the batches run the cpu side the opengl backend
+// runs (render_batch.c) and record where it would call the driver, so the recording holds the bytes
+// the opengl backend would draw and profiling it shows the cost without a driver
+
+#ifndef AE_NULL_RENDERER_INITIAL_CAPACITY
+#define AE_NULL_RENDERER_INITIAL_CAPACITY (1024 * 1024)
+#endif // !AE_NULL_RENDERER_INITIAL_CAPACITY
+
+// the recording stops growing here, later commands are counted as dropped
+#ifndef AE_NULL_RENDERER_MAX_CAPACITY
+#define AE_NULL_RENDERER_MAX_CAPACITY (1024ull * 1024 * 1024)
+#endif // !AE_NULL_RENDERER_MAX_CAPACITY
+
+// what GL_MAX_TEXTURE_IMAGE_UNITS reports on most desktop drivers
+#ifndef AE_NULL_RENDERER_TEXTURE_UNITS
+#define AE_NULL_RENDERER_TEXTURE_UNITS 32
+#endif // !AE_NULL_RENDERER_TEXTURE_UNITS
+
+#define AE_NULL_RENDERER_WIDTH 1280
+#define AE_NULL_RENDERER_HEIGHT 720
+
+struct ae_null_shader
+{
+	// handed out to the user, must stay the first member
+	struct ae_shader shader;
+	// recorded again when the recording is reset
+	uint8_t* create_command;
+	uint32_t create_size;
+	uint32_t index;
+	struct ae_null_shader* next;
+};
+
+struct ae_pending_shader
+{
+	struct ae_shader* shader;
+	ae_shader_ready_callback callback;
+	void* user_data;
+};
+
+struct ae_null_batch
+{
+	// handed out to the user, must stay the first member
+	struct ae_render_batch batch;
+	// the regions one after the other, like the vertex buffer of an opengl batch
+	uint8_t* memory;
+	struct ae_null_shader* shader;
+	struct ae_texture_binding_desc binding;
+	uint32_t index;
+	bool has_format;
+};
+
+// keeps its quads as recorded so a reset can record the batch again as it is now
+struct ae_static_batch
+{
+	struct ae_render_command_textured_quad* quads;
+	struct ae_null_shader* shader;
+	struct ae_vertex_format format;
+	uint32_t index;
+	uint32_t quad_count;
+	bool has_format;
+	bool updatable;
+};
+
+struct ae_opengl_backend
+{
+	uint32_t width;
+	uint32_t height;
+};
+
+struct ae_null_renderer
+{
+	uint8_t* data;
+	size_t size;
+	size_t capacity;
+	struct ae_render_recorder_stats stats;
+
+	struct ae_null_shader* shaders;
+	struct ae_pending_shader* pending;
+	uint32_t pending_count;
+	uint32_t pending_capacity;
+
+	struct ae_null_batch** batches;
+	uint32_t batch_count;
+	uint32_t batch_capacity;
+
+	struct ae_static_batch** static_batches;
+	uint32_t static_batch_count;
+	uint32_t static_batch_capacity;
+
+	struct ae_texture** textures;
+	uint32_t texture_count;
+	uint32_t texture_capacity;
+
+	uint32_t next_shader;
+	uint32_t next_batch;
+	uint32_t next_static_batch;
+	uint32_t next_texture;
+
+	// changes when a texture is destroyed, the layers of array bindings are bound again
+	uint64_t texture_generation;
+
+	// state changing commands, the null renderer has no gl state to skip
+	struct ae_render_state_stats frame;
+	struct ae_render_state_stats last_frame;
+
+	struct ae_opengl_backend backend;
+	bool backend_created;
+	bool record_vertices;
+};
+
+static struct ae_null_renderer renderer = { .next_shader = 1, .next_batch = 1, .next_static_batch = 1, .next_texture = 1, .record_vertices = true };
+
+static bool reserve_recording(const size_t size)
+{
+	if (renderer.size + size <= renderer.capacity)
+		return true;
+
+	size_t capacity = renderer.capacity ? renderer.capacity : AE_NULL_RENDERER_INITIAL_CAPACITY;
+
+	while (capacity < renderer.size + size)
+		capacity *= 2;
+
+	if (capacity > AE_NULL_RENDERER_MAX_CAPACITY)
+		return false;
+
+	uint8_t* data = realloc(renderer.data, capacity);
+
+	if (!data)
+		return false;
+
+	renderer.data = data;
+	renderer.capacity = capacity;
+
+	return true;
+}
+
+// appends a command and returns its zeroed payload, NULL if the recording is full.
+// the pointer is only valid until the next command is recorded
+static void* record(const uint32_t type, const uint32_t size)
+{
+	size_t padded = (sizeof(struct ae_render_command_header) + size + AE_RENDER_RECORDING_ALIGNMENT - 1) & ~(size_t)(AE_RENDER_RECORDING_ALIGNMENT - 1);
+
+	if (!reserve_recording(padded))
+	{
+		renderer.stats.dropped_count++;
+		return NULL;
+	}
+
+	struct ae_render_command_header header = { .type = type, .size = size };
+	uint8_t* out = renderer.data + renderer.size;
+
+	memcpy(out, &header, sizeof(header));
+	memset(out + sizeof(header), 0, padded - sizeof(header));
+
+	renderer.size += padded;
+	renderer.stats.command_count++;
+	renderer.stats.byte_count = renderer.size;
+
+	return out + sizeof(header);
+}
+
+static void record_copy(const uint32_t type, const void* payload, const uint32_t size)
+{
+	void* out = record(type, size);
+
+	if (out)
+		memcpy(out, payload, size);
+}
+
+static void record_batch(const uint32_t type, const struct ae_null_batch* batch)
+{
+	const struct ae_render_command_batch command = { .batch = batch->index };
+	record_copy(type, &command, sizeof(command));
+}
+
+static void count_state_change()
+{
+	renderer.frame.issued_count++;
+}
+
+//
+// shaders
+//
+
+static void record_shader_state(const struct ae_null_shader* shader)
+{
+	if (shader->shader.enable_blending)
+	{
+		const struct ae_render_command_shader_set_blending command = {
+			.shader = shader->index,
+			.enable = 1,
+			.source = (uint32_t)shader->shader.blend_source,
+			.destination = (uint32_t)shader->shader.blend_destination
+		};
+
+		record_copy(AE_RENDER_COMMAND_SHADER_SET_BLENDING, &command, sizeof(command));
+	}
+
+	if (shader->shader.enable_depth_test)
+	{
+		const struct ae_render_command_shader_set_depth_test command = { .shader = shader->index, .enable = 1 };
+		record_copy(AE_RENDER_COMMAND_SHADER_SET_DEPTH_TEST, &command, sizeof(command));
+	}
+}
+
+static struct ae_shader* null_shader_create(
+	char* debug_output,
+	const int32_t debug_output_size,
+	const char** stage_sources,
+	const int32_t* stage_sizes,
+	const int32_t* stage_types,
+	const int32_t stage_count)
+{
+	if (stage_count <= 0 || stage_count > AE_RENDER_RECORDING_MAX_STAGES)
+	{
+		snprintf(debug_output, (size_t)debug_output_size, "null renderer: %i stages, at most %i are supported", stage_count, AE_RENDER_RECORDING_MAX_STAGES);
+		return NULL;
+	}
+
+	struct ae_render_command_shader_create command = { .stage_count = (uint32_t)stage_count };
+	uint32_t source_size = 0;
+
+	for (int32_t i = 0; i < stage_count; i++)
+	{
+		if (!stage_sources[i])
+			return NULL;
+
+		command.stage_types[i] = stage_types[i];
+		command.stage_sizes[i] = stage_sizes && stage_sizes[i] >= 0 ? (uint32_t)stage_sizes[i] : (uint32_t)strlen(stage_sources[i]);
+		source_size += command.stage_sizes[i];
+	}
+
+	struct ae_null_shader* shader = calloc(1, sizeof(*shader));
+
+	if (!shader)
+		return NULL;
+
+	shader->create_size = sizeof(command) + source_size;
+	shader->create_command = malloc(shader->create_size);
+
+	if (!shader->create_command)
+	{
+		free(shader);
+		return NULL;
+	}
+
+	shader->index = renderer.next_shader++;
+	shader->shader.id = (int32_t)shader->index;
+	command.shader = shader->index;
+
+	uint8_t* out = shader->create_command;
+	memcpy(out, &command, sizeof(command));
+	out += sizeof(command);
+
+	for (int32_t i = 0; i < stage_count; i++)
+	{
+		memcpy(out, stage_sources[i], command.stage_sizes[i]);
+		out += command.stage_sizes[i];
+	}
+
+	record_copy(AE_RENDER_COMMAND_SHADER_CREATE, shader->create_command, shader->create_size);
+
+	shader->next = renderer.shaders;
+	renderer.shaders = shader;
+
+	return &shader->shader;
+}
+
+static struct ae_shader* null_shader_create_basic(char* debug_output, const int32_t debug_output_size, const char* vertex_shader, const char* fragment_shader)
+{
+	// GL_VERTEX_SHADER and GL_FRAGMENT_SHADER
+	const char* stage_sources[2] = { vertex_shader, fragment_shader };
+	const int32_t stage_types[2] = { 0x8B31, 0x8B30 };
+
+	return null_shader_create(debug_output, debug_output_size, stage_sources, NULL, stage_types, 2);
+}
+
+static void null_shader_set_blending(struct ae_shader* shader, bool enable, uint32_t source, uint32_t destination)
+{
+	if (shader == NULL)
+		return;
+
+	shader->enable_blending = enable;
+	shader->blend_source = (int32_t)source;
+	shader->blend_destination = (int32_t)destination;
+
+	const struct ae_render_command_shader_set_blending command = {
+		.shader = ((struct ae_null_shader*)shader)->index,
+		.enable = enable,
+		.source = source,
+		.destination = destination
+	};
+
+	record_copy(AE_RENDER_COMMAND_SHADER_SET_BLENDING, &command, sizeof(command));
+	count_state_change();
+}
+
+static void null_shader_set_depth_test(struct ae_shader* shader, bool enable)
+{
+	if (shader == NULL)
+		return;
+
+	shader->enable_depth_test = enable;
+
+	const struct ae_render_command_shader_set_depth_test command = {
+		.shader = ((struct ae_null_shader*)shader)->index,
+		.enable = enable
+	};
+
+	record_copy(AE_RENDER_COMMAND_SHADER_SET_DEPTH_TEST, &command, sizeof(command));
+	count_state_change();
+}
+
+// nothing compiles, the callback is only delayed to the next poll like it would be with a driver
+static bool null_shader_create_async(
+	const char** stage_sources,
+	const int32_t* stage_sizes,
+	const int32_t* stage_types,
+	int32_t stage_count,
+	ae_shader_ready_callback callback,
+	void* user_data)
+{
+	if (!callback)
+		return false;
+
+	if (renderer.pending_count == renderer.pending_capacity)
+	{
+		uint32_t capacity = renderer.pending_capacity ? renderer.pending_capacity * 2 : 16;
+		struct ae_pending_shader* pending = realloc(renderer.pending, sizeof(*pending) * capacity);
+
+		if (!pending)
+			return false;
+
+		renderer.pending = pending;
+		renderer.pending_capacity = capacity;
+	}
+
+	char debug_output[128] = { 0 };
+	struct ae_shader* shader = null_shader_create(debug_output, sizeof(debug_output), stage_sources, stage_sizes, stage_types, stage_count);
+
+	if (!shader)
+		return false;
+
+	renderer.pending[renderer.pending_count++] = (struct ae_pending_shader){ shader, callback, user_data };
+
+	return true;
+}
+
+static uint32_t null_shader_poll_async()
+{
+	// in the order they were submitted, callbacks may submit more shaders and they are done in this call as well
+	for (uint32_t i = 0; i < renderer.pending_count; i++)
+	{
+		struct ae_pending_shader pending = renderer.pending[i];
+		pending.callback(pending.shader, NULL, pending.user_data);
+	}
+
+	renderer.pending_count = 0;
+
+	return 0;
+}
+
+static bool null_shader_set_cache_directory(const char* directory)
+{
+	AE_UNREFERENCED_PARAMETER(directory);
+	return true;
+}
+
+static void null_shader_get_cache_stats(struct ae_shader_cache_stats* stats)
+{
+	*stats = (struct ae_shader_cache_stats){ 0 };
+}
+
+//
+// textures
+//
+
+static struct ae_texture* find_texture(const uint32_t id)
+{
+	for (uint32_t i = 0; i < renderer.texture_count; i++)
+	{
+		if (renderer.textures[i]->id == id)
+			return renderer.textures[i];
+	}
+
+	return NULL;
+}
+
+static uint32_t get_level_size(const uint32_t size, const uint32_t level)
+{
+	uint32_t level_size = size >> level;
+	return level_size ? level_size : 1;
+}
+
+static void record_texture_create(const struct ae_texture* texture)
+{
+	const struct ae_render_command_texture_create command = {
+		.texture = texture->id,
+		.width = texture->width,
+		.height = texture->height,
+		.format = texture->format,
+		.mip_count = texture->mip_count,
+		.generate_mips = texture->generate_mips
+	};
+
+	record_copy(AE_RENDER_COMMAND_TEXTURE_CREATE, &command, sizeof(command));
+}
+
+// same storage as an opengl texture without texels, the batches read the size and format
+static struct ae_texture* null_texture_create(const struct ae_texture_desc* desc)
+{
+	if (desc->width == 0 || desc->height == 0)
+		return NULL;
+
+	if (renderer.texture_count == renderer.texture_capacity)
+	{
+		uint32_t capacity = renderer.texture_capacity ? renderer.texture_capacity * 2 : 16;
+		struct ae_texture** textures = realloc(renderer.textures, sizeof(*textures) * capacity);
+
+		if (!textures)
+			return NULL;
+
+		renderer.textures = textures;
+		renderer.texture_capacity = capacity;
+	}
+
+	struct ae_texture* texture = calloc(1, sizeof(*texture));
+
+	if (!texture)
+		return NULL;
+
+	uint32_t full_chain = 1;
+
+	for (uint32_t size = desc->width > desc->height ? desc->width : desc->height; size > 1; size >>= 1)
+		full_chain++;
+
+	*texture = (struct ae_texture){
+		.id = renderer.next_texture++,
+		.width = desc->width,
+		.height = desc->height,
+		.mip_count = desc->mip_count && desc->mip_count < full_chain ? desc->mip_count : full_chain,
+		.format = desc->format,
+		.generate_mips = desc->generate_mips
+	};
+
+	renderer.textures[renderer.texture_count++] = texture;
+
+	record_texture_create(texture);
+
+	return texture;
+}
+
+static void null_texture_destroy(struct ae_texture* texture)
+{
+	if (!texture)
+		return;
+
+	const struct ae_render_command_texture command = { .texture = texture->id };
+	record_copy(AE_RENDER_COMMAND_TEXTURE_DESTROY, &command, sizeof(command));
+
+	for (uint32_t i = 0; i < renderer.texture_count; i++)
+	{
+		if (renderer.textures[i] == texture)
+		{
+			renderer.textures[i] = renderer.textures[--renderer.texture_count];
+			break;
+		}
+	}
+
+	// layers copied from the texture are stale like they are in the opengl backend
+	renderer.texture_generation++;
+
+	free(texture);
+}
+
+// the pixels go nowhere, they are freed by end_upload
+static enum ae_texture_upload_result null_texture_begin_upload(struct ae_texture* texture, const uint32_t level, const uint32_t x, const uint32_t y, const uint32_t width, const uint32_t height, struct ae_texture_upload* upload)
+{
+	if (!texture || level >= texture->mip_count || width == 0 || height == 0
+		|| x + width > get_level_size(texture->width, level)
+		|| y + height > get_level_size(texture->height, level))
+	{
+		return AE_TEXTURE_UPLOAD_INVALID;
+	}
+
+	upload->size = (size_t)width * height * (texture->format == AE_TEXTURE_FORMAT_R8 ? 1 : 4);
+	upload->pixels = malloc(upload->size);
+	upload->slot = 0;
+
+	return upload->pixels ? AE_TEXTURE_UPLOAD_OK : AE_TEXTURE_UPLOAD_FULL;
+}
+
+static void null_texture_end_upload(const struct ae_texture_upload* upload)
+{
+	free(upload->pixels);
+}
+
+static bool null_texture_is_ready(const struct ae_texture* texture)
+{
+	AE_UNREFERENCED_PARAMETER(texture);
+	return true;
+}
+
+static void null_texture_set_upload_budget(const uint64_t bytes_per_frame)
+{
+	AE_UNREFERENCED_PARAMETER(bytes_per_frame);
+}
+
+static void null_texture_get_stats(struct ae_texture_stats* stats)
+{
+	*stats = (struct ae_texture_stats){ 0 };
+}
+
+//
+// batches
+//
+
+// one flush command per draw call of the opengl backend, with the bytes the draw reads
+static void record_flush(const struct ae_null_batch* batch, const struct ae_render_region* region)
+{
+	const uint32_t vertex_size = region->quad_count * batch->batch.quad_size;
+	const uint32_t recorded_size = renderer.record_vertices ? vertex_size : 0;
+	struct ae_render_command_flush* flush = record(AE_RENDER_COMMAND_FLUSH, sizeof(*flush) + recorded_size);
+
+	if (flush)
+	{
+		flush->batch = batch->index;
+		flush->quad_count = region->quad_count;
+		flush->texture_count = batch->batch.current_texture_count;
+		flush->vertex_size = recorded_size;
+		memcpy(flush + 1, batch->memory + (size_t)region->region * batch->batch.quad_size * batch->batch.total_quad_count, recorded_size);
+	}
+
+	renderer.stats.quad_count += region->quad_count;
+	renderer.stats.flush_count++;
+	renderer.stats.vertex_byte_count += vertex_size;
+}
+
+// nothing reads the regions, they are free right away
+static uint8_t* null_device_acquire_region(struct ae_render_batch* batch, const uint32_t region)
+{
+	return ((struct ae_null_batch*)batch)->memory + (size_t)region * batch->quad_size * batch->total_quad_count;
+}
+
+static void null_device_draw(struct ae_render_batch* batch, const struct ae_render_region* region)
+{
+	record_flush((struct ae_null_batch*)batch, region);
+}
+
+static void null_device_submit(struct ae_render_batch* batch, const struct ae_render_region* regions, const uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++)
+		record_flush((struct ae_null_batch*)batch, &regions[i]);
+}
+
+// the regions are plain memory, the vertices written so far do not need to survive
+static bool null_device_set_region_count(struct ae_render_batch* batch, const uint32_t region_count)
+{
+	struct ae_null_batch* null_batch = (struct ae_null_batch*)batch;
+	uint8_t* memory = realloc(null_batch->memory, (size_t)batch->quad_size * batch->total_quad_count * region_count);
+
+	if (!memory)
+		return false;
+
+	null_batch->memory = memory;
+
+	return true;
+}
+
+static void null_device_wait_idle(struct ae_render_batch* batch)
+{
+	AE_UNREFERENCED_PARAMETER(batch);
+}
+
+// ids the texture api did not hand out are taken as rgba8 textures that fill their layer
+static bool null_device_bind_texture(struct ae_render_batch* batch, const uint32_t texture, const uint32_t index, vec2 scale)
+{
+	AE_UNREFERENCED_PARAMETER(index);
+
+	const struct ae_null_batch* null_batch = (const struct ae_null_batch*)batch;
+	const struct ae_texture* found = find_texture(texture);
+
+	if (batch->texture_binding != AE_TEXTURE_BINDING_ARRAY || !found)
+		return true;
+
+	if (found->format != AE_TEXTURE_FORMAT_RGBA8)
+		return false;
+
+	// bigger textures are cropped to the layer
+	const uint32_t layer_width = null_batch->binding.layer_width;
+	const uint32_t layer_height = null_batch->binding.layer_height;
+
+	scale[0] = (float)(found->width < layer_width ? found->width : layer_width) / (float)layer_width;
+	scale[1] = (float)(found->height < layer_height ? found->height : layer_height) / (float)layer_height;
+
+	return true;
+}
+
+static void null_device_release_textures(struct ae_render_batch* batch)
+{
+	AE_UNREFERENCED_PARAMETER(batch);
+}
+
+static uint64_t null_device_get_texture_generation(void)
+{
+	return renderer.texture_generation;
+}
+
+static void null_device_start(const struct ae_render_batch* batch)
+{
+	record_batch(AE_RENDER_COMMAND_BATCH_START, (const struct ae_null_batch*)batch);
+	count_state_change();
+}
+
+static void null_device_end(struct ae_render_batch* batch)
+{
+	record_batch(AE_RENDER_COMMAND_BATCH_END, (const struct ae_null_batch*)batch);
+}
+
+static const struct ae_render_device device = {
+	.acquire_region = null_device_acquire_region,
+	.draw = null_device_draw,
+	.submit = null_device_submit,
+	.set_region_count = null_device_set_region_count,
+	.wait_idle = null_device_wait_idle,
+	.bind_texture = null_device_bind_texture,
+	.release_textures = null_device_release_textures,
+	.get_texture_generation = null_device_get_texture_generation,
+	.start = null_device_start,
+	.end = null_device_end
+};
+
+// the counts of the opengl backend on a driver with AE_NULL_RENDERER_TEXTURE_UNITS units
+static uint32_t get_texture_count(const struct ae_texture_binding_desc* desc)
+{
+	switch (desc->binding)
+	{
+	case AE_TEXTURE_BINDING_UNITS:
+		return AE_NULL_RENDERER_TEXTURE_UNITS;
+	case AE_TEXTURE_BINDING_BINDLESS:
+		return AE_RENDER_BATCH_MAX_BINDLESS_TEXTURES;
+	case AE_TEXTURE_BINDING_ARRAY:
+		return desc->layer_count;
+	}
+
+	return 0;
+}
+
+static bool create_texture_binding(struct ae_null_batch* batch, const struct ae_texture_binding_desc* desc)
+{
+	// the layer size is read while the white texture is bound
+	batch->binding = *desc;
+
+	if (ae_render_batch_create_textures(&batch->batch, desc->binding, get_texture_count(desc)))
+		return true;
+
+	batch->binding = (struct ae_texture_binding_desc){ .binding = AE_TEXTURE_BINDING_UNITS };
+
+	return false;
+}
+
+static void record_batch_create(const struct ae_null_batch* batch)
+{
+	const struct ae_render_command_batch_create command = {
+		.batch = batch->index,
+		.shader = batch->shader->index,
+		.max_quad_count = batch->batch.total_quad_count,
+		.instanced = batch->batch.instanced,
+		.has_format = batch->has_format,
+		.color = batch->batch.layout.format.color,
+		.texture_coordinate = batch->batch.layout.format.texture_coordinate,
+		.texture_unit = batch->batch.layout.format.texture_unit
+	};
+
+	record_copy(AE_RENDER_COMMAND_BATCH_CREATE, &command, sizeof(command));
+}
+
+static void record_texture_binding(const struct ae_null_batch* batch, const struct ae_texture_binding_desc* desc, const bool result)
+{
+	const struct ae_render_command_batch_set_texture_binding command = {
+		.batch = batch->index,
+		.binding = desc->binding,
+		.layer_width = desc->layer_width,
+		.layer_height = desc->layer_height,
+		.layer_count = desc->layer_count,
+		.result = result
+	};
+
+	record_copy(AE_RENDER_COMMAND_BATCH_SET_TEXTURE_BINDING, &command, sizeof(command));
+}
+
+static void record_indirect(const struct ae_null_batch* batch)
+{
+	const struct ae_render_command_batch_set_indirect command = { .batch = batch->index, .enabled = batch->batch.indirect };
+	record_copy(AE_RENDER_COMMAND_BATCH_SET_INDIRECT, &command, sizeof(command));
+}
+
+static void record_culling(const struct ae_null_batch* batch)
+{
+	const struct ae_render_command_batch_set_culling command = { .batch = batch->index, .mode = batch->batch.cull_mode };
+	record_copy(AE_RENDER_COMMAND_BATCH_SET_CULLING, &command, sizeof(command));
+}
+
+static void destroy_batch(struct ae_null_batch* batch)
+{
+	ae_render_batch_release_textures(&batch->batch);
+	free(batch->memory);
+	free(batch);
+}
+
+static struct ae_render_batch* create_batch(struct ae_shader* const shader, const uint32_t max_quad_count, const struct ae_vertex_format* format, const bool instanced)
+{
+	if (!shader || max_quad_count == 0)
+		return NULL;
+
+	if (renderer.batch_count == renderer.batch_capacity)
+	{
+		uint32_t capacity = renderer.batch_capacity ? renderer.batch_capacity * 2 : 16;
+		struct ae_null_batch** batches = realloc(renderer.batches, sizeof(*batches) * capacity);
+
+		if (!batches)
+			return NULL;
+
+		renderer.batches = batches;
+		renderer.batch_capacity = capacity;
+	}
+
+	struct ae_null_batch* batch = calloc(1, sizeof(*batch));
+
+	if (!batch)
+		return NULL;
+
+	ae_render_batch_init(&batch->batch, &device, max_quad_count, format, instanced);
+
+	batch->shader = (struct ae_null_shader*)shader;
+	batch->has_format = format != NULL;
+	batch->memory = malloc((size_t)batch->batch.quad_size * max_quad_count * AE_RENDER_BATCH_REGION_COUNT);
+
+	const struct ae_texture_binding_desc units = { .binding = AE_TEXTURE_BINDING_UNITS };
+
+	if (!batch->memory || !create_texture_binding(batch, &units))
+	{
+		destroy_batch(batch);
+		return NULL;
+	}
+
+	batch->batch.vertices = null_device_acquire_region(&batch->batch, 0);
+	batch->index = renderer.next_batch++;
+	renderer.batches[renderer.batch_count++] = batch;
+
+	record_batch_create(batch);
+
+	return &batch->batch;
+}
+
+static struct ae_render_batch* null_render_batch_create(struct ae_shader* const shader, const uint32_t max_quad_count, const struct ae_vertex_format* format)
+{
+	return create_batch(shader, max_quad_count, format, false);
+}
+
+static struct ae_render_batch* null_render_batch_create_instanced(struct ae_shader* const shader, const uint32_t max_quad_count)
+{
+	return create_batch(shader, max_quad_count, NULL, true);
+}
+
+static void null_render_batch_destroy(struct ae_render_batch* batch)
+{
+	struct ae_null_batch* null_batch = (struct ae_null_batch*)batch;
+
+	record_batch(AE_RENDER_COMMAND_BATCH_DESTROY, null_batch);
+
+	for (uint32_t i = 0; i < renderer.batch_count; i++)
+	{
+		if (renderer.batches[i] == null_batch)
+		{
+			renderer.batches[i] = renderer.batches[--renderer.batch_count];
+			break;
+		}
+	}
+
+	destroy_batch(null_batch);
+}
+
+static enum ae_texture_binding null_render_get_preferred_texture_binding()
+{
+	return AE_TEXTURE_BINDING_BINDLESS;
+}
+
+// every binding the opengl backend takes is supported, the layer limit of the driver is not checked
+static bool null_render_batch_set_texture_binding(struct ae_render_batch* batch, const struct ae_texture_binding_desc* desc)
+{
+	struct ae_null_batch* null_batch = (struct ae_null_batch*)batch;
+	bool result = ae_render_batch_is_texture_binding_valid(desc);
+
+	if (result)
+	{
+		ae_render_batch_flush(batch);
+		ae_render_batch_submit(batch);
+		ae_render_batch_release_textures(batch);
+
+		result = create_texture_binding(null_batch, desc);
+
+		if (!result)
+			create_texture_binding(null_batch, &(struct ae_texture_binding_desc){ .binding = AE_TEXTURE_BINDING_UNITS });
+	}
+
+	record_texture_binding(null_batch, desc, result);
+	count_state_change();
+
+	return result;
+}
+
+static void null_render_batch_set_indirect(struct ae_render_batch* batch, const bool enabled)
+{
+	ae_render_batch_set_indirect(batch, enabled);
+
+	record_indirect((struct ae_null_batch*)batch);
+	count_state_change();
+}
+
+// culling changes no gl state, the batch is not flushed
+static void null_render_batch_set_culling(struct ae_render_batch* batch, const enum ae_cull_mode mode)
+{
+	ae_render_batch_set_culling(batch, mode);
+
+	record_culling((struct ae_null_batch*)batch);
+}
+
+static void null_render_get_state_stats(struct ae_render_state_stats* stats)
+{
+	*stats = renderer.last_frame;
+}
+
+static void null_render_batch_start(const struct ae_render_batch* batch)
+{
+	ae_render_batch_start(batch);
+}
+
+static void null_render_batch_end(struct ae_render_batch* batch)
+{
+	ae_render_batch_end(batch);
+}
+
+static void null_render_batch_draw(struct ae_render_batch* batch, struct ae_draw_params* const params)
+{
+	struct ae_render_command_draw* command = record(AE_RENDER_COMMAND_DRAW, sizeof(*command));
+
+	if (command)
+	{
+		command->batch = ((struct ae_null_batch*)batch)->index;
+		memcpy(command->color, params->color, sizeof(command->color));
+		memcpy(command->position, params->position, sizeof(command->position));
+		memcpy(command->size, params->size, sizeof(command->size));
+	}
+
+	ae_render_batch_draw(batch, params);
+}
+
+static void null_render_batch_draw_textured(struct ae_render_batch* batch, struct ae_textured_draw_params* const params)
+{
+	struct ae_render_command_draw_textured* command = record(AE_RENDER_COMMAND_DRAW_TEXTURED, sizeof(*command));
+
+	if (command)
+	{
+		command->batch = ((struct ae_null_batch*)batch)->index;
+		command->texture = params->texture;
+		memcpy(command->color, params->color, sizeof(command->color));
+		memcpy(command->position, params->position, sizeof(command->position));
+		memcpy(command->size, params->size, sizeof(command->size));
+		memcpy(command->texture_coordinates, params->texture_coordinates, sizeof(command->texture_coordinates));
+	}
+
+	ae_render_batch_draw_textured(batch, params);
+}
+
+static struct ae_render_command_draw_quad* record_draw_many(const uint32_t type, const struct ae_render_batch* batch, const uint32_t count)
+{
+	struct ae_render_command_draw_many* command = record(type, sizeof(*command) + sizeof(struct ae_render_command_draw_quad) * count);
+
+	if (!command)
+		return NULL;
+
+	command->batch = ((const struct ae_null_batch*)batch)->index;
+	command->count = count;
+
+	return (struct ae_render_command_draw_quad*)(command + 1);
+}
+
+static void null_render_batch_draw_many(struct ae_render_batch* batch, const struct ae_draw_params* params, const uint32_t count)
+{
+	struct ae_render_command_draw_quad* quads = record_draw_many(AE_RENDER_COMMAND_DRAW_MANY, batch, count);
+
+	for (uint32_t i = 0; quads && i < count; i++)
+	{
+		memcpy(quads[i].color, params[i].color, sizeof(quads[i].color));
+		memcpy(quads[i].position, params[i].position, sizeof(quads[i].position));
+		memcpy(quads[i].size, params[i].size, sizeof(quads[i].size));
+	}
+
+	ae_render_batch_draw_many(batch, params, count);
+}
+
+static void null_render_batch_draw_many_soa(struct ae_render_batch* batch, const struct ae_draw_params_soa* params, const uint32_t count)
+{
+	struct ae_render_command_draw_quad* quads = record_draw_many(AE_RENDER_COMMAND_DRAW_MANY_SOA, batch, count);
+
+	for (uint32_t i = 0; quads && i < count; i++)
+	{
+		memcpy(quads[i].color, params->color[i], sizeof(quads[i].color));
+		quads[i].position[0] = params->x[i];
+		quads[i].position[1] = params->y[i];
+		quads[i].position[2] = params->z[i];
+		quads[i].size[0] = params->width[i];
+		quads[i].size[1] = params->height[i];
+	}
+
+	ae_render_batch_draw_many_soa(batch, params, count);
+}
+
+//
+// static batches
+//
+
+static void copy_textured_quads(struct ae_render_command_textured_quad* quads, const struct ae_textured_draw_params* params, const uint32_t count)
+{
+	for (uint32_t i = 0; i < count; i++)
+	{
+		memcpy(quads[i].color, params[i].color, sizeof(quads[i].color));
+		memcpy(quads[i].position, params[i].position, sizeof(quads[i].position));
+		memcpy(quads[i].size, params[i].size, sizeof(quads[i].size));
+		memcpy(quads[i].texture_coordinates, params[i].texture_coordinates, sizeof(quads[i].texture_coordinates));
+		quads[i].texture = params[i].texture;
+	}
+}
+
+static void record_static_batch_create(const struct ae_static_batch* batch)
+{
+	const size_t quads_size = sizeof(*batch->quads) * batch->quad_count;
+	struct ae_render_command_static_batch_create* command = record(AE_RENDER_COMMAND_STATIC_BATCH_CREATE, (uint32_t)(sizeof(*command) + quads_size));
+
+	if (!command)
+		return;
+
+	*command = (struct ae_render_command_static_batch_create){
+		.static_batch = batch->index,
+		.shader = batch->shader->index,
+		.count = batch->quad_count,
+		.updatable = batch->updatable,
+		.has_format = batch->has_format,
+		.color = batch->format.color,
+		.texture_coordinate = batch->format.texture_coordinate,
+		.texture_unit = batch->format.texture_unit
+	};
+
+	memcpy(command + 1, batch->quads, quads_size);
+}
+
+static void record_static_batch(const uint32_t type, const struct ae_static_batch* batch)
+{
+	const struct ae_render_command_static_batch command = { .static_batch = batch->index };
+	record_copy(type, &command, sizeof(command));
+}
+
+static struct ae_static_batch* null_render_static_batch_create(struct ae_shader* const shader, const struct ae_textured_draw_params* params, const uint32_t count, const struct ae_vertex_format* format, const bool updatable)
+{
+	if (!shader || !count)
+		return NULL;
+
+	if (renderer.static_batch_count == renderer.static_batch_capacity)
+	{
+		uint32_t capacity = renderer.static_batch_capacity ? renderer.static_batch_capacity * 2 : 16;
+		struct ae_static_batch** batches = realloc(renderer.static_batches, sizeof(*batches) * capacity);
+
+		if (!batches)
+			return NULL;
+
+		renderer.static_batches = batches;
+		renderer.static_batch_capacity = capacity;
+	}
+
+	struct ae_static_batch* batch = calloc(1, sizeof(*batch));
+
+	if (!batch)
+		return NULL;
+
+	batch->quads = malloc(sizeof(*batch->quads) * count);
+
+	if (!batch->quads)
+	{
+		free(batch);
+		return NULL;
+	}
+
+	copy_textured_quads(batch->quads, params, count);
+
+	batch->shader = (struct ae_null_shader*)shader;
+	batch->format = format ? *format : ae_default_vertex_format;
+	batch->has_format = format != NULL;
+	batch->quad_count = count;
+	batch->updatable = updatable;
+	batch->index = renderer.next_static_batch++;
+	renderer.static_batches[renderer.static_batch_count++] = batch;
+
+	record_static_batch_create(batch);
+
+	return batch;
+}
+
+static void null_render_static_batch_destroy(struct ae_static_batch* batch)
+{
+	record_static_batch(AE_RENDER_COMMAND_STATIC_BATCH_DESTROY, batch);
+
+	for (uint32_t i = 0; i < renderer.static_batch_count; i++)
+	{
+		if (renderer.static_batches[i] == batch)
+		{
+			renderer.static_batches[i] = renderer.static_batches[--renderer.static_batch_count];
+			break;
+		}
+	}
+
+	free(batch->quads);
+	free(batch);
+}
+
+// texture units are not tracked, every texture fits like every layer does for array bindings
+static bool null_render_static_batch_update(struct ae_static_batch* batch, const uint32_t first, const struct ae_textured_draw_params* params, const uint32_t count)
+{
+	const bool result = batch->updatable && first <= batch->quad_count && count <= batch->quad_count - first;
+	const uint32_t recorded_count = result ? count : 0;
+
+	struct ae_render_command_static_batch_update* command = record(AE_RENDER_COMMAND_STATIC_BATCH_UPDATE, (uint32_t)(sizeof(*command) + sizeof(*batch->quads) * recorded_count));
+
+	if (command)
+	{
+		*command = (struct ae_render_command_static_batch_update){ .static_batch = batch->index, .first = first, .count = recorded_count, .result = result };
+		copy_textured_quads((struct ae_render_command_textured_quad*)(command + 1), params, recorded_count);
+	}
+
+	if (result)
+		copy_textured_quads(batch->quads + first, params, count);
+
+	return result;
+}
+
+static void null_render_static_batch_draw(struct ae_static_batch* batch)
+{
+	record_static_batch(AE_RENDER_COMMAND_STATIC_BATCH_DRAW, batch);
+	count_state_change();
+
+	renderer.stats.quad_count += batch->quad_count;
+}
+
+static void record_camera(const enum ae_render_command_type type, const struct ae_camera* camera)
+{
+	ae_render_culling_set_camera(camera);
+
+	struct ae_render_command_scene_start* command = record(type, sizeof(*command));
+
+	if (command)
+		memcpy(command->view_projection, camera->view_projection, sizeof(command->view_projection));
+}
+
+static void start_frame(const enum ae_render_command_type type, const struct ae_camera* camera)
+{
+	renderer.last_frame = renderer.frame;
+	renderer.frame = (struct ae_render_state_stats){ 0 };
+	ae_render_culling_end_frame();
+
+	record_camera(type, camera);
+}
+
+static void null_render_scene_start(const struct ae_camera* camera)
+{
+	start_frame(AE_RENDER_COMMAND_SCENE_START, camera);
+}
+
+static void null_render_frame_start(const struct ae_camera* camera)
+{
+	start_frame(AE_RENDER_COMMAND_FRAME_START, camera);
+}
+
+static void null_render_set_camera(const struct ae_camera* camera)
+{
+	record_camera(AE_RENDER_COMMAND_SET_CAMERA, camera);
+}
+
+//
+// recorder
+//
+
+static void null_recorder_reset()
+{
+	renderer.size = 0;
+	renderer.stats = (struct ae_render_recorder_stats){ 0 };
+
+	// shaders were pushed to the front of the list, the oldest is recorded first
+	uint32_t shader_count = 0;
+
+	for (struct ae_null_shader* shader = renderer.shaders; shader; shader = shader->next)
+		shader_count++;
+
+	for (uint32_t i = shader_count; i > 0; i--)
+	{
+		struct ae_null_shader* shader = renderer.shaders;
+
+		for (uint32_t j = 1; j < i; j++)
+			shader = shader->next;
+
+		record_copy(AE_RENDER_COMMAND_SHADER_CREATE, shader->create_command, shader->create_size);
+		record_shader_state(shader);
+	}
+
+	for (uint32_t i = 0; i < renderer.texture_count; i++)
+		record_texture_create(renderer.textures[i]);
+
+	for (uint32_t i = 0; i < renderer.batch_count; i++)
+	{
+		struct ae_null_batch* batch = renderer.batches[i];
+
+		record_batch_create(batch);
+
+		if (batch->binding.binding != AE_TEXTURE_BINDING_UNITS)
+			record_texture_binding(batch, &batch->binding, true);
+
+		if (batch->batch.indirect)
+			record_indirect(batch);
+
+		if (batch->batch.cull_mode != AE_CULL_NONE)
+			record_culling(batch);
+	}
+
+	for (uint32_t i = 0; i < renderer.static_batch_count; i++)
+		record_static_batch_create(renderer.static_batches[i]);
+}
+
+static void null_recorder_set_record_vertices(const bool enabled)
+{
+	renderer.record_vertices = enabled;
+}
+
+static const uint8_t* null_recorder_get_data(size_t* size)
+{
+	*size = renderer.size;
+	return renderer.data;
+}
+
+static bool null_recorder_save(const char* path)
+{
+	FILE* file = fopen(path, "wb");
+
+	if (!file)
+		return false;
+
+	struct ae_render_recording_header header = {
+		.version = AE_RENDER_RECORDING_VERSION,
+		.header_size = sizeof(header),
+		.command_count = renderer.stats.command_count,
+		.size = renderer.size
+	};
+
+	memcpy(header.magic, AE_RENDER_RECORDING_MAGIC, sizeof(header.magic));
+
+	bool success = fwrite(&header, sizeof(header), 1, file) == 1
+		&& (renderer.size == 0 || fwrite(renderer.data, 1, renderer.size, file) == renderer.size);
+
+	if (fclose(file) != 0)
+		success = false;
+
+	if (!success)
+		remove(path);
+
+	return success;
+}
+
+static void null_recorder_get_stats(struct ae_render_recorder_stats* stats)
+{
+	*stats = renderer.stats;
+}
+
+//
+// backend
+//
+
+static struct ae_opengl_backend* null_backend_get()
+{
+	return renderer.backend_created ? &renderer.backend : NULL;
+}
+
+static struct ae_opengl_backend* null_backend_get_or_create()
+{
+	if (!renderer.backend_created)
+	{
+		renderer.backend.width = AE_NULL_RENDERER_WIDTH;
+		renderer.backend.height = AE_NULL_RENDERER_HEIGHT;
+		renderer.backend_created = true;
+	}
+
+	return &renderer.backend;
+}
+
+static void null_backend_destroy(struct ae_opengl_backend* backend)
+{
+	AE_UNREFERENCED_PARAMETER(backend);
+	renderer.backend_created = false;
+}
+
+static void null_backend_set_window(struct ae_opengl_backend* backend, struct ae_window* window)
+{
+	backend->width = (uint32_t)window->size[0];
+	backend->height = (uint32_t)window->size[1];
+}
+
+static void null_backend_set_debug_callback(ae_renderer_opengl_debug_callback_fn callback)
+{
+	AE_UNREFERENCED_PARAMETER(callback);
+}
+
+static void null_backend_get_framebuffer_size(struct ae_opengl_backend* backend, uint32_t* width, uint32_t* height)
+{
+	*width = backend->width;
+	*height = backend->height;
+}
+
+// nothing is rasterized
+static bool null_backend_read_pixels(struct ae_opengl_backend* backend, uint8_t* pixels, const size_t size)
+{
+	AE_UNREFERENCED_PARAMETER(backend);
+	AE_UNREFERENCED_PARAMETER(pixels);
+	AE_UNREFERENCED_PARAMETER(size);
+	return false;
+}
+
+static const struct ae_opengl_backend_api opengl_backend_api =
+{
+	.get = null_backend_get,
+	.get_or_create = null_backend_get_or_create,
+	.destroy = null_backend_destroy,
+	.set_window = null_backend_set_window,
+	.set_debug_callback = null_backend_set_debug_callback,
+	.get_framebuffer_size = null_backend_get_framebuffer_size,
+	.read_pixels = null_backend_read_pixels
+};
+
+static const struct ae_shader_api shader_api =
+{
+	.create = null_shader_create,
+	.create_basic = null_shader_create_basic,
+	.set_blending = null_shader_set_blending,
+	.set_depth_test = null_shader_set_depth_test,
+	.set_cache_directory = null_shader_set_cache_directory,
+	.get_cache_stats = null_shader_get_cache_stats,
+	.create_async = null_shader_create_async,
+	.poll_async = null_shader_poll_async
+};
+
+static const struct ae_renderer_api render_api =
+{
+	.render_batch_create = null_render_batch_create,
+	.render_batch_create_instanced = null_render_batch_create_instanced,
+	.render_batch_destroy = null_render_batch_destroy,
+	.render_get_preferred_texture_binding = null_render_get_preferred_texture_binding,
+	.render_batch_set_texture_binding = null_render_batch_set_texture_binding,
+	.render_scene_start = null_render_scene_start,
+	.render_frame_start = null_render_frame_start,
+	.render_set_camera = null_render_set_camera,
+	.render_batch_start = null_render_batch_start,
+	.render_batch_end = null_render_batch_end,
+	.render_batch_draw = null_render_batch_draw,
+	.render_batch_draw_textured = null_render_batch_draw_textured,
+	.render_batch_draw_many = null_render_batch_draw_many,
+	.render_batch_draw_many_soa = null_render_batch_draw_many_soa,
+	.render_batch_set_indirect = null_render_batch_set_indirect,
+	.render_batch_set_culling = null_render_batch_set_culling,
+	.render_get_state_stats = null_render_get_state_stats,
+	.render_get_cull_stats = ae_render_get_cull_stats,
+	.render_batch_get_stats = ae_render_batch_get_stats,
+	.render_queue_create = ae_render_queue_create,
+	.render_queue_destroy = ae_render_queue_destroy,
+	.render_queue_submit = ae_render_queue_submit,
+	.render_queue_submit_textured = ae_render_queue_submit_textured,
+	.render_queue_merge = ae_render_queue_merge,
+	.render_queue_reset = ae_render_queue_reset,
+	.render_queue_flush = ae_render_queue_flush,
+	.render_queue_get_stats = ae_render_queue_get_stats,
+	.render_static_batch_create = null_render_static_batch_create,
+	.render_static_batch_destroy = null_render_static_batch_destroy,
+	.render_static_batch_update = null_render_static_batch_update,
+	.render_static_batch_draw = null_render_static_batch_draw
+};
+
+static const struct ae_texture_api texture_api =
+{
+	.create = null_texture_create,
+	.destroy = null_texture_destroy,
+	.begin_upload = null_texture_begin_upload,
+	.end_upload = null_texture_end_upload,
+	.is_ready = null_texture_is_ready,
+	.set_upload_budget = null_texture_set_upload_budget,
+	.get_stats = null_texture_get_stats
+};
+
+static const struct ae_render_recorder_api recorder_api =
+{
+	.reset = null_recorder_reset,
+	.set_record_vertices = null_recorder_set_record_vertices,
+	.get_data = null_recorder_get_data,
+	.save = null_recorder_save,
+	.get_stats = null_recorder_get_stats
+};
+
+AE_DLL_EXPORT void plugin_load(struct ae_api_registry_api* registry, bool reload)
+{
+	AE_UNREFERENCED_PARAMETER(reload);
+
+	ae_set_api(registry, ae_opengl_backend_api, &opengl_backend_api);
+	ae_set_api(registry, ae_renderer_api, &render_api);
+	ae_render_queue_set_renderer(&render_api);
+	ae_set_api(registry, ae_shader_api, &shader_api);
+	ae_set_api(registry, ae_texture_api, &texture_api);
+	ae_set_api(registry, ae_render_recorder_api, &recorder_api);
+}
+
+AE_DLL_EXPORT void plugin_unload(struct ae_api_registry_api* registry)
+{
+	AE_UNREFERENCED_PARAMETER(registry);
+}
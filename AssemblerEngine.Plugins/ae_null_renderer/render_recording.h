@@ -0,0 +1,227 @@
+#pragma once
+
+// format of the commands recorded by the null renderer, shared with the ae_render_replay tool
+//
+// [file header][command][command]...
+// every command is a command header followed by size bytes of payload, padded to 8 bytes.
+// shaders, batches and static batches are numbered in creation order starting at 1, 0 is none.
+// textures keep the id the null texture api handed out, the texture of textured draws and quads.
+//
+// shader create:	payload struct, then the sources one after the other
+// draw many:		payload struct, then count draw payloads without the batch
+// flush:			payload struct, then vertex_size bytes exactly as the opengl backend would draw them,
+//					one flush per draw call or per command of an indirect multi draw
+// static batch:	create and update are the payload struct, then count textured quads
+// texture:			only the storage is recorded, uploads are not and null textures have no texels
+
+#include <stdint.h>
+
+#define AE_RENDER_RECORDING_MAGIC "AERENREC"
+// version 2 added batch set culling, version 3 static batches, version 4 set camera, version 5 textures
+// and version 6 frame start, the commands of version 1 are unchanged
+#define AE_RENDER_RECORDING_VERSION 6
+#define AE_RENDER_RECORDING_MIN_VERSION 1
+#define AE_RENDER_RECORDING_ALIGNMENT 8
+#define AE_RENDER_RECORDING_MAX_STAGES 5
+
+enum ae_render_command_type
+{
+	AE_RENDER_COMMAND_SHADER_CREATE = 1,
+	AE_RENDER_COMMAND_SHADER_SET_BLENDING = 2,
+	AE_RENDER_COMMAND_SHADER_SET_DEPTH_TEST = 3,
+	AE_RENDER_COMMAND_BATCH_CREATE = 4,
+	AE_RENDER_COMMAND_BATCH_DESTROY = 5,
+	AE_RENDER_COMMAND_BATCH_SET_TEXTURE_BINDING = 6,
+	AE_RENDER_COMMAND_BATCH_SET_INDIRECT = 7,
+	AE_RENDER_COMMAND_SCENE_START = 8,
+	AE_RENDER_COMMAND_BATCH_START = 9,
+	AE_RENDER_COMMAND_BATCH_END = 10,
+	AE_RENDER_COMMAND_DRAW = 11,
+	AE_RENDER_COMMAND_DRAW_TEXTURED = 12,
+	AE_RENDER_COMMAND_DRAW_MANY = 13,
+	AE_RENDER_COMMAND_DRAW_MANY_SOA = 14,
+	AE_RENDER_COMMAND_FLUSH = 15,
+	AE_RENDER_COMMAND_BATCH_SET_CULLING = 16,
+	AE_RENDER_COMMAND_STATIC_BATCH_CREATE = 17,
+	AE_RENDER_COMMAND_STATIC_BATCH_DESTROY = 18,
+	AE_RENDER_COMMAND_STATIC_BATCH_UPDATE = 19,
+	AE_RENDER_COMMAND_STATIC_BATCH_DRAW = 20,
+	AE_RENDER_COMMAND_SET_CAMERA = 21,
+	AE_RENDER_COMMAND_TEXTURE_CREATE = 22,
+	AE_RENDER_COMMAND_TEXTURE_DESTROY = 23,
+	AE_RENDER_COMMAND_FRAME_START = 24
+};
+
+struct ae_render_recording_header
+{
+	char		magic[8];
+	uint32_t	version;
+	uint32_t	header_size;
+	uint64_t	command_count;
+	uint64_t	size;				// bytes of commands after the header
+};
+
+struct ae_render_command_header
+{
+	uint32_t	type;
+	uint32_t	size;				// payload bytes, without header and padding
+};
+
+struct ae_render_command_shader_create
+{
+	uint32_t	shader;
+	uint32_t	stage_count;
+	int32_t		stage_types[AE_RENDER_RECORDING_MAX_STAGES];
+	uint32_t	stage_sizes[AE_RENDER_RECORDING_MAX_STAGES];
+};
+
+struct ae_render_command_shader_set_blending
+{
+	uint32_t	shader;
+	uint32_t	enable;
+	uint32_t	source;
+	uint32_t	destination;
+};
+
+struct ae_render_command_shader_set_depth_test
+{
+	uint32_t	shader;
+	uint32_t	enable;
+};
+
+struct ae_render_command_batch_create
+{
+	uint32_t	batch;
+	uint32_t	shader;
+	uint32_t	max_quad_count;
+	uint32_t	instanced;
+	uint32_t	has_format;
+	uint32_t	color;				// enum ae_vertex_format members when has_format is set
+	uint32_t	texture_coordinate;
+	uint32_t	texture_unit;
+};
+
+// destroy, start and end
+struct ae_render_command_batch
+{
+	uint32_t	batch;
+};
+
+struct ae_render_command_batch_set_texture_binding
+{
+	uint32_t	batch;
+	uint32_t	binding;
+	uint32_t	layer_width;
+	uint32_t	layer_height;
+	uint32_t	layer_count;
+	uint32_t	result;				// what the null renderer returned
+};
+
+struct ae_render_command_batch_set_indirect
+{
+	uint32_t	batch;
+	uint32_t	enabled;
+};
+
+struct ae_render_command_batch_set_culling
+{
+	uint32_t	batch;
+	uint32_t	mode;				// enum ae_cull_mode
+};
+
+// also the payload of set camera and frame start
+struct ae_render_command_scene_start
+{
+	float		view_projection[16];
+};
+
+struct ae_render_command_draw
+{
+	uint32_t	batch;
+	float		color[4];
+	float		position[3];
+	float		size[2];
+};
+
+struct ae_render_command_draw_textured
+{
+	uint32_t	batch;
+	float		color[4];
+	float		position[3];
+	float		size[2];
+	float		texture_coordinates[8];
+	uint32_t	texture;
+};
+
+struct ae_render_command_draw_quad
+{
+	float		color[4];
+	float		position[3];
+	float		size[2];
+};
+
+// draw many and draw many soa, the arrays of soa are stored as quads
+struct ae_render_command_draw_many
+{
+	uint32_t	batch;
+	uint32_t	count;
+};
+
+struct ae_render_command_flush
+{
+	uint32_t	batch;
+	uint32_t	quad_count;
+	uint32_t	texture_count;		// textures bound when the draw was made
+	uint32_t	vertex_size;
+};
+
+struct ae_render_command_textured_quad
+{
+	float		color[4];
+	float		position[3];
+	float		size[2];
+	float		texture_coordinates[8];
+	uint32_t	texture;
+};
+
+struct ae_render_command_static_batch_create
+{
+	uint32_t	static_batch;
+	uint32_t	shader;
+	uint32_t	count;
+	uint32_t	updatable;
+	uint32_t	has_format;
+	uint32_t	color;				// enum ae_vertex_format members when has_format is set
+	uint32_t	texture_coordinate;
+	uint32_t	texture_unit;
+};
+
+// destroy and draw
+struct ae_render_command_static_batch
+{
+	uint32_t	static_batch;
+};
+
+struct ae_render_command_static_batch_update
+{
+	uint32_t	static_batch;
+	uint32_t	first;
+	uint32_t	count;
+	uint32_t	result;				// what the null renderer returned
+};
+
+struct ae_render_command_texture_create
+{
+	uint32_t	texture;
+	uint32_t	width;
+	uint32_t	height;
+	uint32_t	format;				// enum ae_texture_format
+	uint32_t	mip_count;			// levels the texture was created with, never 0
+	uint32_t	generate_mips;
+};
+
+// destroy
+struct ae_render_command_texture
+{
+	uint32_t	texture;
+};
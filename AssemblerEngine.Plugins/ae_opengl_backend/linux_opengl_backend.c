@@ -1,2 +1,428 @@
+#include "opengl_atlas.h"
+#include "opengl_extensions.h"
+#include "opengl_frame_graph.h"
+#include "opengl_profiler.h"
 #include "opengl_renderer.h"
-#include "opengl_shader.h"
\ No newline at end of file
+#include "opengl_shader.h"
+#include "opengl_static_batch.h"
+#include "opengl_state.h"
+#include "opengl_texture.h"
+#include "render_queue.h"
+
+#include <apis/opengl_backend.h>
+#include <apis/api_registry.h>
+#include <apis/frame_graph.h>
+#include <apis/gpu_profiler.h>
+#include <apis/renderer.h>
+#include <apis/shader.h>
+#include <apis/texture.h>
+#include <apis/texture_atlas.h>
+#include <apis/window.h>
+#include <core/core.h>
+#include "glad/glad.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// headless: there is no window system, everything is drawn into an offscreen framebuffer.
+// runs on any egl driver, mesa llvmpipe included (LIBGL_ALWAYS_SOFTWARE=1 forces it)
+
+// framebuffer size until a window is set
+#ifndef AE_HEADLESS_WIDTH
+#define AE_HEADLESS_WIDTH 1280
+#endif // !AE_HEADLESS_WIDTH
+
+#ifndef AE_HEADLESS_HEIGHT
+#define AE_HEADLESS_HEIGHT 720
+#endif // !AE_HEADLESS_HEIGHT
+
+struct ae_opengl_backend
+{
+	EGLDisplay	display;
+	EGLContext	context;
+	// only used when the driver can not make a context current without one
+	EGLSurface	surface;
+	uint32_t	framebuffer;
+	uint32_t	color;
+	uint32_t	depth;
+	uint32_t	width;
+	uint32_t	height;
+};
+
+static struct ae_opengl_backend* render_backend = NULL;
+
+void opengl_message_callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, GLchar const* message, void const* user_param)
+{
+	AE_UNREFERENCED_PARAMETER(source);
+	AE_UNREFERENCED_PARAMETER(length);
+	AE_UNREFERENCED_PARAMETER(user_param);
+
+	// llvmpipe reports every buffer placement as a notification
+	if (severity == GL_DEBUG_SEVERITY_NOTIFICATION)
+		return;
+
+	printf("%s, %i: %s \n", type == GL_DEBUG_TYPE_ERROR ? "ERROR" : "OTHER", id, message);
+}
+
+static GLADvoidfn opengl_backend_get_opengl_proc_address(const char* name)
+{
+	return (GLADvoidfn)eglGetProcAddress(name);
+}
+
+static bool has_egl_extension(const char* extensions, const char* name)
+{
+	size_t length = strlen(name);
+
+	for (const char* found = extensions ? strstr(extensions, name) : NULL; found; found = strstr(found + length, name))
+	{
+		// a name may be the start of a longer one
+		if ((found == extensions || found[-1] == ' ') && (found[length] == ' ' || found[length] == '\0'))
+			return true;
+	}
+
+	return false;
+}
+
+static EGLDisplay get_display()
+{
+	const char* client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+
+	if (has_egl_extension(client_extensions, "EGL_MESA_platform_surfaceless"))
+	{
+		PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+		if (get_platform_display)
+		{
+			EGLDisplay display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+
+			if (display != EGL_NO_DISPLAY)
+				return display;
+		}
+	}
+
+	return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+static void destroy_framebuffer(struct ae_opengl_backend* backend)
+{
+	if (!backend->framebuffer)
+		return;
+
+	glDeleteFramebuffers(1, &backend->framebuffer);
+	glDeleteRenderbuffers(1, &backend->color);
+	glDeleteRenderbuffers(1, &backend->depth);
+
+	backend->framebuffer = 0;
+}
+
+static bool create_framebuffer(struct ae_opengl_backend* backend, const uint32_t width, const uint32_t height)
+{
+	destroy_framebuffer(backend);
+
+	glCreateRenderbuffers(1, &backend->color);
+	glNamedRenderbufferStorage(backend->color, GL_RGBA8, (GLsizei)width, (GLsizei)height);
+
+	glCreateRenderbuffers(1, &backend->depth);
+	glNamedRenderbufferStorage(backend->depth, GL_DEPTH24_STENCIL8, (GLsizei)width, (GLsizei)height);
+
+	glCreateFramebuffers(1, &backend->framebuffer);
+	glNamedFramebufferRenderbuffer(backend->framebuffer, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, backend->color);
+	glNamedFramebufferRenderbuffer(backend->framebuffer, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, backend->depth);
+
+	if (glCheckNamedFramebufferStatus(backend->framebuffer, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		destroy_framebuffer(backend);
+		return false;
+	}
+
+	// the renderer never binds a framebuffer, it draws into this one
+	glBindFramebuffer(GL_FRAMEBUFFER, backend->framebuffer);
+	glViewport(0, 0, (GLsizei)width, (GLsizei)height);
+
+	backend->width = width;
+	backend->height = height;
+
+	return true;
+}
+
+static void ae_opengl_backend_set_debug_callback(ae_renderer_opengl_debug_callback_fn callback)
+{
+	glEnable(GL_DEBUG_OUTPUT);
+	glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+	glDebugMessageCallback(callback, NULL);
+}
+
+static void opengl_backend_destroy(struct ae_opengl_backend* backend)
+{
+	if (!backend)
+		return;
+
+	if (backend->context != EGL_NO_CONTEXT)
+	{
+		destroy_framebuffer(backend);
+		ae_gpu_profiler_shutdown();
+		ae_texture_shutdown();
+		ae_render_shutdown();
+		eglMakeCurrent(backend->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		eglDestroyContext(backend->display, backend->context);
+	}
+
+	if (backend->surface != EGL_NO_SURFACE)
+		eglDestroySurface(backend->display, backend->surface);
+
+	eglTerminate(backend->display);
+
+	if (backend == render_backend)
+		render_backend = NULL;
+
+	free(backend);
+}
+
+static struct ae_opengl_backend* opengl_get_or_create()
+{
+	if (render_backend)
+		return render_backend;
+
+	struct ae_opengl_backend* backend = calloc(1, sizeof(*backend));
+
+	if (!backend)
+		return NULL;
+
+	backend->context = EGL_NO_CONTEXT;
+	backend->surface = EGL_NO_SURFACE;
+	backend->display = get_display();
+
+	EGLint major = 0, minor = 0;
+
+	if (backend->display == EGL_NO_DISPLAY || !eglInitialize(backend->display, &major, &minor))
+	{
+		free(backend);
+		return NULL;
+	}
+
+	const EGLint config_attributes[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8,
+		EGL_GREEN_SIZE, 8,
+		EGL_BLUE_SIZE, 8,
+		EGL_ALPHA_SIZE, 8,
+		EGL_NONE
+	};
+
+	// the renderer needs direct state access, 4.5 core
+	const EGLint context_attributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 4,
+		EGL_CONTEXT_MINOR_VERSION, 5,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+
+	EGLConfig config;
+	EGLint config_count = 0;
+
+	if (!eglBindAPI(EGL_OPENGL_API)
+		|| !eglChooseConfig(backend->display, config_attributes, &config, 1, &config_count)
+		|| config_count == 0
+		|| (backend->context = eglCreateContext(backend->display, config, EGL_NO_CONTEXT, context_attributes)) == EGL_NO_CONTEXT)
+	{
+		printf("opengl backend: no opengl 4.5 core context on egl %i.%i\n", major, minor);
+		opengl_backend_destroy(backend);
+		return NULL;
+	}
+
+	// the framebuffer is always ours, a pbuffer is only made for drivers that insist on a surface
+	if (!has_egl_extension(eglQueryString(backend->display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context"))
+	{
+		const EGLint pbuffer_attributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+		backend->surface = eglCreatePbufferSurface(backend->display, config, pbuffer_attributes);
+	}
+
+	if (!eglMakeCurrent(backend->display, backend->surface, backend->surface, backend->context))
+	{
+		printf("opengl backend: eglMakeCurrent failed with 0x%x\n", eglGetError());
+		opengl_backend_destroy(backend);
+		return NULL;
+	}
+
+	gladLoadGLLoader((GLADloadproc)opengl_backend_get_opengl_proc_address);
+	ae_opengl_extensions_load((GLADloadproc)opengl_backend_get_opengl_proc_address);
+	ae_gl_state_invalidate();
+
+	ae_opengl_backend_set_debug_callback(opengl_message_callback);
+
+	if (!create_framebuffer(backend, AE_HEADLESS_WIDTH, AE_HEADLESS_HEIGHT))
+	{
+		opengl_backend_destroy(backend);
+		return NULL;
+	}
+
+	render_backend = backend;
+
+	return render_backend;
+}
+
+// there is nothing to present to, the window only decides the framebuffer size
+static void opengl_backend_set_window(struct ae_opengl_backend* backend, struct ae_window* window)
+{
+	uint32_t width = (uint32_t)window->size[0];
+	uint32_t height = (uint32_t)window->size[1];
+
+	if (width && height && (width != backend->width || height != backend->height))
+		create_framebuffer(backend, width, height);
+}
+
+static void opengl_backend_get_framebuffer_size(struct ae_opengl_backend* backend, uint32_t* width, uint32_t* height)
+{
+	*width = backend->width;
+	*height = backend->height;
+}
+
+static bool opengl_backend_read_pixels(struct ae_opengl_backend* backend, uint8_t* pixels, const size_t size)
+{
+	size_t needed = (size_t)backend->width * backend->height * 4;
+
+	if (size < needed)
+		return false;
+
+	glNamedFramebufferReadBuffer(backend->framebuffer, GL_COLOR_ATTACHMENT0);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, backend->framebuffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadnPixels(0, 0, (GLsizei)backend->width, (GLsizei)backend->height, GL_RGBA, GL_UNSIGNED_BYTE, (GLsizei)needed, pixels);
+
+	return true;
+}
+
+static struct ae_opengl_backend* ae_opengl_backend_get()
+{
+	return render_backend;
+}
+
+static const struct ae_opengl_backend_api opengl_backend_api =
+{
+	.get = ae_opengl_backend_get,
+	.get_or_create = opengl_get_or_create,
+	.destroy = opengl_backend_destroy,
+	.set_window = opengl_backend_set_window,
+	.set_debug_callback = ae_opengl_backend_set_debug_callback,
+	.get_framebuffer_size = opengl_backend_get_framebuffer_size,
+	.read_pixels = opengl_backend_read_pixels
+};
+
+static const struct ae_shader_api shader_api =
+{
+	.create = ae_shader_create,
+	.create_basic = ae_shader_create_basic,
+	.create_async = ae_shader_create_async,
+	.poll_async = ae_shader_poll_async,
+	.set_cache_directory = ae_shader_set_cache_directory,
+	.get_cache_stats = ae_shader_get_cache_stats
+};
+
+static const struct ae_renderer_api render_api =
+{
+	.render_batch_create = ae_render_batch_create,
+	.render_batch_create_instanced = ae_render_batch_create_instanced,
+	.render_batch_destroy = ae_render_batch_destroy,
+	.render_get_preferred_texture_binding = ae_render_get_preferred_texture_binding,
+	.render_batch_set_texture_binding = ae_render_batch_set_texture_binding,
+	.render_scene_start = ae_render_scene_start,
+	.render_frame_start = ae_render_frame_start,
+	.render_set_camera = ae_render_set_camera,
+	.render_batch_start = ae_render_batch_start,
+	.render_batch_end = ae_render_batch_end,
+	.render_batch_draw = ae_render_batch_draw,
+	.render_batch_draw_textured = ae_render_batch_draw_textured,
+	.render_batch_draw_many = ae_render_batch_draw_many,
+	.render_batch_draw_many_soa = ae_render_batch_draw_many_soa,
+	.render_batch_set_indirect = ae_render_batch_set_indirect,
+	.render_batch_set_culling = ae_render_batch_set_culling,
+	.render_get_state_stats = ae_render_get_state_stats,
+	.render_get_cull_stats = ae_render_get_cull_stats,
+	.render_batch_get_stats = ae_render_batch_get_stats,
+	.render_queue_create = ae_render_queue_create,
+	.render_queue_destroy = ae_render_queue_destroy,
+	.render_queue_submit = ae_render_queue_submit,
+	.render_queue_submit_textured = ae_render_queue_submit_textured,
+	.render_queue_merge = ae_render_queue_merge,
+	.render_queue_reset = ae_render_queue_reset,
+	.render_queue_flush = ae_render_queue_flush,
+	.render_queue_get_stats = ae_render_queue_get_stats,
+	.render_static_batch_create = ae_static_batch_create,
+	.render_static_batch_destroy = ae_static_batch_destroy,
+	.render_static_batch_update = ae_static_batch_update,
+	.render_static_batch_draw = ae_static_batch_draw
+};
+
+static const struct ae_gpu_profiler_api gpu_profiler_api =
+{
+	.set_enabled = ae_gpu_profiler_set_enabled,
+	.begin_scope = ae_gpu_profiler_begin_scope,
+	.end_scope = ae_gpu_profiler_end_scope,
+	.get_frame = ae_gpu_profiler_get_frame
+};
+
+static const struct ae_texture_api texture_api =
+{
+	.create = ae_texture_create,
+	.destroy = ae_texture_destroy,
+	.begin_upload = ae_texture_begin_upload,
+	.end_upload = ae_texture_end_upload,
+	.is_ready = ae_texture_is_ready,
+	.set_upload_budget = ae_texture_set_upload_budget,
+	.get_stats = ae_texture_get_stats
+};
+
+static const struct ae_texture_atlas_api texture_atlas_api =
+{
+	.create = ae_texture_atlas_create,
+	.destroy = ae_texture_atlas_destroy,
+	.insert = ae_texture_atlas_insert,
+	.remove = ae_texture_atlas_remove,
+	.get_page = ae_texture_atlas_get_page,
+	.get_stats = ae_texture_atlas_get_stats
+};
+
+static const struct ae_frame_graph_api frame_graph_api =
+{
+	.create = ae_frame_graph_create,
+	.destroy = ae_frame_graph_destroy,
+	.reset = ae_frame_graph_reset,
+	.create_texture = ae_frame_graph_create_texture,
+	.import_texture = ae_frame_graph_import_texture,
+	.import_buffer = ae_frame_graph_import_buffer,
+	.get_backbuffer = ae_frame_graph_get_backbuffer,
+	.add_pass = ae_frame_graph_add_pass,
+	.read = ae_frame_graph_read,
+	.write_attachment = ae_frame_graph_write_attachment,
+	.write_storage = ae_frame_graph_write_storage,
+	.set_side_effect = ae_frame_graph_set_side_effect,
+	.execute = ae_frame_graph_execute,
+	.get_name = ae_frame_graph_get_name,
+	.get_stats = ae_frame_graph_get_stats
+};
+
+AE_DLL_EXPORT void plugin_load(struct ae_api_registry_api* registry, bool reload)
+{
+	// the cache of the reloaded library starts zeroed while the context keeps the state of the old one
+	if (reload)
+		ae_gl_state_invalidate();
+
+	ae_set_api(registry, ae_opengl_backend_api, &opengl_backend_api);
+	ae_set_api(registry, ae_renderer_api, &render_api);
+	ae_render_queue_set_renderer(&render_api);
+	ae_set_api(registry, ae_shader_api, &shader_api);
+	ae_set_api(registry, ae_gpu_profiler_api, &gpu_profiler_api);
+	ae_set_api(registry, ae_texture_api, &texture_api);
+	ae_set_api(registry, ae_texture_atlas_api, &texture_atlas_api);
+	ae_set_api(registry, ae_frame_graph_api, &frame_graph_api);
+}
+
+AE_DLL_EXPORT void plugin_unload(struct ae_api_registry_api* registry)
+{
+	AE_UNREFERENCED_PARAMETER(registry);
+}
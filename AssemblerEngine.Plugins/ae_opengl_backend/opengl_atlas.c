@@ -0,0 +1,473 @@
+#include "opengl_atlas.h"
+#include "opengl_texture.h"
+#include "glad/glad.h"
+
+#include <apis/texture.h>
+#include <apis/texture_atlas.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+// a shelf higher than an image by more than 1 / AE_TEXTURE_ATLAS_SHELF_WASTE of its height only takes the
+// image when no new shelf fits. keeps small glyphs out of shelves opened by big icons
+#ifndef AE_TEXTURE_ATLAS_SHELF_WASTE
+#define AE_TEXTURE_ATLAS_SHELF_WASTE 4
+#endif // !AE_TEXTURE_ATLAS_SHELF_WASTE
+
+struct ae_atlas_span
+{
+	uint32_t x;
+	uint32_t width;
+};
+
+struct ae_atlas_shelf
+{
+	// free spans sorted by x, neighbours are merged
+	struct ae_atlas_span* spans;
+	uint32_t span_count;
+	uint32_t span_capacity;
+	uint32_t y;
+	uint32_t height;
+	uint32_t used_count;
+	// texels of removed entries may be left, new entries clear their rect first
+	bool reused;
+};
+
+struct ae_atlas_page
+{
+	struct ae_texture* texture;
+	// sorted by y, a new shelf always starts at top
+	struct ae_atlas_shelf* shelves;
+	uint32_t shelf_count;
+	uint32_t shelf_capacity;
+	uint32_t top;
+	// rows from here on were never part of a shelf and still hold the clear of add_page
+	uint32_t fresh_top;
+};
+
+// the rect includes the padding, id - 1 indexes the allocations
+struct ae_atlas_allocation
+{
+	uint32_t page;
+	uint32_t x;
+	uint32_t y;
+	uint32_t width;
+	uint32_t height;
+	// id of the next unused allocation while this one is unused
+	uint32_t next_free;
+	bool used;
+};
+
+struct ae_texture_atlas
+{
+	struct ae_texture_atlas_desc desc;
+	struct ae_atlas_page* pages;
+	uint32_t page_count;
+	uint32_t page_capacity;
+	struct ae_atlas_allocation* allocations;
+	uint32_t allocation_count;
+	uint32_t allocation_capacity;
+	uint32_t free_allocation;
+	uint32_t entry_count;
+	uint64_t used_area;
+};
+
+static bool grow(void** data, uint32_t* capacity, const uint32_t count, const size_t element_size)
+{
+	if (count < *capacity)
+		return true;
+
+	uint32_t new_capacity = *capacity ? *capacity * 2 : 8;
+	void* grown = realloc(*data, element_size * new_capacity);
+
+	if (!grown)
+		return false;
+
+	*data = grown;
+	*capacity = new_capacity;
+
+	return true;
+}
+
+//
+// shelves
+//
+
+static bool take_span(struct ae_atlas_shelf* shelf, const uint32_t width, uint32_t* x)
+{
+	for (uint32_t i = 0; i < shelf->span_count; i++)
+	{
+		struct ae_atlas_span* span = &shelf->spans[i];
+
+		if (span->width < width)
+			continue;
+
+		*x = span->x;
+		span->x += width;
+		span->width -= width;
+
+		if (span->width == 0)
+		{
+			memmove(span, span + 1, sizeof(*span) * (shelf->span_count - i - 1));
+			shelf->span_count--;
+		}
+
+		shelf->used_count++;
+		return true;
+	}
+
+	return false;
+}
+
+static bool has_span(const struct ae_atlas_shelf* shelf, const uint32_t width)
+{
+	for (uint32_t i = 0; i < shelf->span_count; i++)
+	{
+		if (shelf->spans[i].width >= width)
+			return true;
+	}
+
+	return false;
+}
+
+// the entry is gone even if its span can not be stored, the shelf must still empty out
+static bool give_span(struct ae_atlas_shelf* shelf, const uint32_t x, const uint32_t width)
+{
+	shelf->used_count--;
+	shelf->reused = true;
+
+	uint32_t i = 0;
+
+	while (i < shelf->span_count && shelf->spans[i].x < x)
+		i++;
+
+	bool merges_previous = i > 0 && shelf->spans[i - 1].x + shelf->spans[i - 1].width == x;
+	bool merges_next = i < shelf->span_count && x + width == shelf->spans[i].x;
+
+	if (merges_previous && merges_next)
+	{
+		shelf->spans[i - 1].width += width + shelf->spans[i].width;
+		memmove(&shelf->spans[i], &shelf->spans[i + 1], sizeof(*shelf->spans) * (shelf->span_count - i - 1));
+		shelf->span_count--;
+	}
+	else if (merges_previous)
+	{
+		shelf->spans[i - 1].width += width;
+	}
+	else if (merges_next)
+	{
+		shelf->spans[i].x = x;
+		shelf->spans[i].width += width;
+	}
+	else
+	{
+		if (!grow((void**)&shelf->spans, &shelf->span_capacity, shelf->span_count, sizeof(*shelf->spans)))
+			return false;
+
+		memmove(&shelf->spans[i + 1], &shelf->spans[i], sizeof(*shelf->spans) * (shelf->span_count - i));
+		shelf->spans[i] = (struct ae_atlas_span){ x, width };
+		shelf->span_count++;
+	}
+
+	return true;
+}
+
+static struct ae_atlas_shelf* open_shelf(struct ae_atlas_page* page, const uint32_t page_width, const uint32_t height)
+{
+	if (!grow((void**)&page->shelves, &page->shelf_capacity, page->shelf_count, sizeof(*page->shelves)))
+		return NULL;
+
+	struct ae_atlas_shelf* shelf = &page->shelves[page->shelf_count];
+	*shelf = (struct ae_atlas_shelf){ .y = page->top, .height = height, .reused = page->top < page->fresh_top };
+
+	if (!grow((void**)&shelf->spans, &shelf->span_capacity, 0, sizeof(*shelf->spans)))
+		return NULL;
+
+	shelf->spans[0] = (struct ae_atlas_span){ 0, page_width };
+	shelf->span_count = 1;
+
+	page->shelf_count++;
+	page->top += height;
+
+	if (page->top > page->fresh_top)
+		page->fresh_top = page->top;
+
+	return shelf;
+}
+
+// best fitting shelf with room, a new shelf if that one wastes too much and the page has the rows left.
+// reused is set when the rect may still hold texels of a removed entry
+static bool allocate_in_page(struct ae_texture_atlas* atlas, struct ae_atlas_page* page, const uint32_t width, const uint32_t height, uint32_t* x, uint32_t* y, bool* reused)
+{
+	// an index, opening a shelf can move the shelves
+	uint32_t best_index = page->shelf_count;
+
+	for (uint32_t i = 0; i < page->shelf_count; i++)
+	{
+		const struct ae_atlas_shelf* shelf = &page->shelves[i];
+
+		if (shelf->height >= height && (best_index == page->shelf_count || shelf->height < page->shelves[best_index].height) && has_span(shelf, width))
+			best_index = i;
+	}
+
+	struct ae_atlas_shelf* best = best_index < page->shelf_count ? &page->shelves[best_index] : NULL;
+	bool wasteful = !best || (best->height - height) * AE_TEXTURE_ATLAS_SHELF_WASTE > best->height;
+
+	if (wasteful && page->top + height <= atlas->desc.page_height)
+	{
+		struct ae_atlas_shelf* shelf = open_shelf(page, atlas->desc.page_width, height);
+		best = shelf ? shelf : best_index < page->shelf_count ? &page->shelves[best_index] : NULL;
+	}
+
+	if (!best)
+		return false;
+
+	*y = best->y;
+	*reused = best->reused;
+
+	return take_span(best, width, x);
+}
+
+static void free_in_page(struct ae_atlas_page* page, const uint32_t x, const uint32_t y, const uint32_t width)
+{
+	for (uint32_t i = 0; i < page->shelf_count; i++)
+	{
+		if (page->shelves[i].y == y)
+		{
+			give_span(&page->shelves[i], x, width);
+			break;
+		}
+	}
+
+	// empty shelves at the top can be opened again with another height
+	while (page->shelf_count && page->shelves[page->shelf_count - 1].used_count == 0)
+	{
+		struct ae_atlas_shelf* shelf = &page->shelves[--page->shelf_count];
+
+		page->top = shelf->y;
+		free(shelf->spans);
+	}
+}
+
+//
+// pages
+//
+
+static struct ae_atlas_page* add_page(struct ae_texture_atlas* atlas)
+{
+	if ((atlas->desc.max_page_count && atlas->page_count == atlas->desc.max_page_count)
+		|| !grow((void**)&atlas->pages, &atlas->page_capacity, atlas->page_count, sizeof(*atlas->pages)))
+	{
+		return NULL;
+	}
+
+	const struct ae_texture_desc desc = {
+		.width = atlas->desc.page_width,
+		.height = atlas->desc.page_height,
+		.format = atlas->desc.format,
+		.mip_count = 1
+	};
+
+	struct ae_texture* texture = ae_texture_create(&desc);
+
+	if (!texture)
+		return NULL;
+
+	// the padding has to be empty, storage starts out undefined
+	glClearTexImage(texture->id, 0, atlas->desc.format == AE_TEXTURE_FORMAT_R8 ? GL_RED : GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+	struct ae_atlas_page* page = &atlas->pages[atlas->page_count++];
+	*page = (struct ae_atlas_page){ .texture = texture };
+
+	return page;
+}
+
+static void destroy_page(struct ae_atlas_page* page)
+{
+	for (uint32_t i = 0; i < page->shelf_count; i++)
+		free(page->shelves[i].spans);
+
+	free(page->shelves);
+	ae_texture_destroy(page->texture);
+}
+
+//
+// atlas
+//
+
+struct ae_texture_atlas* ae_texture_atlas_create(const struct ae_texture_atlas_desc* desc)
+{
+	if (desc->page_width == 0 || desc->page_height == 0)
+		return NULL;
+
+	struct ae_texture_atlas* atlas = calloc(1, sizeof(*atlas));
+
+	if (atlas)
+		atlas->desc = *desc;
+
+	return atlas;
+}
+
+void ae_texture_atlas_destroy(struct ae_texture_atlas* atlas)
+{
+	if (!atlas)
+		return;
+
+	for (uint32_t i = 0; i < atlas->page_count; i++)
+		destroy_page(&atlas->pages[i]);
+
+	free(atlas->pages);
+	free(atlas->allocations);
+	free(atlas);
+}
+
+static uint32_t add_allocation(struct ae_texture_atlas* atlas)
+{
+	if (atlas->free_allocation)
+	{
+		uint32_t id = atlas->free_allocation;
+		atlas->free_allocation = atlas->allocations[id - 1].next_free;
+		return id;
+	}
+
+	if (!grow((void**)&atlas->allocations, &atlas->allocation_capacity, atlas->allocation_count, sizeof(*atlas->allocations)))
+		return 0;
+
+	return ++atlas->allocation_count;
+}
+
+static bool upload_pixels(const struct ae_texture_atlas* atlas, struct ae_texture_atlas_entry* entry, const uint8_t* pixels)
+{
+	struct ae_texture_upload upload;
+
+	if (ae_texture_begin_upload(atlas->pages[entry->page].texture, 0, entry->x, entry->y, entry->width, entry->height, &upload) != AE_TEXTURE_UPLOAD_OK)
+		return false;
+
+	memcpy(upload.pixels, pixels, upload.size);
+	ae_texture_end_upload(&upload);
+
+	return true;
+}
+
+bool ae_texture_atlas_insert(struct ae_texture_atlas* atlas, const uint32_t width, const uint32_t height, const uint8_t* pixels, struct ae_texture_atlas_entry* entry)
+{
+	uint32_t padded_width = width + atlas->desc.padding * 2;
+	uint32_t padded_height = height + atlas->desc.padding * 2;
+
+	if (width == 0 || height == 0 || padded_width > atlas->desc.page_width || padded_height > atlas->desc.page_height)
+		return false;
+
+	uint32_t page = 0;
+	uint32_t x = 0;
+	uint32_t y = 0;
+	bool reused = false;
+
+	while (page < atlas->page_count && !allocate_in_page(atlas, &atlas->pages[page], padded_width, padded_height, &x, &y, &reused))
+		page++;
+
+	if (page == atlas->page_count)
+	{
+		struct ae_atlas_page* added = add_page(atlas);
+
+		if (!added || !allocate_in_page(atlas, added, padded_width, padded_height, &x, &y, &reused))
+			return false;
+	}
+
+	uint32_t id = add_allocation(atlas);
+
+	if (!id)
+	{
+		free_in_page(&atlas->pages[page], x, y, padded_width);
+		return false;
+	}
+
+	// the padding and entries without pixels have to be empty, batches holding copies of the page copy it again
+	if (reused)
+	{
+		glClearTexSubImage(atlas->pages[page].texture->id, 0, (GLint)x, (GLint)y, 0, (GLsizei)padded_width, (GLsizei)padded_height, 1,
+			atlas->desc.format == AE_TEXTURE_FORMAT_R8 ? GL_RED : GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+		ae_texture_touch();
+	}
+
+	atlas->allocations[id - 1] = (struct ae_atlas_allocation){
+		.page = page,
+		.x = x,
+		.y = y,
+		.width = padded_width,
+		.height = padded_height,
+		.used = true
+	};
+
+	const float page_width = (float)atlas->desc.page_width;
+	const float page_height = (float)atlas->desc.page_height;
+
+	*entry = (struct ae_texture_atlas_entry){
+		.id = id,
+		.texture = atlas->pages[page].texture->id,
+		.page = page,
+		.x = x + atlas->desc.padding,
+		.y = y + atlas->desc.padding,
+		.width = width,
+		.height = height
+	};
+
+	float left = (float)entry->x / page_width;
+	float right = (float)(entry->x + width) / page_width;
+	float top = (float)entry->y / page_height;
+	float bottom = (float)(entry->y + height) / page_height;
+
+	entry->texture_coordinates[0][0] = left;
+	entry->texture_coordinates[0][1] = top;
+	entry->texture_coordinates[1][0] = right;
+	entry->texture_coordinates[1][1] = top;
+	entry->texture_coordinates[2][0] = right;
+	entry->texture_coordinates[2][1] = bottom;
+	entry->texture_coordinates[3][0] = left;
+	entry->texture_coordinates[3][1] = bottom;
+
+	atlas->entry_count++;
+	atlas->used_area += (uint64_t)padded_width * padded_height;
+
+	if (pixels && !upload_pixels(atlas, entry, pixels))
+	{
+		ae_texture_atlas_remove(atlas, id);
+		return false;
+	}
+
+	return true;
+}
+
+void ae_texture_atlas_remove(struct ae_texture_atlas* atlas, const uint32_t id)
+{
+	if (id == 0 || id > atlas->allocation_count || !atlas->allocations[id - 1].used)
+		return;
+
+	struct ae_atlas_allocation* allocation = &atlas->allocations[id - 1];
+
+	// a queued upload of the image would land after the clear of the next entry placed here
+	ae_texture_cancel_uploads(atlas->pages[allocation->page].texture, 0, allocation->x, allocation->y, allocation->width, allocation->height);
+
+	free_in_page(&atlas->pages[allocation->page], allocation->x, allocation->y, allocation->width);
+
+	atlas->entry_count--;
+	atlas->used_area -= (uint64_t)allocation->width * allocation->height;
+
+	allocation->used = false;
+	allocation->next_free = atlas->free_allocation;
+	atlas->free_allocation = id;
+}
+
+struct ae_texture* ae_texture_atlas_get_page(struct ae_texture_atlas* atlas, const uint32_t page)
+{
+	return page < atlas->page_count ? atlas->pages[page].texture : NULL;
+}
+
+void ae_texture_atlas_get_stats(const struct ae_texture_atlas* atlas, struct ae_texture_atlas_stats* stats)
+{
+	*stats = (struct ae_texture_atlas_stats){
+		.page_count = atlas->page_count,
+		.entry_count = atlas->entry_count,
+		.used_area = atlas->used_area,
+		.page_area = (uint64_t)atlas->page_count * atlas->desc.page_width * atlas->desc.page_height
+	};
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+// atlas pages are shelf packed: a page is split in rows (shelves) as high as the first image placed in them,
+// every shelf keeps a sorted list of its free spans. removing an image gives its span back to the shelf,
+// empty shelves at the top of the page give their rows back to the page
+
+#include <core/types.h>
+
+struct ae_texture;
+struct ae_texture_atlas;
+struct ae_texture_atlas_desc;
+struct ae_texture_atlas_entry;
+struct ae_texture_atlas_stats;
+
+struct ae_texture_atlas* ae_texture_atlas_create(const struct ae_texture_atlas_desc* desc);
+void ae_texture_atlas_destroy(struct ae_texture_atlas* atlas);
+bool ae_texture_atlas_insert(struct ae_texture_atlas* atlas, const uint32_t width, const uint32_t height, const uint8_t* pixels, struct ae_texture_atlas_entry* entry);
+void ae_texture_atlas_remove(struct ae_texture_atlas* atlas, const uint32_t id);
+struct ae_texture* ae_texture_atlas_get_page(struct ae_texture_atlas* atlas, const uint32_t page);
+void ae_texture_atlas_get_stats(const struct ae_texture_atlas* atlas, struct ae_texture_atlas_stats* stats);
@@ -0,0 +1,155 @@
+#include "opengl_extensions.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+struct ae_opengl_extensions ae_opengl_extensions;
+
+struct ae_resident_handle
+{
+	GLuint64 handle;
+	uint32_t count;
+};
+
+// open addressing on the handle, at most half full
+struct ae_resident_handles
+{
+	struct ae_resident_handle* entries;
+	uint32_t capacity;
+	uint32_t count;
+};
+
+static struct ae_resident_handles resident;
+
+static uint32_t hash_handle(const GLuint64 handle)
+{
+	return (uint32_t)((handle * 11400714819323198485ull) >> 32) & (resident.capacity - 1);
+}
+
+static uint32_t find_handle(const GLuint64 handle)
+{
+	uint32_t slot = hash_handle(handle);
+
+	while (resident.entries[slot].handle && resident.entries[slot].handle != handle)
+		slot = (slot + 1) & (resident.capacity - 1);
+
+	return slot;
+}
+
+static bool grow_handles()
+{
+	struct ae_resident_handles old = resident;
+	uint32_t capacity = resident.capacity ? resident.capacity * 2 : 64;
+	struct ae_resident_handle* entries = calloc(capacity, sizeof(*entries));
+
+	if (!entries)
+		return false;
+
+	resident.entries = entries;
+	resident.capacity = capacity;
+
+	for (uint32_t i = 0; i < old.capacity; i++)
+	{
+		if (old.entries[i].handle)
+			resident.entries[find_handle(old.entries[i].handle)] = old.entries[i];
+	}
+
+	free(old.entries);
+
+	return true;
+}
+
+bool ae_opengl_has_extension(const char* name)
+{
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+	for (GLint i = 0; i < count; i++)
+	{
+		const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+
+		if (extension && strcmp(extension, name) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+void ae_opengl_extensions_load(GLADloadproc load)
+{
+	memset(&ae_opengl_extensions, 0, sizeof(ae_opengl_extensions));
+
+	// handles of an earlier context are gone with it
+	free(resident.entries);
+	memset(&resident, 0, sizeof(resident));
+
+	if (ae_opengl_has_extension("GL_ARB_bindless_texture"))
+	{
+		ae_opengl_extensions.get_texture_handle = (PFNGLGETTEXTUREHANDLEARBPROC)load("glGetTextureHandleARB");
+		ae_opengl_extensions.make_texture_handle_resident = (PFNGLMAKETEXTUREHANDLERESIDENTARBPROC)load("glMakeTextureHandleResidentARB");
+		ae_opengl_extensions.make_texture_handle_non_resident = (PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC)load("glMakeTextureHandleNonResidentARB");
+
+		ae_opengl_extensions.bindless_texture = ae_opengl_extensions.get_texture_handle
+			&& ae_opengl_extensions.make_texture_handle_resident
+			&& ae_opengl_extensions.make_texture_handle_non_resident;
+	}
+
+	if (ae_opengl_has_extension("GL_KHR_parallel_shader_compile"))
+		ae_opengl_extensions.max_shader_compiler_threads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)load("glMaxShaderCompilerThreadsKHR");
+	else if (ae_opengl_has_extension("GL_ARB_parallel_shader_compile"))
+		ae_opengl_extensions.max_shader_compiler_threads = (PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)load("glMaxShaderCompilerThreadsARB");
+
+	ae_opengl_extensions.parallel_shader_compile = ae_opengl_extensions.max_shader_compiler_threads != NULL;
+
+	// all ones lets the driver pick the thread count
+	if (ae_opengl_extensions.parallel_shader_compile)
+		ae_opengl_extensions.max_shader_compiler_threads(0xffffffffu);
+}
+
+GLuint64 ae_opengl_acquire_texture_handle(const GLuint texture)
+{
+	const GLuint64 handle = ae_opengl_extensions.get_texture_handle(texture);
+
+	if (!handle || ((resident.count + 1) * 2 > resident.capacity && !grow_handles()))
+		return 0;
+
+	struct ae_resident_handle* entry = &resident.entries[find_handle(handle)];
+
+	if (!entry->count++)
+	{
+		entry->handle = handle;
+		resident.count++;
+		ae_opengl_extensions.make_texture_handle_resident(handle);
+	}
+
+	return handle;
+}
+
+void ae_opengl_release_texture_handle(const GLuint64 handle)
+{
+	if (!handle || !resident.capacity)
+		return;
+
+	const uint32_t mask = resident.capacity - 1;
+	uint32_t hole = find_handle(handle);
+
+	if (!resident.entries[hole].handle || --resident.entries[hole].count)
+		return;
+
+	ae_opengl_extensions.make_texture_handle_non_resident(handle);
+	resident.count--;
+
+	// later entries of the probe sequence move into the hole, a lookup never stops at it too early
+	for (uint32_t next = (hole + 1) & mask; resident.entries[next].handle; next = (next + 1) & mask)
+	{
+		const uint32_t home = hash_handle(resident.entries[next].handle);
+
+		if (((next - home) & mask) >= ((next - hole) & mask))
+		{
+			resident.entries[hole] = resident.entries[next];
+			hole = next;
+		}
+	}
+
+	resident.entries[hole] = (struct ae_resident_handle){ 0 };
+}
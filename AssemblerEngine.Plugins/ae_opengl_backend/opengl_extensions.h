@@ -0,0 +1,40 @@
+#pragma once
+
+// extensions the renderer uses when the driver has them, glad only loads the core profile
+
+#include "glad/glad.h"
+
+#include <stdbool.h>
+
+typedef GLuint64 (APIENTRYP PFNGLGETTEXTUREHANDLEARBPROC)(GLuint texture);
+typedef void (APIENTRYP PFNGLMAKETEXTUREHANDLERESIDENTARBPROC)(GLuint64 handle);
+typedef void (APIENTRYP PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC)(GLuint64 handle);
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif // !GL_COMPLETION_STATUS_KHR
+
+struct ae_opengl_extensions
+{
+	bool bindless_texture;
+	PFNGLGETTEXTUREHANDLEARBPROC get_texture_handle;
+	PFNGLMAKETEXTUREHANDLERESIDENTARBPROC make_texture_handle_resident;
+	PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC make_texture_handle_non_resident;
+
+	// GL_KHR_parallel_shader_compile or the ARB version, both use the same enums
+	bool parallel_shader_compile;
+	PFNGLMAXSHADERCOMPILERTHREADSKHRPROC max_shader_compiler_threads;
+};
+
+extern struct ae_opengl_extensions ae_opengl_extensions;
+
+bool ae_opengl_has_extension(const char* name);
+
+// must be called with the context current, after glad was loaded
+void ae_opengl_extensions_load(GLADloadproc load);
+
+// bindless handles are counted, a handle stays resident until every acquire was released.
+// making a resident handle resident again is an error, so batches sharing a texture go through here
+GLuint64 ae_opengl_acquire_texture_handle(const GLuint texture);
+void ae_opengl_release_texture_handle(const GLuint64 handle);
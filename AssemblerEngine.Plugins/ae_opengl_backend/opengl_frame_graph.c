@@ -0,0 +1,924 @@
+#include "opengl_frame_graph.h"
+#include "opengl_profiler.h"
+#include "opengl_state.h"
+#include "glad/glad.h"
+
+#include <apis/frame_graph.h>
+#include <apis/gpu_profiler.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum ae_graph_resource_type
+{
+	AE_GRAPH_RESOURCE_TEXTURE,
+	AE_GRAPH_RESOURCE_BUFFER,
+	AE_GRAPH_RESOURCE_BACKBUFFER
+};
+
+// the read a write of an attachment does when it keeps the earlier contents, after the accesses of the api
+#define AE_GRAPH_ACCESS_ATTACHMENT (AE_FRAME_GRAPH_ACCESS_UNIFORM + 1)
+
+// not assigned to a position or pooled texture
+#define AE_GRAPH_NONE UINT32_MAX
+
+struct ae_graph_resource
+{
+	char name[AE_GPU_SCOPE_NAME_LENGTH];
+	struct ae_frame_graph_texture_desc desc;
+	enum ae_graph_resource_type type;
+	// the imported texture or buffer, a transient texture gets the one of its pooled texture
+	uint32_t gl_name;
+	uint32_t latest;
+	uint32_t pooled;
+	// positions in the execution order of the first and last pass that uses the resource
+	uint32_t first_use;
+	uint32_t last_use;
+	bool imported;
+};
+
+// handle - 1 indexes the versions
+struct ae_graph_version
+{
+	uint32_t resource;
+	// pass - 1 of the pass that wrote the version, 0 for the version a resource starts with
+	uint32_t producer;
+	uint32_t previous;
+	uint32_t next;
+	// written by image store or a shader storage write, later reads need a barrier
+	bool storage;
+};
+
+struct ae_graph_read
+{
+	uint32_t version;
+	uint32_t access;
+};
+
+struct ae_graph_attachment
+{
+	uint32_t resource;
+	vec4 clear_value;
+	bool clear;
+};
+
+struct ae_graph_pass
+{
+	char name[AE_GPU_SCOPE_NAME_LENGTH];
+	ae_frame_graph_execute_fn execute;
+	void* user_data;
+	struct ae_graph_read reads[AE_FRAME_GRAPH_MAX_ACCESSES];
+	uint32_t read_count;
+	uint32_t writes[AE_FRAME_GRAPH_MAX_ACCESSES];
+	uint32_t write_count;
+	struct ae_graph_attachment colors[AE_FRAME_GRAPH_MAX_COLOR_ATTACHMENTS];
+	uint32_t color_count;
+	struct ae_graph_attachment depth;
+	bool has_depth;
+	bool writes_backbuffer;
+	bool side_effect;
+	bool alive;
+	uint32_t position;
+};
+
+struct ae_graph_texture
+{
+	uint32_t texture;
+	struct ae_frame_graph_texture_desc desc;
+	uint64_t last_used;
+	bool in_use;
+};
+
+// a framebuffer for every set of pooled textures that were attached together
+struct ae_graph_framebuffer
+{
+	uint32_t framebuffer;
+	uint32_t colors[AE_FRAME_GRAPH_MAX_COLOR_ATTACHMENTS];
+	uint32_t depth;
+	uint64_t last_used;
+};
+
+struct ae_frame_graph
+{
+	struct ae_graph_resource resources[AE_FRAME_GRAPH_MAX_RESOURCES];
+	uint32_t resource_count;
+	struct ae_graph_version versions[AE_FRAME_GRAPH_MAX_VERSIONS];
+	uint32_t version_count;
+	struct ae_graph_pass passes[AE_FRAME_GRAPH_MAX_PASSES];
+	uint32_t pass_count;
+	// after[a][b] when pass a has to run after pass b
+	bool after[AE_FRAME_GRAPH_MAX_PASSES][AE_FRAME_GRAPH_MAX_PASSES];
+	uint32_t order[AE_FRAME_GRAPH_MAX_PASSES];
+	uint32_t order_count;
+	struct ae_graph_texture textures[AE_FRAME_GRAPH_MAX_TEXTURES];
+	uint32_t texture_count;
+	struct ae_graph_framebuffer framebuffers[AE_FRAME_GRAPH_MAX_FRAMEBUFFERS];
+	uint32_t framebuffer_count;
+	// the position + 1 of the pass the last barrier with each bit ran before, writes of earlier passes are visible
+	uint32_t barrier_positions[32];
+	struct ae_frame_graph_stats stats;
+	uint64_t frame;
+	uint32_t backbuffer;
+	// the framebuffer and viewport bound when execute was called
+	GLint target;
+	GLint viewport[4];
+	bool failed;
+};
+
+static uint32_t get_internal_format(const enum ae_frame_graph_format format)
+{
+	switch (format)
+	{
+	case AE_FRAME_GRAPH_FORMAT_RGBA16F:
+		return GL_RGBA16F;
+	case AE_FRAME_GRAPH_FORMAT_DEPTH24_STENCIL8:
+		return GL_DEPTH24_STENCIL8;
+	default:
+		return GL_RGBA8;
+	}
+}
+
+static uint32_t get_barrier_bit(const uint32_t access, const enum ae_graph_resource_type type)
+{
+	switch (access)
+	{
+	case AE_FRAME_GRAPH_ACCESS_STORAGE:
+		return type == AE_GRAPH_RESOURCE_BUFFER ? GL_SHADER_STORAGE_BARRIER_BIT : GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+	case AE_FRAME_GRAPH_ACCESS_VERTEX:
+		return GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT;
+	case AE_FRAME_GRAPH_ACCESS_INDEX:
+		return GL_ELEMENT_ARRAY_BARRIER_BIT;
+	case AE_FRAME_GRAPH_ACCESS_INDIRECT:
+		return GL_COMMAND_BARRIER_BIT;
+	case AE_FRAME_GRAPH_ACCESS_UNIFORM:
+		return GL_UNIFORM_BARRIER_BIT;
+	case AE_GRAPH_ACCESS_ATTACHMENT:
+		return GL_FRAMEBUFFER_BARRIER_BIT;
+	default:
+		return GL_TEXTURE_FETCH_BARRIER_BIT;
+	}
+}
+
+//
+// declaration
+//
+
+// a failed declaration fails the execute of the frame, the passes would otherwise run with missing dependencies
+static uint32_t fail(struct ae_frame_graph* graph)
+{
+	graph->failed = true;
+	return 0;
+}
+
+static struct ae_graph_version* get_version(const struct ae_frame_graph* graph, const ae_frame_graph_handle handle)
+{
+	return handle && handle <= graph->version_count ? (struct ae_graph_version*)&graph->versions[handle - 1] : NULL;
+}
+
+static struct ae_graph_pass* get_pass(struct ae_frame_graph* graph, const ae_frame_graph_pass pass)
+{
+	return pass && pass <= graph->pass_count ? &graph->passes[pass - 1] : NULL;
+}
+
+static ae_frame_graph_handle add_version(struct ae_frame_graph* graph, const uint32_t resource, const uint32_t producer, const ae_frame_graph_handle previous)
+{
+	if (graph->version_count == AE_FRAME_GRAPH_MAX_VERSIONS)
+		return fail(graph);
+
+	graph->versions[graph->version_count++] = (struct ae_graph_version){ .resource = resource, .producer = producer, .previous = previous };
+	graph->resources[resource].latest = graph->version_count;
+
+	return graph->version_count;
+}
+
+static ae_frame_graph_handle add_resource(struct ae_frame_graph* graph, const char* name, const enum ae_graph_resource_type type, const uint32_t gl_name, const struct ae_frame_graph_texture_desc* desc)
+{
+	if (graph->resource_count == AE_FRAME_GRAPH_MAX_RESOURCES)
+		return fail(graph);
+
+	struct ae_graph_resource* resource = &graph->resources[graph->resource_count];
+	*resource = (struct ae_graph_resource){ .type = type, .gl_name = gl_name, .imported = type != AE_GRAPH_RESOURCE_TEXTURE || gl_name != 0 };
+	snprintf(resource->name, sizeof(resource->name), "%s", name);
+
+	if (desc)
+		resource->desc = *desc;
+
+	return add_version(graph, graph->resource_count++, 0, 0);
+}
+
+static bool add_read(struct ae_frame_graph* graph, struct ae_graph_pass* pass, const ae_frame_graph_handle version, const uint32_t access)
+{
+	if (pass->read_count == AE_FRAME_GRAPH_MAX_ACCESSES)
+		return fail(graph);
+
+	pass->reads[pass->read_count++] = (struct ae_graph_read){ .version = version, .access = access };
+	return true;
+}
+
+// every version is written once, a second write from it would split the resource in two
+static ae_frame_graph_handle add_write(struct ae_frame_graph* graph, const ae_frame_graph_pass pass, const ae_frame_graph_handle resource, const bool storage)
+{
+	struct ae_graph_pass* written_by = get_pass(graph, pass);
+	struct ae_graph_version* version = get_version(graph, resource);
+
+	if (!written_by || !version || version->next || written_by->write_count == AE_FRAME_GRAPH_MAX_ACCESSES)
+		return fail(graph);
+
+	ae_frame_graph_handle written = add_version(graph, version->resource, pass, resource);
+
+	if (!written)
+		return 0;
+
+	graph->versions[resource - 1].next = written;
+	graph->versions[written - 1].storage = storage;
+	written_by->writes[written_by->write_count++] = written;
+
+	return written;
+}
+
+struct ae_frame_graph* ae_frame_graph_create()
+{
+	struct ae_frame_graph* graph = calloc(1, sizeof(*graph));
+
+	if (graph)
+		graph->backbuffer = AE_GRAPH_NONE;
+
+	return graph;
+}
+
+static void delete_framebuffer(struct ae_frame_graph* graph, const uint32_t index)
+{
+	glDeleteFramebuffers(1, &graph->framebuffers[index].framebuffer);
+	graph->framebuffers[index] = graph->framebuffers[--graph->framebuffer_count];
+}
+
+static void delete_texture(struct ae_frame_graph* graph, const uint32_t index)
+{
+	const uint32_t texture = graph->textures[index].texture;
+
+	for (uint32_t i = graph->framebuffer_count; i-- > 0;)
+	{
+		bool attached = graph->framebuffers[i].depth == texture;
+
+		for (uint32_t j = 0; j < AE_FRAME_GRAPH_MAX_COLOR_ATTACHMENTS; j++)
+			attached |= graph->framebuffers[i].colors[j] == texture;
+
+		if (attached)
+			delete_framebuffer(graph, i);
+	}
+
+	ae_gl_state_forget_texture(texture);
+	glDeleteTextures(1, &texture);
+	graph->textures[index] = graph->textures[--graph->texture_count];
+}
+
+void ae_frame_graph_destroy(struct ae_frame_graph* graph)
+{
+	while (graph->texture_count)
+		delete_texture(graph, 0);
+
+	while (graph->framebuffer_count)
+		delete_framebuffer(graph, 0);
+
+	free(graph);
+}
+
+void ae_frame_graph_reset(struct ae_frame_graph* graph)
+{
+	graph->resource_count = 0;
+	graph->version_count = 0;
+	graph->pass_count = 0;
+	graph->order_count = 0;
+	graph->backbuffer = AE_GRAPH_NONE;
+	graph->failed = false;
+}
+
+ae_frame_graph_handle ae_frame_graph_create_texture(struct ae_frame_graph* graph, const char* name, const struct ae_frame_graph_texture_desc* desc)
+{
+	return add_resource(graph, name, AE_GRAPH_RESOURCE_TEXTURE, 0, desc);
+}
+
+ae_frame_graph_handle ae_frame_graph_import_texture(struct ae_frame_graph* graph, const char* name, const uint32_t texture, const struct ae_frame_graph_texture_desc* desc)
+{
+	return texture ? add_resource(graph, name, AE_GRAPH_RESOURCE_TEXTURE, texture, desc) : fail(graph);
+}
+
+ae_frame_graph_handle ae_frame_graph_import_buffer(struct ae_frame_graph* graph, const char* name, const uint32_t buffer)
+{
+	return buffer ? add_resource(graph, name, AE_GRAPH_RESOURCE_BUFFER, buffer, NULL) : fail(graph);
+}
+
+ae_frame_graph_handle ae_frame_graph_get_backbuffer(struct ae_frame_graph* graph)
+{
+	if (graph->backbuffer == AE_GRAPH_NONE)
+	{
+		ae_frame_graph_handle handle = add_resource(graph, "backbuffer", AE_GRAPH_RESOURCE_BACKBUFFER, 0, NULL);
+
+		if (!handle)
+			return 0;
+
+		graph->backbuffer = graph->versions[handle - 1].resource;
+	}
+
+	return graph->resources[graph->backbuffer].latest;
+}
+
+ae_frame_graph_pass ae_frame_graph_add_pass(struct ae_frame_graph* graph, const char* name, ae_frame_graph_execute_fn execute, void* user_data)
+{
+	if (graph->pass_count == AE_FRAME_GRAPH_MAX_PASSES)
+		return fail(graph);
+
+	struct ae_graph_pass* pass = &graph->passes[graph->pass_count++];
+	*pass = (struct ae_graph_pass){ .execute = execute, .user_data = user_data };
+	snprintf(pass->name, sizeof(pass->name), "%s", name);
+
+	return graph->pass_count;
+}
+
+void ae_frame_graph_read(struct ae_frame_graph* graph, const ae_frame_graph_pass pass, const ae_frame_graph_handle resource, const enum ae_frame_graph_access access)
+{
+	struct ae_graph_pass* reader = get_pass(graph, pass);
+
+	if (!reader || !get_version(graph, resource))
+		fail(graph);
+	else
+		add_read(graph, reader, resource, access);
+}
+
+ae_frame_graph_handle ae_frame_graph_write_attachment(struct ae_frame_graph* graph, const ae_frame_graph_pass pass, const ae_frame_graph_handle resource, const struct ae_frame_graph_attachment* attachment)
+{
+	struct ae_graph_pass* writer = get_pass(graph, pass);
+	const struct ae_graph_version* version = get_version(graph, resource);
+
+	if (!writer || !version || graph->resources[version->resource].type == AE_GRAPH_RESOURCE_BUFFER)
+		return fail(graph);
+
+	const struct ae_graph_resource* target = &graph->resources[version->resource];
+	const bool depth = target->type == AE_GRAPH_RESOURCE_TEXTURE && target->desc.format == AE_FRAME_GRAPH_FORMAT_DEPTH24_STENCIL8;
+
+	if (depth ? writer->has_depth : writer->color_count == AE_FRAME_GRAPH_MAX_COLOR_ATTACHMENTS)
+		return fail(graph);
+
+	// without a clear the pass draws over what the earlier version holds
+	if (!(attachment && attachment->clear) && !add_read(graph, writer, resource, AE_GRAPH_ACCESS_ATTACHMENT))
+		return 0;
+
+	const uint32_t resource_index = version->resource;
+	ae_frame_graph_handle written = add_write(graph, pass, resource, false);
+
+	if (!written)
+		return 0;
+
+	struct ae_graph_attachment* slot = depth ? &writer->depth : &writer->colors[writer->color_count++];
+	*slot = (struct ae_graph_attachment){ .resource = resource_index, .clear = attachment && attachment->clear };
+
+	if (slot->clear)
+		memcpy(slot->clear_value, attachment->clear_value, sizeof(slot->clear_value));
+
+	writer->has_depth |= depth;
+	writer->writes_backbuffer |= target->type == AE_GRAPH_RESOURCE_BACKBUFFER;
+
+	return written;
+}
+
+ae_frame_graph_handle ae_frame_graph_write_storage(struct ae_frame_graph* graph, const ae_frame_graph_pass pass, const ae_frame_graph_handle resource)
+{
+	struct ae_graph_pass* writer = get_pass(graph, pass);
+	const struct ae_graph_version* version = get_version(graph, resource);
+
+	if (!writer || !version || graph->resources[version->resource].type == AE_GRAPH_RESOURCE_BACKBUFFER)
+		return fail(graph);
+
+	// image stores only touch some texels, the rest keeps the earlier contents
+	if (!add_read(graph, writer, resource, AE_FRAME_GRAPH_ACCESS_STORAGE))
+		return 0;
+
+	return add_write(graph, pass, resource, true);
+}
+
+void ae_frame_graph_set_side_effect(struct ae_frame_graph* graph, const ae_frame_graph_pass pass)
+{
+	struct ae_graph_pass* marked = get_pass(graph, pass);
+
+	if (marked)
+		marked->side_effect = true;
+	else
+		fail(graph);
+}
+
+//
+// compile
+//
+
+// a pass stays when something that stays reads what it wrote, starting at the passes whose writes are seen outside the graph
+static void cull_passes(struct ae_frame_graph* graph)
+{
+	uint32_t stack[AE_FRAME_GRAPH_MAX_PASSES];
+	uint32_t count = 0;
+
+	for (uint32_t i = 0; i < graph->pass_count; i++)
+	{
+		struct ae_graph_pass* pass = &graph->passes[i];
+		pass->alive = pass->side_effect;
+
+		for (uint32_t j = 0; j < pass->write_count; j++)
+			pass->alive |= graph->resources[graph->versions[pass->writes[j] - 1].resource].imported;
+
+		if (pass->alive)
+			stack[count++] = i;
+	}
+
+	while (count)
+	{
+		const struct ae_graph_pass* pass = &graph->passes[stack[--count]];
+
+		for (uint32_t i = 0; i < pass->read_count; i++)
+		{
+			const uint32_t producer = graph->versions[pass->reads[i].version - 1].producer;
+
+			if (producer && !graph->passes[producer - 1].alive)
+			{
+				graph->passes[producer - 1].alive = true;
+				stack[count++] = producer - 1;
+			}
+		}
+	}
+}
+
+static void add_dependency(struct ae_frame_graph* graph, const uint32_t pass, const uint32_t producer)
+{
+	if (producer && producer - 1 != pass)
+		graph->after[pass][producer - 1] = true;
+}
+
+// reads wait for the write of their version, a write waits for the write and the reads of the version before it
+static void add_dependencies(struct ae_frame_graph* graph)
+{
+	for (uint32_t i = 0; i < graph->pass_count; i++)
+		memset(graph->after[i], 0, sizeof(bool) * graph->pass_count);
+
+	for (uint32_t i = 0; i < graph->pass_count; i++)
+	{
+		const struct ae_graph_pass* pass = &graph->passes[i];
+
+		if (!pass->alive)
+			continue;
+
+		for (uint32_t j = 0; j < pass->read_count; j++)
+			add_dependency(graph, i, graph->versions[pass->reads[j].version - 1].producer);
+
+		for (uint32_t j = 0; j < pass->write_count; j++)
+		{
+			const ae_frame_graph_handle previous = graph->versions[pass->writes[j] - 1].previous;
+			add_dependency(graph, i, graph->versions[previous - 1].producer);
+
+			for (uint32_t k = 0; k < graph->pass_count; k++)
+			{
+				const struct ae_graph_pass* reader = &graph->passes[k];
+
+				for (uint32_t l = 0; reader->alive && l < reader->read_count; l++)
+				{
+					if (reader->reads[l].version == previous)
+						add_dependency(graph, i, k + 1);
+				}
+			}
+		}
+	}
+}
+
+// passes run as soon as everything they wait for ran, passes that are ready together keep the order they were added in
+static bool sort_passes(struct ae_frame_graph* graph)
+{
+	uint32_t waiting[AE_FRAME_GRAPH_MAX_PASSES];
+	uint32_t alive_count = 0;
+
+	for (uint32_t i = 0; i < graph->pass_count; i++)
+	{
+		waiting[i] = 0;
+		graph->passes[i].position = AE_GRAPH_NONE;
+
+		for (uint32_t j = 0; j < graph->pass_count; j++)
+			waiting[i] += graph->after[i][j] && graph->passes[j].alive;
+
+		alive_count += graph->passes[i].alive;
+	}
+
+	graph->order_count = 0;
+
+	while (graph->order_count < alive_count)
+	{
+		uint32_t next = 0;
+
+		while (next < graph->pass_count && (!graph->passes[next].alive || graph->passes[next].position != AE_GRAPH_NONE || waiting[next]))
+			next++;
+
+		// every pass left waits for another one
+		if (next == graph->pass_count)
+			return false;
+
+		graph->passes[next].position = graph->order_count;
+		graph->order[graph->order_count++] = next;
+
+		for (uint32_t i = 0; i < graph->pass_count; i++)
+			waiting[i] -= graph->after[i][next] && graph->passes[i].alive;
+	}
+
+	return true;
+}
+
+static void use_resource(struct ae_frame_graph* graph, const ae_frame_graph_handle version, const uint32_t position)
+{
+	struct ae_graph_resource* resource = &graph->resources[graph->versions[version - 1].resource];
+
+	if (resource->first_use == AE_GRAPH_NONE || position < resource->first_use)
+		resource->first_use = position;
+
+	if (resource->last_use == AE_GRAPH_NONE || position > resource->last_use)
+		resource->last_use = position;
+}
+
+static void find_lifetimes(struct ae_frame_graph* graph)
+{
+	for (uint32_t i = 0; i < graph->resource_count; i++)
+	{
+		struct ae_graph_resource* resource = &graph->resources[i];
+
+		resource->first_use = AE_GRAPH_NONE;
+		resource->last_use = AE_GRAPH_NONE;
+		resource->pooled = AE_GRAPH_NONE;
+
+		// a size of 0 follows the viewport
+		if (resource->type == AE_GRAPH_RESOURCE_TEXTURE && !resource->imported)
+		{
+			resource->desc.width = resource->desc.width ? resource->desc.width : (uint32_t)graph->viewport[2];
+			resource->desc.height = resource->desc.height ? resource->desc.height : (uint32_t)graph->viewport[3];
+		}
+	}
+
+	for (uint32_t i = 0; i < graph->order_count; i++)
+	{
+		const struct ae_graph_pass* pass = &graph->passes[graph->order[i]];
+
+		for (uint32_t j = 0; j < pass->read_count; j++)
+			use_resource(graph, pass->reads[j].version, i);
+
+		for (uint32_t j = 0; j < pass->write_count; j++)
+			use_resource(graph, pass->writes[j], i);
+	}
+}
+
+static uint32_t create_texture(struct ae_frame_graph* graph, const struct ae_frame_graph_texture_desc* desc)
+{
+	if (graph->texture_count == AE_FRAME_GRAPH_MAX_TEXTURES)
+		return AE_GRAPH_NONE;
+
+	struct ae_graph_texture* texture = &graph->textures[graph->texture_count];
+	*texture = (struct ae_graph_texture){ .desc = *desc };
+
+	glCreateTextures(GL_TEXTURE_2D, 1, &texture->texture);
+	glTextureStorage2D(texture->texture, 1, get_internal_format(desc->format), (GLsizei)desc->width, (GLsizei)desc->height);
+	glTextureParameteri(texture->texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTextureParameteri(texture->texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTextureParameteri(texture->texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTextureParameteri(texture->texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	return graph->texture_count++;
+}
+
+static uint32_t acquire_texture(struct ae_frame_graph* graph, const struct ae_frame_graph_texture_desc* desc)
+{
+	for (uint32_t i = 0; i < graph->texture_count; i++)
+	{
+		const struct ae_graph_texture* texture = &graph->textures[i];
+
+		if (!texture->in_use && texture->desc.width == desc->width && texture->desc.height == desc->height && texture->desc.format == desc->format)
+			return i;
+	}
+
+	return create_texture(graph, desc);
+}
+
+// a transient texture takes a pooled texture at its first pass and gives it back after its last pass,
+// so resources that are never alive at the same time share one texture
+static bool assign_textures(struct ae_frame_graph* graph)
+{
+	for (uint32_t i = 0; i < graph->order_count; i++)
+	{
+		for (uint32_t j = 0; j < graph->resource_count; j++)
+		{
+			struct ae_graph_resource* resource = &graph->resources[j];
+
+			if (resource->type != AE_GRAPH_RESOURCE_TEXTURE || resource->imported || resource->first_use != i)
+				continue;
+
+			resource->pooled = acquire_texture(graph, &resource->desc);
+
+			if (resource->pooled == AE_GRAPH_NONE)
+				return false;
+
+			struct ae_graph_texture* texture = &graph->textures[resource->pooled];
+
+			if (texture->last_used != graph->frame)
+				graph->stats.allocated_count++;
+
+			texture->in_use = true;
+			texture->last_used = graph->frame;
+			resource->gl_name = texture->texture;
+			graph->stats.texture_count++;
+		}
+
+		for (uint32_t j = 0; j < graph->resource_count; j++)
+		{
+			const struct ae_graph_resource* resource = &graph->resources[j];
+
+			if (resource->pooled != AE_GRAPH_NONE && resource->last_use == i)
+				graph->textures[resource->pooled].in_use = false;
+		}
+	}
+
+	return true;
+}
+
+static bool compile(struct ae_frame_graph* graph)
+{
+	cull_passes(graph);
+	add_dependencies(graph);
+
+	if (!sort_passes(graph))
+		return false;
+
+	for (uint32_t i = 0; i < graph->order_count; i++)
+	{
+		const struct ae_graph_pass* pass = &graph->passes[graph->order[i]];
+
+		// the backbuffer is a framebuffer of its own, nothing else can be attached to it
+		if (pass->writes_backbuffer && (pass->color_count > 1 || pass->has_depth))
+			return false;
+	}
+
+	find_lifetimes(graph);
+
+	return assign_textures(graph);
+}
+
+//
+// execute
+//
+
+static uint32_t create_framebuffer(const uint32_t* colors, const uint32_t color_count, const uint32_t depth)
+{
+	GLenum draw_buffers[AE_FRAME_GRAPH_MAX_COLOR_ATTACHMENTS];
+	uint32_t framebuffer;
+
+	glCreateFramebuffers(1, &framebuffer);
+
+	for (uint32_t i = 0; i < color_count; i++)
+	{
+		glNamedFramebufferTexture(framebuffer, GL_COLOR_ATTACHMENT0 + i, colors[i], 0);
+		draw_buffers[i] = GL_COLOR_ATTACHMENT0 + i;
+	}
+
+	if (depth)
+		glNamedFramebufferTexture(framebuffer, GL_DEPTH_STENCIL_ATTACHMENT, depth, 0);
+
+	if (color_count)
+		glNamedFramebufferDrawBuffers(framebuffer, (GLsizei)color_count, draw_buffers);
+	else
+		glNamedFramebufferDrawBuffer(framebuffer, GL_NONE);
+
+	return framebuffer;
+}
+
+// framebuffers of pooled textures are kept until one of the textures is deleted, a framebuffer with
+// an imported texture is made for the pass because the texture can be deleted and its name reused
+static uint32_t get_framebuffer(struct ae_frame_graph* graph, const struct ae_graph_pass* pass, bool* temporary)
+{
+	uint32_t colors[AE_FRAME_GRAPH_MAX_COLOR_ATTACHMENTS] = { 0 };
+	uint32_t depth = pass->has_depth ? graph->resources[pass->depth.resource].gl_name : 0;
+	bool pooled = !pass->has_depth || !graph->resources[pass->depth.resource].imported;
+
+	for (uint32_t i = 0; i < pass->color_count; i++)
+	{
+		colors[i] = graph->resources[pass->colors[i].resource].gl_name;
+		pooled &= !graph->resources[pass->colors[i].resource].imported;
+	}
+
+	*temporary = !pooled;
+
+	if (!pooled)
+		return create_framebuffer(colors, pass->color_count, depth);
+
+	for (uint32_t i = 0; i < graph->framebuffer_count; i++)
+	{
+		struct ae_graph_framebuffer* cached = &graph->framebuffers[i];
+
+		if (cached->depth == depth && memcmp(cached->colors, colors, sizeof(colors)) == 0)
+		{
+			cached->last_used = graph->frame;
+			return cached->framebuffer;
+		}
+	}
+
+	// the least recently used framebuffer makes room
+	if (graph->framebuffer_count == AE_FRAME_GRAPH_MAX_FRAMEBUFFERS)
+	{
+		uint32_t oldest = 0;
+
+		for (uint32_t i = 1; i < graph->framebuffer_count; i++)
+		{
+			if (graph->framebuffers[i].last_used < graph->framebuffers[oldest].last_used)
+				oldest = i;
+		}
+
+		delete_framebuffer(graph, oldest);
+	}
+
+	struct ae_graph_framebuffer* created = &graph->framebuffers[graph->framebuffer_count++];
+	*created = (struct ae_graph_framebuffer){ .depth = depth, .last_used = graph->frame };
+	memcpy(created->colors, colors, sizeof(colors));
+	created->framebuffer = create_framebuffer(colors, pass->color_count, depth);
+
+	return created->framebuffer;
+}
+
+// binds the framebuffer of the pass and runs all of its clears at once
+static uint32_t begin_render_pass(struct ae_frame_graph* graph, const struct ae_graph_pass* pass, uint32_t* bound)
+{
+	bool temporary = false;
+	uint32_t framebuffer = pass->writes_backbuffer ? (uint32_t)graph->target : get_framebuffer(graph, pass, &temporary);
+
+	if (framebuffer != *bound)
+	{
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+		*bound = framebuffer;
+	}
+
+	if (pass->writes_backbuffer)
+	{
+		glViewport(graph->viewport[0], graph->viewport[1], graph->viewport[2], graph->viewport[3]);
+	}
+	else
+	{
+		const struct ae_graph_attachment* first = pass->color_count ? &pass->colors[0] : &pass->depth;
+		const struct ae_frame_graph_texture_desc* desc = &graph->resources[first->resource].desc;
+		glViewport(0, 0, (GLsizei)desc->width, (GLsizei)desc->height);
+	}
+
+	bool clears = pass->has_depth && pass->depth.clear;
+
+	for (uint32_t i = 0; i < pass->color_count; i++)
+		clears |= pass->colors[i].clear;
+
+	// a clear only writes what the scissor rectangle and the write masks let through
+	if (clears)
+	{
+		ae_gl_state_set_scissor_test(false);
+		ae_gl_state_set_write_masks(true, true, 0xff);
+	}
+
+	for (uint32_t i = 0; i < pass->color_count; i++)
+	{
+		if (pass->colors[i].clear)
+		{
+			glClearNamedFramebufferfv(framebuffer, GL_COLOR, (GLint)i, pass->colors[i].clear_value);
+			graph->stats.clear_count++;
+		}
+	}
+
+	if (pass->has_depth && pass->depth.clear)
+	{
+		glClearNamedFramebufferfi(framebuffer, GL_DEPTH_STENCIL, 0, pass->depth.clear_value[0], 0);
+		graph->stats.clear_count++;
+	}
+
+	return temporary ? framebuffer : 0;
+}
+
+// one barrier before the pass with every bit its reads need. a bit is left out when a barrier with it
+// already ran after the storage write, so passes reading the same results share the first barrier
+static void issue_barrier(struct ae_frame_graph* graph, const struct ae_graph_pass* pass)
+{
+	GLbitfield bits = 0;
+
+	for (uint32_t i = 0; i < pass->read_count; i++)
+	{
+		const struct ae_graph_version* version = &graph->versions[pass->reads[i].version - 1];
+
+		if (!version->storage)
+			continue;
+
+		const uint32_t bit = get_barrier_bit(pass->reads[i].access, graph->resources[version->resource].type);
+		const uint32_t written = graph->passes[version->producer - 1].position;
+
+		for (uint32_t j = 0; j < 32; j++)
+		{
+			if ((bit >> j & 1) && graph->barrier_positions[j] <= written + 1)
+				bits |= bit;
+		}
+	}
+
+	if (!bits)
+		return;
+
+	glMemoryBarrier(bits);
+	graph->stats.barrier_count++;
+
+	for (uint32_t j = 0; j < 32; j++)
+	{
+		if (bits >> j & 1)
+			graph->barrier_positions[j] = pass->position + 1;
+	}
+}
+
+// transient textures are discarded after their last pass, the driver does not have to keep or store them
+static void end_pass(struct ae_frame_graph* graph, const uint32_t position)
+{
+	for (uint32_t i = 0; i < graph->resource_count; i++)
+	{
+		const struct ae_graph_resource* resource = &graph->resources[i];
+
+		if (resource->pooled != AE_GRAPH_NONE && resource->last_use == position)
+			glInvalidateTexImage(resource->gl_name, 0);
+	}
+}
+
+// textures the graph stopped asking for are deleted after AE_FRAME_GRAPH_TEXTURE_LIFETIME executes
+static void trim_pool(struct ae_frame_graph* graph)
+{
+	for (uint32_t i = graph->texture_count; i-- > 0;)
+	{
+		graph->textures[i].in_use = false;
+
+		if (graph->frame - graph->textures[i].last_used >= AE_FRAME_GRAPH_TEXTURE_LIFETIME)
+			delete_texture(graph, i);
+	}
+}
+
+bool ae_frame_graph_execute(struct ae_frame_graph* graph)
+{
+	graph->frame++;
+	graph->stats = (struct ae_frame_graph_stats){ .pass_count = graph->pass_count };
+
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &graph->target);
+	glGetIntegerv(GL_VIEWPORT, graph->viewport);
+
+	if (graph->failed || !compile(graph))
+	{
+		trim_pool(graph);
+		return false;
+	}
+
+	graph->stats.culled_count = graph->pass_count - graph->order_count;
+	memset(graph->barrier_positions, 0, sizeof(graph->barrier_positions));
+
+	uint32_t bound = (uint32_t)graph->target;
+
+	for (uint32_t i = 0; i < graph->order_count; i++)
+	{
+		const struct ae_graph_pass* pass = &graph->passes[graph->order[i]];
+		uint32_t temporary = 0;
+
+		issue_barrier(graph, pass);
+
+		if (pass->color_count || pass->has_depth)
+			temporary = begin_render_pass(graph, pass, &bound);
+
+		ae_gpu_profiler_begin_scope(pass->name);
+
+		if (pass->execute)
+		{
+			pass->execute(graph, pass->user_data);
+			// the pass may change gl state without the cache
+			ae_gl_state_invalidate();
+		}
+
+		ae_gpu_profiler_end_scope();
+		end_pass(graph, i);
+
+		if (temporary)
+		{
+			glDeleteFramebuffers(1, &temporary);
+			bound = AE_GRAPH_NONE;
+		}
+	}
+
+	// the backend finds its framebuffer and viewport the way it left them
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, (GLuint)graph->target);
+	glViewport(graph->viewport[0], graph->viewport[1], graph->viewport[2], graph->viewport[3]);
+
+	trim_pool(graph);
+
+	return true;
+}
+
+uint32_t ae_frame_graph_get_name(const struct ae_frame_graph* graph, const ae_frame_graph_handle resource)
+{
+	const struct ae_graph_version* version = get_version(graph, resource);
+	return version ? graph->resources[version->resource].gl_name : 0;
+}
+
+void ae_frame_graph_get_stats(const struct ae_frame_graph* graph, struct ae_frame_graph_stats* stats)
+{
+	*stats = graph->stats;
+}
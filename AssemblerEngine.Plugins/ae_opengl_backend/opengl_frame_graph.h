@@ -0,0 +1,58 @@
+#pragma once
+
+// passes are sorted by the versions of the resources they read and write, passes that do not lead to an
+// imported resource or a side effect are culled. transient textures come from a pool that outlives the frame,
+// a pooled texture is handed to the next resource with the same size and format once its last pass ran
+
+#include <apis/frame_graph.h>
+#include <core/types.h>
+
+#ifndef AE_FRAME_GRAPH_MAX_PASSES
+#define AE_FRAME_GRAPH_MAX_PASSES 64
+#endif // !AE_FRAME_GRAPH_MAX_PASSES
+
+#ifndef AE_FRAME_GRAPH_MAX_RESOURCES
+#define AE_FRAME_GRAPH_MAX_RESOURCES 64
+#endif // !AE_FRAME_GRAPH_MAX_RESOURCES
+
+#ifndef AE_FRAME_GRAPH_MAX_VERSIONS
+#define AE_FRAME_GRAPH_MAX_VERSIONS 256
+#endif // !AE_FRAME_GRAPH_MAX_VERSIONS
+
+// reads and writes of one pass
+#ifndef AE_FRAME_GRAPH_MAX_ACCESSES
+#define AE_FRAME_GRAPH_MAX_ACCESSES 16
+#endif // !AE_FRAME_GRAPH_MAX_ACCESSES
+
+#ifndef AE_FRAME_GRAPH_MAX_COLOR_ATTACHMENTS
+#define AE_FRAME_GRAPH_MAX_COLOR_ATTACHMENTS 8
+#endif // !AE_FRAME_GRAPH_MAX_COLOR_ATTACHMENTS
+
+#ifndef AE_FRAME_GRAPH_MAX_TEXTURES
+#define AE_FRAME_GRAPH_MAX_TEXTURES 64
+#endif // !AE_FRAME_GRAPH_MAX_TEXTURES
+
+#ifndef AE_FRAME_GRAPH_MAX_FRAMEBUFFERS
+#define AE_FRAME_GRAPH_MAX_FRAMEBUFFERS 32
+#endif // !AE_FRAME_GRAPH_MAX_FRAMEBUFFERS
+
+// executes a pooled texture stays alive without being used
+#ifndef AE_FRAME_GRAPH_TEXTURE_LIFETIME
+#define AE_FRAME_GRAPH_TEXTURE_LIFETIME 3
+#endif // !AE_FRAME_GRAPH_TEXTURE_LIFETIME
+
+struct ae_frame_graph* ae_frame_graph_create();
+void ae_frame_graph_destroy(struct ae_frame_graph* graph);
+void ae_frame_graph_reset(struct ae_frame_graph* graph);
+ae_frame_graph_handle ae_frame_graph_create_texture(struct ae_frame_graph* graph, const char* name, const struct ae_frame_graph_texture_desc* desc);
+ae_frame_graph_handle ae_frame_graph_import_texture(struct ae_frame_graph* graph, const char* name, const uint32_t texture, const struct ae_frame_graph_texture_desc* desc);
+ae_frame_graph_handle ae_frame_graph_import_buffer(struct ae_frame_graph* graph, const char* name, const uint32_t buffer);
+ae_frame_graph_handle ae_frame_graph_get_backbuffer(struct ae_frame_graph* graph);
+ae_frame_graph_pass ae_frame_graph_add_pass(struct ae_frame_graph* graph, const char* name, ae_frame_graph_execute_fn execute, void* user_data);
+void ae_frame_graph_read(struct ae_frame_graph* graph, const ae_frame_graph_pass pass, const ae_frame_graph_handle resource, const enum ae_frame_graph_access access);
+ae_frame_graph_handle ae_frame_graph_write_attachment(struct ae_frame_graph* graph, const ae_frame_graph_pass pass, const ae_frame_graph_handle resource, const struct ae_frame_graph_attachment* attachment);
+ae_frame_graph_handle ae_frame_graph_write_storage(struct ae_frame_graph* graph, const ae_frame_graph_pass pass, const ae_frame_graph_handle resource);
+void ae_frame_graph_set_side_effect(struct ae_frame_graph* graph, const ae_frame_graph_pass pass);
+bool ae_frame_graph_execute(struct ae_frame_graph* graph);
+uint32_t ae_frame_graph_get_name(const struct ae_frame_graph* graph, const ae_frame_graph_handle resource);
+void ae_frame_graph_get_stats(const struct ae_frame_graph* graph, struct ae_frame_graph_stats* stats);
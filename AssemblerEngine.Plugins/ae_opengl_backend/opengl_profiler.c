@@ -0,0 +1,259 @@
+#include "opengl_profiler.h"
+#include "glad/glad.h"
+
+#include <apis/gpu_profiler.h>
+
+#include <string.h>
+
+// the frame start, a begin and an end per scope, then the frame end
+#define AE_GPU_PROFILER_QUERY_COUNT (AE_GPU_PROFILER_MAX_SCOPES * 2 + 2)
+#define AE_GPU_PROFILER_FRAME_END (AE_GPU_PROFILER_QUERY_COUNT - 1)
+
+// stack entry of a scope that is not measured
+#define AE_GPU_PROFILER_NO_SCOPE 0xffffffffu
+
+struct ae_gpu_profiler_frame
+{
+	// name and depth are set while recording, the times once the frame is read back
+	struct ae_gpu_scope scopes[AE_GPU_PROFILER_MAX_SCOPES];
+	uint32_t queries[AE_GPU_PROFILER_QUERY_COUNT];
+	uint32_t scope_count;
+	uint32_t dropped_count;
+	uint64_t frame_index;
+	bool started;
+	bool ended;
+};
+
+struct ae_gpu_profiler
+{
+	struct ae_gpu_profiler_frame frames[AE_GPU_PROFILER_FRAME_COUNT];
+	// the newest frame that was read back, copied so the slot can be recorded again
+	struct ae_gpu_scope results[AE_GPU_PROFILER_MAX_SCOPES];
+	struct ae_gpu_frame result;
+	uint32_t stack[AE_GPU_PROFILER_MAX_DEPTH];
+	uint32_t depth;
+	uint32_t current;
+	uint64_t frame_index;
+	bool enabled;
+	bool created;
+	bool has_result;
+};
+
+static struct ae_gpu_profiler profiler;
+
+static uint32_t begin_query(const uint32_t scope)
+{
+	return 1 + scope * 2;
+}
+
+static uint32_t end_query(const uint32_t scope)
+{
+	return 2 + scope * 2;
+}
+
+static uint64_t get_timestamp(const uint32_t query)
+{
+	GLuint64 time = 0;
+	glGetQueryObjectui64v(query, GL_QUERY_RESULT, &time);
+
+	return time;
+}
+
+// only reads the frame if the gpu is done with it, waiting here would stall the cpu on the gpu
+static void read_frame(struct ae_gpu_profiler_frame* frame)
+{
+	GLint available = 0;
+	glGetQueryObjectiv(frame->queries[AE_GPU_PROFILER_FRAME_END], GL_QUERY_RESULT_AVAILABLE, &available);
+
+	frame->ended = false;
+
+	// queries complete in order, the frame end is the last one
+	if (!available)
+		return;
+
+	uint64_t frame_start = get_timestamp(frame->queries[0]);
+
+	for (uint32_t i = 0; i < frame->scope_count; i++)
+	{
+		uint64_t start = get_timestamp(frame->queries[begin_query(i)]);
+		uint64_t end = get_timestamp(frame->queries[end_query(i)]);
+
+		profiler.results[i] = frame->scopes[i];
+		profiler.results[i].start = start - frame_start;
+		profiler.results[i].duration = end > start ? end - start : 0;
+	}
+
+	profiler.result = (struct ae_gpu_frame){
+		.frame_index = frame->frame_index,
+		.gpu_time = get_timestamp(frame->queries[AE_GPU_PROFILER_FRAME_END]) - frame_start,
+		.dropped_count = frame->dropped_count,
+		.scope_count = frame->scope_count,
+		.scopes = profiler.results
+	};
+
+	profiler.has_result = true;
+}
+
+static void start_frame(struct ae_gpu_profiler_frame* frame)
+{
+	frame->scope_count = 0;
+	frame->dropped_count = 0;
+	frame->frame_index = profiler.frame_index++;
+	frame->started = true;
+	frame->ended = false;
+
+	glQueryCounter(frame->queries[0], GL_TIMESTAMP);
+}
+
+static void end_open_scopes(const struct ae_gpu_profiler_frame* frame)
+{
+	uint32_t depth = profiler.depth < AE_GPU_PROFILER_MAX_DEPTH ? profiler.depth : AE_GPU_PROFILER_MAX_DEPTH;
+
+	// the stack is kept so the end_scope calls still match, the scopes are just no longer measured
+	for (uint32_t i = 0; i < depth; i++)
+	{
+		if (profiler.stack[i] != AE_GPU_PROFILER_NO_SCOPE)
+		{
+			glQueryCounter(frame->queries[end_query(profiler.stack[i])], GL_TIMESTAMP);
+			profiler.stack[i] = AE_GPU_PROFILER_NO_SCOPE;
+		}
+	}
+}
+
+void ae_gpu_profiler_set_enabled(const bool enabled)
+{
+	if (enabled && !profiler.created)
+	{
+		for (uint32_t i = 0; i < AE_GPU_PROFILER_FRAME_COUNT; i++)
+			glCreateQueries(GL_TIMESTAMP, AE_GPU_PROFILER_QUERY_COUNT, profiler.frames[i].queries);
+
+		profiler.created = true;
+	}
+
+	if (!enabled)
+	{
+		for (uint32_t i = 0; i < AE_GPU_PROFILER_FRAME_COUNT; i++)
+			profiler.frames[i].started = profiler.frames[i].ended = false;
+	}
+
+	// the first frame starts at the next render_scene_start
+	profiler.enabled = enabled;
+	profiler.depth = 0;
+}
+
+bool ae_gpu_profiler_is_enabled()
+{
+	return profiler.enabled;
+}
+
+void ae_gpu_profiler_begin_scope(const char* name)
+{
+	if (!profiler.enabled)
+		return;
+
+	struct ae_gpu_profiler_frame* frame = &profiler.frames[profiler.current];
+	uint32_t scope = AE_GPU_PROFILER_NO_SCOPE;
+
+	if (frame->started && profiler.depth < AE_GPU_PROFILER_MAX_DEPTH)
+	{
+		// the previous scope of the same parent ended already and only scopes nested in it were begun
+		// after it. one with the same name takes the new end query, a draw per flush uses one scope
+		uint32_t previous = frame->scope_count;
+
+		while (previous > 0 && frame->scopes[previous - 1].depth > profiler.depth)
+			previous--;
+
+		bool parent_measured = profiler.depth == 0 || profiler.stack[profiler.depth - 1] != AE_GPU_PROFILER_NO_SCOPE;
+
+		if (parent_measured && previous > 0 && frame->scopes[previous - 1].depth == profiler.depth
+			&& strncmp(frame->scopes[previous - 1].name, name, AE_GPU_SCOPE_NAME_LENGTH - 1) == 0)
+		{
+			scope = previous - 1;
+			frame->scopes[scope].count++;
+		}
+		else if (frame->scope_count < AE_GPU_PROFILER_MAX_SCOPES)
+		{
+			scope = frame->scope_count++;
+
+			size_t length = strlen(name);
+			length = length < AE_GPU_SCOPE_NAME_LENGTH - 1 ? length : AE_GPU_SCOPE_NAME_LENGTH - 1;
+
+			memcpy(frame->scopes[scope].name, name, length);
+			frame->scopes[scope].name[length] = '\0';
+			frame->scopes[scope].depth = profiler.depth;
+			frame->scopes[scope].count = 1;
+
+			glQueryCounter(frame->queries[begin_query(scope)], GL_TIMESTAMP);
+		}
+		else
+		{
+			frame->dropped_count++;
+		}
+	}
+
+	if (profiler.depth < AE_GPU_PROFILER_MAX_DEPTH)
+		profiler.stack[profiler.depth] = scope;
+
+	profiler.depth++;
+}
+
+void ae_gpu_profiler_end_scope()
+{
+	if (!profiler.enabled || profiler.depth == 0)
+		return;
+
+	profiler.depth--;
+
+	if (profiler.depth < AE_GPU_PROFILER_MAX_DEPTH && profiler.stack[profiler.depth] != AE_GPU_PROFILER_NO_SCOPE)
+	{
+		const struct ae_gpu_profiler_frame* frame = &profiler.frames[profiler.current];
+		glQueryCounter(frame->queries[end_query(profiler.stack[profiler.depth])], GL_TIMESTAMP);
+	}
+}
+
+bool ae_gpu_profiler_get_frame(struct ae_gpu_frame* frame)
+{
+	if (!profiler.has_result)
+		return false;
+
+	*frame = profiler.result;
+
+	return true;
+}
+
+void ae_gpu_profiler_end_frame()
+{
+	if (!profiler.enabled)
+		return;
+
+	struct ae_gpu_profiler_frame* frame = &profiler.frames[profiler.current];
+
+	if (frame->started)
+	{
+		end_open_scopes(frame);
+		glQueryCounter(frame->queries[AE_GPU_PROFILER_FRAME_END], GL_TIMESTAMP);
+
+		frame->started = false;
+		frame->ended = true;
+		profiler.current = (profiler.current + 1) % AE_GPU_PROFILER_FRAME_COUNT;
+	}
+
+	// the oldest frame is read before its queries are used again
+	struct ae_gpu_profiler_frame* next = &profiler.frames[profiler.current];
+
+	if (next->ended)
+		read_frame(next);
+
+	start_frame(next);
+}
+
+void ae_gpu_profiler_shutdown()
+{
+	if (profiler.created)
+	{
+		for (uint32_t i = 0; i < AE_GPU_PROFILER_FRAME_COUNT; i++)
+			glDeleteQueries(AE_GPU_PROFILER_QUERY_COUNT, profiler.frames[i].queries);
+	}
+
+	memset(&profiler, 0, sizeof(profiler));
+}
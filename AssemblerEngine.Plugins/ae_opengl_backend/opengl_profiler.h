@@ -0,0 +1,33 @@
+#pragma once
+
+// gpu timestamps around frames and scopes. every frame has its own queries and is read back
+// AE_GPU_PROFILER_FRAME_COUNT - 1 frames after it ended, a frame the gpu is still working on is skipped
+
+#include <core/types.h>
+
+struct ae_gpu_frame;
+
+#ifndef AE_GPU_PROFILER_FRAME_COUNT
+#define AE_GPU_PROFILER_FRAME_COUNT 3
+#endif // !AE_GPU_PROFILER_FRAME_COUNT
+
+#ifndef AE_GPU_PROFILER_MAX_SCOPES
+#define AE_GPU_PROFILER_MAX_SCOPES 512
+#endif // !AE_GPU_PROFILER_MAX_SCOPES
+
+// scopes nested deeper are not measured
+#ifndef AE_GPU_PROFILER_MAX_DEPTH
+#define AE_GPU_PROFILER_MAX_DEPTH 32
+#endif // !AE_GPU_PROFILER_MAX_DEPTH
+
+void ae_gpu_profiler_set_enabled(const bool enabled);
+bool ae_gpu_profiler_is_enabled();
+void ae_gpu_profiler_begin_scope(const char* name);
+void ae_gpu_profiler_end_scope();
+bool ae_gpu_profiler_get_frame(struct ae_gpu_frame* frame);
+
+// ends the current frame and starts the next, called by render_scene_start
+void ae_gpu_profiler_end_frame();
+
+// deletes the queries, the context has to be current
+void ae_gpu_profiler_shutdown();
@@ -0,0 +1,276 @@
+#include "opengl_program_cache.h"
+#include "glad/glad.h"
+
+#include <core/os.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // !_WIN32
+
+#define AE_PROGRAM_CACHE_MAGIC "AEPB"
+// bump when the file layout changes
+#define AE_PROGRAM_CACHE_VERSION 1
+
+struct ae_program_binary_header
+{
+	char magic[4];
+	uint32_t version;
+	uint64_t key;
+	uint32_t format;
+	uint32_t size;
+};
+
+// empty until the default directory is looked up or a directory is set
+static char directory[AE_PROGRAM_CACHE_PATH_LENGTH];
+static bool enabled = true;
+static bool directory_created = false;
+
+// fnv-1a, sources are small and only hashed when a program is created
+static uint64_t hash_bytes(uint64_t hash, const void* data, const size_t size)
+{
+	const uint8_t* bytes = data;
+
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+static uint64_t hash_string(const uint64_t hash, const char* string)
+{
+	// the terminator keeps "ab" + "c" apart from "a" + "bc"
+	return string ? hash_bytes(hash, string, strlen(string) + 1) : hash_bytes(hash, "", 1);
+}
+
+static bool is_supported()
+{
+	GLint format_count = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+
+	return enabled && format_count > 0;
+}
+
+// the working directory depends on how the engine was started, the executable stays where it is
+static void set_default_directory()
+{
+	char executable[AE_PROGRAM_CACHE_PATH_LENGTH];
+
+#ifdef _WIN32
+	DWORD length = GetModuleFileNameA(NULL, executable, sizeof(executable));
+	bool found = length > 0 && length < sizeof(executable);
+#else
+	ssize_t length = readlink("/proc/self/exe", executable, sizeof(executable) - 1);
+	bool found = length > 0;
+#endif // _WIN32
+
+	char* separator = NULL;
+
+	if (found)
+	{
+		executable[length] = '\0';
+
+		for (char* c = executable; *c; c++)
+		{
+			if (*c == '/' || *c == '\\')
+				separator = c;
+		}
+	}
+
+	if (separator)
+	{
+		*separator = '\0';
+		int written = snprintf(directory, sizeof(directory), "%s/%s", executable, AE_PROGRAM_CACHE_DIRECTORY);
+
+		if (written > 0 && written < AE_PROGRAM_CACHE_PATH_LENGTH - 32)
+			return;
+	}
+
+	snprintf(directory, sizeof(directory), "%s", AE_PROGRAM_CACHE_DIRECTORY);
+}
+
+static bool get_path(const uint64_t key, char* path, const size_t size)
+{
+	if (!directory[0])
+		set_default_directory();
+
+	int written = snprintf(path, size, "%s/%016llx.bin", directory, (unsigned long long)key);
+	return written > 0 && (size_t)written < size;
+}
+
+static void create_directory()
+{
+	if (directory_created)
+		return;
+
+	if (!directory[0])
+		set_default_directory();
+
+#ifdef _WIN32
+	CreateDirectoryA(directory, NULL);
+#else
+	mkdir(directory, 0755);
+#endif // _WIN32
+
+	directory_created = true;
+}
+
+bool ae_program_cache_set_directory(const char* path)
+{
+	if (!path)
+	{
+		enabled = false;
+		return true;
+	}
+
+	if (strlen(path) >= AE_PROGRAM_CACHE_PATH_LENGTH - 32)
+		return false;
+
+	strcpy(directory, path);
+	enabled = true;
+	directory_created = false;
+
+	return true;
+}
+
+uint64_t ae_program_cache_key(const char** stage_sources, const int32_t* stage_sizes, const int32_t* stage_types, const int32_t stage_count)
+{
+	uint64_t hash = 14695981039346656037ull;
+
+	hash = hash_string(hash, (const char*)glGetString(GL_VENDOR));
+	hash = hash_string(hash, (const char*)glGetString(GL_RENDERER));
+	hash = hash_string(hash, (const char*)glGetString(GL_VERSION));
+
+	for (int32_t i = 0; i < stage_count; i++)
+	{
+		size_t size = stage_sizes && stage_sizes[i] >= 0 ? (size_t)stage_sizes[i] : strlen(stage_sources[i]);
+
+		hash = hash_bytes(hash, &stage_types[i], sizeof(stage_types[i]));
+		hash = hash_bytes(hash, &size, sizeof(size));
+		hash = hash_bytes(hash, stage_sources[i], size);
+	}
+
+	return hash;
+}
+
+enum ae_program_cache_result ae_program_cache_load(const uint64_t key, uint32_t* program)
+{
+	if (!is_supported())
+		return AE_PROGRAM_CACHE_MISS;
+
+	char path[AE_PROGRAM_CACHE_FILE_PATH_LENGTH];
+
+	if (!get_path(key, path, sizeof(path)))
+		return AE_PROGRAM_CACHE_MISS;
+
+	FILE* file = fopen(path, "rb");
+
+	if (!file)
+		return AE_PROGRAM_CACHE_MISS;
+
+	struct ae_program_binary_header header;
+	void* binary = NULL;
+	bool valid = fread(&header, sizeof(header), 1, file) == 1
+		&& memcmp(header.magic, AE_PROGRAM_CACHE_MAGIC, sizeof(header.magic)) == 0
+		&& header.version == AE_PROGRAM_CACHE_VERSION
+		&& header.key == key
+		&& header.size > 0
+		&& (binary = malloc(header.size)) != NULL
+		&& fread(binary, 1, header.size, file) == header.size;
+
+	fclose(file);
+
+	GLint linked = GL_FALSE;
+	uint32_t id = 0;
+
+	if (valid)
+	{
+		id = glCreateProgram();
+		glProgramBinary(id, header.format, binary, (GLsizei)header.size);
+		glGetProgramiv(id, GL_LINK_STATUS, &linked);
+	}
+
+	free(binary);
+
+	// a driver update makes old binaries invalid, they are replaced once the program was compiled
+	if (!linked)
+	{
+		if (id)
+			glDeleteProgram(id);
+
+		remove(path);
+		return AE_PROGRAM_CACHE_REJECTED;
+	}
+
+	*program = id;
+
+	return AE_PROGRAM_CACHE_HIT;
+}
+
+void ae_program_cache_store(const uint64_t key, const uint32_t program)
+{
+	if (!is_supported())
+		return;
+
+	GLint size = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size);
+
+	if (size <= 0)
+		return;
+
+	struct ae_program_binary_header header = { .version = AE_PROGRAM_CACHE_VERSION, .key = key };
+	memcpy(header.magic, AE_PROGRAM_CACHE_MAGIC, sizeof(header.magic));
+
+	void* binary = malloc((size_t)size);
+
+	if (!binary)
+		return;
+
+	GLsizei length = 0;
+	GLenum format = 0;
+	glGetProgramBinary(program, size, &length, &format, binary);
+
+	header.format = format;
+	header.size = (uint32_t)length;
+
+	char path[AE_PROGRAM_CACHE_FILE_PATH_LENGTH];
+	char temporary_path[AE_PROGRAM_CACHE_FILE_PATH_LENGTH + 4];
+
+	if (!get_path(key, path, sizeof(path)) || snprintf(temporary_path, sizeof(temporary_path), "%s.tmp", path) >= (int)sizeof(temporary_path))
+	{
+		free(binary);
+		return;
+	}
+
+	create_directory();
+
+	// written next to the final file and renamed, a crash never leaves half a binary behind
+	FILE* file = fopen(temporary_path, "wb");
+	bool success = file != NULL && length > 0;
+
+	success = success && fwrite(&header, sizeof(header), 1, file) == 1;
+	success = success && fwrite(binary, 1, (size_t)length, file) == (size_t)length;
+
+	if (file && fclose(file) != 0)
+		success = false;
+
+	free(binary);
+
+	if (!success)
+	{
+		remove(temporary_path);
+		return;
+	}
+
+	remove(path);
+
+	if (rename(temporary_path, path) != 0)
+		remove(temporary_path);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+// linked programs are stored with glGetProgramBinary and reloaded with glProgramBinary on the next launch.
+// a binary only fits the driver that made it, the key includes vendor, renderer and version
+
+#include <core/types.h>
+
+#ifndef AE_PROGRAM_CACHE_DIRECTORY
+#define AE_PROGRAM_CACHE_DIRECTORY "shader_cache"
+#endif // !AE_PROGRAM_CACHE_DIRECTORY
+
+#define AE_PROGRAM_CACHE_PATH_LENGTH 260
+
+// a directory of AE_PROGRAM_CACHE_PATH_LENGTH - 32 characters leaves room for the file name
+#define AE_PROGRAM_CACHE_FILE_PATH_LENGTH (AE_PROGRAM_CACHE_PATH_LENGTH + 32)
+
+enum ae_program_cache_result
+{
+	AE_PROGRAM_CACHE_MISS,
+	AE_PROGRAM_CACHE_HIT,
+	// the binary was there but the driver refused it, it is deleted
+	AE_PROGRAM_CACHE_REJECTED
+};
+
+// NULL turns the cache off, returns false if the path is too long. a relative path starts at the working directory,
+// the default AE_PROGRAM_CACHE_DIRECTORY is placed next to the executable
+bool ae_program_cache_set_directory(const char* directory);
+
+uint64_t ae_program_cache_key(const char** stage_sources, const int32_t* stage_sizes, const int32_t* stage_types, const int32_t stage_count);
+
+// creates the program from the cached binary, program is only set on a hit
+enum ae_program_cache_result ae_program_cache_load(const uint64_t key, uint32_t* program);
+
+// the program must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set
+void ae_program_cache_store(const uint64_t key, const uint32_t program);
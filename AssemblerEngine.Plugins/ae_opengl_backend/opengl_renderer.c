@@ -1,324 +1,720 @@
 #include "opengl_renderer.h"
+#include "opengl_extensions.h"
+#include "opengl_profiler.h"
 #include "opengl_shader.h"
+#include "opengl_state.h"
+#include "opengl_texture.h"
 #include "glad/glad.h"
 
+#include <apis/camera.h>
+#include <apis/gpu_profiler.h>
 #include <apis/shader.h>
 #include <apis/renderer.h>
+#include <core/clock.h>
 #include <core/core.h>
 #include <math/vec4.h>
 
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
-struct ae_camera
+// nanoseconds per glClientWaitSync call while waiting for a region
+#define AE_RENDER_BATCH_WAIT_TIMEOUT 1000000
+
+// shader storage buffer binding of the texture handles
+#define AE_RENDER_BATCH_BINDLESS_BINDING 1
+
+// sampler arrays of the shaders never have more elements
+#define AE_RENDER_BATCH_MAX_TEXTURE_UNITS 64
+
+// layouts of the commands in the GL_DRAW_INDIRECT_BUFFER
+struct ae_draw_elements_indirect_command
 {
-	mat4 view;
-	mat4 projection;
-	mat4 view_projection;
+	uint32_t count;
+	uint32_t instance_count;
+	uint32_t first_index;
+	int32_t base_vertex;
+	uint32_t base_instance;
 };
 
-struct ae_vertex
+struct ae_draw_arrays_indirect_command
 {
-	vec4 color;
-	vec3 position;
-	vec2 texture_coordinate;
-	float texture_unit;
+	uint32_t count;
+	uint32_t instance_count;
+	uint32_t first;
+	uint32_t base_instance;
+};
+
+// the vertex buffer is split into regions, vertices are written straight into the region the gpu is not reading.
+// every region has a slice of the indirect buffer for the commands of the multi draws that start at it, the
+// fence of the region also covers its slice. both buffers stay mapped while the ring is used
+struct ae_opengl_ring
+{
+	uint8_t* mapped;
+	uint8_t* commands;
+	uint32_t vbo;
+	uint32_t indirect_buffer;
 };
 
-struct ae_render_batch
+struct ae_opengl_batch
 {
-	struct ae_vertex* vertices;
+	// handed out to the user, must stay the first member
+	struct ae_render_batch batch;
+	struct ae_opengl_ring ring;
 	struct ae_shader* shader;
-	uint32_t* textures;
-	uint16_t* indices;
+	GLuint64* texture_handles;
+	void* indices;
+	GLsync fences[AE_RENDER_BATCH_INDIRECT_REGION_COUNT];
 	uint32_t vao;
-	uint32_t vbo;
 	uint32_t ibo;
-	uint32_t total_vertex_count;
-	uint32_t total_index_count;
-	uint32_t total_texture_count;
-	uint32_t current_vertex_count;
-	uint32_t current_index_count;
-	uint32_t current_texture_count;
+	GLenum index_type;
+	uint32_t region_size;
+	uint32_t texture_handle_buffer;
+	uint32_t texture_array;
+	uint32_t layer_width;
+	uint32_t layer_height;
 };
 
-static void upload_batch(struct ae_render_batch* const batch)
+// the texture of untextured quads, one white texel shared by every batch
+static uint32_t white_texture;
+
+static void wait_for_region(struct ae_opengl_batch* batch, const uint32_t region)
+{
+	GLsync fence = batch->fences[region];
+
+	if (!fence)
+		return;
+
+	if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+	{
+		uint64_t start = ae_clock_now();
+		GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+
+		while (glClientWaitSync(fence, flags, AE_RENDER_BATCH_WAIT_TIMEOUT) == GL_TIMEOUT_EXPIRED)
+			flags = 0;
+
+		batch->batch.stats.stall_count++;
+		batch->batch.stats.stall_time += ae_clock_now() - start;
+	}
+
+	glDeleteSync(fence);
+	batch->fences[region] = NULL;
+}
+
+static void wait_for_regions(struct ae_opengl_batch* batch)
+{
+	for (uint32_t i = 0; i < batch->batch.region_count; i++)
+		wait_for_region(batch, i);
+}
+
+static void bind_batch(const struct ae_opengl_batch* batch)
+{
+	switch (batch->batch.texture_binding)
+	{
+	case AE_TEXTURE_BINDING_UNITS:
+		for (uint16_t i = 0; i < batch->batch.current_texture_count; i++)
+			ae_gl_state_bind_texture_unit(i, batch->batch.textures[i]);
+		break;
+	case AE_TEXTURE_BINDING_BINDLESS:
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, AE_RENDER_BATCH_BINDLESS_BINDING, batch->texture_handle_buffer);
+		break;
+	case AE_TEXTURE_BINDING_ARRAY:
+		ae_gl_state_bind_texture_unit(0, batch->texture_array);
+		break;
+	}
+
+	ae_gl_state_bind_vertex_array(batch->vao);
+}
+
+// layers are copies of rgba8 textures, glCopyImageSubData can not convert other formats
+static bool is_layer_format(const uint32_t texture)
 {
-	glNamedBufferSubData(batch->vbo, 0, batch->current_vertex_count * sizeof(*(batch->vertices)), batch->vertices);
+	GLint format = 0;
+	glGetTextureLevelParameteriv(texture, 0, GL_TEXTURE_INTERNAL_FORMAT, &format);
+
+	return format == GL_RGBA8;
 }
 
-static void draw_batch(const struct ae_render_batch* batch)
+// waits until the gpu is done with the region and points the vertices at it
+static uint8_t* device_acquire_region(struct ae_render_batch* batch, const uint32_t region)
 {
-	for (uint16_t i = 0; i < batch->current_texture_count; i++)
-		glBindTextureUnit(i, batch->textures[i]);
+	struct ae_opengl_batch* gl = (struct ae_opengl_batch*)batch;
+	wait_for_region(gl, region);
 
-	glBindVertexArray(batch->vao);
-	glDrawElements(GL_TRIANGLES, batch->current_index_count, GL_UNSIGNED_SHORT, 0);
+	return gl->ring.mapped + (size_t)region * gl->region_size;
 }
 
-static void reset_batch(struct ae_render_batch* batch)
+static void device_draw(struct ae_render_batch* batch, const struct ae_render_region* region)
 {
-	batch->current_vertex_count = 0;
-	batch->current_index_count = 0;
-	batch->current_texture_count = 1;
+	struct ae_opengl_batch* gl = (struct ae_opengl_batch*)batch;
+
+	bind_batch(gl);
+	ae_gpu_profiler_begin_scope("draw");
+
+	if (batch->instanced)
+		glDrawArraysInstancedBaseInstance(GL_TRIANGLE_STRIP, 0, 4, region->quad_count, region->region * batch->total_quad_count);
+	else
+		glDrawElementsBaseVertex(GL_TRIANGLES, region->quad_count * 6, gl->index_type, 0, (GLint)(region->region * batch->total_quad_count * 4));
+
+	ae_gpu_profiler_end_scope();
+
+	gl->fences[region->region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
 }
 
-static void test_batch(struct ae_render_batch* batch)
+// every region becomes one command of a multi draw, written to the slice of the first region
+static void device_submit(struct ae_render_batch* batch, const struct ae_render_region* regions, const uint32_t count)
 {
-	if (batch->current_index_count >= batch->total_index_count)
+	struct ae_opengl_batch* gl = (struct ae_opengl_batch*)batch;
+	const size_t offset = (size_t)regions[0].region * batch->region_count * sizeof(struct ae_draw_elements_indirect_command);
+
+	for (uint32_t i = 0; i < count; i++)
 	{
-		upload_batch(batch);
-		draw_batch(batch);
-		reset_batch(batch);
+		if (batch->instanced)
+		{
+			((struct ae_draw_arrays_indirect_command*)(gl->ring.commands + offset))[i] = (struct ae_draw_arrays_indirect_command){
+				.count = 4,
+				.instance_count = regions[i].quad_count,
+				.first = 0,
+				.base_instance = regions[i].region * batch->total_quad_count
+			};
+		}
+		else
+		{
+			((struct ae_draw_elements_indirect_command*)(gl->ring.commands + offset))[i] = (struct ae_draw_elements_indirect_command){
+				.count = regions[i].quad_count * 6,
+				.instance_count = 1,
+				.first_index = 0,
+				.base_vertex = (int32_t)(regions[i].region * batch->total_quad_count * 4),
+				.base_instance = 0
+			};
+		}
 	}
+
+	bind_batch(gl);
+	ae_gl_state_bind_draw_indirect_buffer(gl->ring.indirect_buffer);
+	ae_gpu_profiler_begin_scope("draw");
+
+	if (batch->instanced)
+		glMultiDrawArraysIndirect(GL_TRIANGLE_STRIP, (const void*)offset, (GLsizei)count, 0);
+	else
+		glMultiDrawElementsIndirect(GL_TRIANGLES, gl->index_type, (const void*)offset, (GLsizei)count, 0);
+
+	ae_gpu_profiler_end_scope();
+
+	// every region needs its own fence, they are waited on and deleted one by one
+	for (uint32_t i = 0; i < count; i++)
+		gl->fences[regions[i].region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+static void release_ring(struct ae_opengl_ring* ring)
+{
+	if (ring->mapped)
+		glUnmapNamedBuffer(ring->vbo);
+
+	if (ring->commands)
+		glUnmapNamedBuffer(ring->indirect_buffer);
+
+	ae_gl_state_forget_buffer(ring->indirect_buffer);
+	glDeleteBuffers(1, &ring->vbo);
+	glDeleteBuffers(1, &ring->indirect_buffer);
+
+	*ring = (struct ae_opengl_ring){ 0 };
 }
 
-static void test_batch_with_textures(struct ae_render_batch* batch)
+static bool create_ring(const struct ae_opengl_batch* batch, const uint32_t region_count, struct ae_opengl_ring* ring)
 {
-	if (batch->current_texture_count >= batch->total_texture_count || batch->current_index_count >= batch->total_index_count)
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	const GLsizeiptr vertex_size = (GLsizeiptr)batch->region_size * region_count;
+	const GLsizeiptr command_size = (GLsizeiptr)(sizeof(struct ae_draw_elements_indirect_command) * region_count * region_count);
+
+	*ring = (struct ae_opengl_ring){ 0 };
+
+	glCreateBuffers(1, &ring->vbo);
+	glNamedBufferStorage(ring->vbo, vertex_size, NULL, flags);
+	ring->mapped = glMapNamedBufferRange(ring->vbo, 0, vertex_size, flags);
+
+	glCreateBuffers(1, &ring->indirect_buffer);
+	glNamedBufferStorage(ring->indirect_buffer, command_size, NULL, flags);
+	ring->commands = glMapNamedBufferRange(ring->indirect_buffer, 0, command_size, flags);
+
+	if (ring->mapped && ring->commands)
+		return true;
+
+	release_ring(ring);
+
+	return false;
+}
+
+// the batch is idle, the old ring is only released once the new one is mapped
+static bool device_set_region_count(struct ae_render_batch* batch, const uint32_t region_count)
+{
+	struct ae_opengl_batch* gl = (struct ae_opengl_batch*)batch;
+	struct ae_opengl_ring ring;
+
+	wait_for_regions(gl);
+
+	if (!create_ring(gl, region_count, &ring))
+		return false;
+
+	release_ring(&gl->ring);
+	gl->ring = ring;
+
+	const GLsizei stride = batch->instanced ? (GLsizei)sizeof(struct ae_quad_instance) : (GLsizei)batch->layout.stride;
+	glVertexArrayVertexBuffer(gl->vao, 0, gl->ring.vbo, 0, stride);
+
+	return true;
+}
+
+static void device_wait_idle(struct ae_render_batch* batch)
+{
+	wait_for_regions((struct ae_opengl_batch*)batch);
+}
+
+static bool device_bind_texture(struct ae_render_batch* batch, const uint32_t texture, const uint32_t index, vec2 scale)
+{
+	struct ae_opengl_batch* gl = (struct ae_opengl_batch*)batch;
+
+	if (batch->texture_binding == AE_TEXTURE_BINDING_BINDLESS)
 	{
-		upload_batch(batch);
-		draw_batch(batch);
-		reset_batch(batch);
+		gl->texture_handles[index] = ae_opengl_acquire_texture_handle(texture);
+		return true;
 	}
+
+	// layer 0 was cleared to white when the array was created
+	if (batch->texture_binding != AE_TEXTURE_BINDING_ARRAY || texture == batch->white_texture)
+		return true;
+
+	if (!is_layer_format(texture))
+		return false;
+
+	GLint width = 0;
+	GLint height = 0;
+	glGetTextureLevelParameteriv(texture, 0, GL_TEXTURE_WIDTH, &width);
+	glGetTextureLevelParameteriv(texture, 0, GL_TEXTURE_HEIGHT, &height);
+
+	// bigger textures are cropped to the layer
+	uint32_t copy_width = (uint32_t)width < gl->layer_width ? (uint32_t)width : gl->layer_width;
+	uint32_t copy_height = (uint32_t)height < gl->layer_height ? (uint32_t)height : gl->layer_height;
+
+	glCopyImageSubData(texture, GL_TEXTURE_2D, 0, 0, 0, 0, gl->texture_array, GL_TEXTURE_2D_ARRAY, 0, 0, 0, (GLint)index, (GLsizei)copy_width, (GLsizei)copy_height, 1);
+
+	scale[0] = (float)copy_width / (float)gl->layer_width;
+	scale[1] = (float)copy_height / (float)gl->layer_height;
+
+	return true;
 }
 
-static float get_free_texture_unit(struct ae_render_batch* batch, uint32_t texture_id)
+static void device_release_textures(struct ae_render_batch* batch)
 {
-	float textureUnit = 1.0;
+	struct ae_opengl_batch* gl = (struct ae_opengl_batch*)batch;
+
+	if (batch->texture_binding != AE_TEXTURE_BINDING_BINDLESS)
+		return;
 
 	for (uint32_t i = 0; i < batch->current_texture_count; i++)
+		ae_opengl_release_texture_handle(gl->texture_handles[i]);
+}
+
+static void device_start(const struct ae_render_batch* batch)
+{
+	const struct ae_opengl_batch* gl = (const struct ae_opengl_batch*)batch;
+
+	// the name is only formatted while profiling
+	if (ae_gpu_profiler_is_enabled())
+	{
+		char name[AE_GPU_SCOPE_NAME_LENGTH];
+		snprintf(name, sizeof(name), "batch %u", gl->vao);
+		ae_gpu_profiler_begin_scope(name);
+	}
+
+	ae_shader_set_current_shader(gl->shader);
+}
+
+static void device_end(struct ae_render_batch* batch)
+{
+	(void)batch;
+	ae_gpu_profiler_end_scope();
+}
+
+static const struct ae_render_device device = {
+	.acquire_region = device_acquire_region,
+	.draw = device_draw,
+	.submit = device_submit,
+	.set_region_count = device_set_region_count,
+	.wait_idle = device_wait_idle,
+	.bind_texture = device_bind_texture,
+	.release_textures = device_release_textures,
+	.get_texture_generation = ae_texture_get_generation,
+	.start = device_start,
+	.end = device_end
+};
+
+// indices of quad_count quads, 16 bit while they fit and 32 bit for more vertices
+void* ae_render_create_indices(const uint32_t quad_count, uint32_t* index_type, size_t* size)
+{
+	const bool wide = quad_count * 4 > UINT16_MAX + 1;
+	const size_t index_size = wide ? sizeof(uint32_t) : sizeof(uint16_t);
+
+	*index_type = wide ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+	*size = index_size * quad_count * 6;
+
+	void* indices = malloc(*size);
+
+	if (!indices)
+		return NULL;
+
+	for (uint32_t i = 0, vertex = 0; i < quad_count * 6; i += 6, vertex += 4)
 	{
-		if (batch->textures[i] == texture_id)
+		const uint32_t quad[6] = { vertex, vertex + 1, vertex + 2, vertex + 2, vertex + 3, vertex };
+
+		for (uint32_t j = 0; j < 6; j++)
 		{
-			textureUnit = (float)i;
-			break;
+			if (wide)
+				((uint32_t*)indices)[i + j] = quad[j];
+			else
+				((uint16_t*)indices)[i + j] = (uint16_t)quad[j];
 		}
 	}
 
-	if (textureUnit == 1.0f)
+	return indices;
+}
+
+void ae_render_set_vertex_attributes(const uint32_t vao, const uint32_t vbo, const struct ae_vertex_layout* layout)
+{
+	glVertexArrayVertexBuffer(vao, 0, vbo, 0, layout->stride);
+
+	glEnableVertexArrayAttrib(vao, 0);
+	glEnableVertexArrayAttrib(vao, 1);
+	glEnableVertexArrayAttrib(vao, 2);
+	glEnableVertexArrayAttrib(vao, 3);
+
+	// packed attributes are converted to the same float inputs, shaders do not change with the format
+	if (layout->format.color == AE_VERTEX_COLOR_RGBA8)
+		glVertexArrayAttribFormat(vao, 0, 4, GL_UNSIGNED_BYTE, GL_TRUE, layout->color_offset);
+	else
+		glVertexArrayAttribFormat(vao, 0, 4, GL_FLOAT, GL_FALSE, layout->color_offset);
+
+	glVertexArrayAttribFormat(vao, 1, 3, GL_FLOAT, GL_FALSE, 0);
+
+	if (layout->format.texture_coordinate == AE_VERTEX_TEXTURE_COORDINATE_HALF2)
+		glVertexArrayAttribFormat(vao, 2, 2, GL_HALF_FLOAT, GL_FALSE, layout->texture_coordinate_offset);
+	else if (layout->format.texture_coordinate == AE_VERTEX_TEXTURE_COORDINATE_UNORM16)
+		glVertexArrayAttribFormat(vao, 2, 2, GL_UNSIGNED_SHORT, GL_TRUE, layout->texture_coordinate_offset);
+	else
+		glVertexArrayAttribFormat(vao, 2, 2, GL_FLOAT, GL_FALSE, layout->texture_coordinate_offset);
+
+	if (layout->format.texture_unit == AE_VERTEX_TEXTURE_UNIT_UINT8)
+		glVertexArrayAttribFormat(vao, 3, 1, GL_UNSIGNED_BYTE, GL_FALSE, layout->texture_unit_offset);
+	else
+		glVertexArrayAttribFormat(vao, 3, 1, GL_FLOAT, GL_FALSE, layout->texture_unit_offset);
+
+	glVertexArrayAttribBinding(vao, 0, 0);
+	glVertexArrayAttribBinding(vao, 1, 0);
+	glVertexArrayAttribBinding(vao, 2, 0);
+	glVertexArrayAttribBinding(vao, 3, 0);
+}
+
+// the indices cover one region, every region is drawn with its own base vertex
+static bool create_vertex_layout(struct ae_opengl_batch* batch)
+{
+	uint32_t index_type;
+	size_t size;
+	batch->indices = ae_render_create_indices(batch->batch.total_quad_count, &index_type, &size);
+
+	if (!batch->indices)
+		return false;
+
+	batch->index_type = index_type;
+
+	glCreateBuffers(1, &batch->ibo);
+	glNamedBufferStorage(batch->ibo, (GLsizeiptr)size, batch->indices, GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT);
+
+	ae_render_set_vertex_attributes(batch->vao, batch->ring.vbo, &batch->batch.layout);
+	glVertexArrayElementBuffer(batch->vao, batch->ibo);
+
+	return true;
+}
+
+// every attribute advances once per instance, there is no per vertex data
+static void create_instance_layout(struct ae_opengl_batch* batch)
+{
+	batch->indices = NULL;
+	batch->ibo = 0;
+
+	glVertexArrayVertexBuffer(batch->vao, 0, batch->ring.vbo, 0, sizeof(struct ae_quad_instance));
+	glVertexArrayBindingDivisor(batch->vao, 0, 1);
+
+	for (uint32_t i = 0; i < 6; i++)
 	{
-		batch->textures[batch->current_texture_count] = texture_id;
-		textureUnit = (float)batch->current_texture_count;
-		batch->current_texture_count++;
+		glEnableVertexArrayAttrib(batch->vao, i);
+		glVertexArrayAttribBinding(batch->vao, i, 0);
 	}
 
-	return textureUnit;
+	glVertexArrayAttribFormat(batch->vao, 0, 2, GL_FLOAT, GL_FALSE, offsetof(struct ae_quad_instance, position));
+	glVertexArrayAttribFormat(batch->vao, 1, 2, GL_FLOAT, GL_FALSE, offsetof(struct ae_quad_instance, size));
+	glVertexArrayAttribFormat(batch->vao, 2, 4, GL_UNSIGNED_SHORT, GL_TRUE, offsetof(struct ae_quad_instance, texture_rect));
+	glVertexArrayAttribFormat(batch->vao, 3, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(struct ae_quad_instance, color));
+	glVertexArrayAttribIFormat(batch->vao, 4, 1, GL_UNSIGNED_SHORT, offsetof(struct ae_quad_instance, texture_unit));
+	glVertexArrayAttribFormat(batch->vao, 5, 1, GL_SHORT, GL_TRUE, offsetof(struct ae_quad_instance, depth));
 }
 
-struct ae_render_batch* ae_render_batch_create(struct ae_shader* const shader, const uint32_t max_quad_count)
+static bool is_texture_binding_supported(const struct ae_texture_binding_desc* desc)
 {
-	struct ae_render_batch* batch = malloc(sizeof(*batch));
+	GLint max_layers = 0;
 
-	if (!batch)
-		return NULL;
+	if (!ae_render_batch_is_texture_binding_valid(desc))
+		return false;
 
-	batch->total_vertex_count = max_quad_count * 4;
-	batch->total_index_count = max_quad_count * 6;
-	glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, (int32_t*)&batch->total_texture_count);
+	switch (desc->binding)
+	{
+	case AE_TEXTURE_BINDING_BINDLESS:
+		return ae_opengl_extensions.bindless_texture;
+	case AE_TEXTURE_BINDING_ARRAY:
+		glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_layers);
+		return desc->layer_count <= (uint32_t)max_layers;
+	default:
+		return true;
+	}
+}
 
-	batch->vertices = malloc(sizeof(*batch->vertices) * batch->total_vertex_count);
+// the handles are released while the buffer is still mapped
+static void release_texture_binding(struct ae_opengl_batch* batch)
+{
+	ae_render_batch_release_textures(&batch->batch);
 
-	if (!batch->vertices)
-		return NULL;
+	if (batch->texture_handle_buffer)
+	{
+		glUnmapNamedBuffer(batch->texture_handle_buffer);
+		glDeleteBuffers(1, &batch->texture_handle_buffer);
+	}
 
-	batch->textures = malloc(sizeof(*batch->textures) * batch->total_texture_count);
+	if (batch->texture_array)
+	{
+		ae_gl_state_forget_texture(batch->texture_array);
+		glDeleteTextures(1, &batch->texture_array);
+	}
 
-	if (!batch->textures)
-		return NULL;
+	batch->texture_handles = NULL;
+	batch->texture_handle_buffer = 0;
+	batch->texture_array = 0;
+}
 
-	batch->indices = malloc(sizeof(*batch->indices) * batch->total_index_count);
+static bool create_texture_binding(struct ae_opengl_batch* batch, const struct ae_texture_binding_desc* desc)
+{
+	GLint unit_count = 0;
+	uint32_t count = 0;
 
-	if (!batch->indices)
-		return NULL;
+	switch (desc->binding)
+	{
+	case AE_TEXTURE_BINDING_UNITS:
+		glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &unit_count);
+		count = (uint32_t)unit_count < AE_RENDER_BATCH_MAX_TEXTURE_UNITS ? (uint32_t)unit_count : AE_RENDER_BATCH_MAX_TEXTURE_UNITS;
+		break;
+	case AE_TEXTURE_BINDING_BINDLESS:
+		count = AE_RENDER_BATCH_MAX_BINDLESS_TEXTURES;
+		break;
+	case AE_TEXTURE_BINDING_ARRAY:
+		count = desc->layer_count;
+		break;
+	}
 
-	batch->shader = shader;
+	count = ae_render_batch_get_texture_count(&batch->batch, count);
 
-	size_t offset = 0;
-	for (size_t i = 0; i < batch->total_index_count; i += 6)
+	if (desc->binding == AE_TEXTURE_BINDING_UNITS)
 	{
-		((uint16_t*)batch->indices)[i] =		(uint16_t)(0 + offset);
-		((uint16_t*)batch->indices)[i + 1] =	(uint16_t)(1 + offset);
-		((uint16_t*)batch->indices)[i + 2] =	(uint16_t)(2 + offset);			 
-		((uint16_t*)batch->indices)[i + 3] =	(uint16_t)(2 + offset);
-		((uint16_t*)batch->indices)[i + 4] =	(uint16_t)(3 + offset);
-		((uint16_t*)batch->indices)[i + 5] =	(uint16_t)(0 + offset);
-
-		offset += 4;
+		int32_t samplers[AE_RENDER_BATCH_MAX_TEXTURE_UNITS];
+
+		for (uint32_t i = 0; i < count; i++)
+			samplers[i] = (int32_t)i;
+
+		ae_gl_state_use_program(batch->shader->id);
+		glUniform1iv(glGetUniformLocation(batch->shader->id, "u_textures"), (GLsizei)count, samplers);
 	}
+	else if (desc->binding == AE_TEXTURE_BINDING_BINDLESS)
+	{
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
 
-	glCreateBuffers(1, &batch->vbo);
-	glNamedBufferStorage(batch->vbo, sizeof(*batch->vertices) * batch->total_vertex_count, NULL, GL_DYNAMIC_STORAGE_BIT);
+		glCreateBuffers(1, &batch->texture_handle_buffer);
+		glNamedBufferStorage(batch->texture_handle_buffer, sizeof(GLuint64) * count, NULL, flags);
+		batch->texture_handles = glMapNamedBufferRange(batch->texture_handle_buffer, 0, sizeof(GLuint64) * count, flags);
 
-	glCreateBuffers(1, &batch->ibo);
-	glNamedBufferStorage(batch->ibo, sizeof(*batch->indices) * batch->total_index_count, batch->indices, GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT);
+		if (!batch->texture_handles)
+		{
+			glDeleteBuffers(1, &batch->texture_handle_buffer);
+			batch->texture_handle_buffer = 0;
+			return false;
+		}
+	}
+	else
+	{
+		const uint32_t white = 0xffffffff;
 
-	glCreateVertexArrays(1, &batch->vao);
+		glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &batch->texture_array);
+		glTextureStorage3D(batch->texture_array, 1, GL_RGBA8, (GLsizei)desc->layer_width, (GLsizei)desc->layer_height, (GLsizei)count);
+		glTextureParameteri(batch->texture_array, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTextureParameteri(batch->texture_array, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTextureParameteri(batch->texture_array, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTextureParameteri(batch->texture_array, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-	glVertexArrayVertexBuffer(batch->vao, 0, batch->vbo, 0, sizeof(*batch->vertices));
-	glVertexArrayElementBuffer(batch->vao, batch->ibo);
+		// layer 0 belongs to the white texture
+		glClearTexSubImage(batch->texture_array, 0, 0, 0, 0, (GLsizei)desc->layer_width, (GLsizei)desc->layer_height, 1, GL_RGBA, GL_UNSIGNED_BYTE, &white);
+
+		batch->layer_width = desc->layer_width;
+		batch->layer_height = desc->layer_height;
+	}
 
-	glEnableVertexArrayAttrib(batch->vao, 0);
-	glEnableVertexArrayAttrib(batch->vao, 1);
-	glEnableVertexArrayAttrib(batch->vao, 2);
-	glEnableVertexArrayAttrib(batch->vao, 3);
+	if (ae_render_batch_create_textures(&batch->batch, desc->binding, count))
+		return true;
 
-	glVertexArrayAttribFormat(batch->vao, 0, 4, GL_FLOAT, GL_FALSE, offsetof(struct ae_vertex, color));
-	glVertexArrayAttribFormat(batch->vao, 1, 3, GL_FLOAT, GL_FALSE, offsetof(struct ae_vertex, position));
-	glVertexArrayAttribFormat(batch->vao, 2, 2, GL_FLOAT, GL_FALSE, offsetof(struct ae_vertex, texture_coordinate));
-	glVertexArrayAttribFormat(batch->vao, 3, 1, GL_FLOAT, GL_FALSE, offsetof(struct ae_vertex, texture_unit));
+	release_texture_binding(batch);
 
-	glVertexArrayAttribBinding(batch->vao, 0, 0);
-	glVertexArrayAttribBinding(batch->vao, 1, 0);
-	glVertexArrayAttribBinding(batch->vao, 2, 0);
-	glVertexArrayAttribBinding(batch->vao, 3, 0);
+	return false;
+}
 
-	uint32_t texure;
-	int32_t color = 0xffffffff;
+static struct ae_render_batch* create_batch(struct ae_shader* const shader, const uint32_t max_quad_count, const struct ae_vertex_format* format, const bool instanced)
+{
+	struct ae_opengl_batch* batch = calloc(1, sizeof(*batch));
 
-	glCreateTextures(GL_TEXTURE_2D, 1, &texure);
-	glTextureStorage2D(texure, 1, GL_RGBA8, 1, 1);
-	glTextureSubImage2D(texure, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, &color);
+	if (!batch)
+		return NULL;
 
-	int32_t samplers[64] = { 0 };
-	samplers[0] = texure;
+	ae_render_batch_init(&batch->batch, &device, max_quad_count, format, instanced);
 
-	for (uint32_t i = 0; i < batch->total_texture_count; i++)
+	batch->region_size = batch->batch.quad_size * max_quad_count;
+	batch->shader = shader;
+
+	if (!create_ring(batch, batch->batch.region_count, &batch->ring))
 	{
-		samplers[i] = i;
-		batch->textures[i] = 0;
+		ae_render_batch_destroy(&batch->batch);
+		return NULL;
 	}
 
-	batch->textures[0] = texure;
+	batch->batch.vertices = device_acquire_region(&batch->batch, 0);
+
+	glCreateVertexArrays(1, &batch->vao);
+
+	if (instanced)
+		create_instance_layout(batch);
+	else if (!create_vertex_layout(batch))
+	{
+		ae_render_batch_destroy(&batch->batch);
+		return NULL;
+	}
 
-	glUseProgram(batch->shader->id);
-	glUniform1iv(glGetUniformLocation(batch->shader->id, "u_textures"), batch->total_texture_count, samplers);
+	batch->batch.white_texture = ae_render_get_white_texture();
 
-	batch->current_vertex_count = 0;
-	batch->current_texture_count = 1;
-	batch->current_index_count = 0;
+	const struct ae_texture_binding_desc units = { .binding = AE_TEXTURE_BINDING_UNITS };
 
-	return batch;
+	if (!create_texture_binding(batch, &units))
+	{
+		ae_render_batch_destroy(&batch->batch);
+		return NULL;
+	}
+
+	return &batch->batch;
 }
 
-void ae_render_batch_destroy(struct ae_render_batch* batch)
+uint32_t ae_render_get_white_texture()
 {
-	glDeleteVertexArrays(1, &batch->vao);
-	glDeleteBuffers(1, &batch->vbo);
-	glDeleteBuffers(1, &batch->ibo);
-	free(batch);
+	if (!white_texture)
+	{
+		const uint32_t color = 0xffffffff;
+
+		glCreateTextures(GL_TEXTURE_2D, 1, &white_texture);
+		glTextureStorage2D(white_texture, 1, GL_RGBA8, 1, 1);
+		glTextureSubImage2D(white_texture, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, &color);
+	}
+
+	return white_texture;
 }
 
-void ae_render_scene_start(const struct ae_camera* camera)
+void ae_render_shutdown()
 {
-	glClearColor(0.0f, 1.0f, 0.0f, 1.0f);
-	glClear(GL_COLOR_BUFFER_BIT);
-	ae_shader_set_view_projection(&camera->view_projection[0][0]);
+	ae_gl_state_forget_texture(white_texture);
+	glDeleteTextures(1, &white_texture);
+	white_texture = 0;
 }
 
-void ae_render_batch_start(const struct ae_render_batch* batch)
+struct ae_render_batch* ae_render_batch_create(struct ae_shader* const shader, const uint32_t max_quad_count, const struct ae_vertex_format* format)
 {
-	ae_shader_set_current_shader(batch->shader);
+	return create_batch(shader, max_quad_count, format, false);
 }
 
-void ae_render_batch_end(struct ae_render_batch* batch)
+struct ae_render_batch* ae_render_batch_create_instanced(struct ae_shader* const shader, const uint32_t max_quad_count)
 {
-	upload_batch(batch);
-	draw_batch(batch);
-	reset_batch(batch);
+	return create_batch(shader, max_quad_count, NULL, true);
 }
 
-void ae_render_batch_draw(struct ae_render_batch* batch, struct ae_draw_params* const params)
+void ae_render_batch_destroy(struct ae_render_batch* batch)
 {
-	test_batch(batch);
-
-	ae_vec4_copy(&params->color[0], &batch->vertices[batch->current_vertex_count].color[0]);
-	batch->vertices[batch->current_vertex_count].position[0] = params->position[0];
-	batch->vertices[batch->current_vertex_count].position[1] = params->position[1] + params->size[1];
-	batch->vertices[batch->current_vertex_count].position[2] = params->position[2];
-	batch->vertices[batch->current_vertex_count].texture_coordinate[0] = 0.0f;
-	batch->vertices[batch->current_vertex_count].texture_coordinate[1] = 0.0f;
-	batch->vertices[batch->current_vertex_count].texture_unit = 0.0f;
-
-	batch->current_vertex_count++;
-
-	ae_vec4_copy(&params->color[0], &batch->vertices[batch->current_vertex_count].color[0]);
-	batch->vertices[batch->current_vertex_count].position[0] = params->position[0] + params->size[0];
-	batch->vertices[batch->current_vertex_count].position[1] = params->position[1] + params->size[1];
-	batch->vertices[batch->current_vertex_count].position[2] = params->position[2];
-	batch->vertices[batch->current_vertex_count].texture_coordinate[0] = 1.0f;
-	batch->vertices[batch->current_vertex_count].texture_coordinate[1] = 0.0f;
-	batch->vertices[batch->current_vertex_count].texture_unit = 0.0f;
-
-	batch->current_vertex_count++;
+	struct ae_opengl_batch* gl = (struct ae_opengl_batch*)batch;
 
-	ae_vec4_copy(&params->color[0], &batch->vertices[batch->current_vertex_count].color[0]);
-	batch->vertices[batch->current_vertex_count].position[0] = params->position[0] + params->size[0];
-	batch->vertices[batch->current_vertex_count].position[1] = params->position[1];
-	batch->vertices[batch->current_vertex_count].position[2] = params->position[2];
-	batch->vertices[batch->current_vertex_count].texture_coordinate[0] = 1.0f;
-	batch->vertices[batch->current_vertex_count].texture_coordinate[1] = 1.0f;
-	batch->vertices[batch->current_vertex_count].texture_unit = 0.0f;
+	// texture handles may only become non resident once no draw call uses them
+	wait_for_regions(gl);
+	release_texture_binding(gl);
 
-	batch->current_vertex_count++;
+	// also releases batches create_batch gave up on, names it did not create yet are 0
+	release_ring(&gl->ring);
 
-	ae_vec4_copy(&params->color[0], &batch->vertices[batch->current_vertex_count].color[0]);
-	batch->vertices[batch->current_vertex_count].position[0] = params->position[0];
-	batch->vertices[batch->current_vertex_count].position[1] = params->position[1];
-	batch->vertices[batch->current_vertex_count].position[2] = params->position[2];
-	batch->vertices[batch->current_vertex_count].texture_coordinate[0] = 0.0f;
-	batch->vertices[batch->current_vertex_count].texture_coordinate[1] = 1.0f;
-	batch->vertices[batch->current_vertex_count].texture_unit = 0.0f;
-
-	batch->current_vertex_count++;
+	ae_gl_state_forget_vertex_array(gl->vao);
+	glDeleteVertexArrays(1, &gl->vao);
+	glDeleteBuffers(1, &gl->ibo);
+	free(gl->indices);
+	free(gl);
+}
 
-	batch->current_index_count += 6;
+enum ae_texture_binding ae_render_get_preferred_texture_binding()
+{
+	return ae_opengl_extensions.bindless_texture ? AE_TEXTURE_BINDING_BINDLESS : AE_TEXTURE_BINDING_ARRAY;
 }
 
-void ae_render_batch_draw_textured(struct ae_render_batch* batch, struct ae_textured_draw_params* const params)
+bool ae_render_batch_set_texture_binding(struct ae_render_batch* batch, const struct ae_texture_binding_desc* desc)
 {
-	test_batch_with_textures(batch);
+	struct ae_opengl_batch* gl = (struct ae_opengl_batch*)batch;
 
-	float textureUnit = get_free_texture_unit(batch, params->texture);
+	if (!is_texture_binding_supported(desc))
+		return false;
 
-	ae_vec4_copy(&params->color[0], &batch->vertices[batch->current_vertex_count].color[0]);
-	batch->vertices[batch->current_vertex_count].position[0] = params->position[0];
-	batch->vertices[batch->current_vertex_count].position[1] = params->position[1] + params->size[1];
-	batch->vertices[batch->current_vertex_count].position[2] = params->position[2];
-	batch->vertices[batch->current_vertex_count].texture_coordinate[0] = params->texture_coordinates[0][0];
-	batch->vertices[batch->current_vertex_count].texture_coordinate[1] = params->texture_coordinates[0][1];
-	batch->vertices[batch->current_vertex_count].texture_unit = textureUnit;
+	ae_render_batch_flush(batch);
+	ae_render_batch_submit(batch);
+	wait_for_regions(gl);
 
-	batch->current_vertex_count++;
+	release_texture_binding(gl);
 
-	ae_vec4_copy(&params->color[0], &batch->vertices[batch->current_vertex_count].color[0]);
-	batch->vertices[batch->current_vertex_count].position[0] = params->position[0] + params->size[0];
-	batch->vertices[batch->current_vertex_count].position[1] = params->position[1] + params->size[1];
-	batch->vertices[batch->current_vertex_count].position[2] = params->position[2];
-	batch->vertices[batch->current_vertex_count].texture_coordinate[0] = params->texture_coordinates[1][0];
-	batch->vertices[batch->current_vertex_count].texture_coordinate[1] = params->texture_coordinates[1][1];
-	batch->vertices[batch->current_vertex_count].texture_unit = textureUnit;
+	if (create_texture_binding(gl, desc))
+		return true;
+
+	const struct ae_texture_binding_desc units = { .binding = AE_TEXTURE_BINDING_UNITS };
+	create_texture_binding(gl, &units);
+
+	return false;
+}
 
-	batch->current_vertex_count++;
+void ae_render_scene_start(const struct ae_camera* camera)
+{
+	ae_render_frame_start(camera);
 
-	ae_vec4_copy(&params->color[0], &batch->vertices[batch->current_vertex_count].color[0]);
-	batch->vertices[batch->current_vertex_count].position[0] = params->position[0] + params->size[0];
-	batch->vertices[batch->current_vertex_count].position[1] = params->position[1];
-	batch->vertices[batch->current_vertex_count].position[2] = params->position[2];
-	batch->vertices[batch->current_vertex_count].texture_coordinate[0] = params->texture_coordinates[2][0];
-	batch->vertices[batch->current_vertex_count].texture_coordinate[1] = params->texture_coordinates[2][1];
-	batch->vertices[batch->current_vertex_count].texture_unit = textureUnit;
+	glClearColor(0.0f, 1.0f, 0.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+}
 
-	batch->current_vertex_count++;
+void ae_render_frame_start(const struct ae_camera* camera)
+{
+	ae_gl_state_end_frame();
+	ae_gpu_profiler_end_frame();
+	ae_texture_update();
+	ae_render_culling_end_frame();
 
-	ae_vec4_copy(&params->color[0], &batch->vertices[batch->current_vertex_count].color[0]);
-	batch->vertices[batch->current_vertex_count].position[0] = params->position[0];
-	batch->vertices[batch->current_vertex_count].position[1] = params->position[1];
-	batch->vertices[batch->current_vertex_count].position[2] = params->position[2];
-	batch->vertices[batch->current_vertex_count].texture_coordinate[0] = params->texture_coordinates[3][0];
-	batch->vertices[batch->current_vertex_count].texture_coordinate[1] = params->texture_coordinates[3][1];
-	batch->vertices[batch->current_vertex_count].texture_unit = textureUnit;
+	ae_render_set_camera(camera);
+}
 
-	batch->current_vertex_count++;
+void ae_render_set_camera(const struct ae_camera* camera)
+{
+	ae_render_culling_set_camera(camera);
+	ae_shader_set_view_projection(&camera->view_projection[0][0]);
+}
 
-	batch->current_index_count += 6;
-}
\ No newline at end of file
+void ae_render_get_state_stats(struct ae_render_state_stats* stats)
+{
+	ae_gl_state_get_stats(stats);
+}
@@ -1,17 +1,30 @@
 #pragma once
 
+#include "render_batch.h"
+
+#include <apis/renderer.h>
 #include <core/types.h>
 
 struct ae_render_batch;
 struct ae_camera;
-struct ae_draw_params;
-struct ae_textured_draw_params;
 struct ae_shader;
+struct ae_vertex_format;
+struct ae_vertex_layout;
 
-struct ae_render_batch* ae_render_batch_create(struct ae_shader* const shader, const uint32_t max_quad_count);
+struct ae_render_batch* ae_render_batch_create(struct ae_shader* const shader, const uint32_t max_quad_count, const struct ae_vertex_format* format);
+struct ae_render_batch* ae_render_batch_create_instanced(struct ae_shader* const shader, const uint32_t max_quad_count);
 void ae_render_batch_destroy(struct ae_render_batch* batch);
+enum ae_texture_binding ae_render_get_preferred_texture_binding();
+bool ae_render_batch_set_texture_binding(struct ae_render_batch* batch, const struct ae_texture_binding_desc* desc);
+void ae_render_get_state_stats(struct ae_render_state_stats* stats);
 void ae_render_scene_start(const struct ae_camera* camera);
-void ae_render_batch_start(const struct ae_render_batch* batch);
-void ae_render_batch_end(struct ae_render_batch* batch);
-void ae_render_batch_draw(struct ae_render_batch* batch,  struct ae_draw_params* const params);
-void ae_render_batch_draw_textured(struct ae_render_batch* batch, struct ae_textured_draw_params* const params);
\ No newline at end of file
+void ae_render_frame_start(const struct ae_camera* camera);
+void ae_render_set_camera(const struct ae_camera* camera);
+
+// shared with the static batches
+uint32_t ae_render_get_white_texture();
+void* ae_render_create_indices(const uint32_t quad_count, uint32_t* index_type, size_t* size);
+void ae_render_set_vertex_attributes(const uint32_t vao, const uint32_t vbo, const struct ae_vertex_layout* layout);
+
+// deletes the white texture, the context has to be current
+void ae_render_shutdown();
@@ -1,15 +1,57 @@
 #include "opengl_shader.h"
+#include "opengl_extensions.h"
+#include "opengl_program_cache.h"
+#include "opengl_state.h"
 #include "glad/glad.h"
 
 #include <apis/shader.h>
+#include <core/clock.h>
 #include <math/io.h>
 #include <math/mat4.h>
 
+#include <stdlib.h>
 #include <string.h>
 
 #define AE_MAX_SHADER_STAGES 5
 
+#ifndef AE_SHADER_ASYNC_INITIAL_CAPACITY
+#define AE_SHADER_ASYNC_INITIAL_CAPACITY 32
+#endif // !AE_SHADER_ASYNC_INITIAL_CAPACITY
+
+// programs poll_async compiles per call when the driver can not compile in the background
+#ifndef AE_SHADER_ASYNC_BLOCKING_BUDGET
+#define AE_SHADER_ASYNC_BLOCKING_BUDGET 1
+#endif // !AE_SHADER_ASYNC_BLOCKING_BUDGET
+
+#define AE_SHADER_ASYNC_LOG_LENGTH 1024
+
+enum ae_pending_program_state
+{
+	// sources are set, compiling waits for poll_async
+	AE_PENDING_PROGRAM_WAITING,
+	AE_PENDING_PROGRAM_COMPILING,
+	AE_PENDING_PROGRAM_LINKING,
+	// loaded from the program cache
+	AE_PENDING_PROGRAM_READY
+};
+
+struct ae_pending_program
+{
+	uint64_t key;
+	uint32_t stage_ids[AE_MAX_SHADER_STAGES];
+	int32_t stage_count;
+	uint32_t program;
+	enum ae_pending_program_state state;
+	ae_shader_ready_callback callback;
+	void* user_data;
+};
+
 static uint32_t ubo_view_projection_matrix = 0;
+static struct ae_shader_cache_stats cache_stats;
+
+static struct ae_pending_program* pending_programs = NULL;
+static uint32_t pending_count = 0;
+static uint32_t pending_capacity = 0;
 
 void ae_shader_set_view_projection(const float* view_projection)
 {
@@ -49,21 +91,87 @@ void ae_shader_set_depth_test(struct ae_shader* shader, bool enable)
 
 void ae_shader_set_current_shader(struct ae_shader* shader)
 {
-	if (shader->enable_blending)
+	// state the shader does not want is turned off again, the previous shader may have enabled it
+	ae_gl_state_set_blending(shader->enable_blending, shader->blend_source, shader->blend_destination);
+	ae_gl_state_set_depth_test(shader->enable_depth_test);
+	ae_gl_state_use_program(shader->id);
+}
+
+// sets the sources, glShaderSource copies them so the caller may free them right after
+static void create_stages(uint32_t* stage_ids, const char** stage_sources, const int32_t* stage_sizes, const int32_t* stage_types, const int32_t stage_count)
+{
+	for (int32_t i = 0; i < stage_count; i++)
+	{
+		stage_ids[i] = glCreateShader(stage_types[i]);
+		glShaderSource(stage_ids[i], 1, &stage_sources[i], stage_sizes ? &stage_sizes[i] : NULL);
+	}
+}
+
+static void delete_stages(const uint32_t* stage_ids, const int32_t stage_count)
+{
+	for (int32_t i = 0; i < stage_count; i++)
+		glDeleteShader(stage_ids[i]);
+}
+
+static void compile_stages(const uint32_t* stage_ids, const int32_t stage_count)
+{
+	for (int32_t i = 0; i < stage_count; i++)
+		glCompileShader(stage_ids[i]);
+}
+
+// waits for the compiler unless every stage reported GL_COMPLETION_STATUS_KHR
+static bool check_stages(const uint32_t* stage_ids, const int32_t stage_count, char* debug_output, const int32_t debug_output_size)
+{
+	for (int32_t i = 0; i < stage_count; i++)
 	{
-		glEnable(GL_BLEND);
-		glBlendFunc(shader->blend_source, shader->blend_destination);
+		int32_t success = 0;
+		glGetShaderiv(stage_ids[i], GL_COMPILE_STATUS, &success);
+
+		if (success == GL_FALSE)
+		{
+			glGetShaderInfoLog(stage_ids[i], debug_output_size, NULL, debug_output);
+			return false;
+		}
 	}
 
-	if (shader->enable_depth_test)
+	return true;
+}
+
+// the stages are deleted once the program no longer needs them
+static uint32_t link_stages(const uint32_t* stage_ids, const int32_t stage_count)
+{
+	uint32_t id = glCreateProgram();
+
+	for (int32_t i = 0; i < stage_count; i++)
 	{
-		glEnable(GL_DEPTH_TEST);
+		glAttachShader(id, stage_ids[i]);
 	}
 
-	glUseProgram(shader->id);
+	// the driver only has to keep a binary for glGetProgramBinary when asked before linking
+	glProgramParameteri(id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	glLinkProgram(id);
+
+	delete_stages(stage_ids, stage_count);
+
+	return id;
 }
 
-struct ae_shader* ae_shader_create(
+static bool check_program(const uint32_t id, char* debug_output, const int32_t debug_output_size)
+{
+	int32_t success = 0;
+	glGetProgramiv(id, GL_LINK_STATUS, &success);
+
+	if (!success)
+	{
+		glGetProgramInfoLog(id, debug_output_size, NULL, debug_output);
+		glDeleteProgram(id);
+		return false;
+	}
+
+	return true;
+}
+
+static uint32_t compile_program(
 	char* debug_output,
 	const int32_t debug_output_size,
 	const char** stage_sources,
@@ -71,75 +179,104 @@ struct ae_shader* ae_shader_create(
 	const int32_t* stage_types,
 	const int32_t stage_count)
 {
-	if (stage_count > AE_MAX_SHADER_STAGES)
-		return NULL;
-
-	struct ae_shader* out = NULL;
+	uint32_t stage_ids[AE_MAX_SHADER_STAGES] = { 0 };
 
-	if ((out = malloc(sizeof(*out))) == NULL)
-		return NULL;
+	create_stages(stage_ids, stage_sources, stage_sizes, stage_types, stage_count);
+	compile_stages(stage_ids, stage_count);
 
-	if (ubo_view_projection_matrix == 0)
+	if (!check_stages(stage_ids, stage_count, debug_output, debug_output_size))
 	{
-		glCreateBuffers(1, &ubo_view_projection_matrix);
-		glNamedBufferStorage(ubo_view_projection_matrix, sizeof(mat4), NULL, GL_DYNAMIC_STORAGE_BIT);
-		glBindBufferBase(GL_UNIFORM_BUFFER, 0, ubo_view_projection_matrix);
+		delete_stages(stage_ids, stage_count);
+		return 0;
 	}
 
-	int32_t stage_ids[AE_MAX_SHADER_STAGES] = { 0 };
-	int32_t stage_ids_count = 0;
-	int32_t success = 0;
-
-	for (int i = 0; i < stage_count; ++i)
-	{
-		if (stage_sources[i] == NULL)
-			return NULL;
+	uint32_t id = link_stages(stage_ids, stage_count);
 
-		int32_t stage_id = glCreateShader(stage_types[i]);
-		glShaderSource(stage_id, 1, &stage_sources[i], &stage_sizes[i]);
-		glCompileShader(stage_id);
-		glGetShaderiv(stage_id, GL_COMPILE_STATUS, &success);
+	return check_program(id, debug_output, debug_output_size) ? id : 0;
+}
 
-		if (success == GL_FALSE)
-		{
-			glGetShaderInfoLog(stage_id, debug_output_size, NULL, debug_output);
-			free(out);
-			return NULL;
-		}
+static void create_view_projection_buffer()
+{
+	if (ubo_view_projection_matrix != 0)
+		return;
 
-		stage_ids[i] = stage_id;
-		stage_ids_count++;
-	}
+	glCreateBuffers(1, &ubo_view_projection_matrix);
+	glNamedBufferStorage(ubo_view_projection_matrix, sizeof(mat4), NULL, GL_DYNAMIC_STORAGE_BIT);
+	glBindBufferBase(GL_UNIFORM_BUFFER, 0, ubo_view_projection_matrix);
+}
 
-	out->id = glCreateProgram();
+static bool is_valid_program(const char** stage_sources, const int32_t stage_count)
+{
+	if (stage_count <= 0 || stage_count > AE_MAX_SHADER_STAGES)
+		return false;
 
-	for (int32_t i = 0; i < stage_ids_count; i++)
+	for (int32_t i = 0; i < stage_count; i++)
 	{
-		glAttachShader(out->id, stage_ids[i]);
+		if (stage_sources[i] == NULL)
+			return false;
 	}
 
-	glLinkProgram(out->id);
-	glGetProgramiv(out->id, GL_LINK_STATUS, &success);
+	return true;
+}
 
-	if (!success)
-	{
-		glGetShaderInfoLog(out->id, debug_output_size, NULL, debug_output);
-		glDeleteProgram(out->id);
-		free(out);
-		return NULL;
-	}
+static struct ae_shader* create_shader(const uint32_t id)
+{
+	struct ae_shader* out = NULL;
 
-	for (int32_t i = 0; i < stage_ids_count; i++)
+	if ((out = malloc(sizeof(*out))) == NULL)
 	{
-		glDeleteShader(stage_ids[i]);
+		glDeleteProgram(id);
+		return NULL;
 	}
 
+	out->id = (int32_t)id;
 	out->enable_blending = false;
 	out->enable_depth_test = false;
 
 	return out;
 }
 
+struct ae_shader* ae_shader_create(
+	char* debug_output,
+	const int32_t debug_output_size,
+	const char** stage_sources,
+	const int32_t* stage_sizes,
+	const int32_t* stage_types,
+	const int32_t stage_count)
+{
+	if (!is_valid_program(stage_sources, stage_count))
+		return NULL;
+
+	create_view_projection_buffer();
+
+	uint64_t start = ae_clock_now();
+	uint64_t key = ae_program_cache_key(stage_sources, stage_sizes, stage_types, stage_count);
+	uint32_t id = 0;
+
+	enum ae_program_cache_result result = ae_program_cache_load(key, &id);
+
+	if (result == AE_PROGRAM_CACHE_HIT)
+	{
+		cache_stats.hit_count++;
+		cache_stats.load_time += ae_clock_now() - start;
+	}
+	else
+	{
+		id = compile_program(debug_output, debug_output_size, stage_sources, stage_sizes, stage_types, stage_count);
+
+		if (id == 0)
+			return NULL;
+
+		ae_program_cache_store(key, id);
+
+		cache_stats.miss_count++;
+		cache_stats.rejected_count += result == AE_PROGRAM_CACHE_REJECTED;
+		cache_stats.compile_time += ae_clock_now() - start;
+	}
+
+	return create_shader(id);
+}
+
 struct ae_shader* ae_shader_create_basic(
 	char* debug_output,
 	const int32_t debug_output_size,
@@ -152,7 +289,169 @@ struct ae_shader* ae_shader_create_basic(
 	return ae_shader_create(debug_output, debug_output_size, stage_sources, stage_sizes, stages_types, 2);
 }
 
+bool ae_shader_create_async(
+	const char** stage_sources,
+	const int32_t* stage_sizes,
+	const int32_t* stage_types,
+	const int32_t stage_count,
+	ae_shader_ready_callback callback,
+	void* user_data)
+{
+	if (!callback || !is_valid_program(stage_sources, stage_count))
+		return false;
+
+	if (pending_count == pending_capacity)
+	{
+		uint32_t capacity = pending_capacity ? pending_capacity * 2 : AE_SHADER_ASYNC_INITIAL_CAPACITY;
+		struct ae_pending_program* programs = realloc(pending_programs, sizeof(*programs) * capacity);
+
+		if (!programs)
+			return false;
+
+		pending_programs = programs;
+		pending_capacity = capacity;
+	}
+
+	create_view_projection_buffer();
+
+	struct ae_pending_program* pending = &pending_programs[pending_count++];
+	*pending = (struct ae_pending_program){
+		.key = ae_program_cache_key(stage_sources, stage_sizes, stage_types, stage_count),
+		.stage_count = stage_count,
+		.callback = callback,
+		.user_data = user_data
+	};
+
+	enum ae_program_cache_result result = ae_program_cache_load(pending->key, &pending->program);
+
+	if (result == AE_PROGRAM_CACHE_HIT)
+	{
+		cache_stats.hit_count++;
+		pending->state = AE_PENDING_PROGRAM_READY;
+		return true;
+	}
+
+	cache_stats.rejected_count += result == AE_PROGRAM_CACHE_REJECTED;
+
+	create_stages(pending->stage_ids, stage_sources, stage_sizes, stage_types, stage_count);
+
+	// without the extension glCompileShader may block, poll_async compiles a few programs per call instead
+	if (ae_opengl_extensions.parallel_shader_compile)
+	{
+		compile_stages(pending->stage_ids, stage_count);
+		pending->state = AE_PENDING_PROGRAM_COMPILING;
+	}
+	else
+	{
+		pending->state = AE_PENDING_PROGRAM_WAITING;
+	}
+
+	return true;
+}
+
+static bool is_completed(const uint32_t id, const bool program)
+{
+	int32_t completed = GL_FALSE;
+
+	if (program)
+		glGetProgramiv(id, GL_COMPLETION_STATUS_KHR, &completed);
+	else
+		glGetShaderiv(id, GL_COMPLETION_STATUS_KHR, &completed);
+
+	return completed != GL_FALSE;
+}
+
+// moves the program one step further, returns true once the callback can be called
+static bool advance_program(struct ae_pending_program* pending, char* debug_output, const int32_t debug_output_size, uint32_t* blocking_count)
+{
+	switch (pending->state)
+	{
+	case AE_PENDING_PROGRAM_WAITING:
+		if (*blocking_count == AE_SHADER_ASYNC_BLOCKING_BUDGET)
+			return false;
+
+		(*blocking_count)++;
+		compile_stages(pending->stage_ids, pending->stage_count);
+		break;
+	case AE_PENDING_PROGRAM_COMPILING:
+		for (int32_t i = 0; i < pending->stage_count; i++)
+		{
+			if (!is_completed(pending->stage_ids[i], false))
+				return false;
+		}
+		break;
+	case AE_PENDING_PROGRAM_LINKING:
+		if (ae_opengl_extensions.parallel_shader_compile && !is_completed(pending->program, true))
+			return false;
+
+		if (check_program(pending->program, debug_output, debug_output_size))
+		{
+			ae_program_cache_store(pending->key, pending->program);
+			cache_stats.miss_count++;
+		}
+		else
+		{
+			pending->program = 0;
+		}
+
+		return true;
+	case AE_PENDING_PROGRAM_READY:
+		return true;
+	}
+
+	if (!check_stages(pending->stage_ids, pending->stage_count, debug_output, debug_output_size))
+	{
+		delete_stages(pending->stage_ids, pending->stage_count);
+		pending->program = 0;
+		return true;
+	}
+
+	pending->program = link_stages(pending->stage_ids, pending->stage_count);
+	pending->state = AE_PENDING_PROGRAM_LINKING;
+
+	// without the extension the link status is read right away, the program is done in this call
+	return !ae_opengl_extensions.parallel_shader_compile && advance_program(pending, debug_output, debug_output_size, blocking_count);
+}
+
+uint32_t ae_shader_poll_async()
+{
+	char debug_output[AE_SHADER_ASYNC_LOG_LENGTH];
+	uint32_t blocking_count = 0;
+	uint32_t i = 0;
+
+	while (i < pending_count)
+	{
+		debug_output[0] = '\0';
+
+		if (!advance_program(&pending_programs[i], debug_output, sizeof(debug_output), &blocking_count))
+		{
+			i++;
+			continue;
+		}
+
+		// removed before the callback, it may submit more programs and move the array
+		struct ae_pending_program done = pending_programs[i];
+		memmove(&pending_programs[i], &pending_programs[i + 1], sizeof(*pending_programs) * (--pending_count - i));
+
+		struct ae_shader* shader = done.program ? create_shader(done.program) : NULL;
+		done.callback(shader, shader ? NULL : debug_output, done.user_data);
+	}
+
+	return pending_count;
+}
+
 void ae_shader_terminate(int32_t id)
 {
+	ae_gl_state_forget_program((uint32_t)id);
 	glDeleteProgram(id);
 }
+
+bool ae_shader_set_cache_directory(const char* directory)
+{
+	return ae_program_cache_set_directory(directory);
+}
+
+void ae_shader_get_cache_stats(struct ae_shader_cache_stats* stats)
+{
+	*stats = cache_stats;
+}
@@ -1,9 +1,8 @@
 #pragma once
 
+#include <apis/shader.h>
 #include <core/types.h>
 
-struct ae_shader;
-
 void ae_shader_set_view_projection(const float* view_projection);
 void ae_shader_set_blending(struct ae_shader* shader, bool enable, uint32_t source, uint32_t destination);
 void ae_shader_set_depth_test(struct ae_shader* shader, bool enable);
@@ -21,4 +20,17 @@ struct ae_shader* ae_shader_create_basic(
 	char* debug_output,
 	const int32_t debug_output_size,
 	const char* vertex_shader,
-	const char* fragment_shader);
\ No newline at end of file
+	const char* fragment_shader);
+
+bool ae_shader_create_async(
+	const char** stage_sources,
+	const int32_t* stage_sizes,
+	const int32_t* stage_types,
+	const int32_t stage_count,
+	ae_shader_ready_callback callback,
+	void* user_data);
+
+uint32_t ae_shader_poll_async();
+
+bool ae_shader_set_cache_directory(const char* directory);
+void ae_shader_get_cache_stats(struct ae_shader_cache_stats* stats);
@@ -0,0 +1,192 @@
+#include "opengl_state.h"
+#include "glad/glad.h"
+
+#include <apis/renderer.h>
+
+// no gl object has this name, the next call always changes the state
+#define AE_GL_STATE_UNKNOWN 0xffffffffu
+
+struct ae_gl_state
+{
+	uint32_t program;
+	uint32_t vertex_array;
+	uint32_t draw_indirect_buffer;
+	uint32_t textures[AE_GL_STATE_MAX_TEXTURE_UNITS];
+	uint32_t blending;
+	uint32_t blend_source;
+	uint32_t blend_destination;
+	uint32_t depth_test;
+	uint32_t scissor_test;
+	uint32_t color_mask;
+	uint32_t depth_mask;
+	uint32_t stencil_mask;
+	struct ae_render_state_stats frame;
+	struct ae_render_state_stats last_frame;
+};
+
+// only valid after ae_gl_state_invalidate, the backend calls it once the context exists
+static struct ae_gl_state state;
+
+// true if the cached value changes and the gl call has to be made
+static bool update(uint32_t* cached, const uint32_t value)
+{
+	if (*cached == value)
+	{
+		state.frame.skipped_count++;
+		return false;
+	}
+
+	*cached = value;
+	state.frame.issued_count++;
+
+	return true;
+}
+
+void ae_gl_state_invalidate()
+{
+	state.program = AE_GL_STATE_UNKNOWN;
+	state.vertex_array = AE_GL_STATE_UNKNOWN;
+	state.draw_indirect_buffer = AE_GL_STATE_UNKNOWN;
+	state.blending = AE_GL_STATE_UNKNOWN;
+	state.blend_source = AE_GL_STATE_UNKNOWN;
+	state.blend_destination = AE_GL_STATE_UNKNOWN;
+	state.depth_test = AE_GL_STATE_UNKNOWN;
+	state.scissor_test = AE_GL_STATE_UNKNOWN;
+	state.color_mask = AE_GL_STATE_UNKNOWN;
+	state.depth_mask = AE_GL_STATE_UNKNOWN;
+	state.stencil_mask = AE_GL_STATE_UNKNOWN;
+
+	for (uint32_t i = 0; i < AE_GL_STATE_MAX_TEXTURE_UNITS; i++)
+		state.textures[i] = AE_GL_STATE_UNKNOWN;
+}
+
+void ae_gl_state_use_program(const uint32_t program)
+{
+	if (update(&state.program, program))
+		glUseProgram(program);
+}
+
+void ae_gl_state_set_blending(const bool enable, const uint32_t source, const uint32_t destination)
+{
+	if (update(&state.blending, enable))
+	{
+		if (enable)
+			glEnable(GL_BLEND);
+		else
+			glDisable(GL_BLEND);
+	}
+
+	// the factors do not matter while blending is off
+	if (!enable)
+		return;
+
+	if (state.blend_source == source && state.blend_destination == destination)
+	{
+		state.frame.skipped_count++;
+		return;
+	}
+
+	state.blend_source = source;
+	state.blend_destination = destination;
+	state.frame.issued_count++;
+
+	glBlendFunc(source, destination);
+}
+
+void ae_gl_state_set_depth_test(const bool enable)
+{
+	if (!update(&state.depth_test, enable))
+		return;
+
+	if (enable)
+		glEnable(GL_DEPTH_TEST);
+	else
+		glDisable(GL_DEPTH_TEST);
+}
+
+void ae_gl_state_set_scissor_test(const bool enable)
+{
+	if (!update(&state.scissor_test, enable))
+		return;
+
+	if (enable)
+		glEnable(GL_SCISSOR_TEST);
+	else
+		glDisable(GL_SCISSOR_TEST);
+}
+
+void ae_gl_state_set_write_masks(const bool color, const bool depth, const uint32_t stencil)
+{
+	if (update(&state.color_mask, color))
+		glColorMask(color, color, color, color);
+
+	if (update(&state.depth_mask, depth))
+		glDepthMask(depth);
+
+	// stencil buffers have 8 bits, without the higher ones the mask never equals the unknown marker
+	if (update(&state.stencil_mask, stencil & 0xffu))
+		glStencilMask(stencil & 0xffu);
+}
+
+void ae_gl_state_bind_vertex_array(const uint32_t vertex_array)
+{
+	if (update(&state.vertex_array, vertex_array))
+		glBindVertexArray(vertex_array);
+}
+
+void ae_gl_state_bind_texture_unit(const uint32_t unit, const uint32_t texture)
+{
+	if (unit >= AE_GL_STATE_MAX_TEXTURE_UNITS)
+	{
+		state.frame.issued_count++;
+		glBindTextureUnit(unit, texture);
+		return;
+	}
+
+	if (update(&state.textures[unit], texture))
+		glBindTextureUnit(unit, texture);
+}
+
+void ae_gl_state_bind_draw_indirect_buffer(const uint32_t buffer)
+{
+	if (update(&state.draw_indirect_buffer, buffer))
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer);
+}
+
+void ae_gl_state_forget_program(const uint32_t program)
+{
+	if (state.program == program)
+		state.program = AE_GL_STATE_UNKNOWN;
+}
+
+void ae_gl_state_forget_vertex_array(const uint32_t vertex_array)
+{
+	if (state.vertex_array == vertex_array)
+		state.vertex_array = AE_GL_STATE_UNKNOWN;
+}
+
+void ae_gl_state_forget_texture(const uint32_t texture)
+{
+	for (uint32_t i = 0; i < AE_GL_STATE_MAX_TEXTURE_UNITS; i++)
+	{
+		if (state.textures[i] == texture)
+			state.textures[i] = AE_GL_STATE_UNKNOWN;
+	}
+}
+
+void ae_gl_state_forget_buffer(const uint32_t buffer)
+{
+	if (state.draw_indirect_buffer == buffer)
+		state.draw_indirect_buffer = AE_GL_STATE_UNKNOWN;
+}
+
+void ae_gl_state_end_frame()
+{
+	state.last_frame = state.frame;
+	state.frame = (struct ae_render_state_stats){ 0 };
+}
+
+void ae_gl_state_get_stats(struct ae_render_state_stats* stats)
+{
+	*stats = state.last_frame;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+// cache of the gl state the renderer changes, calls that would not change anything are skipped.
+// every change of this state has to go through here, ae_gl_state_invalidate after code that does not
+
+#include <core/types.h>
+
+struct ae_render_state_stats;
+
+#ifndef AE_GL_STATE_MAX_TEXTURE_UNITS
+#define AE_GL_STATE_MAX_TEXTURE_UNITS 64
+#endif // !AE_GL_STATE_MAX_TEXTURE_UNITS
+
+void ae_gl_state_invalidate();
+
+void ae_gl_state_use_program(const uint32_t program);
+void ae_gl_state_set_blending(const bool enable, const uint32_t source, const uint32_t destination);
+void ae_gl_state_set_depth_test(const bool enable);
+void ae_gl_state_set_scissor_test(const bool enable);
+// color enables all four channels, stencil is the mask of both faces
+void ae_gl_state_set_write_masks(const bool color, const bool depth, const uint32_t stencil);
+void ae_gl_state_bind_vertex_array(const uint32_t vertex_array);
+void ae_gl_state_bind_texture_unit(const uint32_t unit, const uint32_t texture);
+void ae_gl_state_bind_draw_indirect_buffer(const uint32_t buffer);
+
+// deleted names may be reused by the next object, they must not stay cached
+void ae_gl_state_forget_program(const uint32_t program);
+void ae_gl_state_forget_vertex_array(const uint32_t vertex_array);
+void ae_gl_state_forget_texture(const uint32_t texture);
+void ae_gl_state_forget_buffer(const uint32_t buffer);
+
+// the counters run per frame, ending a frame keeps them for ae_gl_state_get_stats
+void ae_gl_state_end_frame();
+void ae_gl_state_get_stats(struct ae_render_state_stats* stats);
@@ -0,0 +1,345 @@
+#include "opengl_static_batch.h"
+#include "opengl_profiler.h"
+#include "opengl_renderer.h"
+#include "opengl_shader.h"
+#include "opengl_state.h"
+#include "quad_expansion.h"
+#include "glad/glad.h"
+
+#include <apis/renderer.h>
+#include <apis/shader.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+// quads drawn with one set of texture units, index 0 is the white texture of untextured quads.
+// a unit no quad refers to any more is free for the next new texture of the segment
+struct ae_static_segment
+{
+	uint32_t first_quad;
+	uint32_t quad_count;
+	uint32_t texture_count;
+	uint32_t textures[AE_GL_STATE_MAX_TEXTURE_UNITS];
+	uint32_t texture_refs[AE_GL_STATE_MAX_TEXTURE_UNITS];
+};
+
+struct ae_static_batch
+{
+	struct ae_shader* shader;
+	struct ae_static_segment* segments;
+	// the unit of every quad, only kept for updatable batches
+	uint8_t* quad_units;
+	struct ae_vertex_layout layout;
+	uint32_t segment_count;
+	uint32_t quad_count;
+	uint32_t unit_count;
+	uint32_t index_type;
+	uint32_t index_size;
+	uint32_t vao;
+	uint32_t vbo;
+	uint32_t ibo;
+	bool updatable;
+};
+
+// finds or adds the unit of a texture and counts the quad using it, false once every unit of the segment is in use
+static bool get_texture_index(const struct ae_static_batch* batch, struct ae_static_segment* segment, const uint32_t texture, uint32_t* index)
+{
+	uint32_t free_index = 0;
+
+	if (!texture)
+	{
+		*index = 0;
+		return true;
+	}
+
+	for (uint32_t i = 1; i < segment->texture_count; i++)
+	{
+		if (segment->textures[i] == texture)
+		{
+			*index = i;
+			segment->texture_refs[i]++;
+			return true;
+		}
+
+		if (!free_index && !segment->texture_refs[i])
+			free_index = i;
+	}
+
+	if (!free_index)
+	{
+		if (segment->texture_count == batch->unit_count)
+			return false;
+
+		free_index = segment->texture_count++;
+	}
+
+	*index = free_index;
+	segment->textures[free_index] = texture;
+	segment->texture_refs[free_index] = 1;
+
+	return true;
+}
+
+// units left without quads get the white texture, the texture they held may be destroyed by now
+static void release_free_units(struct ae_static_segment* segment)
+{
+	while (segment->texture_count > 1 && !segment->texture_refs[segment->texture_count - 1])
+		segment->texture_count--;
+
+	for (uint32_t i = 1; i < segment->texture_count; i++)
+	{
+		if (!segment->texture_refs[i])
+			segment->textures[i] = segment->textures[0];
+	}
+}
+
+static void write_quad(const struct ae_static_batch* batch, uint8_t* out, const struct ae_textured_draw_params* params, const uint32_t index)
+{
+	ae_quad_write(&batch->layout, out, params->color, params->position, params->size, (const vec2*)params->texture_coordinates, (float)index);
+}
+
+// the quads are split where a texture no longer fits in the units of the current segment, draw order is kept
+static bool build_segments(struct ae_static_batch* batch, const struct ae_textured_draw_params* params, uint8_t* vertices)
+{
+	uint32_t capacity = 1;
+	batch->segments = malloc(sizeof(*batch->segments));
+
+	if (!batch->segments)
+		return false;
+
+	struct ae_static_segment* segment = &batch->segments[0];
+	*segment = (struct ae_static_segment){ .texture_count = 1, .textures = { ae_render_get_white_texture() } };
+	batch->segment_count = 1;
+
+	for (uint32_t i = 0; i < batch->quad_count; i++)
+	{
+		uint32_t index = 0;
+
+		if (!get_texture_index(batch, segment, params[i].texture, &index))
+		{
+			if (batch->segment_count == capacity)
+			{
+				capacity *= 2;
+				struct ae_static_segment* segments = realloc(batch->segments, sizeof(*segments) * capacity);
+
+				if (!segments)
+					return false;
+
+				batch->segments = segments;
+			}
+
+			segment = &batch->segments[batch->segment_count++];
+			*segment = (struct ae_static_segment){ .first_quad = i, .texture_count = 1, .textures = { ae_render_get_white_texture() } };
+
+			// only a driver with a single unit has no room next to the white texture
+			if (!get_texture_index(batch, segment, params[i].texture, &index))
+				return false;
+		}
+
+		write_quad(batch, vertices + (size_t)i * 4 * batch->layout.stride, &params[i], index);
+		segment->quad_count++;
+
+		if (batch->quad_units)
+			batch->quad_units[i] = (uint8_t)index;
+	}
+
+	return true;
+}
+
+// the segment holding the quad, segments are sorted by their first quad
+static struct ae_static_segment* find_segment(const struct ae_static_batch* batch, const uint32_t quad)
+{
+	uint32_t low = 0;
+	uint32_t high = batch->segment_count - 1;
+
+	while (low < high)
+	{
+		uint32_t middle = (low + high + 1) / 2;
+
+		if (batch->segments[middle].first_quad <= quad)
+			low = middle;
+		else
+			high = middle - 1;
+	}
+
+	return &batch->segments[low];
+}
+
+static bool create_buffers(struct ae_static_batch* batch, const uint8_t* vertices)
+{
+	size_t index_size;
+	void* indices = ae_render_create_indices(batch->quad_count, &batch->index_type, &index_size);
+
+	if (!indices)
+		return false;
+
+	batch->index_size = batch->index_type == GL_UNSIGNED_INT ? sizeof(uint32_t) : sizeof(uint16_t);
+
+	glCreateBuffers(1, &batch->ibo);
+	glNamedBufferStorage(batch->ibo, (GLsizeiptr)index_size, indices, 0);
+	free(indices);
+
+	// without the dynamic storage bit the driver can keep the vertices where only the gpu reads them
+	glCreateBuffers(1, &batch->vbo);
+	glNamedBufferStorage(batch->vbo, (GLsizeiptr)batch->quad_count * 4 * batch->layout.stride, vertices, batch->updatable ? GL_DYNAMIC_STORAGE_BIT : 0);
+
+	glCreateVertexArrays(1, &batch->vao);
+	ae_render_set_vertex_attributes(batch->vao, batch->vbo, &batch->layout);
+	glVertexArrayElementBuffer(batch->vao, batch->ibo);
+
+	return true;
+}
+
+static void set_samplers(const struct ae_static_batch* batch)
+{
+	int32_t samplers[AE_GL_STATE_MAX_TEXTURE_UNITS];
+
+	for (uint32_t i = 0; i < batch->unit_count; i++)
+		samplers[i] = (int32_t)i;
+
+	ae_gl_state_use_program(batch->shader->id);
+	glUniform1iv(glGetUniformLocation(batch->shader->id, "u_textures"), (GLsizei)batch->unit_count, samplers);
+}
+
+struct ae_static_batch* ae_static_batch_create(struct ae_shader* const shader, const struct ae_textured_draw_params* params, const uint32_t count, const struct ae_vertex_format* format, const bool updatable)
+{
+	if (!shader || !count)
+		return NULL;
+
+	struct ae_static_batch* batch = calloc(1, sizeof(*batch));
+
+	if (!batch)
+		return NULL;
+
+	ae_vertex_layout_init(&batch->layout, format ? format : &ae_default_vertex_format);
+
+	GLint unit_count = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &unit_count);
+
+	batch->shader = shader;
+	batch->quad_count = count;
+	batch->updatable = updatable;
+	batch->unit_count = (uint32_t)unit_count < AE_GL_STATE_MAX_TEXTURE_UNITS ? (uint32_t)unit_count : AE_GL_STATE_MAX_TEXTURE_UNITS;
+
+	// the vertices only live on the cpu until they are uploaded
+	uint8_t* vertices = malloc((size_t)count * 4 * batch->layout.stride);
+	batch->quad_units = updatable ? malloc(count) : NULL;
+
+	bool created = vertices && (!updatable || batch->quad_units) && build_segments(batch, params, vertices) && create_buffers(batch, vertices);
+
+	free(vertices);
+
+	if (!created)
+	{
+		ae_static_batch_destroy(batch);
+		return NULL;
+	}
+
+	set_samplers(batch);
+
+	return batch;
+}
+
+void ae_static_batch_destroy(struct ae_static_batch* batch)
+{
+	ae_gl_state_forget_vertex_array(batch->vao);
+	glDeleteVertexArrays(1, &batch->vao);
+	glDeleteBuffers(1, &batch->vbo);
+	glDeleteBuffers(1, &batch->ibo);
+	free(batch->segments);
+	free(batch->quad_units);
+	free(batch);
+}
+
+bool ae_static_batch_update(struct ae_static_batch* batch, const uint32_t first, const struct ae_textured_draw_params* params, const uint32_t count)
+{
+	if (!batch->updatable || first > batch->quad_count || count > batch->quad_count - first)
+		return false;
+
+	if (!count)
+		return true;
+
+	const size_t quad_size = (size_t)4 * batch->layout.stride;
+	const uint32_t first_segment = (uint32_t)(find_segment(batch, first) - batch->segments);
+	const uint32_t segment_count = (uint32_t)(find_segment(batch, first + count - 1) - batch->segments) - first_segment + 1;
+
+	// the units are assigned on copies of the touched segments, a texture that does not fit leaves the batch as it was
+	struct ae_static_segment* segments = malloc(sizeof(*segments) * segment_count);
+	uint8_t* units = malloc(count);
+	uint8_t* vertices = malloc(quad_size * count);
+
+	if (!segments || !units || !vertices)
+	{
+		free(segments);
+		free(units);
+		free(vertices);
+		return false;
+	}
+
+	memcpy(segments, batch->segments + first_segment, sizeof(*segments) * segment_count);
+
+	// every quad of the range gives up its unit before the new textures are placed
+	for (uint32_t i = 0, j = 0; i < count; i++)
+	{
+		while (j + 1 < segment_count && segments[j + 1].first_quad <= first + i)
+			j++;
+
+		const uint8_t unit = batch->quad_units[first + i];
+
+		// the white texture is not counted, it never leaves unit 0
+		if (unit)
+			segments[j].texture_refs[unit]--;
+	}
+
+	for (uint32_t i = 0, j = 0; i < count; i++)
+	{
+		uint32_t index = 0;
+
+		while (j + 1 < segment_count && segments[j + 1].first_quad <= first + i)
+			j++;
+
+		if (!get_texture_index(batch, &segments[j], params[i].texture, &index))
+		{
+			free(segments);
+			free(units);
+			free(vertices);
+			return false;
+		}
+
+		units[i] = (uint8_t)index;
+		write_quad(batch, vertices + quad_size * i, &params[i], index);
+	}
+
+	for (uint32_t i = 0; i < segment_count; i++)
+		release_free_units(&segments[i]);
+
+	memcpy(batch->segments + first_segment, segments, sizeof(*segments) * segment_count);
+	memcpy(batch->quad_units + first, units, count);
+	free(segments);
+	free(units);
+
+	glNamedBufferSubData(batch->vbo, (GLintptr)(quad_size * first), (GLsizeiptr)(quad_size * count), vertices);
+	free(vertices);
+
+	return true;
+}
+
+void ae_static_batch_draw(struct ae_static_batch* batch)
+{
+	ae_shader_set_current_shader(batch->shader);
+	ae_gl_state_bind_vertex_array(batch->vao);
+	ae_gpu_profiler_begin_scope("static batch");
+
+	for (uint32_t i = 0; i < batch->segment_count; i++)
+	{
+		const struct ae_static_segment* segment = &batch->segments[i];
+
+		for (uint32_t j = 0; j < segment->texture_count; j++)
+			ae_gl_state_bind_texture_unit(j, segment->textures[j]);
+
+		const uintptr_t offset = (uintptr_t)segment->first_quad * 6 * batch->index_size;
+		glDrawElements(GL_TRIANGLES, (GLsizei)(segment->quad_count * 6), batch->index_type, (const void*)offset);
+	}
+
+	ae_gpu_profiler_end_scope();
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+// static batches keep their vertices in gpu storage written when the batch is created, drawing one binds
+// its textures and issues a draw call per set of texture units. nothing is written per frame
+
+#include <core/types.h>
+
+struct ae_shader;
+struct ae_static_batch;
+struct ae_textured_draw_params;
+struct ae_vertex_format;
+
+struct ae_static_batch* ae_static_batch_create(struct ae_shader* const shader, const struct ae_textured_draw_params* params, const uint32_t count, const struct ae_vertex_format* format, const bool updatable);
+void ae_static_batch_destroy(struct ae_static_batch* batch);
+bool ae_static_batch_update(struct ae_static_batch* batch, const uint32_t first, const struct ae_textured_draw_params* params, const uint32_t count);
+void ae_static_batch_draw(struct ae_static_batch* batch);
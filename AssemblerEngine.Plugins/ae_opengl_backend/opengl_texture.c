@@ -0,0 +1,464 @@
+#include "opengl_texture.h"
+#include "opengl_state.h"
+#include "glad/glad.h"
+
+#include <apis/texture.h>
+#include <core/atomic.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+// offsets into the staging ring, a multiple of every pixel size
+#define AE_TEXTURE_STAGING_ALIGNMENT 16
+
+enum ae_upload_state
+{
+	AE_UPLOAD_FREE,
+	// handed out by begin_upload, the pixels are being written
+	AE_UPLOAD_WRITING,
+	// end_upload was called, waiting for its frame
+	AE_UPLOAD_READY,
+	// copied into the texture, the gpu may still be reading the staging memory
+	AE_UPLOAD_COMMITTED
+};
+
+struct ae_opengl_texture
+{
+	// handed out to the user, must stay the first member
+	struct ae_texture texture;
+	volatile uint32_t pending_count;
+	bool mips_dirty;
+};
+
+struct ae_upload_slot
+{
+	// NULL once the texture was destroyed, the upload is skipped
+	struct ae_opengl_texture* texture;
+	GLsync fence;
+	// ring positions, end includes the bytes skipped to not wrap in the middle of the upload
+	uint64_t offset;
+	uint64_t end;
+	uint32_t level;
+	uint32_t x;
+	uint32_t y;
+	uint32_t width;
+	uint32_t height;
+	volatile uint32_t state;
+};
+
+// begin_upload runs on any thread, it takes the lock to move head and slot_head.
+// tail and slot_tail are moved by the render thread under the lock as well, begin_upload only moves the tail of an empty ring
+struct ae_texture_streamer
+{
+	struct ae_upload_slot slots[AE_TEXTURE_MAX_UPLOADS];
+	uint8_t* mapped;
+	// positions in the ring grow forever, the offset in the buffer is position % AE_TEXTURE_STAGING_SIZE
+	uint64_t head;
+	uint64_t tail;
+	uint32_t slot_head;
+	uint32_t slot_tail;
+	uint32_t buffer;
+	volatile uint32_t lock;
+	volatile uint64_t full_count;
+	uint64_t budget;
+	uint64_t uploaded_bytes;
+	uint32_t committed_count;
+	uint32_t pending_count;
+};
+
+static struct ae_texture_streamer streamer = { .budget = AE_TEXTURE_UPLOAD_BUDGET };
+
+// outlives the streamer, a batch compares it against the value it copied its layers at
+static uint64_t generation;
+
+static void lock()
+{
+	while (!ae_atomic_cas_u32(&streamer.lock, 0, 1))
+		;
+}
+
+static void unlock()
+{
+	ae_atomic_store_u32(&streamer.lock, 0);
+}
+
+static uint32_t get_pixel_size(const enum ae_texture_format format)
+{
+	return format == AE_TEXTURE_FORMAT_R8 ? 1 : 4;
+}
+
+static uint32_t get_level_size(const uint32_t size, const uint32_t level)
+{
+	uint32_t level_size = size >> level;
+	return level_size ? level_size : 1;
+}
+
+static bool create_staging()
+{
+	if (streamer.mapped)
+		return true;
+
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	glCreateBuffers(1, &streamer.buffer);
+	glNamedBufferStorage(streamer.buffer, AE_TEXTURE_STAGING_SIZE, NULL, flags);
+	streamer.mapped = glMapNamedBufferRange(streamer.buffer, 0, AE_TEXTURE_STAGING_SIZE, flags);
+
+	if (!streamer.mapped)
+	{
+		glDeleteBuffers(1, &streamer.buffer);
+		streamer.buffer = 0;
+		return false;
+	}
+
+	return true;
+}
+
+// an upload never wraps around the end of the ring, the rest of the ring is skipped instead
+static bool allocate_staging(const uint64_t size, uint64_t* offset)
+{
+	uint64_t position = streamer.head;
+	uint64_t ring_offset = position % AE_TEXTURE_STAGING_SIZE;
+
+	if (ring_offset + size > AE_TEXTURE_STAGING_SIZE)
+		position += AE_TEXTURE_STAGING_SIZE - ring_offset;
+
+	// nothing is in flight, the skipped bytes are free right away. a region close to the
+	// staging size would never fit behind them otherwise
+	uint64_t tail = streamer.head == streamer.tail ? position : streamer.tail;
+
+	if (position + size - tail > AE_TEXTURE_STAGING_SIZE)
+		return false;
+
+	*offset = position;
+	streamer.head = position + size;
+	streamer.tail = tail;
+
+	return true;
+}
+
+struct ae_texture* ae_texture_create(const struct ae_texture_desc* desc)
+{
+	if (desc->width == 0 || desc->height == 0 || !create_staging())
+		return NULL;
+
+	struct ae_opengl_texture* texture = calloc(1, sizeof(*texture));
+
+	if (!texture)
+		return NULL;
+
+	uint32_t full_chain = 1;
+
+	for (uint32_t size = desc->width > desc->height ? desc->width : desc->height; size > 1; size >>= 1)
+		full_chain++;
+
+	texture->texture = (struct ae_texture){
+		.width = desc->width,
+		.height = desc->height,
+		.mip_count = desc->mip_count && desc->mip_count < full_chain ? desc->mip_count : full_chain,
+		.format = desc->format,
+		.generate_mips = desc->generate_mips
+	};
+
+	GLuint id;
+	glCreateTextures(GL_TEXTURE_2D, 1, &id);
+	glTextureStorage2D(id, (GLsizei)texture->texture.mip_count, desc->format == AE_TEXTURE_FORMAT_R8 ? GL_R8 : GL_RGBA8, (GLsizei)desc->width, (GLsizei)desc->height);
+	glTextureParameteri(id, GL_TEXTURE_MIN_FILTER, texture->texture.mip_count > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTextureParameteri(id, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTextureParameteri(id, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTextureParameteri(id, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	texture->texture.id = id;
+
+	return &texture->texture;
+}
+
+void ae_texture_destroy(struct ae_texture* texture)
+{
+	if (!texture)
+		return;
+
+	lock();
+
+	for (uint32_t i = streamer.slot_tail; i != streamer.slot_head; i++)
+	{
+		struct ae_upload_slot* slot = &streamer.slots[i % AE_TEXTURE_MAX_UPLOADS];
+
+		if (slot->texture == (struct ae_opengl_texture*)texture)
+			slot->texture = NULL;
+	}
+
+	unlock();
+
+	// the name can be handed out again for other texels
+	generation++;
+
+	ae_gl_state_forget_texture(texture->id);
+	glDeleteTextures(1, &texture->id);
+	free(texture);
+}
+
+enum ae_texture_upload_result ae_texture_begin_upload(struct ae_texture* texture, const uint32_t level, const uint32_t x, const uint32_t y, const uint32_t width, const uint32_t height, struct ae_texture_upload* upload)
+{
+	if (!texture || level >= texture->mip_count || width == 0 || height == 0
+		|| x + width > get_level_size(texture->width, level)
+		|| y + height > get_level_size(texture->height, level))
+	{
+		return AE_TEXTURE_UPLOAD_INVALID;
+	}
+
+	uint64_t size = (uint64_t)width * height * get_pixel_size(texture->format);
+	uint64_t reserved = (size + AE_TEXTURE_STAGING_ALIGNMENT - 1) & ~(uint64_t)(AE_TEXTURE_STAGING_ALIGNMENT - 1);
+	uint64_t offset;
+
+	// would wait for the ring to empty forever, not counted as full
+	if (reserved > AE_TEXTURE_STAGING_SIZE)
+		return AE_TEXTURE_UPLOAD_TOO_LARGE;
+
+	lock();
+
+	if (streamer.slot_head - streamer.slot_tail == AE_TEXTURE_MAX_UPLOADS || !allocate_staging(reserved, &offset))
+	{
+		unlock();
+		ae_atomic_add_u64(&streamer.full_count, 1);
+		return AE_TEXTURE_UPLOAD_FULL;
+	}
+
+	uint32_t index = streamer.slot_head++ % AE_TEXTURE_MAX_UPLOADS;
+	struct ae_upload_slot* slot = &streamer.slots[index];
+
+	slot->texture = (struct ae_opengl_texture*)texture;
+	slot->fence = NULL;
+	slot->offset = offset;
+	slot->end = offset + reserved;
+	slot->level = level;
+	slot->x = x;
+	slot->y = y;
+	slot->width = width;
+	slot->height = height;
+	slot->state = AE_UPLOAD_WRITING;
+
+	ae_atomic_add_u32(&((struct ae_opengl_texture*)texture)->pending_count, 1);
+
+	unlock();
+
+	upload->pixels = streamer.mapped + offset % AE_TEXTURE_STAGING_SIZE;
+	upload->size = (size_t)size;
+	upload->slot = index;
+
+	return AE_TEXTURE_UPLOAD_OK;
+}
+
+void ae_texture_end_upload(const struct ae_texture_upload* upload)
+{
+	ae_atomic_store_u32(&streamer.slots[upload->slot].state, AE_UPLOAD_READY);
+}
+
+void ae_texture_cancel_uploads(struct ae_texture* texture, const uint32_t level, const uint32_t x, const uint32_t y, const uint32_t width, const uint32_t height)
+{
+	struct ae_opengl_texture* cancelled = (struct ae_opengl_texture*)texture;
+
+	lock();
+
+	// skipped like the uploads of a destroyed texture, the pixels may still be written and the slot is retired as usual
+	for (uint32_t i = streamer.slot_tail; i != streamer.slot_head; i++)
+	{
+		struct ae_upload_slot* slot = &streamer.slots[i % AE_TEXTURE_MAX_UPLOADS];
+
+		if (slot->texture != cancelled || slot->level != level || ae_atomic_load_u32(&slot->state) == AE_UPLOAD_COMMITTED
+			|| slot->x < x || slot->y < y || slot->x + slot->width > x + width || slot->y + slot->height > y + height)
+		{
+			continue;
+		}
+
+		slot->texture = NULL;
+		ae_atomic_add_u32(&cancelled->pending_count, (uint32_t)-1);
+	}
+
+	unlock();
+}
+
+bool ae_texture_is_ready(const struct ae_texture* texture)
+{
+	return ae_atomic_load_u32(&((struct ae_opengl_texture*)texture)->pending_count) == 0;
+}
+
+void ae_texture_set_upload_budget(const uint64_t bytes_per_frame)
+{
+	streamer.budget = bytes_per_frame;
+}
+
+void ae_texture_get_stats(struct ae_texture_stats* stats)
+{
+	lock();
+	uint64_t staging_used = streamer.head - streamer.tail;
+	unlock();
+
+	*stats = (struct ae_texture_stats){
+		.uploaded_bytes = streamer.uploaded_bytes,
+		.committed_count = streamer.committed_count,
+		.pending_count = streamer.pending_count,
+		.staging_used = staging_used,
+		.staging_size = AE_TEXTURE_STAGING_SIZE,
+		.full_count = ae_atomic_load_u64(&streamer.full_count)
+	};
+}
+
+// frees the staging memory of the oldest uploads the gpu is done with, in the order they were begun
+static void retire_uploads(const uint32_t slot_head)
+{
+	uint32_t slot_tail = streamer.slot_tail;
+	// begin_upload moves the tail of an empty ring, it is only written when uploads were retired
+	uint64_t tail = 0;
+
+	for (; slot_tail != slot_head; slot_tail++)
+	{
+		struct ae_upload_slot* slot = &streamer.slots[slot_tail % AE_TEXTURE_MAX_UPLOADS];
+
+		if (ae_atomic_load_u32(&slot->state) != AE_UPLOAD_COMMITTED)
+			break;
+
+		if (slot->fence)
+		{
+			if (glClientWaitSync(slot->fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+				break;
+
+			glDeleteSync(slot->fence);
+			slot->fence = NULL;
+		}
+
+		slot->state = AE_UPLOAD_FREE;
+		tail = slot->end;
+	}
+
+	lock();
+
+	if (slot_tail != streamer.slot_tail)
+	{
+		streamer.slot_tail = slot_tail;
+		streamer.tail = tail;
+	}
+
+	unlock();
+}
+
+static void commit_upload(struct ae_upload_slot* slot)
+{
+	const struct ae_texture* texture = &slot->texture->texture;
+	GLenum format = texture->format == AE_TEXTURE_FORMAT_R8 ? GL_RED : GL_RGBA;
+
+	// the pixels are read from the bound unpack buffer, the pointer is the offset into it
+	glTextureSubImage2D(texture->id, (GLint)slot->level, (GLint)slot->x, (GLint)slot->y, (GLsizei)slot->width, (GLsizei)slot->height,
+		format, GL_UNSIGNED_BYTE, (const void*)(uintptr_t)(slot->offset % AE_TEXTURE_STAGING_SIZE));
+
+	slot->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	generation++;
+
+	if (slot->level == 0 && texture->generate_mips)
+		slot->texture->mips_dirty = true;
+}
+
+// uploads can finish in any order, they are copied as they become ready
+static void commit_uploads(const uint32_t slot_head)
+{
+	struct ae_opengl_texture* committed[AE_TEXTURE_MAX_UPLOADS];
+	uint32_t committed_count = 0;
+	uint64_t uploaded_bytes = 0;
+	uint32_t pending_count = 0;
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, streamer.buffer);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	for (uint32_t i = streamer.slot_tail; i != slot_head; i++)
+	{
+		struct ae_upload_slot* slot = &streamer.slots[i % AE_TEXTURE_MAX_UPLOADS];
+		uint32_t state = ae_atomic_load_u32(&slot->state);
+
+		if (state == AE_UPLOAD_COMMITTED)
+			continue;
+
+		// the texture is only cleared under the lock, destroy runs on this thread
+		if (state == AE_UPLOAD_READY && !slot->texture)
+		{
+			slot->state = AE_UPLOAD_COMMITTED;
+			continue;
+		}
+
+		uint64_t size = (uint64_t)slot->width * slot->height * get_pixel_size(slot->texture ? slot->texture->texture.format : AE_TEXTURE_FORMAT_RGBA8);
+
+		// at least one upload per frame, however big it is
+		if (state != AE_UPLOAD_READY || (committed_count && uploaded_bytes + size > streamer.budget))
+		{
+			pending_count++;
+			continue;
+		}
+
+		commit_upload(slot);
+
+		slot->state = AE_UPLOAD_COMMITTED;
+		ae_atomic_add_u32(&slot->texture->pending_count, (uint32_t)-1);
+
+		committed[committed_count++] = slot->texture;
+		uploaded_bytes += size;
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	// a texture uploaded in parts gets its mips once the last part is in
+	for (uint32_t i = 0; i < committed_count; i++)
+	{
+		struct ae_opengl_texture* texture = committed[i];
+
+		if (texture->mips_dirty && ae_atomic_load_u32(&texture->pending_count) == 0)
+		{
+			glGenerateTextureMipmap(texture->texture.id);
+			texture->mips_dirty = false;
+		}
+	}
+
+	streamer.uploaded_bytes = uploaded_bytes;
+	streamer.committed_count = committed_count;
+	streamer.pending_count = pending_count;
+}
+
+void ae_texture_update()
+{
+	if (!streamer.mapped)
+		return;
+
+	lock();
+	uint32_t slot_head = streamer.slot_head;
+	unlock();
+
+	retire_uploads(slot_head);
+	commit_uploads(slot_head);
+}
+
+void ae_texture_shutdown()
+{
+	if (!streamer.mapped)
+		return;
+
+	for (uint32_t i = 0; i < AE_TEXTURE_MAX_UPLOADS; i++)
+	{
+		if (streamer.slots[i].fence)
+			glDeleteSync(streamer.slots[i].fence);
+	}
+
+	glUnmapNamedBuffer(streamer.buffer);
+	glDeleteBuffers(1, &streamer.buffer);
+
+	memset(&streamer, 0, sizeof(streamer));
+	streamer.budget = AE_TEXTURE_UPLOAD_BUDGET;
+}
+
+uint64_t ae_texture_get_generation()
+{
+	return generation;
+}
+
+void ae_texture_touch()
+{
+	generation++;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+// textures and the staging ring their pixels are streamed through. uploads are copied out of a persistent mapped
+// pixel unpack buffer with glTextureSubImage2D, each copy is fenced and its ring space reused once the fence signaled
+
+#include <apis/texture.h>
+#include <core/types.h>
+
+#ifndef AE_TEXTURE_STAGING_SIZE
+#define AE_TEXTURE_STAGING_SIZE (32 * 1024 * 1024)
+#endif // !AE_TEXTURE_STAGING_SIZE
+
+// uploads that can be in flight at once, begun but not yet read by the gpu
+#ifndef AE_TEXTURE_MAX_UPLOADS
+#define AE_TEXTURE_MAX_UPLOADS 1024
+#endif // !AE_TEXTURE_MAX_UPLOADS
+
+// bytes copied per frame unless set_upload_budget is called
+#ifndef AE_TEXTURE_UPLOAD_BUDGET
+#define AE_TEXTURE_UPLOAD_BUDGET (4 * 1024 * 1024)
+#endif // !AE_TEXTURE_UPLOAD_BUDGET
+
+struct ae_texture* ae_texture_create(const struct ae_texture_desc* desc);
+void ae_texture_destroy(struct ae_texture* texture);
+enum ae_texture_upload_result ae_texture_begin_upload(struct ae_texture* texture, const uint32_t level, const uint32_t x, const uint32_t y, const uint32_t width, const uint32_t height, struct ae_texture_upload* upload);
+void ae_texture_end_upload(const struct ae_texture_upload* upload);
+bool ae_texture_is_ready(const struct ae_texture* texture);
+void ae_texture_set_upload_budget(const uint64_t bytes_per_frame);
+void ae_texture_get_stats(struct ae_texture_stats* stats);
+
+// retires the uploads the gpu has read and copies the finished ones, called by render_scene_start
+void ae_texture_update();
+
+// releases the staging ring, the context has to be current
+void ae_texture_shutdown();
+
+// changes whenever texels are written through the streamer or a texture is destroyed,
+// copies of textures (the layers of array batches) are stale once it moved
+uint64_t ae_texture_get_generation();
+
+// moves the generation for writes that do not go through the streamer, e.g. the atlas
+void ae_texture_touch();
+
+// drops the uploads to the level that lie within the rect and were not copied yet, e.g. of a removed atlas entry. render thread only
+void ae_texture_cancel_uploads(struct ae_texture* texture, const uint32_t level, const uint32_t x, const uint32_t y, const uint32_t width, const uint32_t height);
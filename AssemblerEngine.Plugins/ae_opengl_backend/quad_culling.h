@@ -0,0 +1,143 @@
+#pragma once
+
+// cpu culling of quads against the planes of the camera, kept free of gl calls like quad_expansion.h.
+// a quad is the box from its position to position + size at the depth of the position, it is culled
+// when it lies completely outside one of the planes
+
+#include <apis/renderer.h>
+#include <math/frustum.h>
+#include <math/simd/intrin.h>
+
+#include <stdint.h>
+
+// most quads tested by one call of ae_quad_cull, one bit each
+#define AE_QUAD_CULL_GROUP_SIZE 32
+
+// the planes of the view projection, ordered left, right, bottom, top, near, far.
+// a point p is inside a plane when dot(plane.xyz, p) + plane.w >= 0
+struct ae_quad_culler
+{
+	vec4 planes[6];
+	uint32_t plane_count;
+};
+
+static inline void ae_quad_culler_init(struct ae_quad_culler* culler, const mat4 view_projection, const enum ae_cull_mode mode)
+{
+	ae_frustum_planes((vec4*)view_projection, culler->planes);
+
+	// the side planes come first, rect culling ignores the depth range
+	culler->plane_count = mode == AE_CULL_FRUSTUM ? 6 : mode == AE_CULL_RECT ? 4 : 0;
+}
+
+static inline bool ae_quad_is_visible(const struct ae_quad_culler* culler, const vec3 position, const vec2 size)
+{
+	for (uint32_t i = 0; i < culler->plane_count; i++)
+	{
+		const float* plane = culler->planes[i];
+
+		// the corner furthest along the normal is the last one to leave the plane
+		float x = plane[0] > 0.0f ? position[0] + size[0] : position[0];
+		float y = plane[1] > 0.0f ? position[1] + size[1] : position[1];
+
+		if (plane[0] * x + plane[1] * y + plane[2] * position[2] + plane[3] < 0.0f)
+			return false;
+	}
+
+	return true;
+}
+
+#ifdef __SSE2__
+// visibility of four quads as bits 0-3. for every plane the x of the furthest corner is left + width when the
+// normal points right, so the distance along the normal is nx * left + max(nx, 0) * width, the same goes for y
+static inline uint32_t ae_quad_cull_sse2(const struct ae_quad_culler* culler, const __m128 left, const __m128 bottom, const __m128 depth, const __m128 width, const __m128 height)
+{
+	__m128 outside = _mm_setzero_ps();
+
+	for (uint32_t i = 0; i < culler->plane_count; i++)
+	{
+		const float* plane = culler->planes[i];
+
+		__m128 x = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane[0]), left), _mm_mul_ps(_mm_set1_ps(plane[0] > 0.0f ? plane[0] : 0.0f), width));
+		__m128 y = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane[1]), bottom), _mm_mul_ps(_mm_set1_ps(plane[1] > 0.0f ? plane[1] : 0.0f), height));
+		__m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane[2]), depth), _mm_set1_ps(plane[3]));
+
+		outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(_mm_add_ps(x, y), z), _mm_setzero_ps()));
+	}
+
+	return ~(uint32_t)_mm_movemask_ps(outside) & 0xf;
+}
+#endif // __SSE2__
+
+// visibility of count quads as bits, count is at most AE_QUAD_CULL_GROUP_SIZE
+static inline uint32_t ae_quad_cull(const struct ae_quad_culler* culler, const struct ae_draw_params* params, const uint32_t count)
+{
+	uint32_t visible = 0;
+	uint32_t i = 0;
+
+#ifdef __SSE2__
+	for (; i + 4 <= count; i += 4)
+	{
+		const struct ae_draw_params* quads = params + i;
+
+		__m128 left = _mm_set_ps(quads[3].position[0], quads[2].position[0], quads[1].position[0], quads[0].position[0]);
+		__m128 bottom = _mm_set_ps(quads[3].position[1], quads[2].position[1], quads[1].position[1], quads[0].position[1]);
+		__m128 depth = _mm_set_ps(quads[3].position[2], quads[2].position[2], quads[1].position[2], quads[0].position[2]);
+		__m128 width = _mm_set_ps(quads[3].size[0], quads[2].size[0], quads[1].size[0], quads[0].size[0]);
+		__m128 height = _mm_set_ps(quads[3].size[1], quads[2].size[1], quads[1].size[1], quads[0].size[1]);
+
+		visible |= ae_quad_cull_sse2(culler, left, bottom, depth, width, height) << i;
+	}
+#endif // __SSE2__
+
+	for (; i < count; i++)
+	{
+		if (ae_quad_is_visible(culler, params[i].position, params[i].size))
+			visible |= 1u << i;
+	}
+
+	return visible;
+}
+
+// ae_quad_cull of the quads [first, first + count) of params
+static inline uint32_t ae_quad_cull_soa(const struct ae_quad_culler* culler, const struct ae_draw_params_soa* params, const uint32_t first, const uint32_t count)
+{
+	uint32_t visible = 0;
+	uint32_t i = 0;
+
+#ifdef __SSE2__
+	for (; i + 4 <= count; i += 4)
+	{
+		const uint32_t index = first + i;
+
+		visible |= ae_quad_cull_sse2(culler,
+			_mm_loadu_ps(params->x + index),
+			_mm_loadu_ps(params->y + index),
+			_mm_loadu_ps(params->z + index),
+			_mm_loadu_ps(params->width + index),
+			_mm_loadu_ps(params->height + index)) << i;
+	}
+#endif // __SSE2__
+
+	for (; i < count; i++)
+	{
+		const uint32_t index = first + i;
+		const vec3 position = { params->x[index], params->y[index], params->z[index] };
+		const vec2 size = { params->width[index], params->height[index] };
+
+		if (ae_quad_is_visible(culler, position, size))
+			visible |= 1u << i;
+	}
+
+	return visible;
+}
+
+// length of the run of set bits starting at bit first
+static inline uint32_t ae_quad_cull_run_length(const uint32_t bits, const uint32_t first, const uint32_t count)
+{
+	uint32_t end = first;
+
+	while (end < count && (bits >> end & 1))
+		end++;
+
+	return end - first;
+}
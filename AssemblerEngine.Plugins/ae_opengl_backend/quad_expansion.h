@@ -0,0 +1,347 @@
+#pragma once
+
+// cpu side quad to vertex expansion of the render batches, kept free of gl calls so the
+// ae_render_bench tool can measure it without a context
+
+#include <apis/renderer.h>
+#include <math/simd/intrin.h>
+
+#include <stdint.h>
+#include <string.h>
+
+// byte layout of the vertices of a batch, built from its ae_vertex_format.
+// the position always comes first as three floats, the other attributes follow packed
+// in the requested format and the stride is padded to 4 bytes.
+struct ae_vertex_layout
+{
+	struct ae_vertex_format format;
+	uint32_t stride;
+	uint32_t color_offset;
+	uint32_t color_size;
+	uint32_t texture_coordinate_offset;
+	uint32_t texture_coordinate_size;
+	uint32_t texture_unit_offset;
+	uint32_t texture_unit_size;
+};
+
+// one quad of an instanced batch, 32 bytes instead of four 48 byte vertices. the vertex
+// shader expands it to the corners of a unit quad using gl_VertexID.
+// texture coordinates are unorm so they have to stay within [0, 1], depth is snorm [-1, 1]
+struct ae_quad_instance
+{
+	float position[2];
+	float size[2];
+	uint16_t texture_rect[4];
+	uint32_t color;
+	uint16_t texture_unit;
+	int16_t depth;
+};
+
+// matches the layout batches used before vertex formats existed
+static const struct ae_vertex_format ae_default_vertex_format =
+{
+	.color = AE_VERTEX_COLOR_FLOAT4,
+	.texture_coordinate = AE_VERTEX_TEXTURE_COORDINATE_FLOAT2,
+	.texture_unit = AE_VERTEX_TEXTURE_UNIT_FLOAT
+};
+
+// texture coordinates of an untextured quad, top left, top right, bottom right, bottom left
+static const vec2 ae_quad_texture_coordinates[4] = { { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f } };
+
+static inline uint16_t ae_quad_pack_unorm16(const float value)
+{
+	float clamped = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+	return (uint16_t)(clamped * 65535.0f + 0.5f);
+}
+
+static inline int16_t ae_quad_pack_snorm16(const float value)
+{
+	float clamped = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+	return (int16_t)(clamped * 32767.0f + (clamped < 0.0f ? -0.5f : 0.5f));
+}
+
+static inline uint32_t ae_quad_pack_color(const vec4 color)
+{
+	uint32_t packed = 0;
+
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		float clamped = color[i] < 0.0f ? 0.0f : (color[i] > 1.0f ? 1.0f : color[i]);
+		packed |= (uint32_t)(clamped * 255.0f + 0.5f) << (i * 8);
+	}
+
+	return packed;
+}
+
+static inline uint16_t ae_quad_pack_half(const float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+	int32_t exponent = (int32_t)((bits >> 23) & 0xff) - 127 + 15;
+	uint32_t mantissa = bits & 0x7fffff;
+
+	// too small for a normal half, texture coordinates that close to 0 are 0
+	if (exponent <= 0)
+		return sign;
+
+	if (exponent >= 31)
+		return sign | 0x7c00;
+
+	// round to nearest
+	uint16_t half = sign | (uint16_t)(exponent << 10) | (uint16_t)(mantissa >> 13);
+
+	if (mantissa & 0x1000)
+		half++;
+
+	return half;
+}
+
+static inline void ae_quad_write_instance(struct ae_quad_instance* instance, const vec4 color, const vec3 position, const vec2 size, const vec4 texture_rect, const float texture_unit)
+{
+	instance->position[0] = position[0];
+	instance->position[1] = position[1];
+	instance->size[0] = size[0];
+	instance->size[1] = size[1];
+	instance->texture_rect[0] = ae_quad_pack_unorm16(texture_rect[0]);
+	instance->texture_rect[1] = ae_quad_pack_unorm16(texture_rect[1]);
+	instance->texture_rect[2] = ae_quad_pack_unorm16(texture_rect[2]);
+	instance->texture_rect[3] = ae_quad_pack_unorm16(texture_rect[3]);
+	instance->color = ae_quad_pack_color(color);
+	instance->texture_unit = (uint16_t)texture_unit;
+	instance->depth = ae_quad_pack_snorm16(position[2]);
+}
+
+static inline void ae_vertex_layout_init(struct ae_vertex_layout* layout, const struct ae_vertex_format* format)
+{
+	layout->format = *format;
+
+	uint32_t offset = 3 * sizeof(float);
+
+	layout->color_offset = offset;
+	layout->color_size = format->color == AE_VERTEX_COLOR_RGBA8 ? 4 : 4 * sizeof(float);
+	offset += layout->color_size;
+
+	layout->texture_coordinate_offset = offset;
+	layout->texture_coordinate_size = format->texture_coordinate == AE_VERTEX_TEXTURE_COORDINATE_FLOAT2 ? 2 * sizeof(float) : 2 * sizeof(uint16_t);
+	offset += layout->texture_coordinate_size;
+
+	layout->texture_unit_offset = offset;
+	layout->texture_unit_size = format->texture_unit == AE_VERTEX_TEXTURE_UNIT_UINT8 ? 1 : sizeof(float);
+	offset += layout->texture_unit_size;
+
+	layout->stride = (offset + 3) & ~3u;
+}
+
+static inline bool ae_vertex_layout_is_default(const struct ae_vertex_layout* layout)
+{
+	return layout->format.color == AE_VERTEX_COLOR_FLOAT4
+		&& layout->format.texture_coordinate == AE_VERTEX_TEXTURE_COORDINATE_FLOAT2
+		&& layout->format.texture_unit == AE_VERTEX_TEXTURE_UNIT_FLOAT;
+}
+
+static inline void ae_quad_pack_texture_coordinate(const struct ae_vertex_layout* layout, const vec2 texture_coordinate, uint8_t* out)
+{
+	uint16_t packed[2];
+
+	switch (layout->format.texture_coordinate)
+	{
+	case AE_VERTEX_TEXTURE_COORDINATE_FLOAT2:
+		memcpy(out, texture_coordinate, 2 * sizeof(float));
+		return;
+	case AE_VERTEX_TEXTURE_COORDINATE_HALF2:
+		packed[0] = ae_quad_pack_half(texture_coordinate[0]);
+		packed[1] = ae_quad_pack_half(texture_coordinate[1]);
+		break;
+	case AE_VERTEX_TEXTURE_COORDINATE_UNORM16:
+		packed[0] = ae_quad_pack_unorm16(texture_coordinate[0]);
+		packed[1] = ae_quad_pack_unorm16(texture_coordinate[1]);
+		break;
+	}
+
+	memcpy(out, packed, sizeof(packed));
+}
+
+// writes the four corners of a quad, color and texture unit are packed once per quad.
+// returns the end of the written vertices
+static inline uint8_t* ae_quad_write(const struct ae_vertex_layout* layout, uint8_t* out, const vec4 color, const vec3 position, const vec2 size, const vec2 texture_coordinates[4], const float texture_unit)
+{
+	uint8_t packed_color[4 * sizeof(float)];
+	uint8_t packed_texture_unit[sizeof(float)];
+
+	if (layout->format.color == AE_VERTEX_COLOR_RGBA8)
+	{
+		uint32_t rgba = ae_quad_pack_color(color);
+		memcpy(packed_color, &rgba, sizeof(rgba));
+	}
+	else
+	{
+		memcpy(packed_color, color, 4 * sizeof(float));
+	}
+
+	if (layout->format.texture_unit == AE_VERTEX_TEXTURE_UNIT_UINT8)
+		packed_texture_unit[0] = (uint8_t)texture_unit;
+	else
+		memcpy(packed_texture_unit, &texture_unit, sizeof(float));
+
+	// top left, top right, bottom right, bottom left
+	const float corners[4][3] = {
+		{ position[0],				position[1] + size[1],	position[2] },
+		{ position[0] + size[0],	position[1] + size[1],	position[2] },
+		{ position[0] + size[0],	position[1],			position[2] },
+		{ position[0],				position[1],			position[2] }
+	};
+
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		memcpy(out, corners[i], sizeof(corners[i]));
+		memcpy(out + layout->color_offset, packed_color, layout->color_size);
+		ae_quad_pack_texture_coordinate(layout, texture_coordinates[i], out + layout->texture_coordinate_offset);
+		memcpy(out + layout->texture_unit_offset, packed_texture_unit, layout->texture_unit_size);
+
+		out += layout->stride;
+	}
+
+	return out;
+}
+
+static inline uint8_t* ae_quad_write_soa(const struct ae_vertex_layout* layout, uint8_t* out, const struct ae_draw_params_soa* params, const uint32_t index)
+{
+	vec3 position = { params->x[index], params->y[index], params->z[index] };
+	vec2 size = { params->width[index], params->height[index] };
+
+	return ae_quad_write(layout, out, params->color[index], position, size, ae_quad_texture_coordinates, 0.0f);
+}
+
+#ifdef __SSE2__
+// the sse2 kernels only handle the default layout, 40 byte vertices of ten floats:
+// x y z | r g b a | u v | unit
+// xy01 holds the top left and top right corner, xy23 the bottom right and bottom left one,
+// zr is (z, r, -, -) and gba is (g, b, a, 0)
+static inline float* ae_quad_emit_sse2(float* out, const __m128 xy01, const __m128 xy23, const __m128 zr, const __m128 gba)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 v = _mm_set_ss(1.0f);
+	const __m128 gbau = _mm_add_ps(gba, _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f));
+
+	_mm_storeu_ps(out, _mm_movelh_ps(xy01, zr));
+	_mm_storeu_ps(out + 4, gba);
+	_mm_storel_pi((__m64*)(out + 8), zero);
+
+	_mm_storeu_ps(out + 10, _mm_shuffle_ps(xy01, zr, _MM_SHUFFLE(1, 0, 3, 2)));
+	_mm_storeu_ps(out + 14, gbau);
+	_mm_storel_pi((__m64*)(out + 18), zero);
+
+	_mm_storeu_ps(out + 20, _mm_movelh_ps(xy23, zr));
+	_mm_storeu_ps(out + 24, gbau);
+	_mm_storel_pi((__m64*)(out + 28), v);
+
+	_mm_storeu_ps(out + 30, _mm_shuffle_ps(xy23, zr, _MM_SHUFFLE(1, 0, 3, 2)));
+	_mm_storeu_ps(out + 34, gba);
+	_mm_storel_pi((__m64*)(out + 38), v);
+
+	return out + 40;
+}
+
+static inline __m128 ae_quad_gba_sse2(const __m128 color)
+{
+	const __m128 mask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+	return _mm_and_ps(_mm_shuffle_ps(color, color, _MM_SHUFFLE(0, 3, 2, 1)), mask);
+}
+
+static inline void ae_quad_expand_sse2(float* out, const struct ae_draw_params* params, const uint32_t count)
+{
+	// adds the size to every lane but the left x, or only to the right x
+	const __m128 top_mask = _mm_castsi128_ps(_mm_set_epi32(-1, -1, -1, 0));
+	const __m128 bottom_mask = _mm_castsi128_ps(_mm_set_epi32(0, 0, 0, -1));
+	const __m128 zero = _mm_setzero_ps();
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const struct ae_draw_params* quad = &params[i];
+
+		__m128 xy = _mm_loadl_pi(zero, (const __m64*)quad->position);
+		__m128 size = _mm_loadl_pi(zero, (const __m64*)quad->size);
+		__m128 color = _mm_loadu_ps(quad->color);
+
+		xy = _mm_movelh_ps(xy, xy);
+		size = _mm_movelh_ps(size, size);
+
+		__m128 xy01 = _mm_add_ps(xy, _mm_and_ps(size, top_mask));
+		__m128 xy23 = _mm_add_ps(xy, _mm_and_ps(size, bottom_mask));
+		__m128 zr = _mm_unpacklo_ps(_mm_load_ss(&quad->position[2]), color);
+
+		out = ae_quad_emit_sse2(out, xy01, xy23, zr, ae_quad_gba_sse2(color));
+	}
+}
+
+// four quads per iteration, the corners are computed for all four at once and transposed
+static inline uint32_t ae_quad_expand_soa_sse2(float* out, const struct ae_draw_params_soa* params, const uint32_t first, const uint32_t count)
+{
+	uint32_t i = 0;
+
+	for (; i + 4 <= count; i += 4)
+	{
+		const uint32_t index = first + i;
+
+		__m128 left = _mm_loadu_ps(params->x + index);
+		__m128 bottom = _mm_loadu_ps(params->y + index);
+		__m128 right = _mm_add_ps(left, _mm_loadu_ps(params->width + index));
+		__m128 top = _mm_add_ps(bottom, _mm_loadu_ps(params->height + index));
+
+		// (x, y) pairs of one corner for two quads
+		__m128 top_left[2] = { _mm_unpacklo_ps(left, top), _mm_unpackhi_ps(left, top) };
+		__m128 top_right[2] = { _mm_unpacklo_ps(right, top), _mm_unpackhi_ps(right, top) };
+		__m128 bottom_right[2] = { _mm_unpacklo_ps(right, bottom), _mm_unpackhi_ps(right, bottom) };
+		__m128 bottom_left[2] = { _mm_unpacklo_ps(left, bottom), _mm_unpackhi_ps(left, bottom) };
+
+		for (uint32_t j = 0; j < 2; j++)
+		{
+			__m128 color = _mm_loadu_ps(params->color[index + j * 2]);
+			__m128 zr = _mm_unpacklo_ps(_mm_load_ss(params->z + index + j * 2), color);
+
+			out = ae_quad_emit_sse2(out, _mm_movelh_ps(top_left[j], top_right[j]), _mm_movelh_ps(bottom_right[j], bottom_left[j]), zr, ae_quad_gba_sse2(color));
+
+			color = _mm_loadu_ps(params->color[index + j * 2 + 1]);
+			zr = _mm_unpacklo_ps(_mm_load_ss(params->z + index + j * 2 + 1), color);
+
+			out = ae_quad_emit_sse2(out, _mm_movehl_ps(top_right[j], top_left[j]), _mm_movehl_ps(bottom_left[j], bottom_right[j]), zr, ae_quad_gba_sse2(color));
+		}
+	}
+
+	return i;
+}
+#endif // __SSE2__
+
+// expands count untextured quads into out, which must hold 4 * count vertices
+static inline void ae_quad_expand(const struct ae_vertex_layout* layout, uint8_t* out, const struct ae_draw_params* params, const uint32_t count)
+{
+#ifdef __SSE2__
+	if (ae_vertex_layout_is_default(layout))
+	{
+		ae_quad_expand_sse2((float*)out, params, count);
+		return;
+	}
+#endif // __SSE2__
+
+	for (uint32_t i = 0; i < count; i++)
+		out = ae_quad_write(layout, out, params[i].color, params[i].position, params[i].size, ae_quad_texture_coordinates, 0.0f);
+}
+
+// expands the quads [first, first + count) of params into out
+static inline void ae_quad_expand_soa(const struct ae_vertex_layout* layout, uint8_t* out, const struct ae_draw_params_soa* params, const uint32_t first, const uint32_t count)
+{
+	uint32_t i = 0;
+
+#ifdef __SSE2__
+	if (ae_vertex_layout_is_default(layout))
+	{
+		i = ae_quad_expand_soa_sse2((float*)out, params, first, count);
+		out += (size_t)i * 4 * layout->stride;
+	}
+#endif // __SSE2__
+
+	for (; i < count; i++)
+		out = ae_quad_write_soa(layout, out, params, first + i);
+}
@@ -0,0 +1,583 @@
+#include "render_batch.h"
+
+#include <apis/camera.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+// planes of the camera of the current frame, no plane is set before the first render_scene_start
+struct ae_render_culling
+{
+	// the camera the planes are made from, quads are drawn with it whatever camera their params name
+	const struct ae_camera* camera;
+	mat4 view_projection;
+	struct ae_quad_culler rect;
+	struct ae_quad_culler frustum;
+	struct ae_render_cull_stats frame;
+	struct ae_render_cull_stats last_frame;
+};
+
+static struct ae_render_culling culling;
+
+static uint32_t hash_texture(const struct ae_render_batch* batch, const uint32_t texture)
+{
+	return (texture * 2654435761u) & (batch->texture_slot_count - 1);
+}
+
+// finds or assigns the index of a texture, false once every index is in use or the device can not bind it
+static bool get_texture_index(struct ae_render_batch* batch, const uint32_t texture, uint32_t* index)
+{
+	// 0 is no texture, the white one
+	if (!texture)
+	{
+		*index = 0;
+		return true;
+	}
+
+	uint32_t slot = hash_texture(batch, texture);
+
+	while (batch->texture_slots[slot].texture)
+	{
+		if (batch->texture_slots[slot].texture == texture)
+		{
+			*index = batch->texture_slots[slot].index;
+			return true;
+		}
+
+		slot = (slot + 1) & (batch->texture_slot_count - 1);
+	}
+
+	if (batch->current_texture_count >= batch->total_texture_count)
+		return false;
+
+	vec2 scale = { 1.0f, 1.0f };
+
+	if (!batch->device->bind_texture(batch, texture, batch->current_texture_count, scale))
+		return false;
+
+	*index = batch->current_texture_count++;
+	batch->textures[*index] = texture;
+	batch->texture_slots[slot].texture = texture;
+	batch->texture_slots[slot].index = *index;
+
+	if (batch->texture_scales)
+	{
+		batch->texture_scales[*index][0] = scale[0];
+		batch->texture_scales[*index][1] = scale[1];
+	}
+
+	return true;
+}
+
+// the white texture of untextured draws always has index 0
+static void reset_texture_slots(struct ae_render_batch* batch)
+{
+	batch->device->release_textures(batch);
+
+	memset(batch->texture_slots, 0, sizeof(*batch->texture_slots) * batch->texture_slot_count);
+	batch->current_texture_count = 0;
+	batch->texture_generation = batch->device->get_texture_generation();
+
+	vec2 scale = { 1.0f, 1.0f };
+	batch->device->bind_texture(batch, batch->white_texture, 0, scale);
+	batch->textures[0] = batch->white_texture;
+	batch->current_texture_count = 1;
+
+	if (batch->texture_scales)
+	{
+		batch->texture_scales[0][0] = 1.0f;
+		batch->texture_scales[0][1] = 1.0f;
+	}
+
+	if (batch->white_texture)
+	{
+		uint32_t slot = hash_texture(batch, batch->white_texture);
+		batch->texture_slots[slot].texture = batch->white_texture;
+		batch->texture_slots[slot].index = 0;
+	}
+}
+
+// every draw call of the batch is done before the handles or layers are reused
+static void recycle_texture_slots(struct ae_render_batch* batch)
+{
+	ae_render_batch_flush(batch);
+	ae_render_batch_submit(batch);
+	batch->device->wait_idle(batch);
+
+	reset_texture_slots(batch);
+}
+
+static void test_batch(struct ae_render_batch* batch)
+{
+	if (batch->current_quad_count >= batch->total_quad_count)
+		ae_render_batch_flush(batch);
+}
+
+static uint8_t* get_quad(const struct ae_render_batch* batch)
+{
+	return batch->vertices + (size_t)batch->current_quad_count * batch->quad_size;
+}
+
+static void write_instance(struct ae_render_batch* batch, const vec4 color, const vec3 position, const vec2 size, const vec4 texture_rect, const float texture_unit)
+{
+	ae_quad_write_instance((struct ae_quad_instance*)get_quad(batch), color, position, size, texture_rect, texture_unit);
+	batch->current_quad_count++;
+}
+
+// writes the four corners of a quad, color and texture unit are packed once per quad
+static void write_quad(struct ae_render_batch* batch, const vec4 color, const vec3 position, const vec2 size, const vec2 texture_coordinates[4], const float texture_unit)
+{
+	ae_quad_write(&batch->layout, get_quad(batch), color, position, size, texture_coordinates, texture_unit);
+	batch->current_quad_count++;
+}
+
+static const struct ae_quad_culler* get_culler(const struct ae_render_batch* batch)
+{
+	switch (batch->cull_mode)
+	{
+	case AE_CULL_RECT:
+		return &culling.rect;
+	case AE_CULL_FRUSTUM:
+		return &culling.frustum;
+	default:
+		return NULL;
+	}
+}
+
+static void count_culled(const uint32_t submitted_count, const uint32_t culled_count)
+{
+	culling.frame.submitted_count += submitted_count;
+	culling.frame.culled_count += culled_count;
+}
+
+// the planes only hold for quads of the scene camera, other ones are never culled
+static bool is_scene_camera(const struct ae_camera* camera)
+{
+	return !camera || camera == culling.camera || !memcmp(camera->view_projection, culling.view_projection, sizeof(culling.view_projection));
+}
+
+// quads of a group that are not of the scene camera as visible bits
+static uint32_t get_other_cameras(const struct ae_draw_params* params, const uint32_t count)
+{
+	uint32_t bits = 0;
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		if (!is_scene_camera(params[i].camera))
+			bits |= 1u << i;
+	}
+
+	return bits;
+}
+
+// false if the quad is outside the view of a culling batch
+static bool cull_quad(const struct ae_render_batch* batch, const struct ae_camera* camera, const vec3 position, const vec2 size)
+{
+	const struct ae_quad_culler* culler = get_culler(batch);
+
+	if (!culler)
+		return true;
+
+	const bool visible = !is_scene_camera(camera) || ae_quad_is_visible(culler, position, size);
+	count_culled(visible, !visible);
+
+	return visible;
+}
+
+// flushes if needed and returns how many of the remaining quads go into the next chunk
+static uint32_t begin_chunk(struct ae_render_batch* batch, const uint32_t remaining)
+{
+	test_batch(batch);
+
+	uint32_t free_count = batch->total_quad_count - batch->current_quad_count;
+
+	return remaining < free_count ? remaining : free_count;
+}
+
+static void draw_many(struct ae_render_batch* batch, const struct ae_draw_params* params, const uint32_t count)
+{
+	uint32_t drawn = 0;
+
+	while (drawn < count)
+	{
+		uint32_t chunk = begin_chunk(batch, count - drawn);
+		const struct ae_draw_params* quads = params + drawn;
+
+		if (batch->instanced)
+		{
+			for (uint32_t i = 0; i < chunk; i++)
+				write_instance(batch, quads[i].color, quads[i].position, quads[i].size, (vec4){ 0.0f, 0.0f, 1.0f, 1.0f }, 0.0f);
+		}
+		else
+		{
+			ae_quad_expand(&batch->layout, get_quad(batch), quads, chunk);
+			batch->current_quad_count += chunk;
+		}
+
+		drawn += chunk;
+	}
+}
+
+static void draw_many_soa(struct ae_render_batch* batch, const struct ae_draw_params_soa* params, const uint32_t first, const uint32_t count)
+{
+	uint32_t drawn = first;
+
+	while (drawn < first + count)
+	{
+		uint32_t chunk = begin_chunk(batch, first + count - drawn);
+
+		if (batch->instanced)
+		{
+			for (uint32_t i = drawn; i < drawn + chunk; i++)
+			{
+				vec3 position = { params->x[i], params->y[i], params->z[i] };
+				vec2 size = { params->width[i], params->height[i] };
+
+				write_instance(batch, params->color[i], position, size, (vec4){ 0.0f, 0.0f, 1.0f, 1.0f }, 0.0f);
+			}
+		}
+		else
+		{
+			ae_quad_expand_soa(&batch->layout, get_quad(batch), params, drawn, chunk);
+			batch->current_quad_count += chunk;
+		}
+
+		drawn += chunk;
+	}
+}
+
+void ae_render_batch_init(struct ae_render_batch* batch, const struct ae_render_device* device, const uint32_t max_quad_count, const struct ae_vertex_format* format, const bool instanced)
+{
+	memset(batch, 0, sizeof(*batch));
+	ae_vertex_layout_init(&batch->layout, format ? format : &ae_default_vertex_format);
+
+	batch->device = device;
+	batch->instanced = instanced;
+	batch->total_quad_count = max_quad_count;
+	batch->quad_size = instanced ? sizeof(struct ae_quad_instance) : batch->layout.stride * 4;
+	batch->texture_binding = AE_TEXTURE_BINDING_UNITS;
+	batch->cull_mode = AE_CULL_NONE;
+	batch->region_count = AE_RENDER_BATCH_REGION_COUNT;
+}
+
+bool ae_render_batch_is_texture_binding_valid(const struct ae_texture_binding_desc* desc)
+{
+	if (desc->binding != AE_TEXTURE_BINDING_ARRAY)
+		return desc->binding == AE_TEXTURE_BINDING_UNITS || desc->binding == AE_TEXTURE_BINDING_BINDLESS;
+
+	// layer 0 is the white texture, one more is needed to draw anything textured
+	return desc->layer_width && desc->layer_height && desc->layer_count >= 2;
+}
+
+uint32_t ae_render_batch_get_texture_count(const struct ae_render_batch* batch, const uint32_t count)
+{
+	// floats hold every integer up to 2^24
+	uint32_t max_count = 1u << 24;
+
+	if (batch->instanced)
+		max_count = UINT16_MAX + 1;
+	else if (batch->layout.format.texture_unit == AE_VERTEX_TEXTURE_UNIT_UINT8)
+		max_count = UINT8_MAX + 1;
+
+	return count < max_count ? count : max_count;
+}
+
+bool ae_render_batch_create_textures(struct ae_render_batch* batch, const enum ae_texture_binding binding, const uint32_t count)
+{
+	const uint32_t texture_count = ae_render_batch_get_texture_count(batch, count);
+
+	if (texture_count == 0)
+		return false;
+
+	// keeps the map at most half full
+	uint32_t slot_count = 2;
+
+	while (slot_count < texture_count * 2)
+		slot_count *= 2;
+
+	batch->textures = malloc(sizeof(*batch->textures) * texture_count);
+	batch->texture_slots = calloc(slot_count, sizeof(*batch->texture_slots));
+	batch->texture_scales = binding == AE_TEXTURE_BINDING_ARRAY ? malloc(sizeof(*batch->texture_scales) * texture_count) : NULL;
+
+	if (!batch->textures || !batch->texture_slots || (binding == AE_TEXTURE_BINDING_ARRAY && !batch->texture_scales))
+	{
+		ae_render_batch_release_textures(batch);
+		return false;
+	}
+
+	batch->texture_binding = binding;
+	batch->total_texture_count = texture_count;
+	batch->texture_slot_count = slot_count;
+	batch->current_texture_count = 0;
+
+	reset_texture_slots(batch);
+
+	return true;
+}
+
+void ae_render_batch_release_textures(struct ae_render_batch* batch)
+{
+	if (batch->textures)
+		batch->device->release_textures(batch);
+
+	free(batch->textures);
+	free(batch->texture_slots);
+	free(batch->texture_scales);
+
+	batch->textures = NULL;
+	batch->texture_slots = NULL;
+	batch->texture_scales = NULL;
+	batch->total_texture_count = 0;
+	batch->current_texture_count = 0;
+	batch->texture_binding = AE_TEXTURE_BINDING_UNITS;
+}
+
+void ae_render_batch_flush(struct ae_render_batch* batch)
+{
+	if (batch->current_quad_count)
+	{
+		const struct ae_render_region region = { .region = batch->current_region, .quad_count = batch->current_quad_count };
+
+		if (batch->indirect)
+		{
+			batch->pending[batch->pending_count++] = region;
+
+			// one region stays out of the call, it is written while the gpu draws the others
+			if (batch->pending_count + 1 >= batch->region_count)
+				ae_render_batch_submit(batch);
+		}
+		else
+		{
+			batch->device->draw(batch, &region);
+			batch->stats.draw_call_count++;
+		}
+
+		batch->current_region = (batch->current_region + 1) % batch->region_count;
+		batch->stats.flush_count++;
+		batch->vertices = batch->device->acquire_region(batch, batch->current_region);
+	}
+
+	batch->current_quad_count = 0;
+
+	// handles and layers stay valid over flushes, units are bound again for every draw call.
+	// recorded regions are drawn with the units they were written with, those stay until the submit
+	if (batch->texture_binding == AE_TEXTURE_BINDING_UNITS && !batch->indirect)
+		reset_texture_slots(batch);
+}
+
+// draws every recorded region with one call
+void ae_render_batch_submit(struct ae_render_batch* batch)
+{
+	if (batch->pending_count)
+	{
+		batch->device->submit(batch, batch->pending, batch->pending_count);
+		batch->pending_count = 0;
+		batch->stats.draw_call_count++;
+	}
+
+	if (batch->texture_binding == AE_TEXTURE_BINDING_UNITS && batch->indirect)
+		reset_texture_slots(batch);
+}
+
+void ae_render_culling_set_camera(const struct ae_camera* camera)
+{
+	culling.camera = camera;
+	memcpy(culling.view_projection, camera->view_projection, sizeof(culling.view_projection));
+	ae_quad_culler_init(&culling.rect, camera->view_projection, AE_CULL_RECT);
+	ae_quad_culler_init(&culling.frustum, camera->view_projection, AE_CULL_FRUSTUM);
+}
+
+void ae_render_culling_end_frame()
+{
+	culling.last_frame = culling.frame;
+	culling.frame = (struct ae_render_cull_stats){ 0 };
+}
+
+void ae_render_batch_start(const struct ae_render_batch* batch)
+{
+	batch->device->start(batch);
+}
+
+void ae_render_batch_end(struct ae_render_batch* batch)
+{
+	ae_render_batch_flush(batch);
+	ae_render_batch_submit(batch);
+	batch->device->end(batch);
+}
+
+void ae_render_batch_draw(struct ae_render_batch* batch, struct ae_draw_params* const params)
+{
+	if (!cull_quad(batch, params->camera, params->position, params->size))
+		return;
+
+	test_batch(batch);
+
+	if (batch->instanced)
+	{
+		write_instance(batch, params->color, params->position, params->size, (vec4){ 0.0f, 0.0f, 1.0f, 1.0f }, 0.0f);
+		return;
+	}
+
+	write_quad(batch, params->color, params->position, params->size, ae_quad_texture_coordinates, 0.0f);
+}
+
+void ae_render_batch_draw_textured(struct ae_render_batch* batch, struct ae_textured_draw_params* const params)
+{
+	if (!cull_quad(batch, params->camera, params->position, params->size))
+		return;
+
+	test_batch(batch);
+
+	// layers copied before a texture changed hold the old texels, the quads already written still use them
+	if (batch->texture_binding == AE_TEXTURE_BINDING_ARRAY && batch->texture_generation != batch->device->get_texture_generation())
+	{
+		ae_render_batch_flush(batch);
+		ae_render_batch_submit(batch);
+		reset_texture_slots(batch);
+	}
+
+	uint32_t index;
+
+	if (!get_texture_index(batch, params->texture, &index))
+	{
+		if (batch->texture_binding == AE_TEXTURE_BINDING_UNITS)
+		{
+			ae_render_batch_flush(batch);
+			ae_render_batch_submit(batch);
+		}
+		else
+			recycle_texture_slots(batch);
+
+		// a texture the device can not bind is not drawn
+		if (!get_texture_index(batch, params->texture, &index))
+			return;
+	}
+
+	vec2 texture_coordinates[4];
+	memcpy(texture_coordinates, params->texture_coordinates, sizeof(texture_coordinates));
+
+	// textures smaller than a layer only cover its top left part
+	if (batch->texture_scales)
+	{
+		for (uint32_t i = 0; i < 4; i++)
+		{
+			texture_coordinates[i][0] *= batch->texture_scales[index][0];
+			texture_coordinates[i][1] *= batch->texture_scales[index][1];
+		}
+	}
+
+	if (batch->instanced)
+	{
+		// left/right from the top corners, top/bottom from the left corners
+		vec4 texture_rect = {
+			texture_coordinates[0][0],
+			texture_coordinates[0][1],
+			texture_coordinates[1][0],
+			texture_coordinates[3][1]
+		};
+
+		write_instance(batch, params->color, params->position, params->size, texture_rect, (float)index);
+		return;
+	}
+
+	write_quad(batch, params->color, params->position, params->size, (const vec2*)texture_coordinates, (float)index);
+}
+
+void ae_render_batch_draw_many(struct ae_render_batch* batch, const struct ae_draw_params* params, const uint32_t count)
+{
+	const struct ae_quad_culler* culler = get_culler(batch);
+
+	if (!culler)
+	{
+		draw_many(batch, params, count);
+		return;
+	}
+
+	// runs of visible quads are still expanded together
+	for (uint32_t group = 0; group < count; group += AE_QUAD_CULL_GROUP_SIZE)
+	{
+		const uint32_t group_count = count - group < AE_QUAD_CULL_GROUP_SIZE ? count - group : AE_QUAD_CULL_GROUP_SIZE;
+		const uint32_t visible = ae_quad_cull(culler, params + group, group_count) | get_other_cameras(params + group, group_count);
+		uint32_t submitted_count = 0;
+
+		for (uint32_t i = 0; i < group_count; i++)
+		{
+			uint32_t run = ae_quad_cull_run_length(visible, i, group_count);
+
+			if (run)
+			{
+				draw_many(batch, params + group + i, run);
+				submitted_count += run;
+				i += run;
+			}
+		}
+
+		count_culled(submitted_count, group_count - submitted_count);
+	}
+}
+
+void ae_render_batch_draw_many_soa(struct ae_render_batch* batch, const struct ae_draw_params_soa* params, const uint32_t count)
+{
+	const struct ae_quad_culler* culler = get_culler(batch);
+
+	if (!culler)
+	{
+		draw_many_soa(batch, params, 0, count);
+		return;
+	}
+
+	for (uint32_t group = 0; group < count; group += AE_QUAD_CULL_GROUP_SIZE)
+	{
+		const uint32_t group_count = count - group < AE_QUAD_CULL_GROUP_SIZE ? count - group : AE_QUAD_CULL_GROUP_SIZE;
+		const uint32_t visible = ae_quad_cull_soa(culler, params, group, group_count);
+		uint32_t submitted_count = 0;
+
+		for (uint32_t i = 0; i < group_count; i++)
+		{
+			uint32_t run = ae_quad_cull_run_length(visible, i, group_count);
+
+			if (run)
+			{
+				draw_many_soa(batch, params, group + i, run);
+				submitted_count += run;
+				i += run;
+			}
+		}
+
+		count_culled(submitted_count, group_count - submitted_count);
+	}
+}
+
+void ae_render_batch_set_culling(struct ae_render_batch* batch, const enum ae_cull_mode mode)
+{
+	batch->cull_mode = mode;
+}
+
+// indirect batches get a longer ring so more flushes fit in one multi draw, without it they draw
+// indirect with the regions they have
+void ae_render_batch_set_indirect(struct ae_render_batch* batch, const bool enabled)
+{
+	const uint32_t region_count = enabled ? AE_RENDER_BATCH_INDIRECT_REGION_COUNT : AE_RENDER_BATCH_REGION_COUNT;
+
+	ae_render_batch_flush(batch);
+	ae_render_batch_submit(batch);
+
+	if (region_count != batch->region_count && batch->device->set_region_count(batch, region_count))
+	{
+		batch->region_count = region_count;
+		batch->current_region = 0;
+		batch->vertices = batch->device->acquire_region(batch, 0);
+	}
+
+	batch->indirect = enabled;
+}
+
+void ae_render_batch_get_stats(const struct ae_render_batch* batch, struct ae_render_batch_stats* stats)
+{
+	*stats = batch->stats;
+}
+
+void ae_render_get_cull_stats(struct ae_render_cull_stats* stats)
+{
+	*stats = culling.last_frame;
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+// the cpu side of render batches, kept free of gl calls so the null renderer runs the same code.
+// quads are culled, packed into the region of the vertex buffer that is being written and flushed
+// at the same points whatever the backend is. a backend puts the batch first in its own struct and
+// does the device work (waiting for regions, draw calls, texture bindings) through a device table
+
+#include "quad_culling.h"
+#include "quad_expansion.h"
+
+#include <apis/renderer.h>
+#include <core/types.h>
+
+// amount of vertex buffer regions, the gpu reads one while the next ones are written
+#ifndef AE_RENDER_BATCH_REGION_COUNT
+#define AE_RENDER_BATCH_REGION_COUNT 3
+#endif // !AE_RENDER_BATCH_REGION_COUNT
+
+// regions of a batch in indirect mode, the flushes written to all but one of them are drawn with one call
+#ifndef AE_RENDER_BATCH_INDIRECT_REGION_COUNT
+#define AE_RENDER_BATCH_INDIRECT_REGION_COUNT 16
+#endif // !AE_RENDER_BATCH_INDIRECT_REGION_COUNT
+
+#if AE_RENDER_BATCH_INDIRECT_REGION_COUNT < AE_RENDER_BATCH_REGION_COUNT
+#error "AE_RENDER_BATCH_INDIRECT_REGION_COUNT can not be below AE_RENDER_BATCH_REGION_COUNT"
+#endif
+
+// handles in the shader storage buffer of a bindless batch
+#ifndef AE_RENDER_BATCH_MAX_BINDLESS_TEXTURES
+#define AE_RENDER_BATCH_MAX_BINDLESS_TEXTURES 4096
+#endif // !AE_RENDER_BATCH_MAX_BINDLESS_TEXTURES
+
+struct ae_render_batch;
+
+// one flush, the quads written to a region
+struct ae_render_region
+{
+	uint32_t region;
+	uint32_t quad_count;
+};
+
+// what a backend does when the batch needs the device, called on the render thread
+struct ae_render_device
+{
+	// waits until the device is done reading the region, the quads of the batch are written to the returned memory
+	uint8_t* (*acquire_region)(struct ae_render_batch* batch, const uint32_t region);
+	void (*draw)(struct ae_render_batch* batch, const struct ae_render_region* region);
+	// draws the regions flushed in indirect mode with one call
+	void (*submit)(struct ae_render_batch* batch, const struct ae_render_region* regions, const uint32_t count);
+	// replaces the vertex memory with region_count regions, nothing of the batch is pending. false keeps the old regions
+	bool (*set_region_count)(struct ae_render_batch* batch, const uint32_t region_count);
+	// waits until no draw of the batch reads its textures anymore
+	void (*wait_idle)(struct ae_render_batch* batch);
+	// makes the texture readable at index, scale is the part of an array layer it covers. false if it can not be bound
+	bool (*bind_texture)(struct ae_render_batch* batch, const uint32_t texture, const uint32_t index, vec2 scale);
+	// the textures below current_texture_count are not used anymore
+	void (*release_textures)(struct ae_render_batch* batch);
+	// changes when texels change, array layers are copied again once it moved
+	uint64_t (*get_texture_generation)(void);
+	void (*start)(const struct ae_render_batch* batch);
+	void (*end)(struct ae_render_batch* batch);
+};
+
+// open addressing map from texture id to the index the shader reads, 0 marks a free slot
+struct ae_texture_slot
+{
+	uint32_t texture;
+	uint32_t index;
+};
+
+struct ae_render_batch
+{
+	const struct ae_render_device* device;
+	// the region being written
+	uint8_t* vertices;
+	uint32_t* textures;
+	struct ae_texture_slot* texture_slots;
+	// array layers only
+	vec2* texture_scales;
+	struct ae_render_region pending[AE_RENDER_BATCH_INDIRECT_REGION_COUNT];
+	struct ae_render_batch_stats stats;
+	struct ae_vertex_layout layout;
+	// texture generation of the last reset of the texture slots
+	uint64_t texture_generation;
+	uint32_t quad_size;
+	uint32_t total_quad_count;
+	uint32_t current_quad_count;
+	uint32_t total_texture_count;
+	uint32_t current_texture_count;
+	uint32_t texture_slot_count;
+	uint32_t current_region;
+	uint32_t region_count;
+	// flushes made in indirect mode that were not drawn yet
+	uint32_t pending_count;
+	// has index 0, 0 if the shader treats index 0 as white on its own
+	uint32_t white_texture;
+	enum ae_texture_binding texture_binding;
+	enum ae_cull_mode cull_mode;
+	bool instanced;
+	bool indirect;
+};
+
+// sets up the cpu side, the backend creates its buffers and acquires region 0 after it
+void ae_render_batch_init(struct ae_render_batch* batch, const struct ae_render_device* device, const uint32_t max_quad_count, const struct ae_vertex_format* format, const bool instanced);
+
+// array bindings need two layers, the first holds the white texture. the device checks its own limits
+bool ae_render_batch_is_texture_binding_valid(const struct ae_texture_binding_desc* desc);
+
+// count clamped to the indices the texture unit attribute holds
+uint32_t ae_render_batch_get_texture_count(const struct ae_render_batch* batch, const uint32_t count);
+
+// allocates the texture indices and binds the white texture at 0, the device has to be ready to bind textures the new way
+bool ae_render_batch_create_textures(struct ae_render_batch* batch, const enum ae_texture_binding binding, const uint32_t count);
+
+// releases the bound textures and goes back to texture units without indices, create_textures has to follow
+void ae_render_batch_release_textures(struct ae_render_batch* batch);
+
+void ae_render_batch_flush(struct ae_render_batch* batch);
+void ae_render_batch_submit(struct ae_render_batch* batch);
+
+// the planes of the camera batches cull against and the culling counters of the frame
+void ae_render_culling_set_camera(const struct ae_camera* camera);
+void ae_render_culling_end_frame();
+
+// the functions of ae_renderer_api that only need the cpu side
+void ae_render_batch_start(const struct ae_render_batch* batch);
+void ae_render_batch_end(struct ae_render_batch* batch);
+void ae_render_batch_draw(struct ae_render_batch* batch, struct ae_draw_params* const params);
+void ae_render_batch_draw_textured(struct ae_render_batch* batch, struct ae_textured_draw_params* const params);
+void ae_render_batch_draw_many(struct ae_render_batch* batch, const struct ae_draw_params* params, const uint32_t count);
+void ae_render_batch_draw_many_soa(struct ae_render_batch* batch, const struct ae_draw_params_soa* params, const uint32_t count);
+void ae_render_batch_set_culling(struct ae_render_batch* batch, const enum ae_cull_mode mode);
+void ae_render_batch_set_indirect(struct ae_render_batch* batch, const bool enabled);
+void ae_render_batch_get_stats(const struct ae_render_batch* batch, struct ae_render_batch_stats* stats);
+void ae_render_get_cull_stats(struct ae_render_cull_stats* stats);
@@ -0,0 +1,376 @@
+#include "render_queue.h"
+
+#include <apis/renderer.h>
+#include <core/clock.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+// sort key, from the most to the least significant bits:
+// layer 8 | batch 12 | blend 4 | texture 16 | depth 24
+#define AE_RENDER_KEY_DEPTH_BITS 24
+#define AE_RENDER_KEY_TEXTURE_SHIFT 24
+#define AE_RENDER_KEY_BLEND_SHIFT 40
+#define AE_RENDER_KEY_BATCH_SHIFT 44
+#define AE_RENDER_KEY_LAYER_SHIFT 56
+
+// the batch part of the key indexes the batches a queue has seen
+#define AE_RENDER_QUEUE_MAX_BATCHES 4096
+
+#ifndef AE_RENDER_QUEUE_DEFAULT_CAPACITY
+#define AE_RENDER_QUEUE_DEFAULT_CAPACITY 1024
+#endif // !AE_RENDER_QUEUE_DEFAULT_CAPACITY
+
+// untextured draws are stored with texture 0
+struct ae_render_command
+{
+	struct ae_textured_draw_params params;
+	uint32_t batch;
+};
+
+struct ae_render_sort_entry
+{
+	uint64_t key;
+	uint32_t command;
+};
+
+struct ae_render_queue
+{
+	struct ae_render_command* commands;
+	struct ae_render_sort_entry* entries;
+	struct ae_render_sort_entry* scratch;
+	struct ae_render_batch** batches;
+	struct ae_render_queue_stats stats;
+	uint32_t count;
+	uint32_t capacity;
+	uint32_t batch_count;
+	uint32_t last_batch;
+	uint32_t dropped_count;
+};
+
+static const struct ae_renderer_api* renderer;
+
+// maps the float bits so they compare like integers and keeps the most significant ones
+static uint64_t get_depth_key(const float depth)
+{
+	uint32_t bits;
+	memcpy(&bits, &depth, sizeof(bits));
+
+	bits = (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+
+	return bits >> (32 - AE_RENDER_KEY_DEPTH_BITS);
+}
+
+static bool get_batch_index(struct ae_render_queue* queue, struct ae_render_batch* batch, uint32_t* index)
+{
+	// consecutive submits nearly always use the same batch
+	if (queue->last_batch < queue->batch_count && queue->batches[queue->last_batch] == batch)
+	{
+		*index = queue->last_batch;
+		return true;
+	}
+
+	for (uint32_t i = 0; i < queue->batch_count; i++)
+	{
+		if (queue->batches[i] == batch)
+		{
+			*index = queue->last_batch = i;
+			return true;
+		}
+	}
+
+	if (queue->batch_count == AE_RENDER_QUEUE_MAX_BATCHES)
+		return false;
+
+	queue->batches[queue->batch_count] = batch;
+	*index = queue->last_batch = queue->batch_count++;
+
+	return true;
+}
+
+static bool reserve(struct ae_render_queue* queue, const uint32_t count)
+{
+	if (queue->count + count <= queue->capacity)
+		return true;
+
+	uint32_t capacity = queue->capacity * 2;
+
+	while (capacity < queue->count + count)
+		capacity *= 2;
+
+	struct ae_render_command* commands = realloc(queue->commands, sizeof(*commands) * capacity);
+
+	if (!commands)
+		return false;
+
+	queue->commands = commands;
+
+	struct ae_render_sort_entry* entries = realloc(queue->entries, sizeof(*entries) * capacity);
+
+	if (!entries)
+		return false;
+
+	queue->entries = entries;
+
+	struct ae_render_sort_entry* scratch = realloc(queue->scratch, sizeof(*scratch) * capacity);
+
+	if (!scratch)
+		return false;
+
+	queue->scratch = scratch;
+	queue->capacity = capacity;
+
+	return true;
+}
+
+// least significant byte first, passes where every key has the same byte are skipped
+static struct ae_render_sort_entry* radix_sort(struct ae_render_sort_entry* entries, struct ae_render_sort_entry* scratch, const uint32_t count)
+{
+	uint32_t histograms[8][256] = { 0 };
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint64_t key = entries[i].key;
+
+		for (uint32_t pass = 0; pass < 8; pass++)
+			histograms[pass][(key >> (pass * 8)) & 0xff]++;
+	}
+
+	struct ae_render_sort_entry* in = entries;
+	struct ae_render_sort_entry* out = scratch;
+
+	for (uint32_t pass = 0; pass < 8; pass++)
+	{
+		uint32_t* histogram = histograms[pass];
+		uint32_t shift = pass * 8;
+
+		if (histogram[(in[0].key >> shift) & 0xff] == count)
+			continue;
+
+		uint32_t offset = 0;
+
+		for (uint32_t i = 0; i < 256; i++)
+		{
+			uint32_t bucket_count = histogram[i];
+			histogram[i] = offset;
+			offset += bucket_count;
+		}
+
+		for (uint32_t i = 0; i < count; i++)
+			out[histogram[(in[i].key >> shift) & 0xff]++] = in[i];
+
+		struct ae_render_sort_entry* swap = in;
+		in = out;
+		out = swap;
+	}
+
+	return in;
+}
+
+static void submit(struct ae_render_queue* queue, struct ae_render_batch* batch, const uint8_t layer, const uint8_t blend, const struct ae_textured_draw_params* params)
+{
+	uint32_t batch_index;
+
+	if (!reserve(queue, 1) || !get_batch_index(queue, batch, &batch_index))
+	{
+		queue->dropped_count++;
+		return;
+	}
+
+	struct ae_render_command* command = &queue->commands[queue->count];
+	command->params = *params;
+	command->batch = batch_index;
+
+	struct ae_render_sort_entry* entry = &queue->entries[queue->count];
+	entry->command = queue->count;
+	entry->key = (uint64_t)layer << AE_RENDER_KEY_LAYER_SHIFT
+		| (uint64_t)batch_index << AE_RENDER_KEY_BATCH_SHIFT
+		| (uint64_t)(blend & 0xf) << AE_RENDER_KEY_BLEND_SHIFT
+		| (uint64_t)(params->texture & 0xffff) << AE_RENDER_KEY_TEXTURE_SHIFT
+		| get_depth_key(params->position[2]);
+
+	queue->count++;
+}
+
+void ae_render_queue_set_renderer(const struct ae_renderer_api* api)
+{
+	renderer = api;
+}
+
+struct ae_render_queue* ae_render_queue_create(const uint32_t initial_capacity)
+{
+	struct ae_render_queue* queue = calloc(1, sizeof(*queue));
+
+	if (!queue)
+		return NULL;
+
+	queue->capacity = initial_capacity ? initial_capacity : AE_RENDER_QUEUE_DEFAULT_CAPACITY;
+	queue->commands = malloc(sizeof(*queue->commands) * queue->capacity);
+	queue->entries = malloc(sizeof(*queue->entries) * queue->capacity);
+	queue->scratch = malloc(sizeof(*queue->scratch) * queue->capacity);
+	queue->batches = malloc(sizeof(*queue->batches) * AE_RENDER_QUEUE_MAX_BATCHES);
+
+	if (!queue->commands || !queue->entries || !queue->scratch || !queue->batches)
+	{
+		ae_render_queue_destroy(queue);
+		return NULL;
+	}
+
+	return queue;
+}
+
+void ae_render_queue_destroy(struct ae_render_queue* queue)
+{
+	free(queue->commands);
+	free(queue->entries);
+	free(queue->scratch);
+	free(queue->batches);
+	free(queue);
+}
+
+void ae_render_queue_submit(struct ae_render_queue* queue, struct ae_render_batch* batch, const uint8_t layer, const uint8_t blend, const struct ae_draw_params* params)
+{
+	struct ae_textured_draw_params textured = {
+		.position = { params->position[0], params->position[1], params->position[2] },
+		.size = { params->size[0], params->size[1] },
+		.color = { params->color[0], params->color[1], params->color[2], params->color[3] },
+		.camera = params->camera,
+		.texture = 0
+	};
+
+	submit(queue, batch, layer, blend, &textured);
+}
+
+void ae_render_queue_submit_textured(struct ae_render_queue* queue, struct ae_render_batch* batch, const uint8_t layer, const uint8_t blend, const struct ae_textured_draw_params* params)
+{
+	submit(queue, batch, layer, blend, params);
+}
+
+void ae_render_queue_merge(struct ae_render_queue* queue, struct ae_render_queue* source)
+{
+	queue->dropped_count += source->dropped_count;
+
+	if (!reserve(queue, source->count))
+	{
+		queue->dropped_count += source->count;
+		ae_render_queue_reset(source);
+		return;
+	}
+
+	// batch indices of the source in this queue, UINT32_MAX when this queue has no room for the batch
+	uint32_t* batch_indices = malloc(sizeof(*batch_indices) * (source->batch_count ? source->batch_count : 1));
+
+	if (!batch_indices)
+	{
+		queue->dropped_count += source->count;
+		ae_render_queue_reset(source);
+		return;
+	}
+
+	for (uint32_t i = 0; i < source->batch_count; i++)
+	{
+		if (!get_batch_index(queue, source->batches[i], &batch_indices[i]))
+			batch_indices[i] = UINT32_MAX;
+	}
+
+	const uint64_t batch_mask = (uint64_t)(AE_RENDER_QUEUE_MAX_BATCHES - 1) << AE_RENDER_KEY_BATCH_SHIFT;
+
+	// entries are still in submission order, appending them keeps equal keys in the order of the merges
+	for (uint32_t i = 0; i < source->count; i++)
+	{
+		const struct ae_render_sort_entry* entry = &source->entries[i];
+		const struct ae_render_command* command = &source->commands[entry->command];
+
+		uint32_t batch = batch_indices[command->batch];
+
+		if (batch == UINT32_MAX)
+		{
+			queue->dropped_count++;
+			continue;
+		}
+
+		queue->commands[queue->count].params = command->params;
+		queue->commands[queue->count].batch = batch;
+		queue->entries[queue->count].command = queue->count;
+		queue->entries[queue->count].key = (entry->key & ~batch_mask) | (uint64_t)batch << AE_RENDER_KEY_BATCH_SHIFT;
+		queue->count++;
+	}
+
+	free(batch_indices);
+	ae_render_queue_reset(source);
+}
+
+void ae_render_queue_reset(struct ae_render_queue* queue)
+{
+	queue->count = 0;
+	queue->batch_count = 0;
+	queue->last_batch = 0;
+	queue->dropped_count = 0;
+}
+
+void ae_render_queue_flush(struct ae_render_queue* queue)
+{
+	uint64_t start = ae_clock_now();
+	const struct ae_render_sort_entry* sorted = queue->count ? radix_sort(queue->entries, queue->scratch, queue->count) : queue->entries;
+
+	queue->stats.sort_time = ae_clock_now() - start;
+	queue->stats.command_count = queue->count;
+	queue->stats.draw_call_count = 0;
+	queue->stats.dropped_count = queue->dropped_count;
+
+	struct ae_render_batch* current = NULL;
+	struct ae_render_batch_stats batch_stats;
+	uint64_t draw_call_count = 0;
+
+	for (uint32_t i = 0; i < queue->count; i++)
+	{
+		struct ae_render_command* command = &queue->commands[sorted[i].command];
+		struct ae_render_batch* batch = queue->batches[command->batch];
+
+		if (batch != current)
+		{
+			if (current)
+			{
+				renderer->render_batch_end(current);
+				renderer->render_batch_get_stats(current, &batch_stats);
+				queue->stats.draw_call_count += (uint32_t)(batch_stats.draw_call_count - draw_call_count);
+			}
+
+			current = batch;
+			renderer->render_batch_get_stats(current, &batch_stats);
+			draw_call_count = batch_stats.draw_call_count;
+			renderer->render_batch_start(current);
+		}
+
+		if (command->params.texture)
+		{
+			renderer->render_batch_draw_textured(current, &command->params);
+		}
+		else
+		{
+			struct ae_draw_params params = {
+				.position = { command->params.position[0], command->params.position[1], command->params.position[2] },
+				.size = { command->params.size[0], command->params.size[1] },
+				.color = { command->params.color[0], command->params.color[1], command->params.color[2], command->params.color[3] },
+				.camera = command->params.camera
+			};
+
+			renderer->render_batch_draw(current, &params);
+		}
+	}
+
+	if (current)
+	{
+		renderer->render_batch_end(current);
+		renderer->render_batch_get_stats(current, &batch_stats);
+		queue->stats.draw_call_count += (uint32_t)(batch_stats.draw_call_count - draw_call_count);
+	}
+
+	// batch indices are only kept for one frame, batches may be destroyed in between
+	ae_render_queue_reset(queue);
+}
+
+void ae_render_queue_get_stats(const struct ae_render_queue* queue, struct ae_render_queue_stats* stats)
+{
+	*stats = queue->stats;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+// sorted draws of a frame, shared by the backends. batches are driven through the renderer table of the
+// plugin that owns the queue so every backend sees the draws go through its own functions
+
+#include <core/types.h>
+
+struct ae_renderer_api;
+struct ae_render_queue;
+struct ae_render_batch;
+struct ae_draw_params;
+struct ae_textured_draw_params;
+struct ae_render_queue_stats;
+
+// the table flush calls into, set once when the plugin is loaded
+void ae_render_queue_set_renderer(const struct ae_renderer_api* api);
+
+struct ae_render_queue* ae_render_queue_create(const uint32_t initial_capacity);
+void ae_render_queue_destroy(struct ae_render_queue* queue);
+void ae_render_queue_submit(struct ae_render_queue* queue, struct ae_render_batch* batch, const uint8_t layer, const uint8_t blend, const struct ae_draw_params* params);
+void ae_render_queue_submit_textured(struct ae_render_queue* queue, struct ae_render_batch* batch, const uint8_t layer, const uint8_t blend, const struct ae_textured_draw_params* params);
+void ae_render_queue_merge(struct ae_render_queue* queue, struct ae_render_queue* source);
+void ae_render_queue_reset(struct ae_render_queue* queue);
+void ae_render_queue_flush(struct ae_render_queue* queue);
+void ae_render_queue_get_stats(const struct ae_render_queue* queue, struct ae_render_queue_stats* stats);
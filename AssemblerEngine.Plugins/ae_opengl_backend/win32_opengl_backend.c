@@ -1,11 +1,23 @@
 #include "wgl.h"
+#include "opengl_atlas.h"
+#include "opengl_extensions.h"
+#include "opengl_frame_graph.h"
+#include "opengl_profiler.h"
 #include "opengl_renderer.h"
 #include "opengl_shader.h"
+#include "opengl_static_batch.h"
+#include "opengl_state.h"
+#include "opengl_texture.h"
+#include "render_queue.h"
 
 #include <apis/opengl_backend.h>
 #include <apis/api_registry.h>
+#include <apis/frame_graph.h>
+#include <apis/gpu_profiler.h>
 #include <apis/renderer.h>
 #include <apis/shader.h>
+#include <apis/texture.h>
+#include <apis/texture_atlas.h>
 #include <apis/window.h>
 #include <core/core.h>
 #include <core/os.h>
@@ -23,6 +35,8 @@ struct ae_opengl_backend
 	HGLRC					render_context;
 	PIXELFORMATDESCRIPTOR	pixel_format_desc;
 	int						pixel_format_id;
+	uint32_t				width;
+	uint32_t				height;
 };
 
 struct ae_native_window
@@ -228,7 +242,7 @@ static struct ae_opengl_backend* opengl_get_or_create()
 	if (!render_backend)
 		return NULL;
 
-	memset(&render_backend->pixel_format_desc, 0, sizeof(render_backend->pixel_format_desc));
+	memset(render_backend, 0, sizeof(*render_backend));
 
 	UINT num_formats;
 	if (!wglChoosePixelFormatARB(dummy_device_context, pixelAttribs, NULL, 1, &render_backend->pixel_format_id, &num_formats))
@@ -257,6 +271,8 @@ static struct ae_opengl_backend* opengl_get_or_create()
 	wglMakeCurrent(device, render_backend->render_context);
 
 	gladLoadGLLoader(opengl_backend_get_opengl_proc_address);
+	ae_opengl_extensions_load(opengl_backend_get_opengl_proc_address);
+	ae_gl_state_invalidate();
 
 	ae_opengl_backend_set_debug_callback(opengl_message_callback);
 
@@ -291,9 +307,33 @@ static void opengl_backend_set_window(struct ae_opengl_backend* backend, struct
 		LocalFree(message);
 	}
 	
+	backend->width = (uint32_t)window->size[0];
+	backend->height = (uint32_t)window->size[1];
+
 	glViewport(0, 0, (int)window->size[0], (int)window->size[1]);
 }
 
+static void opengl_backend_get_framebuffer_size(struct ae_opengl_backend* backend, uint32_t* width, uint32_t* height)
+{
+	*width = backend->width;
+	*height = backend->height;
+}
+
+// reads the back buffer, call it before the window swaps
+static bool opengl_backend_read_pixels(struct ae_opengl_backend* backend, uint8_t* pixels, const size_t size)
+{
+	size_t needed = (size_t)backend->width * backend->height * 4;
+
+	if (size < needed)
+		return false;
+
+	glReadBuffer(GL_BACK);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadnPixels(0, 0, (GLsizei)backend->width, (GLsizei)backend->height, GL_RGBA, GL_UNSIGNED_BYTE, (GLsizei)needed, pixels);
+
+	return true;
+}
+
 static struct ae_opengl_backend* ae_opengl_backend_get()
 {
 	return render_backend;
@@ -304,35 +344,120 @@ static const struct ae_opengl_backend_api opengl_backend_api =
 	.get = ae_opengl_backend_get,
 	.get_or_create = opengl_get_or_create,
 	.destroy = opengl_backend_destroy,
-	.set_window = opengl_backend_set_window
+	.set_window = opengl_backend_set_window,
+	.get_framebuffer_size = opengl_backend_get_framebuffer_size,
+	.read_pixels = opengl_backend_read_pixels
 };
 
 static const struct ae_shader_api shader_api =
 {
 	.create = ae_shader_create,
-	.create_basic = ae_shader_create_basic
+	.create_basic = ae_shader_create_basic,
+	.create_async = ae_shader_create_async,
+	.poll_async = ae_shader_poll_async,
+	.set_cache_directory = ae_shader_set_cache_directory,
+	.get_cache_stats = ae_shader_get_cache_stats
 };
 
 static const struct ae_renderer_api render_api =
 {
 	.render_batch_create = ae_render_batch_create,
+	.render_batch_create_instanced = ae_render_batch_create_instanced,
 	.render_batch_destroy = ae_render_batch_destroy,
+	.render_get_preferred_texture_binding = ae_render_get_preferred_texture_binding,
+	.render_batch_set_texture_binding = ae_render_batch_set_texture_binding,
 	.render_scene_start = ae_render_scene_start,
+	.render_frame_start = ae_render_frame_start,
+	.render_set_camera = ae_render_set_camera,
 	.render_batch_start = ae_render_batch_start,
 	.render_batch_end = ae_render_batch_end,
 	.render_batch_draw = ae_render_batch_draw,
-	.render_batch_draw_textured = ae_render_batch_draw_textured
+	.render_batch_draw_textured = ae_render_batch_draw_textured,
+	.render_batch_draw_many = ae_render_batch_draw_many,
+	.render_batch_draw_many_soa = ae_render_batch_draw_many_soa,
+	.render_batch_set_indirect = ae_render_batch_set_indirect,
+	.render_batch_set_culling = ae_render_batch_set_culling,
+	.render_get_state_stats = ae_render_get_state_stats,
+	.render_get_cull_stats = ae_render_get_cull_stats,
+	.render_batch_get_stats = ae_render_batch_get_stats,
+	.render_queue_create = ae_render_queue_create,
+	.render_queue_destroy = ae_render_queue_destroy,
+	.render_queue_submit = ae_render_queue_submit,
+	.render_queue_submit_textured = ae_render_queue_submit_textured,
+	.render_queue_merge = ae_render_queue_merge,
+	.render_queue_reset = ae_render_queue_reset,
+	.render_queue_flush = ae_render_queue_flush,
+	.render_queue_get_stats = ae_render_queue_get_stats,
+	.render_static_batch_create = ae_static_batch_create,
+	.render_static_batch_destroy = ae_static_batch_destroy,
+	.render_static_batch_update = ae_static_batch_update,
+	.render_static_batch_draw = ae_static_batch_draw
+};
+
+static const struct ae_gpu_profiler_api gpu_profiler_api =
+{
+	.set_enabled = ae_gpu_profiler_set_enabled,
+	.begin_scope = ae_gpu_profiler_begin_scope,
+	.end_scope = ae_gpu_profiler_end_scope,
+	.get_frame = ae_gpu_profiler_get_frame
+};
+
+static const struct ae_texture_api texture_api =
+{
+	.create = ae_texture_create,
+	.destroy = ae_texture_destroy,
+	.begin_upload = ae_texture_begin_upload,
+	.end_upload = ae_texture_end_upload,
+	.is_ready = ae_texture_is_ready,
+	.set_upload_budget = ae_texture_set_upload_budget,
+	.get_stats = ae_texture_get_stats
+};
+
+static const struct ae_texture_atlas_api texture_atlas_api =
+{
+	.create = ae_texture_atlas_create,
+	.destroy = ae_texture_atlas_destroy,
+	.insert = ae_texture_atlas_insert,
+	.remove = ae_texture_atlas_remove,
+	.get_page = ae_texture_atlas_get_page,
+	.get_stats = ae_texture_atlas_get_stats
+};
+
+static const struct ae_frame_graph_api frame_graph_api =
+{
+	.create = ae_frame_graph_create,
+	.destroy = ae_frame_graph_destroy,
+	.reset = ae_frame_graph_reset,
+	.create_texture = ae_frame_graph_create_texture,
+	.import_texture = ae_frame_graph_import_texture,
+	.import_buffer = ae_frame_graph_import_buffer,
+	.get_backbuffer = ae_frame_graph_get_backbuffer,
+	.add_pass = ae_frame_graph_add_pass,
+	.read = ae_frame_graph_read,
+	.write_attachment = ae_frame_graph_write_attachment,
+	.write_storage = ae_frame_graph_write_storage,
+	.set_side_effect = ae_frame_graph_set_side_effect,
+	.execute = ae_frame_graph_execute,
+	.get_name = ae_frame_graph_get_name,
+	.get_stats = ae_frame_graph_get_stats
 };
 
 AE_DLL_EXPORT void plugin_load(struct ae_api_registry_api* registry, bool reload)
 {
-	AE_UNREFERENCED_PARAMETER(reload);
+	// the cache of the reloaded library starts zeroed while the context keeps the state of the old one
+	if (reload)
+		ae_gl_state_invalidate();
 
 	ae_window_api = ae_get_api(registry, ae_window_api);
 
 	ae_set_api(registry, ae_opengl_backend_api, &opengl_backend_api);
 	ae_set_api(registry, ae_renderer_api, &render_api);
+	ae_render_queue_set_renderer(&render_api);
 	ae_set_api(registry, ae_shader_api, &shader_api);
+	ae_set_api(registry, ae_gpu_profiler_api, &gpu_profiler_api);
+	ae_set_api(registry, ae_texture_api, &texture_api);
+	ae_set_api(registry, ae_texture_atlas_api, &texture_atlas_api);
+	ae_set_api(registry, ae_frame_graph_api, &frame_graph_api);
 }
 
 AE_DLL_EXPORT void plugin_unload(struct ae_api_registry_api* registry)
@@ -0,0 +1,424 @@
+// renders a binary log written by the ae_logging plugin to text, compressed segments of a
+// mapped file sink are decompressed first
+// usage: ae_log_decoder <binary log | compressed segment> [output file]
+
+#include "binary_log.h"
+#include "log_compression.h"
+
+#include <apis/logging.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+struct ae_decoded_site
+{
+	const char* fmt;
+	const char* file;
+	uint16_t fmt_length;
+	uint16_t file_length;
+	uint32_t line;
+};
+
+struct ae_decoder
+{
+	struct ae_binary_log_file_header header;
+	struct ae_decoded_site* sites;
+	uint32_t site_capacity;
+	FILE* out;
+};
+
+static const char* level_strings[] = {
+  "TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL"
+};
+
+// the data after the string, NULL if the length or the characters run past end
+static const uint8_t* read_string(const uint8_t* in, const uint8_t* end, const char** string, uint16_t* length)
+{
+	if (!in || (size_t)(end - in) < sizeof(*length))
+		return NULL;
+
+	memcpy(length, in, sizeof(*length));
+	in += sizeof(*length);
+
+	if ((size_t)(end - in) < *length)
+		return NULL;
+
+	*string = (const char*)in;
+	return in + *length;
+}
+
+// line, file and format or message of site and text records
+static const uint8_t* read_location(const uint8_t* in, const uint8_t* end, struct ae_decoded_site* site, const char** text, uint16_t* text_length)
+{
+	if ((size_t)(end - in) < sizeof(site->line))
+		return NULL;
+
+	memcpy(&site->line, in, sizeof(site->line));
+	in = read_string(in + sizeof(site->line), end, &site->file, &site->file_length);
+
+	return read_string(in, end, text, text_length);
+}
+
+static void write_prefix(struct ae_decoder* decoder, const uint64_t ticks, const uint32_t level, const char* file, const uint16_t file_length, const uint32_t line)
+{
+	double seconds = (double)(int64_t)(ticks - decoder->header.start_ticks) / (double)decoder->header.ticks_per_second;
+	uint64_t time_ns = decoder->header.start_time + (uint64_t)(int64_t)(seconds * 1e9);
+	time_t time_s = (time_t)(time_ns / 1000000000ull);
+
+	struct tm local;
+#ifdef _WIN32
+	localtime_s(&local, &time_s);
+#else
+	localtime_r(&time_s, &local);
+#endif // _WIN32
+
+	char buf[32] = { 0 };
+	buf[strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &local)] = '\0';
+
+	fprintf(
+		decoder->out,
+		"%s.%09llu %-5s %.*s:%u: ",
+		buf,
+		(unsigned long long)(time_ns % 1000000000ull),
+		level < 6 ? level_strings[level] : "?",
+		(int)file_length,
+		file,
+		line
+	);
+}
+
+// formats one conversion with the captured argument, the length modifier of the format is
+// replaced by the one matching the captured type
+static void write_argument(FILE* out, const char* spec, size_t spec_length, const char conversion, const uint8_t type, const uint8_t* value, const uint16_t string_length)
+{
+	char fmt[64];
+
+	if (spec_length > sizeof(fmt) - 8)
+		spec_length = sizeof(fmt) - 8;
+
+	// strip length modifiers
+	while (spec_length > 1 && strchr("hljztL", spec[spec_length - 1]))
+		spec_length--;
+
+	memcpy(fmt, spec, spec_length);
+
+	uint64_t bits;
+	memcpy(&bits, value, sizeof(bits));
+
+	switch (type)
+	{
+	case AE_LOG_ARGUMENT_I64:
+	case AE_LOG_ARGUMENT_U64:
+	{
+		char integer_conversion = strchr("diouxXc", conversion) ? conversion : (type == AE_LOG_ARGUMENT_I64 ? 'd' : 'u');
+
+		if (integer_conversion == 'c')
+		{
+			memcpy(fmt + spec_length, "c", 2);
+			fprintf(out, fmt, (int)bits);
+		}
+		else
+		{
+			fmt[spec_length] = 'l';
+			fmt[spec_length + 1] = 'l';
+			fmt[spec_length + 2] = integer_conversion;
+			fmt[spec_length + 3] = '\0';
+			fprintf(out, fmt, (unsigned long long)bits);
+		}
+		break;
+	}
+	case AE_LOG_ARGUMENT_F64:
+	{
+		double number;
+		memcpy(&number, value, sizeof(number));
+		fmt[spec_length] = strchr("eEfFgGaA", conversion) ? conversion : 'f';
+		fmt[spec_length + 1] = '\0';
+		fprintf(out, fmt, number);
+		break;
+	}
+	case AE_LOG_ARGUMENT_POINTER:
+		fprintf(out, "%p", (void*)(uintptr_t)bits);
+		break;
+	case AE_LOG_ARGUMENT_STRING:
+	{
+		static char string[UINT16_MAX + 1];
+		memcpy(string, value, string_length);
+		string[string_length] = '\0';
+		memcpy(fmt + spec_length, "s", 2);
+		fprintf(out, fmt, string);
+		break;
+	}
+	}
+}
+
+// arguments that do not fit before end are written as <truncated>
+static void write_message(struct ae_decoder* decoder, const struct ae_decoded_site* site, const uint8_t* arguments, const uint8_t* arguments_end, const uint16_t argument_count)
+{
+	const char* fmt = site->fmt;
+	const char* end = site->fmt + site->fmt_length;
+	uint16_t argument = 0;
+
+	while (fmt < end)
+	{
+		if (*fmt != '%')
+		{
+			fputc(*fmt++, decoder->out);
+			continue;
+		}
+
+		if (fmt + 1 < end && fmt[1] == '%')
+		{
+			fputc('%', decoder->out);
+			fmt += 2;
+			continue;
+		}
+
+		const char* spec = fmt++;
+
+		while (fmt < end && strchr("-+ #0123456789.hljztL", *fmt))
+			fmt++;
+
+		if (fmt == end)
+			break;
+
+		char conversion = *fmt++;
+
+		if (argument == argument_count)
+		{
+			fputs("<missing>", decoder->out);
+			continue;
+		}
+
+		if (arguments == arguments_end)
+		{
+			fputs("<truncated>", decoder->out);
+			argument = argument_count;
+			continue;
+		}
+
+		uint8_t type = *arguments++;
+
+		if (type == AE_LOG_ARGUMENT_STRING)
+		{
+			const char* string;
+			uint16_t string_length;
+			const uint8_t* next = read_string(arguments, arguments_end, &string, &string_length);
+
+			if (next)
+				write_argument(decoder->out, spec, (size_t)(fmt - spec - 1), conversion, type, (const uint8_t*)string, string_length);
+
+			arguments = next;
+		}
+		else if (type <= AE_LOG_ARGUMENT_POINTER && (size_t)(arguments_end - arguments) >= sizeof(uint64_t))
+		{
+			write_argument(decoder->out, spec, (size_t)(fmt - spec - 1), conversion, type, arguments, 0);
+			arguments += sizeof(uint64_t);
+		}
+		else
+		{
+			arguments = NULL;
+		}
+
+		// the rest of the record can not be trusted once one argument is broken
+		if (!arguments)
+		{
+			fputs("<truncated>", decoder->out);
+			arguments = arguments_end;
+			argument = argument_count;
+			continue;
+		}
+
+		argument++;
+	}
+
+	fputc('\n', decoder->out);
+}
+
+static bool add_site(struct ae_decoder* decoder, const uint32_t id, const struct ae_decoded_site* site)
+{
+	if (id >= AE_BINARY_LOG_MAX_SITES)
+		return false;
+
+	if (id >= decoder->site_capacity)
+	{
+		uint32_t capacity = decoder->site_capacity ? decoder->site_capacity : 64;
+
+		while (capacity <= id)
+			capacity *= 2;
+
+		struct ae_decoded_site* sites = realloc(decoder->sites, sizeof(*sites) * capacity);
+
+		if (!sites)
+			return false;
+
+		memset(sites + decoder->site_capacity, 0, sizeof(*sites) * (capacity - decoder->site_capacity));
+		decoder->sites = sites;
+		decoder->site_capacity = capacity;
+	}
+
+	decoder->sites[id] = *site;
+
+	return true;
+}
+
+static int decode(struct ae_decoder* decoder, const uint8_t* data, const size_t size)
+{
+	if (size < sizeof(decoder->header))
+		return EXIT_FAILURE;
+
+	memcpy(&decoder->header, data, sizeof(decoder->header));
+
+	if (memcmp(decoder->header.magic, AE_BINARY_LOG_MAGIC, sizeof(decoder->header.magic)) != 0 || decoder->header.version != AE_BINARY_LOG_VERSION)
+	{
+		fprintf(stderr, "not a binary log or unsupported version\n");
+		return EXIT_FAILURE;
+	}
+
+	size_t offset = (decoder->header.header_size + AE_BINARY_LOG_ALIGNMENT - 1) & ~(size_t)(AE_BINARY_LOG_ALIGNMENT - 1);
+
+	while (offset + sizeof(struct ae_binary_log_record_header) <= size)
+	{
+		struct ae_binary_log_record_header header;
+		memcpy(&header, data + offset, sizeof(header));
+
+		// end of the written part
+		if (header.size == 0 || offset + header.size > size)
+			break;
+
+		if (header.size < sizeof(header))
+		{
+			fprintf(stderr, "record at %zu is smaller than its header\n", offset);
+			return EXIT_FAILURE;
+		}
+
+		// every read of the payload stays before the end of its record
+		const uint8_t* payload = data + offset + sizeof(header);
+		const uint8_t* payload_end = data + offset + header.size;
+		struct ae_decoded_site site = { 0 };
+
+		switch (header.type)
+		{
+		case AE_BINARY_LOG_RECORD_SITE:
+			if (!read_location(payload, payload_end, &site, &site.fmt, &site.fmt_length))
+			{
+				fprintf(decoder->out, "<broken site %u>\n", header.site);
+				break;
+			}
+
+			if (!add_site(decoder, header.site, &site))
+			{
+				fprintf(stderr, "could not add site %u\n", header.site);
+				return EXIT_FAILURE;
+			}
+			break;
+		case AE_BINARY_LOG_RECORD_MESSAGE:
+			if (header.site >= decoder->site_capacity || !decoder->sites[header.site].fmt)
+			{
+				fprintf(decoder->out, "<unknown site %u>\n", header.site);
+				break;
+			}
+
+			site = decoder->sites[header.site];
+			write_prefix(decoder, header.timestamp, header.level, site.file, site.file_length, site.line);
+			write_message(decoder, &site, payload, payload_end,
+				header.argument_count < AE_BINARY_LOG_MAX_ARGUMENTS ? header.argument_count : AE_BINARY_LOG_MAX_ARGUMENTS);
+			break;
+		case AE_BINARY_LOG_RECORD_TEXT:
+		{
+			const char* message;
+			uint16_t message_length;
+
+			if (!read_location(payload, payload_end, &site, &message, &message_length))
+			{
+				fputs("<broken text>\n", decoder->out);
+				break;
+			}
+
+			write_prefix(decoder, header.timestamp, header.level, site.file, site.file_length, site.line);
+			fprintf(decoder->out, "%.*s\n", (int)message_length, message);
+			break;
+		}
+		}
+
+		offset += header.size;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		fprintf(stderr, "usage: %s <binary log | compressed segment> [output file]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	FILE* in = fopen(argv[1], "rb");
+
+	if (!in)
+	{
+		fprintf(stderr, "could not open %s\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+
+	fseek(in, 0, SEEK_END);
+	long size = ftell(in);
+	fseek(in, 0, SEEK_SET);
+
+	uint8_t* data = malloc(size > 0 ? (size_t)size : 1);
+
+	if (!data || fread(data, 1, (size_t)size, in) != (size_t)size)
+	{
+		fprintf(stderr, "could not read %s\n", argv[1]);
+		fclose(in);
+		free(data);
+		return EXIT_FAILURE;
+	}
+
+	fclose(in);
+
+	if (ae_log_is_compressed(data, (size_t)size))
+	{
+		size_t decompressed_size;
+		uint8_t* decompressed = ae_log_decompress(data, (size_t)size, &decompressed_size);
+
+		free(data);
+
+		if (!decompressed)
+		{
+			fprintf(stderr, "could not decompress %s\n", argv[1]);
+			return EXIT_FAILURE;
+		}
+
+		data = decompressed;
+		size = (long)decompressed_size;
+	}
+
+	struct ae_decoder decoder = { .out = stdout };
+
+	if (argc > 2 && !(decoder.out = fopen(argv[2], "w")))
+	{
+		fprintf(stderr, "could not open %s\n", argv[2]);
+		free(data);
+		return EXIT_FAILURE;
+	}
+
+	int result = EXIT_SUCCESS;
+
+	// text segments are written as they are
+	if ((size_t)size >= sizeof(decoder.header.magic) && memcmp(data, AE_BINARY_LOG_MAGIC, sizeof(decoder.header.magic)) == 0)
+		result = decode(&decoder, data, (size_t)size);
+	else if (fwrite(data, 1, (size_t)size, decoder.out) != (size_t)size)
+		result = EXIT_FAILURE;
+
+	if (decoder.out != stdout)
+		fclose(decoder.out);
+
+	free(decoder.sites);
+	free(data);
+
+	return result;
+}
@@ -0,0 +1,298 @@
+// measures the cpu side quad expansion of the opengl render batches, the per quad path of
+// render_batch_draw against render_batch_draw_many and render_batch_draw_many_soa, and the
+// culling of the quads against a camera that sees a quarter of them.
+// no gl context is needed, vertices are written to plain memory
+// usage: ae_render_bench [sprite count] [iterations]
+
+#include "quad_culling.h"
+#include "quad_expansion.h"
+
+#include <apis/camera.h>
+#include <core/clock.h>
+#include <math/cam.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// quads per flush, the same size the engine creates its batches with
+#define AE_RENDER_BENCH_BATCH_QUADS 10000
+
+struct ae_render_bench
+{
+	struct ae_vertex_layout layout;
+	struct ae_draw_params* params;
+	struct ae_draw_params_soa soa;
+	struct ae_quad_culler culler;
+	uint8_t* vertices;
+	uint32_t count;
+};
+
+// every path flushes at the same quads, a flush only restarts the vertex count
+static void run_per_quad(const struct ae_render_bench* bench, uint8_t* out)
+{
+	uint32_t used = 0;
+
+	for (uint32_t i = 0; i < bench->count; i++)
+	{
+		if (used == AE_RENDER_BENCH_BATCH_QUADS)
+			used = 0;
+
+		const struct ae_draw_params* quad = &bench->params[i];
+		ae_quad_write(&bench->layout, out + (size_t)i * 4 * bench->layout.stride, quad->color, quad->position, quad->size, ae_quad_texture_coordinates, 0.0f);
+		used++;
+	}
+}
+
+static void run_many(const struct ae_render_bench* bench, uint8_t* out)
+{
+	for (uint32_t drawn = 0; drawn < bench->count; drawn += AE_RENDER_BENCH_BATCH_QUADS)
+	{
+		uint32_t remaining = bench->count - drawn;
+		uint32_t chunk = remaining < AE_RENDER_BENCH_BATCH_QUADS ? remaining : AE_RENDER_BENCH_BATCH_QUADS;
+
+		ae_quad_expand(&bench->layout, out + (size_t)drawn * 4 * bench->layout.stride, bench->params + drawn, chunk);
+	}
+}
+
+static void run_many_soa(const struct ae_render_bench* bench, uint8_t* out)
+{
+	for (uint32_t drawn = 0; drawn < bench->count; drawn += AE_RENDER_BENCH_BATCH_QUADS)
+	{
+		uint32_t remaining = bench->count - drawn;
+		uint32_t chunk = remaining < AE_RENDER_BENCH_BATCH_QUADS ? remaining : AE_RENDER_BENCH_BATCH_QUADS;
+
+		ae_quad_expand_soa(&bench->layout, out + (size_t)drawn * 4 * bench->layout.stride, &bench->soa, drawn, chunk);
+	}
+}
+
+// the visibility bits of every quad are written to out
+static void run_cull_per_quad(const struct ae_render_bench* bench, uint8_t* out)
+{
+	uint32_t* visible = (uint32_t*)out;
+
+	for (uint32_t group = 0; group < bench->count; group += AE_QUAD_CULL_GROUP_SIZE)
+	{
+		uint32_t bits = 0;
+
+		for (uint32_t i = group; i < bench->count && i < group + AE_QUAD_CULL_GROUP_SIZE; i++)
+			bits |= (uint32_t)ae_quad_is_visible(&bench->culler, bench->params[i].position, bench->params[i].size) << (i - group);
+
+		visible[group / AE_QUAD_CULL_GROUP_SIZE] = bits;
+	}
+}
+
+static void run_cull(const struct ae_render_bench* bench, uint8_t* out)
+{
+	uint32_t* visible = (uint32_t*)out;
+
+	for (uint32_t group = 0; group < bench->count; group += AE_QUAD_CULL_GROUP_SIZE)
+	{
+		uint32_t remaining = bench->count - group;
+		visible[group / AE_QUAD_CULL_GROUP_SIZE] = ae_quad_cull(&bench->culler, bench->params + group, remaining < AE_QUAD_CULL_GROUP_SIZE ? remaining : AE_QUAD_CULL_GROUP_SIZE);
+	}
+}
+
+static void run_cull_soa(const struct ae_render_bench* bench, uint8_t* out)
+{
+	uint32_t* visible = (uint32_t*)out;
+
+	for (uint32_t group = 0; group < bench->count; group += AE_QUAD_CULL_GROUP_SIZE)
+	{
+		uint32_t remaining = bench->count - group;
+		visible[group / AE_QUAD_CULL_GROUP_SIZE] = ae_quad_cull_soa(&bench->culler, &bench->soa, group, remaining < AE_QUAD_CULL_GROUP_SIZE ? remaining : AE_QUAD_CULL_GROUP_SIZE);
+	}
+}
+
+// best of the iterations, in nanoseconds
+static uint64_t measure(const struct ae_render_bench* bench, void (*run)(const struct ae_render_bench*, uint8_t*), const uint32_t iterations)
+{
+	uint64_t best = UINT64_MAX;
+
+	for (uint32_t i = 0; i < iterations; i++)
+	{
+		uint64_t start = ae_clock_now();
+		run(bench, bench->vertices);
+		uint64_t time = ae_clock_now() - start;
+
+		if (time < best)
+			best = time;
+	}
+
+	return best;
+}
+
+static void report(const char* name, const uint64_t time, const uint64_t baseline, const uint32_t count)
+{
+	printf("  %-14s %10.3f ms %8.2f ns/sprite %8.1f M sprites/s %6.2fx\n",
+		name,
+		(double)time / 1e6,
+		(double)time / count,
+		(double)count * 1e3 / (double)time,
+		(double)baseline / (double)time);
+}
+
+static float random_float(const float min, const float max)
+{
+	return min + (max - min) * ((float)rand() / (float)RAND_MAX);
+}
+
+static bool bench_format(struct ae_render_bench* bench, const char* name, const struct ae_vertex_format* format, const uint32_t iterations)
+{
+	ae_vertex_layout_init(&bench->layout, format);
+
+	size_t size = (size_t)bench->count * 4 * bench->layout.stride;
+	uint8_t* expected = malloc(size);
+
+	if (!expected)
+		return false;
+
+	// every path has to produce exactly the vertices of the per quad path
+	run_per_quad(bench, expected);
+
+	bool matches = true;
+	void (*paths[])(const struct ae_render_bench*, uint8_t*) = { run_many, run_many_soa };
+
+	for (uint32_t i = 0; i < 2; i++)
+	{
+		memset(bench->vertices, 0, size);
+		paths[i](bench, bench->vertices);
+		matches = matches && memcmp(expected, bench->vertices, size) == 0;
+	}
+
+	free(expected);
+
+	if (!matches)
+	{
+		fprintf(stderr, "%s: bulk vertices differ from the per quad path\n", name);
+		return false;
+	}
+
+	uint64_t per_quad = measure(bench, run_per_quad, iterations);
+
+	printf("%s, %u byte vertices\n", name, bench->layout.stride);
+	report("per quad", per_quad, per_quad, bench->count);
+	report("draw_many", measure(bench, run_many, iterations), per_quad, bench->count);
+	report("draw_many_soa", measure(bench, run_many_soa, iterations), per_quad, bench->count);
+
+	return true;
+}
+
+static bool bench_culling(struct ae_render_bench* bench, const uint32_t iterations)
+{
+	// the planes are read from a const camera like render_set_camera does
+	struct ae_camera camera;
+	const struct ae_camera* view = &camera;
+	ae_ortho(-500.0f, 500.0f, -500.0f, 500.0f, -1.0f, 1.0f, camera.view_projection);
+	ae_quad_culler_init(&bench->culler, view->view_projection, AE_CULL_FRUSTUM);
+
+	size_t size = sizeof(uint32_t) * ((bench->count + AE_QUAD_CULL_GROUP_SIZE - 1) / AE_QUAD_CULL_GROUP_SIZE);
+	uint32_t* expected = malloc(size);
+
+	if (!expected)
+		return false;
+
+	run_cull_per_quad(bench, (uint8_t*)expected);
+
+	bool matches = true;
+	void (*paths[])(const struct ae_render_bench*, uint8_t*) = { run_cull, run_cull_soa };
+
+	for (uint32_t i = 0; i < 2; i++)
+	{
+		memset(bench->vertices, 0, size);
+		paths[i](bench, bench->vertices);
+		matches = matches && memcmp(expected, bench->vertices, size) == 0;
+	}
+
+	uint32_t visible_count = 0;
+
+	for (uint32_t i = 0; i < bench->count; i++)
+		visible_count += expected[i / AE_QUAD_CULL_GROUP_SIZE] >> (i % AE_QUAD_CULL_GROUP_SIZE) & 1;
+
+	free(expected);
+
+	if (!matches)
+	{
+		fprintf(stderr, "culling: bulk results differ from the per quad test\n");
+		return false;
+	}
+
+	uint64_t per_quad = measure(bench, run_cull_per_quad, iterations);
+
+	printf("culling, %u of %u visible\n", visible_count, bench->count);
+	report("per quad", per_quad, per_quad, bench->count);
+	report("draw_many", measure(bench, run_cull, iterations), per_quad, bench->count);
+	report("draw_many_soa", measure(bench, run_cull_soa, iterations), per_quad, bench->count);
+
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	struct ae_render_bench bench = { .count = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 100000 };
+	uint32_t iterations = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 50;
+
+	if (bench.count == 0 || iterations == 0)
+	{
+		fprintf(stderr, "usage: %s [sprite count] [iterations]\n", argv[0]);
+		return 1;
+	}
+
+	float* soa = malloc(sizeof(float) * 5 * bench.count);
+	void* color_memory = malloc(sizeof(vec4) * bench.count);
+	vec4* colors = color_memory;
+	bench.params = malloc(sizeof(*bench.params) * bench.count);
+	// big enough for the widest layout
+	bench.vertices = malloc((size_t)bench.count * 4 * 40);
+
+	if (!soa || !colors || !bench.params || !bench.vertices)
+	{
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+
+	bench.soa = (struct ae_draw_params_soa){
+		.x = soa,
+		.y = soa + bench.count,
+		.z = soa + bench.count * 2,
+		.width = soa + bench.count * 3,
+		.height = soa + bench.count * 4,
+		.color = color_memory
+	};
+
+	srand(1);
+
+	for (uint32_t i = 0; i < bench.count; i++)
+	{
+		struct ae_draw_params* quad = &bench.params[i];
+
+		quad->position[0] = soa[i] = random_float(-1000.0f, 1000.0f);
+		quad->position[1] = soa[bench.count + i] = random_float(-1000.0f, 1000.0f);
+		quad->position[2] = soa[bench.count * 2 + i] = random_float(-1.0f, 1.0f);
+		quad->size[0] = soa[bench.count * 3 + i] = random_float(1.0f, 64.0f);
+		quad->size[1] = soa[bench.count * 4 + i] = random_float(1.0f, 64.0f);
+		quad->camera = NULL;
+
+		for (uint32_t j = 0; j < 4; j++)
+			quad->color[j] = colors[i][j] = random_float(0.0f, 1.0f);
+	}
+
+	const struct ae_vertex_format compact_format = {
+		.color = AE_VERTEX_COLOR_RGBA8,
+		.texture_coordinate = AE_VERTEX_TEXTURE_COORDINATE_HALF2,
+		.texture_unit = AE_VERTEX_TEXTURE_UNIT_UINT8
+	};
+
+	printf("%u sprites, best of %u runs\n", bench.count, iterations);
+
+	bool success = bench_format(&bench, "default", &ae_default_vertex_format, iterations)
+		&& bench_format(&bench, "compact", &compact_format, iterations)
+		&& bench_culling(&bench, iterations);
+
+	free(bench.vertices);
+	free(bench.params);
+	free(colors);
+	free(soa);
+
+	return success ? 0 : 1;
+}
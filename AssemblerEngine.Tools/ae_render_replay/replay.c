@@ -0,0 +1,1102 @@
+// prints and replays the recordings of the null renderer plugin.
+// --plugin replays the recorded calls through a renderer plugin and reports the cpu time of the best pass,
+// replaying into the null renderer also checks every flush against the recording so a change to the
+// batching can be verified with a recording made before it. recorded textures are created again through the
+// texture api of the plugin without their texels, draws of texture ids the recording did not create reuse the ids
+// usage: ae_render_replay <recording> [--dump] [--plugin <path>] [--repeat <count>]
+
+#include "render_recording.h"
+
+#include <apis/api_registry.h>
+#include <apis/camera.h>
+#include <apis/opengl_backend.h>
+#include <apis/plugin_registry.h>
+#include <apis/render_recorder.h>
+#include <apis/renderer.h>
+#include <apis/shader.h>
+#include <apis/texture.h>
+#include <core/clock.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#define LIBRARY_TYPE HMODULE
+#define LOAD_LIBRARY(path) LoadLibrary(path)
+#define LOAD_FUNCTION GetProcAddress
+#elif defined __linux
+#include <dlfcn.h>
+#define LIBRARY_TYPE void*
+#define LOAD_LIBRARY(path) dlopen(path, RTLD_NOW)
+#define LOAD_FUNCTION dlsym
+#endif
+
+#define AE_RENDER_REPLAY_MAX_APIS 16
+
+// ids of shaders, batches and textures index arrays, ids read from a broken file are refused above this
+#ifndef AE_RENDER_REPLAY_MAX_OBJECT_ID
+#define AE_RENDER_REPLAY_MAX_OBJECT_ID (1u << 20)
+#endif // !AE_RENDER_REPLAY_MAX_OBJECT_ID
+
+struct ae_api_registry
+{
+	const char* names[AE_RENDER_REPLAY_MAX_APIS];
+	const ae_interface* apis[AE_RENDER_REPLAY_MAX_APIS];
+	uint32_t count;
+};
+
+struct ae_recording
+{
+	uint8_t* file;
+	const uint8_t* commands;
+	size_t size;
+};
+
+struct ae_replay
+{
+	const struct ae_renderer_api* render;
+	const struct ae_shader_api* shader;
+	const struct ae_render_recorder_api* recorder;
+	const struct ae_texture_api* texture;
+	struct ae_shader** shaders;
+	uint32_t shader_capacity;
+	struct ae_render_batch** batches;
+	uint32_t batch_capacity;
+	struct ae_static_batch** static_batches;
+	uint32_t static_batch_capacity;
+	struct ae_texture** textures;
+	uint32_t texture_capacity;
+	struct ae_camera camera;
+	// scratch for the many draws, grown to the biggest one
+	struct ae_draw_params* params;
+	float* soa;
+	vec4* colors;
+	uint32_t param_capacity;
+	uint64_t quad_count;
+};
+
+static const char* command_names[] =
+{
+	"invalid",
+	"shader_create",
+	"shader_set_blending",
+	"shader_set_depth_test",
+	"batch_create",
+	"batch_destroy",
+	"batch_set_texture_binding",
+	"batch_set_indirect",
+	"scene_start",
+	"batch_start",
+	"batch_end",
+	"draw",
+	"draw_textured",
+	"draw_many",
+	"draw_many_soa",
+	"flush",
+	"batch_set_culling",
+	"static_batch_create",
+	"static_batch_destroy",
+	"static_batch_update",
+	"static_batch_draw",
+	"set_camera",
+	"texture_create",
+	"texture_destroy",
+	"frame_start"
+};
+
+#define AE_RENDER_COMMAND_COUNT (sizeof(command_names) / sizeof(command_names[0]))
+
+//
+// registry, plugins only set and get apis while loading
+//
+
+static void registry_set_api(struct ae_api_registry* registry, const char* type, const ae_interface* api, const uint32_t size)
+{
+	AE_UNREFERENCED_PARAMETER(size);
+
+	if (registry->count < AE_RENDER_REPLAY_MAX_APIS)
+	{
+		registry->names[registry->count] = type;
+		registry->apis[registry->count++] = api;
+	}
+}
+
+static ae_interface* registry_get_api(struct ae_api_registry* registry, const char* type, uint32_t size)
+{
+	AE_UNREFERENCED_PARAMETER(size);
+
+	for (uint32_t i = 0; i < registry->count; i++)
+	{
+		if (strcmp(registry->names[i], type) == 0)
+			return (ae_interface*)registry->apis[i];
+	}
+
+	return NULL;
+}
+
+//
+// recording
+//
+
+static bool load_recording(const char* path, struct ae_recording* recording)
+{
+	FILE* file = fopen(path, "rb");
+
+	if (!file)
+	{
+		fprintf(stderr, "could not open %s\n", path);
+		return false;
+	}
+
+	struct ae_render_recording_header header;
+	bool valid = fread(&header, sizeof(header), 1, file) == 1
+		&& memcmp(header.magic, AE_RENDER_RECORDING_MAGIC, sizeof(header.magic)) == 0
+		&& header.version >= AE_RENDER_RECORDING_MIN_VERSION
+		&& header.version <= AE_RENDER_RECORDING_VERSION
+		&& header.header_size == sizeof(header);
+
+	if (!valid)
+	{
+		fprintf(stderr, "%s is not a version %i to %i render recording\n", path, AE_RENDER_RECORDING_MIN_VERSION, AE_RENDER_RECORDING_VERSION);
+		fclose(file);
+		return false;
+	}
+
+	recording->size = (size_t)header.size;
+	recording->file = malloc(recording->size ? recording->size : 1);
+
+	if (!recording->file || fread(recording->file, 1, recording->size, file) != recording->size)
+	{
+		fprintf(stderr, "could not read %s\n", path);
+		free(recording->file);
+		fclose(file);
+		return false;
+	}
+
+	fclose(file);
+	recording->commands = recording->file;
+
+	return true;
+}
+
+// returns the payload of the command at offset and moves offset past it, NULL at the end or if the command is cut off
+static const void* next_command(const uint8_t* commands, const size_t size, size_t* offset, struct ae_render_command_header* header)
+{
+	if (*offset + sizeof(*header) > size)
+		return NULL;
+
+	memcpy(header, commands + *offset, sizeof(*header));
+
+	size_t padded = (sizeof(*header) + header->size + AE_RENDER_RECORDING_ALIGNMENT - 1) & ~(size_t)(AE_RENDER_RECORDING_ALIGNMENT - 1);
+
+	if (*offset + padded > size)
+		return NULL;
+
+	const void* payload = commands + *offset + sizeof(*header);
+	*offset += padded;
+
+	return payload;
+}
+
+// the payload has to hold at least the fixed part of its command
+static bool is_complete(const struct ae_render_command_header* header)
+{
+	static const uint32_t sizes[AE_RENDER_COMMAND_COUNT] =
+	{
+		0,
+		sizeof(struct ae_render_command_shader_create),
+		sizeof(struct ae_render_command_shader_set_blending),
+		sizeof(struct ae_render_command_shader_set_depth_test),
+		sizeof(struct ae_render_command_batch_create),
+		sizeof(struct ae_render_command_batch),
+		sizeof(struct ae_render_command_batch_set_texture_binding),
+		sizeof(struct ae_render_command_batch_set_indirect),
+		sizeof(struct ae_render_command_scene_start),
+		sizeof(struct ae_render_command_batch),
+		sizeof(struct ae_render_command_batch),
+		sizeof(struct ae_render_command_draw),
+		sizeof(struct ae_render_command_draw_textured),
+		sizeof(struct ae_render_command_draw_many),
+		sizeof(struct ae_render_command_draw_many),
+		sizeof(struct ae_render_command_flush),
+		sizeof(struct ae_render_command_batch_set_culling),
+		sizeof(struct ae_render_command_static_batch_create),
+		sizeof(struct ae_render_command_static_batch),
+		sizeof(struct ae_render_command_static_batch_update),
+		sizeof(struct ae_render_command_static_batch),
+		sizeof(struct ae_render_command_scene_start),
+		sizeof(struct ae_render_command_texture_create),
+		sizeof(struct ae_render_command_texture),
+		sizeof(struct ae_render_command_scene_start)
+	};
+
+	return header->type != 0 && header->type < AE_RENDER_COMMAND_COUNT && header->size >= sizes[header->type];
+}
+
+// quads after the fixed part of a static batch create or update
+static uint32_t get_textured_quad_count(const struct ae_render_command_header* header, const size_t command_size, const uint32_t count)
+{
+	uint64_t available = (header->size - command_size) / sizeof(struct ae_render_command_textured_quad);
+	return count <= available ? count : (uint32_t)available;
+}
+
+static uint32_t get_draw_many_count(const struct ae_render_command_header* header, const struct ae_render_command_draw_many* command)
+{
+	uint64_t available = (header->size - sizeof(*command)) / sizeof(struct ae_render_command_draw_quad);
+	return command->count <= available ? command->count : (uint32_t)available;
+}
+
+//
+// dump
+//
+
+static void dump_command(const size_t offset, const struct ae_render_command_header* header, const void* payload)
+{
+	printf("%10zu %-26s", offset, command_names[header->type]);
+
+	switch (header->type)
+	{
+	case AE_RENDER_COMMAND_SHADER_CREATE:
+	{
+		const struct ae_render_command_shader_create* command = payload;
+		printf(" shader %u, %u stages:", command->shader, command->stage_count);
+
+		for (uint32_t i = 0; i < command->stage_count && i < AE_RENDER_RECORDING_MAX_STAGES; i++)
+			printf(" 0x%04x (%u bytes)", (uint32_t)command->stage_types[i], command->stage_sizes[i]);
+		break;
+	}
+	case AE_RENDER_COMMAND_SHADER_SET_BLENDING:
+	{
+		const struct ae_render_command_shader_set_blending* command = payload;
+		printf(" shader %u, %s, 0x%04x 0x%04x", command->shader, command->enable ? "on" : "off", command->source, command->destination);
+		break;
+	}
+	case AE_RENDER_COMMAND_SHADER_SET_DEPTH_TEST:
+	{
+		const struct ae_render_command_shader_set_depth_test* command = payload;
+		printf(" shader %u, %s", command->shader, command->enable ? "on" : "off");
+		break;
+	}
+	case AE_RENDER_COMMAND_BATCH_CREATE:
+	{
+		const struct ae_render_command_batch_create* command = payload;
+		printf(" batch %u, shader %u, %u quads%s", command->batch, command->shader, command->max_quad_count, command->instanced ? ", instanced" : "");
+
+		if (command->has_format)
+			printf(", format %u %u %u", command->color, command->texture_coordinate, command->texture_unit);
+		break;
+	}
+	case AE_RENDER_COMMAND_BATCH_DESTROY:
+	case AE_RENDER_COMMAND_BATCH_START:
+	case AE_RENDER_COMMAND_BATCH_END:
+	{
+		const struct ae_render_command_batch* command = payload;
+		printf(" batch %u", command->batch);
+		break;
+	}
+	case AE_RENDER_COMMAND_BATCH_SET_TEXTURE_BINDING:
+	{
+		const struct ae_render_command_batch_set_texture_binding* command = payload;
+		static const char* bindings[] = { "units", "bindless", "array" };
+
+		printf(" batch %u, %s", command->batch, command->binding < 3 ? bindings[command->binding] : "unknown");
+
+		if (command->binding == AE_TEXTURE_BINDING_ARRAY)
+			printf(" %ux%u x %u", command->layer_width, command->layer_height, command->layer_count);
+
+		printf(", %s", command->result ? "ok" : "failed");
+		break;
+	}
+	case AE_RENDER_COMMAND_BATCH_SET_INDIRECT:
+	{
+		const struct ae_render_command_batch_set_indirect* command = payload;
+		printf(" batch %u, %s", command->batch, command->enabled ? "on" : "off");
+		break;
+	}
+	case AE_RENDER_COMMAND_BATCH_SET_CULLING:
+	{
+		const struct ae_render_command_batch_set_culling* command = payload;
+		static const char* modes[] = { "none", "rect", "frustum" };
+
+		printf(" batch %u, %s", command->batch, command->mode < 3 ? modes[command->mode] : "unknown");
+		break;
+	}
+	case AE_RENDER_COMMAND_STATIC_BATCH_CREATE:
+	{
+		const struct ae_render_command_static_batch_create* command = payload;
+		printf(" static batch %u, shader %u, %u quads%s", command->static_batch, command->shader, command->count, command->updatable ? ", updatable" : "");
+
+		if (command->has_format)
+			printf(", format %u %u %u", command->color, command->texture_coordinate, command->texture_unit);
+		break;
+	}
+	case AE_RENDER_COMMAND_STATIC_BATCH_DESTROY:
+	case AE_RENDER_COMMAND_STATIC_BATCH_DRAW:
+	{
+		const struct ae_render_command_static_batch* command = payload;
+		printf(" static batch %u", command->static_batch);
+		break;
+	}
+	case AE_RENDER_COMMAND_STATIC_BATCH_UPDATE:
+	{
+		const struct ae_render_command_static_batch_update* command = payload;
+		printf(" static batch %u, quads %u to %u, %s", command->static_batch, command->first, command->first + command->count, command->result ? "ok" : "failed");
+		break;
+	}
+	case AE_RENDER_COMMAND_SCENE_START:
+	case AE_RENDER_COMMAND_SET_CAMERA:
+	case AE_RENDER_COMMAND_FRAME_START:
+	{
+		const struct ae_render_command_scene_start* command = payload;
+		printf(" scale %g %g, translation %g %g", command->view_projection[0], command->view_projection[5], command->view_projection[12], command->view_projection[13]);
+		break;
+	}
+	case AE_RENDER_COMMAND_TEXTURE_CREATE:
+	{
+		const struct ae_render_command_texture_create* command = payload;
+		printf(" texture %u, %ux%u, %s, %u levels%s", command->texture, command->width, command->height,
+			command->format == AE_TEXTURE_FORMAT_R8 ? "r8" : "rgba8", command->mip_count, command->generate_mips ? ", generated" : "");
+		break;
+	}
+	case AE_RENDER_COMMAND_TEXTURE_DESTROY:
+	{
+		const struct ae_render_command_texture* command = payload;
+		printf(" texture %u", command->texture);
+		break;
+	}
+	case AE_RENDER_COMMAND_DRAW:
+	{
+		const struct ae_render_command_draw* command = payload;
+		printf(" batch %u, %g %g %g, %gx%g", command->batch, command->position[0], command->position[1], command->position[2], command->size[0], command->size[1]);
+		break;
+	}
+	case AE_RENDER_COMMAND_DRAW_TEXTURED:
+	{
+		const struct ae_render_command_draw_textured* command = payload;
+		printf(" batch %u, %g %g %g, %gx%g, texture %u", command->batch, command->position[0], command->position[1], command->position[2], command->size[0], command->size[1], command->texture);
+		break;
+	}
+	case AE_RENDER_COMMAND_DRAW_MANY:
+	case AE_RENDER_COMMAND_DRAW_MANY_SOA:
+	{
+		const struct ae_render_command_draw_many* command = payload;
+		printf(" batch %u, %u quads", command->batch, get_draw_many_count(header, command));
+		break;
+	}
+	case AE_RENDER_COMMAND_FLUSH:
+	{
+		const struct ae_render_command_flush* command = payload;
+		printf(" batch %u, %u quads, %u textures, %u vertex bytes", command->batch, command->quad_count, command->texture_count, command->vertex_size);
+		break;
+	}
+	}
+
+	printf("\n");
+}
+
+static bool dump(const struct ae_recording* recording)
+{
+	uint64_t counts[AE_RENDER_COMMAND_COUNT] = { 0 };
+	uint64_t quad_count = 0;
+	uint64_t vertex_size = 0;
+	struct ae_render_command_header header;
+	size_t offset = 0;
+	size_t start = 0;
+	const void* payload;
+
+	while ((payload = next_command(recording->commands, recording->size, &offset, &header)))
+	{
+		if (!is_complete(&header))
+		{
+			fprintf(stderr, "invalid command %u of %u bytes at %zu\n", header.type, header.size, start);
+			return false;
+		}
+
+		dump_command(start, &header, payload);
+		counts[header.type]++;
+
+		if (header.type == AE_RENDER_COMMAND_FLUSH)
+		{
+			quad_count += ((const struct ae_render_command_flush*)payload)->quad_count;
+			vertex_size += ((const struct ae_render_command_flush*)payload)->vertex_size;
+		}
+
+		start = offset;
+	}
+
+	printf("\n");
+
+	for (uint32_t i = 1; i < AE_RENDER_COMMAND_COUNT; i++)
+	{
+		if (counts[i])
+			printf("%-26s %10llu\n", command_names[i], (unsigned long long)counts[i]);
+	}
+
+	printf("%-26s %10llu\n%-26s %10llu\n", "flushed quads", (unsigned long long)quad_count, "recorded vertex bytes", (unsigned long long)vertex_size);
+
+	return offset == recording->size;
+}
+
+//
+// replay
+//
+
+static bool grow(void** array, uint32_t* capacity, const uint32_t index, const size_t element_size)
+{
+	if (index < *capacity)
+		return true;
+
+	// doubling up to a bigger id would overflow the capacity
+	if (index >= AE_RENDER_REPLAY_MAX_OBJECT_ID)
+	{
+		fprintf(stderr, "object id %u is out of range\n", index);
+		return false;
+	}
+
+	uint32_t new_capacity = *capacity ? *capacity : 16;
+
+	while (new_capacity <= index)
+		new_capacity *= 2;
+
+	void* grown = realloc(*array, element_size * new_capacity);
+
+	if (!grown)
+		return false;
+
+	memset((uint8_t*)grown + element_size * *capacity, 0, element_size * (new_capacity - *capacity));
+
+	*array = grown;
+	*capacity = new_capacity;
+
+	return true;
+}
+
+static struct ae_shader* get_shader(const struct ae_replay* replay, const uint32_t index)
+{
+	return index < replay->shader_capacity ? replay->shaders[index] : NULL;
+}
+
+static struct ae_render_batch* get_batch(const struct ae_replay* replay, const uint32_t index)
+{
+	return index < replay->batch_capacity ? replay->batches[index] : NULL;
+}
+
+static struct ae_static_batch* get_static_batch(const struct ae_replay* replay, const uint32_t index)
+{
+	return index < replay->static_batch_capacity ? replay->static_batches[index] : NULL;
+}
+
+static struct ae_texture* get_texture(const struct ae_replay* replay, const uint32_t index)
+{
+	return index < replay->texture_capacity ? replay->textures[index] : NULL;
+}
+
+// the id of the replayed texture, ids the recording did not create are passed on unchanged
+static uint32_t map_texture(const struct ae_replay* replay, const uint32_t index)
+{
+	const struct ae_texture* texture = get_texture(replay, index);
+	return texture ? texture->id : index;
+}
+
+static bool reserve_params(struct ae_replay* replay, const uint32_t count)
+{
+	if (count <= replay->param_capacity)
+		return true;
+
+	free(replay->params);
+	free(replay->soa);
+	free(replay->colors);
+
+	replay->params = malloc(sizeof(*replay->params) * count);
+	replay->soa = malloc(sizeof(float) * 5 * count);
+	replay->colors = malloc(sizeof(vec4) * count);
+	replay->param_capacity = replay->params && replay->soa && replay->colors ? count : 0;
+
+	return replay->param_capacity != 0;
+}
+
+static void create_shader(struct ae_replay* replay, const struct ae_render_command_header* header, const struct ae_render_command_shader_create* command)
+{
+	// later passes keep the programs of the first
+	if (get_shader(replay, command->shader) || command->stage_count > AE_RENDER_RECORDING_MAX_STAGES)
+		return;
+
+	const char* sources[AE_RENDER_RECORDING_MAX_STAGES];
+	int32_t sizes[AE_RENDER_RECORDING_MAX_STAGES];
+	const char* source = (const char*)(command + 1);
+	size_t source_size = header->size - sizeof(*command);
+
+	for (uint32_t i = 0; i < command->stage_count; i++)
+	{
+		if (command->stage_sizes[i] > source_size)
+			return;
+
+		sources[i] = source;
+		sizes[i] = (int32_t)command->stage_sizes[i];
+		source += command->stage_sizes[i];
+		source_size -= command->stage_sizes[i];
+	}
+
+	char debug_output[512] = { 0 };
+	struct ae_shader* shader = replay->shader->create(debug_output, sizeof(debug_output), sources, sizes, command->stage_types, (int32_t)command->stage_count);
+
+	if (!shader)
+	{
+		fprintf(stderr, "shader %u failed: %s\n", command->shader, debug_output);
+		return;
+	}
+
+	if (grow((void**)&replay->shaders, &replay->shader_capacity, command->shader, sizeof(*replay->shaders)))
+		replay->shaders[command->shader] = shader;
+}
+
+static void create_batch(struct ae_replay* replay, const struct ae_render_command_batch_create* command)
+{
+	struct ae_shader* shader = get_shader(replay, command->shader);
+
+	if (!shader || get_batch(replay, command->batch) || !grow((void**)&replay->batches, &replay->batch_capacity, command->batch, sizeof(*replay->batches)))
+		return;
+
+	const struct ae_vertex_format format = {
+		.color = (enum ae_vertex_color_format)command->color,
+		.texture_coordinate = (enum ae_vertex_texture_coordinate_format)command->texture_coordinate,
+		.texture_unit = (enum ae_vertex_texture_unit_format)command->texture_unit
+	};
+
+	if (command->instanced)
+		replay->batches[command->batch] = replay->render->render_batch_create_instanced(shader, command->max_quad_count);
+	else
+		replay->batches[command->batch] = replay->render->render_batch_create(shader, command->max_quad_count, command->has_format ? &format : NULL);
+}
+
+static void create_texture(struct ae_replay* replay, const struct ae_render_command_texture_create* command)
+{
+	// later passes keep the textures of the first
+	if (!replay->texture || get_texture(replay, command->texture) || !grow((void**)&replay->textures, &replay->texture_capacity, command->texture, sizeof(*replay->textures)))
+		return;
+
+	const struct ae_texture_desc desc = {
+		.width = command->width,
+		.height = command->height,
+		.format = (enum ae_texture_format)command->format,
+		.mip_count = command->mip_count,
+		.generate_mips = command->generate_mips
+	};
+
+	replay->textures[command->texture] = replay->texture->create(&desc);
+}
+
+// NULL if there are no quads or no memory, the caller frees the params
+static struct ae_textured_draw_params* get_textured_params(struct ae_replay* replay, const struct ae_render_command_textured_quad* quads, const uint32_t count)
+{
+	struct ae_textured_draw_params* params = count ? malloc(sizeof(*params) * count) : NULL;
+
+	for (uint32_t i = 0; params && i < count; i++)
+	{
+		params[i] = (struct ae_textured_draw_params){ .camera = &replay->camera, .texture = map_texture(replay, quads[i].texture) };
+
+		memcpy(params[i].color, quads[i].color, sizeof(params[i].color));
+		memcpy(params[i].position, quads[i].position, sizeof(params[i].position));
+		memcpy(params[i].size, quads[i].size, sizeof(params[i].size));
+		memcpy(params[i].texture_coordinates, quads[i].texture_coordinates, sizeof(params[i].texture_coordinates));
+	}
+
+	return params;
+}
+
+static void create_static_batch(struct ae_replay* replay, const struct ae_render_command_header* header, const struct ae_render_command_static_batch_create* command)
+{
+	struct ae_shader* shader = get_shader(replay, command->shader);
+	uint32_t count = get_textured_quad_count(header, sizeof(*command), command->count);
+
+	if (!shader || get_static_batch(replay, command->static_batch) || !grow((void**)&replay->static_batches, &replay->static_batch_capacity, command->static_batch, sizeof(*replay->static_batches)))
+		return;
+
+	const struct ae_vertex_format format = {
+		.color = (enum ae_vertex_color_format)command->color,
+		.texture_coordinate = (enum ae_vertex_texture_coordinate_format)command->texture_coordinate,
+		.texture_unit = (enum ae_vertex_texture_unit_format)command->texture_unit
+	};
+
+	struct ae_textured_draw_params* params = get_textured_params(replay, (const struct ae_render_command_textured_quad*)(command + 1), count);
+
+	if (params)
+		replay->static_batches[command->static_batch] = replay->render->render_static_batch_create(shader, params, count, command->has_format ? &format : NULL, command->updatable);
+
+	free(params);
+}
+
+static void update_static_batch(struct ae_replay* replay, const struct ae_render_command_header* header, const struct ae_render_command_static_batch_update* command)
+{
+	struct ae_static_batch* batch = get_static_batch(replay, command->static_batch);
+	uint32_t count = get_textured_quad_count(header, sizeof(*command), command->count);
+
+	if (!batch)
+		return;
+
+	struct ae_textured_draw_params* params = get_textured_params(replay, (const struct ae_render_command_textured_quad*)(command + 1), count);
+
+	if (params && replay->render->render_static_batch_update(batch, command->first, params, count) != (bool)command->result)
+		fprintf(stderr, "static batch %u: update of quads %u to %u differs from the recording\n", command->static_batch, command->first, command->first + count);
+
+	free(params);
+}
+
+static void draw_many(struct ae_replay* replay, const struct ae_render_command_header* header, const struct ae_render_command_draw_many* command, struct ae_render_batch* batch)
+{
+	uint32_t count = get_draw_many_count(header, command);
+	const struct ae_render_command_draw_quad* quads = (const struct ae_render_command_draw_quad*)(command + 1);
+
+	if (!reserve_params(replay, count))
+		return;
+
+	if (header->type == AE_RENDER_COMMAND_DRAW_MANY)
+	{
+		for (uint32_t i = 0; i < count; i++)
+		{
+			struct ae_draw_params* params = &replay->params[i];
+
+			memcpy(params->color, quads[i].color, sizeof(params->color));
+			memcpy(params->position, quads[i].position, sizeof(params->position));
+			memcpy(params->size, quads[i].size, sizeof(params->size));
+			params->camera = &replay->camera;
+		}
+
+		replay->render->render_batch_draw_many(batch, replay->params, count);
+	}
+	else
+	{
+		const struct ae_draw_params_soa params = {
+			.x = replay->soa,
+			.y = replay->soa + count,
+			.z = replay->soa + count * 2,
+			.width = replay->soa + count * 3,
+			.height = replay->soa + count * 4,
+			.color = (const vec4*)replay->colors
+		};
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			replay->soa[i] = quads[i].position[0];
+			replay->soa[count + i] = quads[i].position[1];
+			replay->soa[count * 2 + i] = quads[i].position[2];
+			replay->soa[count * 3 + i] = quads[i].size[0];
+			replay->soa[count * 4 + i] = quads[i].size[1];
+			memcpy(replay->colors[i], quads[i].color, sizeof(vec4));
+		}
+
+		replay->render->render_batch_draw_many_soa(batch, &params, count);
+	}
+
+	replay->quad_count += count;
+}
+
+static void replay_command(struct ae_replay* replay, const struct ae_render_command_header* header, const void* payload)
+{
+	switch (header->type)
+	{
+	case AE_RENDER_COMMAND_SHADER_CREATE:
+		create_shader(replay, header, payload);
+		break;
+	case AE_RENDER_COMMAND_SHADER_SET_BLENDING:
+	{
+		const struct ae_render_command_shader_set_blending* command = payload;
+		struct ae_shader* shader = get_shader(replay, command->shader);
+
+		if (shader && replay->shader->set_blending)
+			replay->shader->set_blending(shader, command->enable, command->source, command->destination);
+		break;
+	}
+	case AE_RENDER_COMMAND_SHADER_SET_DEPTH_TEST:
+	{
+		const struct ae_render_command_shader_set_depth_test* command = payload;
+		struct ae_shader* shader = get_shader(replay, command->shader);
+
+		if (shader && replay->shader->set_depth_test)
+			replay->shader->set_depth_test(shader, command->enable);
+		break;
+	}
+	case AE_RENDER_COMMAND_BATCH_CREATE:
+		create_batch(replay, payload);
+		break;
+	case AE_RENDER_COMMAND_STATIC_BATCH_CREATE:
+		create_static_batch(replay, header, payload);
+		break;
+	case AE_RENDER_COMMAND_STATIC_BATCH_DESTROY:
+	{
+		const struct ae_render_command_static_batch* command = payload;
+		struct ae_static_batch* batch = get_static_batch(replay, command->static_batch);
+
+		if (batch)
+		{
+			replay->render->render_static_batch_destroy(batch);
+			replay->static_batches[command->static_batch] = NULL;
+		}
+		break;
+	}
+	case AE_RENDER_COMMAND_STATIC_BATCH_UPDATE:
+		update_static_batch(replay, header, payload);
+		break;
+	case AE_RENDER_COMMAND_STATIC_BATCH_DRAW:
+	{
+		struct ae_static_batch* batch = get_static_batch(replay, ((const struct ae_render_command_static_batch*)payload)->static_batch);
+
+		if (batch)
+			replay->render->render_static_batch_draw(batch);
+		break;
+	}
+	case AE_RENDER_COMMAND_SCENE_START:
+	{
+		const struct ae_render_command_scene_start* command = payload;
+		memcpy(replay->camera.view_projection, command->view_projection, sizeof(replay->camera.view_projection));
+		replay->render->render_scene_start(&replay->camera);
+		break;
+	}
+	case AE_RENDER_COMMAND_FRAME_START:
+	{
+		const struct ae_render_command_scene_start* command = payload;
+		memcpy(replay->camera.view_projection, command->view_projection, sizeof(replay->camera.view_projection));
+		replay->render->render_frame_start(&replay->camera);
+		break;
+	}
+	case AE_RENDER_COMMAND_SET_CAMERA:
+	{
+		const struct ae_render_command_scene_start* command = payload;
+		memcpy(replay->camera.view_projection, command->view_projection, sizeof(replay->camera.view_projection));
+		replay->render->render_set_camera(&replay->camera);
+		break;
+	}
+	case AE_RENDER_COMMAND_TEXTURE_CREATE:
+		create_texture(replay, payload);
+		break;
+	case AE_RENDER_COMMAND_TEXTURE_DESTROY:
+	{
+		const struct ae_render_command_texture* command = payload;
+		struct ae_texture* texture = get_texture(replay, command->texture);
+
+		if (texture)
+		{
+			replay->texture->destroy(texture);
+			replay->textures[command->texture] = NULL;
+		}
+		break;
+	}
+	case AE_RENDER_COMMAND_FLUSH:
+		// the output of the recorded renderer, the replayed one flushes on its own
+		break;
+	default:
+	{
+		// every other command starts with the batch it works on
+		const struct ae_render_command_batch* command = payload;
+		struct ae_render_batch* batch = get_batch(replay, command->batch);
+
+		if (!batch)
+			break;
+
+		switch (header->type)
+		{
+		case AE_RENDER_COMMAND_BATCH_DESTROY:
+			replay->render->render_batch_destroy(batch);
+			replay->batches[command->batch] = NULL;
+			break;
+		case AE_RENDER_COMMAND_BATCH_SET_TEXTURE_BINDING:
+		{
+			const struct ae_render_command_batch_set_texture_binding* binding = payload;
+			const struct ae_texture_binding_desc desc = {
+				.binding = (enum ae_texture_binding)binding->binding,
+				.layer_width = binding->layer_width,
+				.layer_height = binding->layer_height,
+				.layer_count = binding->layer_count
+			};
+
+			replay->render->render_batch_set_texture_binding(batch, &desc);
+			break;
+		}
+		case AE_RENDER_COMMAND_BATCH_SET_INDIRECT:
+			replay->render->render_batch_set_indirect(batch, ((const struct ae_render_command_batch_set_indirect*)payload)->enabled);
+			break;
+		case AE_RENDER_COMMAND_BATCH_SET_CULLING:
+			replay->render->render_batch_set_culling(batch, (enum ae_cull_mode)((const struct ae_render_command_batch_set_culling*)payload)->mode);
+			break;
+		case AE_RENDER_COMMAND_BATCH_START:
+			replay->render->render_batch_start(batch);
+			break;
+		case AE_RENDER_COMMAND_BATCH_END:
+			replay->render->render_batch_end(batch);
+			break;
+		case AE_RENDER_COMMAND_DRAW:
+		{
+			const struct ae_render_command_draw* draw = payload;
+			struct ae_draw_params params = { .camera = &replay->camera };
+
+			memcpy(params.color, draw->color, sizeof(params.color));
+			memcpy(params.position, draw->position, sizeof(params.position));
+			memcpy(params.size, draw->size, sizeof(params.size));
+
+			replay->render->render_batch_draw(batch, &params);
+			replay->quad_count++;
+			break;
+		}
+		case AE_RENDER_COMMAND_DRAW_TEXTURED:
+		{
+			const struct ae_render_command_draw_textured* draw = payload;
+			struct ae_textured_draw_params params = { .camera = &replay->camera, .texture = map_texture(replay, draw->texture) };
+
+			memcpy(params.color, draw->color, sizeof(params.color));
+			memcpy(params.position, draw->position, sizeof(params.position));
+			memcpy(params.size, draw->size, sizeof(params.size));
+			memcpy(params.texture_coordinates, draw->texture_coordinates, sizeof(params.texture_coordinates));
+
+			replay->render->render_batch_draw_textured(batch, &params);
+			replay->quad_count++;
+			break;
+		}
+		case AE_RENDER_COMMAND_DRAW_MANY:
+		case AE_RENDER_COMMAND_DRAW_MANY_SOA:
+			draw_many(replay, header, payload, batch);
+			break;
+		}
+		break;
+	}
+	}
+}
+
+static bool replay_pass(struct ae_replay* replay, const struct ae_recording* recording)
+{
+	struct ae_render_command_header header;
+	size_t offset = 0;
+	const void* payload;
+
+	while ((payload = next_command(recording->commands, recording->size, &offset, &header)))
+	{
+		if (!is_complete(&header))
+		{
+			fprintf(stderr, "invalid command %u of %u bytes\n", header.type, header.size);
+			return false;
+		}
+
+		replay_command(replay, &header, payload);
+	}
+
+	return true;
+}
+
+// finds the next flush at or after offset
+static const struct ae_render_command_flush* next_flush(const uint8_t* commands, const size_t size, size_t* offset, uint32_t* payload_size)
+{
+	struct ae_render_command_header header;
+	const void* payload;
+
+	while ((payload = next_command(commands, size, offset, &header)))
+	{
+		if (header.type == AE_RENDER_COMMAND_FLUSH && header.size >= sizeof(struct ae_render_command_flush))
+		{
+			*payload_size = header.size;
+			return payload;
+		}
+	}
+
+	return NULL;
+}
+
+// batch numbers may differ between the recordings, quad counts and vertices may not
+static bool compare_flushes(const struct ae_recording* expected, const uint8_t* actual, const size_t actual_size)
+{
+	size_t expected_offset = 0;
+	size_t actual_offset = 0;
+	uint32_t expected_size = 0;
+	uint32_t actual_payload_size = 0;
+	uint64_t flush = 0;
+
+	for (;; flush++)
+	{
+		const struct ae_render_command_flush* a = next_flush(expected->commands, expected->size, &expected_offset, &expected_size);
+		const struct ae_render_command_flush* b = next_flush(actual, actual_size, &actual_offset, &actual_payload_size);
+
+		if (!a || !b)
+		{
+			if (a || b)
+			{
+				fprintf(stderr, "the replay flushed %s times than the recording\n", a ? "fewer" : "more");
+				return false;
+			}
+
+			break;
+		}
+
+		bool vertices_match = a->vertex_size == 0 || b->vertex_size == 0
+			|| (a->vertex_size == b->vertex_size
+				&& a->vertex_size <= expected_size - sizeof(*a)
+				&& memcmp(a + 1, b + 1, a->vertex_size) == 0);
+
+		if (a->quad_count != b->quad_count || a->texture_count != b->texture_count || !vertices_match)
+		{
+			fprintf(stderr, "flush %llu differs: %u quads %u textures recorded, %u quads %u textures replayed%s\n",
+				(unsigned long long)flush, a->quad_count, a->texture_count, b->quad_count, b->texture_count, vertices_match ? "" : ", vertices differ");
+			return false;
+		}
+	}
+
+	printf("%llu flushes match the recording\n", (unsigned long long)flush);
+
+	return true;
+}
+
+static bool replay(const struct ae_recording* recording, const char* plugin_path, const uint32_t repeat)
+{
+	LIBRARY_TYPE library = LOAD_LIBRARY(plugin_path);
+
+	if (!library)
+	{
+		fprintf(stderr, "could not load %s\n", plugin_path);
+		return false;
+	}
+
+	// object pointers can not be cast to function pointers in iso c
+	ae_plugin_load_fn load;
+	*(void**)&load = (void*)LOAD_FUNCTION(library, "plugin_load");
+
+	if (!load)
+	{
+		fprintf(stderr, "%s has no plugin_load\n", plugin_path);
+		return false;
+	}
+
+	struct ae_api_registry registry = { 0 };
+	struct ae_api_registry_api registry_api = {
+		.registry = &registry,
+		.set_api = registry_set_api,
+		.get_api = registry_get_api
+	};
+
+	load(&registry_api, false);
+
+	struct ae_opengl_backend_api* backend = ae_get_api((&registry_api), ae_opengl_backend_api);
+	struct ae_replay state = {
+		.render = ae_get_api((&registry_api), ae_renderer_api),
+		.shader = ae_get_api((&registry_api), ae_shader_api),
+		.recorder = ae_get_api((&registry_api), ae_render_recorder_api),
+		.texture = ae_get_api((&registry_api), ae_texture_api)
+	};
+
+	if (!state.render || !state.shader || (backend && !backend->get_or_create()))
+	{
+		fprintf(stderr, "%s has no usable renderer\n", plugin_path);
+		return false;
+	}
+
+	bool success = true;
+	uint64_t best = UINT64_MAX;
+
+	for (uint32_t pass = 0; pass < repeat && success; pass++)
+	{
+		// only the first pass is checked, the later ones skip copying the vertices
+		if (state.recorder)
+		{
+			state.recorder->reset();
+			state.recorder->set_record_vertices(pass == 0);
+		}
+
+		state.quad_count = 0;
+
+		uint64_t start = ae_clock_now();
+		success = replay_pass(&state, recording);
+		uint64_t time = ae_clock_now() - start;
+
+		best = time < best ? time : best;
+
+		if (success && pass == 0 && state.recorder)
+		{
+			size_t size;
+			const uint8_t* data = state.recorder->get_data(&size);
+
+			success = compare_flushes(recording, data, size);
+		}
+	}
+
+	if (success)
+	{
+		printf("%llu quads, best of %u passes: %.3f ms, %.2f ns/quad\n",
+			(unsigned long long)state.quad_count,
+			repeat,
+			(double)best / 1e6,
+			state.quad_count ? (double)best / (double)state.quad_count : 0.0);
+	}
+
+	for (uint32_t i = 0; i < state.batch_capacity; i++)
+	{
+		if (state.batches[i])
+			state.render->render_batch_destroy(state.batches[i]);
+	}
+
+	for (uint32_t i = 0; i < state.static_batch_capacity; i++)
+	{
+		if (state.static_batches[i])
+			state.render->render_static_batch_destroy(state.static_batches[i]);
+	}
+
+	for (uint32_t i = 0; i < state.texture_capacity; i++)
+	{
+		if (state.textures[i])
+			state.texture->destroy(state.textures[i]);
+	}
+
+	free(state.batches);
+	free(state.static_batches);
+	free(state.textures);
+	free(state.shaders);
+	free(state.params);
+	free(state.soa);
+	free(state.colors);
+
+	return success;
+}
+
+int main(int argc, char** argv)
+{
+	const char* recording_path = NULL;
+	const char* plugin_path = NULL;
+	uint32_t repeat = 1;
+	bool print = false;
+	bool valid = true;
+
+	for (int i = 1; i < argc && valid; i++)
+	{
+		if (strcmp(argv[i], "--dump") == 0)
+			print = true;
+		else if (strcmp(argv[i], "--plugin") == 0 && i + 1 < argc)
+			plugin_path = argv[++i];
+		else if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc)
+			valid = (repeat = (uint32_t)strtoul(argv[++i], NULL, 10)) != 0;
+		else if (!recording_path && argv[i][0] != '-')
+			recording_path = argv[i];
+		else
+			valid = false;
+	}
+
+	if (!valid || !recording_path)
+	{
+		fprintf(stderr, "usage: %s <recording> [--dump] [--plugin <path>] [--repeat <count>]\n", argv[0]);
+		return 1;
+	}
+
+	struct ae_recording recording = { 0 };
+
+	if (!load_recording(recording_path, &recording))
+		return 1;
+
+	// without a plugin there is nothing to replay into
+	bool success = true;
+
+	if (print || !plugin_path)
+		success = dump(&recording);
+
+	if (success && plugin_path)
+		success = replay(&recording, plugin_path, repeat);
+
+	free(recording.file);
+
+	return success ? 0 : 1;
+}
@@ -38,7 +38,7 @@ mat4 viewProjection;\n\
 \n\
 out vec4 v_color;\n\
 out vec2 v_textureCoordinate;\n\
-out float v_textureUnit;\n\
+flat out float v_textureUnit;\n\
 \n\
 void main()\n\
 {\
@@ -58,7 +58,7 @@ uniform sampler2D u_textures[32];\n\
 \n\
 in vec4 v_color;\n\
 in vec2 v_textureCoordinate;\n\
-in float v_textureUnit;\n\
+flat in float v_textureUnit;\n\
 \n\
 void main()\n\
 {\n\
@@ -105,7 +105,19 @@ int main()
 	struct ae_imgui_api* ae_imgui_api = ae_get_api(api_registry_api, ae_imgui_api);
 
 	//// initialize apis
-	ae_logging_api->get_or_create_main_logger(LEVEL_INFO);
+	// the log macros only queue their messages, a writer thread formats and writes them
+	struct ae_logger* logger = ae_logging_api->create_async(LEVEL_INFO, 4096, AE_LOG_BACKPRESSURE_BLOCK);
+
+	if (logger)
+	{
+		ae_logging_api->add_console_sink(logger, stderr, LEVEL_INFO);
+		ae_logging_api->set_main_logger(logger);
+	}
+	else
+	{
+		ae_logging_api->get_or_create_main_logger(LEVEL_INFO);
+	}
+
 	struct ae_window* window = ae_window_api->get_or_create(&main_window_params);
 	ae_render_backend_api->get_or_create(window);
 	//struct ae_camera* camera = ae_camera_api->create_orthographic((vec3)
@@ -113,7 +125,7 @@ int main()
 	//	0, 0, 0
 	//}, 1280.0f / 720.0f, 0.0f, 1000.0f, 0.0f, 1000.0f, 0.0f, 1.0f);
 	//struct ae_shader* shader = ae_shader_api->create_basic(debug, 255, default_vertex, default_fragment);
-	//struct ae_render_batch* batch = ae_renderer_api->render_batch_create(shader, 1024);
+	//struct ae_render_batch* batch = ae_renderer_api->render_batch_create(shader, 1024, NULL);
 
 	ae_log_info("Starting AssemblerEngine...");
 
@@ -137,4 +149,7 @@ int main()
 	}
 
 	ae_log_info("Shuttingdown AssemblerEngine...");
+
+	// writes what is still queued
+	ae_logging_api->destroy(ae_logging_api->get_main_logger());
 }
\ No newline at end of file